@@ -45,11 +45,17 @@
  *
  *  The SMB protocol uses the DES algorithm as a hash function, not an
  *  encryption function.  The auth_DEShash() implemented here is a one-way
- *  function.  The reverse is not implemented in this module.  Also, there
- *  is no attempt at making this either fast or efficient.  There is no
- *  need, as the auth_DEShash() function is used for generating the LM
- *  Response from a 7-byte key and an 8-byte challenge.  It is not intended
- *  for use in encrypting large blocks of data or data streams.
+ *  function.  The reverse is not implemented in this module.
+ *
+ *  The original version of this module walked the DES permutation maps
+ *  one bit at a time.  That was simple, but slow, and it turns out that
+ *  some callers (password auditing, servers validating large numbers of
+ *  LM and NTLM responses) do call auth_DEShash() often enough to care.
+ *  The permutations and S-Box lookups are now driven by tables that are
+ *  pre-computed from the standard maps, so that each lookup handles a
+ *  nibble or a 6-bit group rather than a single bit.  The tables use only
+ *  32-bit values, since a 64-bit integer type is not available on every
+ *  platform that we support.
  *
  *  As stated above, this implementation is based on studying existing work
  *  in the public domain or under Open Source (specifically LGPL) license.
@@ -100,56 +106,212 @@
 
 /* -------------------------------------------------------------------------- **
  * Static Constants:
+ *
+ *  The tables below are not the permutation maps shown in the literature.
+ *  Each one is pre-computed from one of those maps so that a whole group
+ *  of bits can be moved with a single table lookup, rather than walking
+ *  the map one bit at a time.  The maps themselves are the ones given in
+ *  Schneier, Chapter 12, with the usual zero-based bit numbering:  bit 0
+ *  is the high-order bit of the first byte.
+ *
+ *  Several of the tables produce a pair of 32-bit values.  That's because
+ *  a 64-bit integer type cannot be counted upon (see the Amiga platform
+ *  header), so the 64-bit data block is handled as two 32-bit halves.
  */
 
-/* Initial permutation map.
- * In the first step of DES, the bits of the initial plaintext are rearranged 
- * according to the map given below.  This map and those like it are read by
- * the Permute() function (below) which uses the maps as a guide when moving
- * bits from one place to another.
+/* Initial permutation table.
+ * In the first step of DES, the bits of the initial plaintext are rearranged.
+ * The initial permutation has a handy property:  all eight bits of an input
+ * byte land in the same bit column of eight different output bytes, and the
+ * column is simply the position of the input byte.  So, we only need to know
+ * where the high and low nibbles of the first byte go.  The results for the
+ * remaining bytes are the same values shifted left by the byte position.
  *
- * Note that the values here are all one less than those shown in Schneier.
- * That's because C likes to start counting from 0, not 1.
+ * Each entry is the { L, R } pair produced by a single input nibble.
  *
  * According to Schneier (Ch12, pg 271), the purpose of the initial
  * permutation was to make it easier to load plaintext and ciphertext into
  * a DES ecryption chip.  I have no idea why that would be the case.
  */
-static const uint8_t InitialPermuteMap[64] = 
+static const uint32_t IPtab[2][16][2] =
   {
-  57, 49, 41, 33, 25, 17,  9, 1,
-  59, 51, 43, 35, 27, 19, 11, 3,
-  61, 53, 45, 37, 29, 21, 13, 5,
-  63, 55, 47, 39, 31, 23, 15, 7,
-  56, 48, 40, 32, 24, 16,  8, 0,
-  58, 50, 42, 34, 26, 18, 10, 2,
-  60, 52, 44, 36, 28, 20, 12, 4,
-  62, 54, 46, 38, 30, 22, 14, 6
+    {  /* high nibble */
+    { 0x00000000, 0x00000000 }, { 0x00010000, 0x00000000 },
+    { 0x00000000, 0x00010000 }, { 0x00010000, 0x00010000 },
+    { 0x01000000, 0x00000000 }, { 0x01010000, 0x00000000 },
+    { 0x01000000, 0x00010000 }, { 0x01010000, 0x00010000 },
+    { 0x00000000, 0x01000000 }, { 0x00010000, 0x01000000 },
+    { 0x00000000, 0x01010000 }, { 0x00010000, 0x01010000 },
+    { 0x01000000, 0x01000000 }, { 0x01010000, 0x01000000 },
+    { 0x01000000, 0x01010000 }, { 0x01010000, 0x01010000 }
+    },
+    {  /* low nibble */
+    { 0x00000000, 0x00000000 }, { 0x00000001, 0x00000000 },
+    { 0x00000000, 0x00000001 }, { 0x00000001, 0x00000001 },
+    { 0x00000100, 0x00000000 }, { 0x00000101, 0x00000000 },
+    { 0x00000100, 0x00000001 }, { 0x00000101, 0x00000001 },
+    { 0x00000000, 0x00000100 }, { 0x00000001, 0x00000100 },
+    { 0x00000000, 0x00000101 }, { 0x00000001, 0x00000101 },
+    { 0x00000100, 0x00000100 }, { 0x00000101, 0x00000100 },
+    { 0x00000100, 0x00000101 }, { 0x00000101, 0x00000101 }
+    }
   };
 
 
-/* Key permutation map.
+/* Key permutation table.
  * Like the input data and encryption result, the key is permuted before
  * the algorithm really gets going.  The original algorithm called for an
  * eight-byte key in which each byte contained a parity bit.  During the
  * key permutiation, the parity bits were discarded.  The DES algorithm,
  * as used with SMB, does not make use of the parity bits.  Instead, SMB
- * passes 7-byte keys to DES.  For DES implementations that expect parity,
- * the parity bits must be added.  In this case, however, we're just going
- * to start with a 7-byte (56 bit) key.  KeyPermuteMap, below, is adjusted
- * accordingly and, of course, each entry in the map is reduced by 1 with
- * respect to the documented values because C likes to start counting from
- * 0, not 1.
+ * passes 7-byte keys to DES, and this table starts with a 7-byte (56 bit)
+ * key.  There is one row for each of the fourteen nibbles of the key.
+ * Each entry gives the bits that the nibble contributes to the two 28-bit
+ * key halves, { C, D }, which are kept in the low-order bits of a pair of
+ * 32-bit values.
  */
-static const uint8_t KeyPermuteMap[56] = 
+static const uint32_t PC1tab[14][16][2] =
   {
-  49, 42, 35, 28, 21, 14,  7,  0,
-  50, 43, 36, 29, 22, 15,  8,  1,
-  51, 44, 37, 30, 23, 16,  9,  2,
-  52, 45, 38, 31, 55, 48, 41, 34,
-  27, 20, 13,  6, 54, 47, 40, 33,
-  26, 19, 12,  5, 53, 46, 39, 32,
-  25, 18, 11,  4, 24, 17, 10,  3,
+    {  /* key nibble 0 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000001 },
+    { 0x00000010, 0x00000000 }, { 0x00000010, 0x00000001 },
+    { 0x00001000, 0x00000000 }, { 0x00001000, 0x00000001 },
+    { 0x00001010, 0x00000000 }, { 0x00001010, 0x00000001 },
+    { 0x00100000, 0x00000000 }, { 0x00100000, 0x00000001 },
+    { 0x00100010, 0x00000000 }, { 0x00100010, 0x00000001 },
+    { 0x00101000, 0x00000000 }, { 0x00101000, 0x00000001 },
+    { 0x00101010, 0x00000000 }, { 0x00101010, 0x00000001 }
+    },
+    {  /* key nibble 1 */
+    { 0x00000000, 0x00000000 }, { 0x00200000, 0x00000000 },
+    { 0x00000000, 0x00100000 }, { 0x00200000, 0x00100000 },
+    { 0x00000000, 0x00001000 }, { 0x00200000, 0x00001000 },
+    { 0x00000000, 0x00101000 }, { 0x00200000, 0x00101000 },
+    { 0x00000000, 0x00000010 }, { 0x00200000, 0x00000010 },
+    { 0x00000000, 0x00100010 }, { 0x00200000, 0x00100010 },
+    { 0x00000000, 0x00001010 }, { 0x00200000, 0x00001010 },
+    { 0x00000000, 0x00101010 }, { 0x00200000, 0x00101010 }
+    },
+    {  /* key nibble 2 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000020 },
+    { 0x00000000, 0x00000002 }, { 0x00000000, 0x00000022 },
+    { 0x00000020, 0x00000000 }, { 0x00000020, 0x00000020 },
+    { 0x00000020, 0x00000002 }, { 0x00000020, 0x00000022 },
+    { 0x00002000, 0x00000000 }, { 0x00002000, 0x00000020 },
+    { 0x00002000, 0x00000002 }, { 0x00002000, 0x00000022 },
+    { 0x00002020, 0x00000000 }, { 0x00002020, 0x00000020 },
+    { 0x00002020, 0x00000002 }, { 0x00002020, 0x00000022 }
+    },
+    {  /* key nibble 3 */
+    { 0x00000000, 0x00000000 }, { 0x00004000, 0x00000000 },
+    { 0x00400000, 0x00000000 }, { 0x00404000, 0x00000000 },
+    { 0x00000000, 0x00200000 }, { 0x00004000, 0x00200000 },
+    { 0x00400000, 0x00200000 }, { 0x00404000, 0x00200000 },
+    { 0x00000000, 0x00002000 }, { 0x00004000, 0x00002000 },
+    { 0x00400000, 0x00002000 }, { 0x00404000, 0x00002000 },
+    { 0x00000000, 0x00202000 }, { 0x00004000, 0x00202000 },
+    { 0x00400000, 0x00202000 }, { 0x00404000, 0x00202000 }
+    },
+    {  /* key nibble 4 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00004000 },
+    { 0x00000000, 0x00000040 }, { 0x00000000, 0x00004040 },
+    { 0x00000000, 0x00000004 }, { 0x00000000, 0x00004004 },
+    { 0x00000000, 0x00000044 }, { 0x00000000, 0x00004044 },
+    { 0x00000040, 0x00000000 }, { 0x00000040, 0x00004000 },
+    { 0x00000040, 0x00000040 }, { 0x00000040, 0x00004040 },
+    { 0x00000040, 0x00000004 }, { 0x00000040, 0x00004004 },
+    { 0x00000040, 0x00000044 }, { 0x00000040, 0x00004044 }
+    },
+    {  /* key nibble 5 */
+    { 0x00000000, 0x00000000 }, { 0x00000080, 0x00000000 },
+    { 0x00008000, 0x00000000 }, { 0x00008080, 0x00000000 },
+    { 0x00800000, 0x00000000 }, { 0x00800080, 0x00000000 },
+    { 0x00808000, 0x00000000 }, { 0x00808080, 0x00000000 },
+    { 0x00000000, 0x00400000 }, { 0x00000080, 0x00400000 },
+    { 0x00008000, 0x00400000 }, { 0x00008080, 0x00400000 },
+    { 0x00800000, 0x00400000 }, { 0x00800080, 0x00400000 },
+    { 0x00808000, 0x00400000 }, { 0x00808080, 0x00400000 }
+    },
+    {  /* key nibble 6 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00800000 },
+    { 0x00000000, 0x00008000 }, { 0x00000000, 0x00808000 },
+    { 0x00000000, 0x00000080 }, { 0x00000000, 0x00800080 },
+    { 0x00000000, 0x00008080 }, { 0x00000000, 0x00808080 },
+    { 0x00000000, 0x00000008 }, { 0x00000000, 0x00800008 },
+    { 0x00000000, 0x00008008 }, { 0x00000000, 0x00808008 },
+    { 0x00000000, 0x00000088 }, { 0x00000000, 0x00800088 },
+    { 0x00000000, 0x00008088 }, { 0x00000000, 0x00808088 }
+    },
+    {  /* key nibble 7 */
+    { 0x00000000, 0x00000000 }, { 0x00000001, 0x00000000 },
+    { 0x00000100, 0x00000000 }, { 0x00000101, 0x00000000 },
+    { 0x00010000, 0x00000000 }, { 0x00010001, 0x00000000 },
+    { 0x00010100, 0x00000000 }, { 0x00010101, 0x00000000 },
+    { 0x01000000, 0x00000000 }, { 0x01000001, 0x00000000 },
+    { 0x01000100, 0x00000000 }, { 0x01000101, 0x00000000 },
+    { 0x01010000, 0x00000000 }, { 0x01010001, 0x00000000 },
+    { 0x01010100, 0x00000000 }, { 0x01010101, 0x00000000 }
+    },
+    {  /* key nibble 8 */
+    { 0x00000000, 0x00000000 }, { 0x02000000, 0x00000000 },
+    { 0x00000000, 0x01000000 }, { 0x02000000, 0x01000000 },
+    { 0x00000000, 0x00010000 }, { 0x02000000, 0x00010000 },
+    { 0x00000000, 0x01010000 }, { 0x02000000, 0x01010000 },
+    { 0x00000000, 0x00000100 }, { 0x02000000, 0x00000100 },
+    { 0x00000000, 0x01000100 }, { 0x02000000, 0x01000100 },
+    { 0x00000000, 0x00010100 }, { 0x02000000, 0x00010100 },
+    { 0x00000000, 0x01010100 }, { 0x02000000, 0x01010100 }
+    },
+    {  /* key nibble 9 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000200 },
+    { 0x00000002, 0x00000000 }, { 0x00000002, 0x00000200 },
+    { 0x00000200, 0x00000000 }, { 0x00000200, 0x00000200 },
+    { 0x00000202, 0x00000000 }, { 0x00000202, 0x00000200 },
+    { 0x00020000, 0x00000000 }, { 0x00020000, 0x00000200 },
+    { 0x00020002, 0x00000000 }, { 0x00020002, 0x00000200 },
+    { 0x00020200, 0x00000000 }, { 0x00020200, 0x00000200 },
+    { 0x00020202, 0x00000000 }, { 0x00020202, 0x00000200 }
+    },
+    {  /* key nibble 10 */
+    { 0x00000000, 0x00000000 }, { 0x00040000, 0x00000000 },
+    { 0x04000000, 0x00000000 }, { 0x04040000, 0x00000000 },
+    { 0x00000000, 0x02000000 }, { 0x00040000, 0x02000000 },
+    { 0x04000000, 0x02000000 }, { 0x04040000, 0x02000000 },
+    { 0x00000000, 0x00020000 }, { 0x00040000, 0x00020000 },
+    { 0x04000000, 0x00020000 }, { 0x04040000, 0x00020000 },
+    { 0x00000000, 0x02020000 }, { 0x00040000, 0x02020000 },
+    { 0x04000000, 0x02020000 }, { 0x04040000, 0x02020000 }
+    },
+    {  /* key nibble 11 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00040000 },
+    { 0x00000000, 0x00000400 }, { 0x00000000, 0x00040400 },
+    { 0x00000004, 0x00000000 }, { 0x00000004, 0x00040000 },
+    { 0x00000004, 0x00000400 }, { 0x00000004, 0x00040400 },
+    { 0x00000400, 0x00000000 }, { 0x00000400, 0x00040000 },
+    { 0x00000400, 0x00000400 }, { 0x00000400, 0x00040400 },
+    { 0x00000404, 0x00000000 }, { 0x00000404, 0x00040000 },
+    { 0x00000404, 0x00000400 }, { 0x00000404, 0x00040400 }
+    },
+    {  /* key nibble 12 */
+    { 0x00000000, 0x00000000 }, { 0x00000800, 0x00000000 },
+    { 0x00080000, 0x00000000 }, { 0x00080800, 0x00000000 },
+    { 0x08000000, 0x00000000 }, { 0x08000800, 0x00000000 },
+    { 0x08080000, 0x00000000 }, { 0x08080800, 0x00000000 },
+    { 0x00000000, 0x04000000 }, { 0x00000800, 0x04000000 },
+    { 0x00080000, 0x04000000 }, { 0x00080800, 0x04000000 },
+    { 0x08000000, 0x04000000 }, { 0x08000800, 0x04000000 },
+    { 0x08080000, 0x04000000 }, { 0x08080800, 0x04000000 }
+    },
+    {  /* key nibble 13 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x08000000 },
+    { 0x00000000, 0x00080000 }, { 0x00000000, 0x08080000 },
+    { 0x00000000, 0x00000800 }, { 0x00000000, 0x08000800 },
+    { 0x00000000, 0x00080800 }, { 0x00000000, 0x08080800 },
+    { 0x00000008, 0x00000000 }, { 0x00000008, 0x08000000 },
+    { 0x00000008, 0x00080000 }, { 0x00000008, 0x08080000 },
+    { 0x00000008, 0x00000800 }, { 0x00000008, 0x08000800 },
+    { 0x00000008, 0x00080800 }, { 0x00000008, 0x08080800 }
+    }
   };
 
 
@@ -163,112 +325,390 @@ static const uint8_t KeyRotation[16] =
 
 
 /* Key compression table.
- * This table is used to select 48 of the 56 bits of the key.
- * The left and right halves of the source text are each 32 bits,
- * but they are expanded to 48 bits and the results are XOR'd
- * against the compressed (48-bit) key.
- */
-static const uint8_t KeyCompression[48] =
-  {
-  13, 16, 10, 23,  0,  4,  2, 27,
-  14,  5, 20,  9, 22, 18, 11,  3,
-  25,  7, 15,  6, 26, 19, 12,  1,
-  40, 51, 30, 36, 46, 54, 29, 39,
-  50, 44, 32, 47, 43, 48, 38, 55,
-  33, 52, 45, 41, 49, 35, 28, 31
-  };
-
-
-/* Data expansion table.
- * This table is used after the data block (64-bits) has been split
- * into two 32-bit (4-byte) halves (generally denoted L and R).
- * Each 32-bit half is "expanded", using this table, to a 48 bit
- * data block, which is then XOR'd with the 48 bit subkey for the
- * round.
+ * This table is used to select 48 of the 56 bits of the key, producing
+ * the subkey for a round.  Each row represents one nibble of the 56-bit
+ * { C, D } key (rows 0..6 are C, rows 7..13 are D).
+ *
+ * The subkey is not stored as a simple string of 48 bits.  It is XOR'd
+ * against the expanded right half of the data block, which is made up of
+ * eight overlapping 6-bit groups.  The expansion is done by rotating the
+ * right half so that four non-overlapping groups line up at bit positions
+ * 26, 18, 10, and 2 (see auth_DESencrypt(), below).  The subkey groups are laid
+ * out the same way:  groups 0, 2, 4, and 6 go into the first value of each
+ * pair, and groups 1, 3, 5, and 7 go into the second.
  */
-static const uint8_t DataExpansion[48] =
+static const uint32_t PC2tab[14][16][2] =
   {
-  31,  0,  1,  2,  3,  4,  3,  4,
-   5,  6,  7,  8,  7,  8,  9, 10,
-  11, 12, 11, 12, 13, 14, 15, 16,
-  15, 16, 17, 18, 19, 20, 19, 20,
-  21, 22, 23, 24, 23, 24, 25, 26,
-  27, 28, 27, 28, 29, 30, 31,  0
+    {  /* CD nibble 0 */
+    { 0x00000000, 0x00000000 }, { 0x00100000, 0x00000000 },
+    { 0x00000000, 0x80000000 }, { 0x00100000, 0x80000000 },
+    { 0x00000000, 0x00040000 }, { 0x00100000, 0x00040000 },
+    { 0x00000000, 0x80040000 }, { 0x00100000, 0x80040000 },
+    { 0x08000000, 0x00000000 }, { 0x08100000, 0x00000000 },
+    { 0x08000000, 0x80000000 }, { 0x08100000, 0x80000000 },
+    { 0x08000000, 0x00040000 }, { 0x08100000, 0x00040000 },
+    { 0x08000000, 0x80040000 }, { 0x08100000, 0x80040000 }
+    },
+    {  /* CD nibble 1 */
+    { 0x00000000, 0x00000000 }, { 0x00040000, 0x00000000 },
+    { 0x00000000, 0x00400000 }, { 0x00040000, 0x00400000 },
+    { 0x00000000, 0x10000000 }, { 0x00040000, 0x10000000 },
+    { 0x00000000, 0x10400000 }, { 0x00040000, 0x10400000 },
+    { 0x04000000, 0x00000000 }, { 0x04040000, 0x00000000 },
+    { 0x04000000, 0x00400000 }, { 0x04040000, 0x00400000 },
+    { 0x04000000, 0x10000000 }, { 0x04040000, 0x10000000 },
+    { 0x04000000, 0x10400000 }, { 0x04040000, 0x10400000 }
+    },
+    {  /* CD nibble 2 */
+    { 0x00000000, 0x00000000 }, { 0x00200000, 0x00000000 },
+    { 0x20000000, 0x00000000 }, { 0x20200000, 0x00000000 },
+    { 0x00000000, 0x04000000 }, { 0x00200000, 0x04000000 },
+    { 0x20000000, 0x04000000 }, { 0x20200000, 0x04000000 },
+    { 0x00000000, 0x00000000 }, { 0x00200000, 0x00000000 },
+    { 0x20000000, 0x00000000 }, { 0x20200000, 0x00000000 },
+    { 0x00000000, 0x04000000 }, { 0x00200000, 0x04000000 },
+    { 0x20000000, 0x04000000 }, { 0x20200000, 0x04000000 }
+    },
+    {  /* CD nibble 3 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00800000 },
+    { 0x00000000, 0x20000000 }, { 0x00000000, 0x20800000 },
+    { 0x80000000, 0x00000000 }, { 0x80000000, 0x00800000 },
+    { 0x80000000, 0x20000000 }, { 0x80000000, 0x20800000 },
+    { 0x00000000, 0x00080000 }, { 0x00000000, 0x00880000 },
+    { 0x00000000, 0x20080000 }, { 0x00000000, 0x20880000 },
+    { 0x80000000, 0x00080000 }, { 0x80000000, 0x00880000 },
+    { 0x80000000, 0x20080000 }, { 0x80000000, 0x20880000 }
+    },
+    {  /* CD nibble 4 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00100000 },
+    { 0x00400000, 0x00000000 }, { 0x00400000, 0x00100000 },
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00100000 },
+    { 0x00400000, 0x00000000 }, { 0x00400000, 0x00100000 },
+    { 0x40000000, 0x00000000 }, { 0x40000000, 0x00100000 },
+    { 0x40400000, 0x00000000 }, { 0x40400000, 0x00100000 },
+    { 0x40000000, 0x00000000 }, { 0x40000000, 0x00100000 },
+    { 0x40400000, 0x00000000 }, { 0x40400000, 0x00100000 }
+    },
+    {  /* CD nibble 5 */
+    { 0x00000000, 0x00000000 }, { 0x10000000, 0x00000000 },
+    { 0x00800000, 0x00000000 }, { 0x10800000, 0x00000000 },
+    { 0x00000000, 0x00000000 }, { 0x10000000, 0x00000000 },
+    { 0x00800000, 0x00000000 }, { 0x10800000, 0x00000000 },
+    { 0x00000000, 0x08000000 }, { 0x10000000, 0x08000000 },
+    { 0x00800000, 0x08000000 }, { 0x10800000, 0x08000000 },
+    { 0x00000000, 0x08000000 }, { 0x10000000, 0x08000000 },
+    { 0x00800000, 0x08000000 }, { 0x10800000, 0x08000000 }
+    },
+    {  /* CD nibble 6 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x40000000 },
+    { 0x00000000, 0x00200000 }, { 0x00000000, 0x40200000 },
+    { 0x00080000, 0x00000000 }, { 0x00080000, 0x40000000 },
+    { 0x00080000, 0x00200000 }, { 0x00080000, 0x40200000 },
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x40000000 },
+    { 0x00000000, 0x00200000 }, { 0x00000000, 0x40200000 },
+    { 0x00080000, 0x00000000 }, { 0x00080000, 0x40000000 },
+    { 0x00080000, 0x00200000 }, { 0x00080000, 0x40200000 }
+    },
+    {  /* CD nibble 7 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000004 },
+    { 0x00002000, 0x00000000 }, { 0x00002000, 0x00000004 },
+    { 0x00000000, 0x00008000 }, { 0x00000000, 0x00008004 },
+    { 0x00002000, 0x00008000 }, { 0x00002000, 0x00008004 },
+    { 0x00000000, 0x00000008 }, { 0x00000000, 0x0000000c },
+    { 0x00002000, 0x00000008 }, { 0x00002000, 0x0000000c },
+    { 0x00000000, 0x00008008 }, { 0x00000000, 0x0000800c },
+    { 0x00002000, 0x00008008 }, { 0x00002000, 0x0000800c }
+    },
+    {  /* CD nibble 8 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000010 },
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000010 },
+    { 0x00000008, 0x00000000 }, { 0x00000008, 0x00000010 },
+    { 0x00000008, 0x00000000 }, { 0x00000008, 0x00000010 },
+    { 0x00000000, 0x00000800 }, { 0x00000000, 0x00000810 },
+    { 0x00000000, 0x00000800 }, { 0x00000000, 0x00000810 },
+    { 0x00000008, 0x00000800 }, { 0x00000008, 0x00000810 },
+    { 0x00000008, 0x00000800 }, { 0x00000008, 0x00000810 }
+    },
+    {  /* CD nibble 9 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00004000 },
+    { 0x00000020, 0x00000000 }, { 0x00000020, 0x00004000 },
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00004000 },
+    { 0x00000020, 0x00000000 }, { 0x00000020, 0x00004000 },
+    { 0x00001000, 0x00000000 }, { 0x00001000, 0x00004000 },
+    { 0x00001020, 0x00000000 }, { 0x00001020, 0x00004000 },
+    { 0x00001000, 0x00000000 }, { 0x00001000, 0x00004000 },
+    { 0x00001020, 0x00000000 }, { 0x00001020, 0x00004000 }
+    },
+    {  /* CD nibble 10 */
+    { 0x00000000, 0x00000000 }, { 0x00000080, 0x00000000 },
+    { 0x00000000, 0x00000000 }, { 0x00000080, 0x00000000 },
+    { 0x00000000, 0x00000040 }, { 0x00000080, 0x00000040 },
+    { 0x00000000, 0x00000040 }, { 0x00000080, 0x00000040 },
+    { 0x00008000, 0x00000000 }, { 0x00008080, 0x00000000 },
+    { 0x00008000, 0x00000000 }, { 0x00008080, 0x00000000 },
+    { 0x00008000, 0x00000040 }, { 0x00008080, 0x00000040 },
+    { 0x00008000, 0x00000040 }, { 0x00008080, 0x00000040 }
+    },
+    {  /* CD nibble 11 */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x00000400 },
+    { 0x00000800, 0x00000000 }, { 0x00000800, 0x00000400 },
+    { 0x00000000, 0x00000080 }, { 0x00000000, 0x00000480 },
+    { 0x00000800, 0x00000080 }, { 0x00000800, 0x00000480 },
+    { 0x00000000, 0x00001000 }, { 0x00000000, 0x00001400 },
+    { 0x00000800, 0x00001000 }, { 0x00000800, 0x00001400 },
+    { 0x00000000, 0x00001080 }, { 0x00000000, 0x00001480 },
+    { 0x00000800, 0x00001080 }, { 0x00000800, 0x00001480 }
+    },
+    {  /* CD nibble 12 */
+    { 0x00000000, 0x00000000 }, { 0x00004000, 0x00000000 },
+    { 0x00000000, 0x00002000 }, { 0x00004000, 0x00002000 },
+    { 0x00000000, 0x00000020 }, { 0x00004000, 0x00000020 },
+    { 0x00000000, 0x00002020 }, { 0x00004000, 0x00002020 },
+    { 0x00000040, 0x00000000 }, { 0x00004040, 0x00000000 },
+    { 0x00000040, 0x00002000 }, { 0x00004040, 0x00002000 },
+    { 0x00000040, 0x00000020 }, { 0x00004040, 0x00000020 },
+    { 0x00000040, 0x00002020 }, { 0x00004040, 0x00002020 }
+    },
+    {  /* CD nibble 13 */
+    { 0x00000000, 0x00000000 }, { 0x00000010, 0x00000000 },
+    { 0x00000400, 0x00000000 }, { 0x00000410, 0x00000000 },
+    { 0x00000000, 0x00000000 }, { 0x00000010, 0x00000000 },
+    { 0x00000400, 0x00000000 }, { 0x00000410, 0x00000000 },
+    { 0x00000004, 0x00000000 }, { 0x00000014, 0x00000000 },
+    { 0x00000404, 0x00000000 }, { 0x00000414, 0x00000000 },
+    { 0x00000004, 0x00000000 }, { 0x00000014, 0x00000000 },
+    { 0x00000404, 0x00000000 }, { 0x00000414, 0x00000000 }
+    }
   };
 
 
-/* The (in)famous S-boxes.
- * These are used to perform substitutions.
- * Six bits worth of input will return four bits of output.
- * The four bit values are stored in these tables.  Each table has
- * 64 entries...and 6 bits provides a number between 0 and 63.
- * There are eight S-boxes, one per 6 bits of a 48-bit value.
- * Thus, 48 bits are reduced to 32 bits.  Obviously, this step
- * follows the DataExpansion step.
- *
- * Note that the literature generally shows this as 8 arrays each
- * with four rows and 16 colums.  There is a complex formula for
- * mapping the 6 bit input values to the correct row and column.
- * I've pre-computed that mapping, and the tables below provide
- * direct 6-bit input to 4-bit output.  See pp 274-274 in Schneier.
+/* The (in)famous S-boxes, combined with the P-Box permutation.
+ * The S-boxes are used to perform substitutions.  Six bits worth of input
+ * will return four bits of output.  There are eight S-boxes, one per 6 bits
+ * of a 48-bit value.  Thus, 48 bits are reduced to 32 bits.  The result is
+ * then rearranged by the P-Box permutation.
+ *
+ * The P-Box permutation moves bits, but never combines them, so it can be
+ * applied to each S-Box output separately and the results OR'd together.
+ * That's what is stored here:  each entry is the 4-bit S-Box output value,
+ * already placed in its final (post P-Box) position within the 32-bit
+ * result.
+ *
+ * Note that the literature generally shows the S-boxes as 8 arrays each
+ * with four rows and 16 colums.  There is a complex formula for mapping
+ * the 6 bit input values to the correct row and column.  That mapping has
+ * been pre-computed, and the tables below provide direct 6-bit input to
+ * 32-bit output.  See pp 274-274 in Schneier.
  */
-static const uint8_t SBox[8][64] =
+static const uint32_t SPtab[8][64] =
   {
     {  /* S0 */
-    14,  0,  4, 15, 13,  7,  1,  4,  2, 14, 15,  2, 11, 13,  8,  1,
-     3, 10, 10,  6,  6, 12, 12, 11,  5,  9,  9,  5,  0,  3,  7,  8,
-     4, 15,  1, 12, 14,  8,  8,  2, 13,  4,  6,  9,  2,  1, 11,  7,
-    15,  5, 12, 11,  9,  3,  7, 14,  3, 10, 10,  0,  5,  6,  0, 13
+    0x00808200, 0x00000000, 0x00008000, 0x00808202,
+    0x00808002, 0x00008202, 0x00000002, 0x00008000,
+    0x00000200, 0x00808200, 0x00808202, 0x00000200,
+    0x00800202, 0x00808002, 0x00800000, 0x00000002,
+    0x00000202, 0x00800200, 0x00800200, 0x00008200,
+    0x00008200, 0x00808000, 0x00808000, 0x00800202,
+    0x00008002, 0x00800002, 0x00800002, 0x00008002,
+    0x00000000, 0x00000202, 0x00008202, 0x00800000,
+    0x00008000, 0x00808202, 0x00000002, 0x00808000,
+    0x00808200, 0x00800000, 0x00800000, 0x00000200,
+    0x00808002, 0x00008000, 0x00008200, 0x00800002,
+    0x00000200, 0x00000002, 0x00800202, 0x00008202,
+    0x00808202, 0x00008002, 0x00808000, 0x00800202,
+    0x00800002, 0x00000202, 0x00008202, 0x00808200,
+    0x00000202, 0x00800200, 0x00800200, 0x00000000,
+    0x00008002, 0x00008200, 0x00000000, 0x00808002
     },
     {  /* S1 */
-    15,  3,  1, 13,  8,  4, 14,  7,  6, 15, 11,  2,  3,  8,  4, 14,
-     9, 12,  7,  0,  2,  1, 13, 10, 12,  6,  0,  9,  5, 11, 10,  5,
-     0, 13, 14,  8,  7, 10, 11,  1, 10,  3,  4, 15, 13,  4,  1,  2,
-     5, 11,  8,  6, 12,  7,  6, 12,  9,  0,  3,  5,  2, 14, 15,  9
+    0x40084010, 0x40004000, 0x00004000, 0x00084010,
+    0x00080000, 0x00000010, 0x40080010, 0x40004010,
+    0x40000010, 0x40084010, 0x40084000, 0x40000000,
+    0x40004000, 0x00080000, 0x00000010, 0x40080010,
+    0x00084000, 0x00080010, 0x40004010, 0x00000000,
+    0x40000000, 0x00004000, 0x00084010, 0x40080000,
+    0x00080010, 0x40000010, 0x00000000, 0x00084000,
+    0x00004010, 0x40084000, 0x40080000, 0x00004010,
+    0x00000000, 0x00084010, 0x40080010, 0x00080000,
+    0x40004010, 0x40080000, 0x40084000, 0x00004000,
+    0x40080000, 0x40004000, 0x00000010, 0x40084010,
+    0x00084010, 0x00000010, 0x00004000, 0x40000000,
+    0x00004010, 0x40084000, 0x00080000, 0x40000010,
+    0x00080010, 0x40004010, 0x40000010, 0x00080010,
+    0x00084000, 0x00000000, 0x40004000, 0x00004010,
+    0x40000000, 0x40080010, 0x40084010, 0x00084000
     },
     {  /* S2 */
-    10, 13,  0,  7,  9,  0, 14,  9,  6,  3,  3,  4, 15,  6,  5, 10,
-     1,  2, 13,  8, 12,  5,  7, 14, 11, 12,  4, 11,  2, 15,  8,  1,
-    13,  1,  6, 10,  4, 13,  9,  0,  8,  6, 15,  9,  3,  8,  0,  7,
-    11,  4,  1, 15,  2, 14, 12,  3,  5, 11, 10,  5, 14,  2,  7, 12
+    0x00000104, 0x04010100, 0x00000000, 0x04010004,
+    0x04000100, 0x00000000, 0x00010104, 0x04000100,
+    0x00010004, 0x04000004, 0x04000004, 0x00010000,
+    0x04010104, 0x00010004, 0x04010000, 0x00000104,
+    0x04000000, 0x00000004, 0x04010100, 0x00000100,
+    0x00010100, 0x04010000, 0x04010004, 0x00010104,
+    0x04000104, 0x00010100, 0x00010000, 0x04000104,
+    0x00000004, 0x04010104, 0x00000100, 0x04000000,
+    0x04010100, 0x04000000, 0x00010004, 0x00000104,
+    0x00010000, 0x04010100, 0x04000100, 0x00000000,
+    0x00000100, 0x00010004, 0x04010104, 0x04000100,
+    0x04000004, 0x00000100, 0x00000000, 0x04010004,
+    0x04000104, 0x00010000, 0x04000000, 0x04010104,
+    0x00000004, 0x00010104, 0x00010100, 0x04000004,
+    0x04010000, 0x04000104, 0x00000104, 0x04010000,
+    0x00010104, 0x00000004, 0x04010004, 0x00010100
     },
     {  /* S3 */
-     7, 13, 13,  8, 14, 11,  3,  5,  0,  6,  6, 15,  9,  0, 10,  3,
-     1,  4,  2,  7,  8,  2,  5, 12, 11,  1, 12, 10,  4, 14, 15,  9,
-    10,  3,  6, 15,  9,  0,  0,  6, 12, 10, 11,  1,  7, 13, 13,  8,
-    15,  9,  1,  4,  3,  5, 14, 11,  5, 12,  2,  7,  8,  2,  4, 14
+    0x80401000, 0x80001040, 0x80001040, 0x00000040,
+    0x00401040, 0x80400040, 0x80400000, 0x80001000,
+    0x00000000, 0x00401000, 0x00401000, 0x80401040,
+    0x80000040, 0x00000000, 0x00400040, 0x80400000,
+    0x80000000, 0x00001000, 0x00400000, 0x80401000,
+    0x00000040, 0x00400000, 0x80001000, 0x00001040,
+    0x80400040, 0x80000000, 0x00001040, 0x00400040,
+    0x00001000, 0x00401040, 0x80401040, 0x80000040,
+    0x00400040, 0x80400000, 0x00401000, 0x80401040,
+    0x80000040, 0x00000000, 0x00000000, 0x00401000,
+    0x00001040, 0x00400040, 0x80400040, 0x80000000,
+    0x80401000, 0x80001040, 0x80001040, 0x00000040,
+    0x80401040, 0x80000040, 0x80000000, 0x00001000,
+    0x80400000, 0x80001000, 0x00401040, 0x80400040,
+    0x80001000, 0x00001040, 0x00400000, 0x80401000,
+    0x00000040, 0x00400000, 0x00001000, 0x00401040
     },
     {  /* S4 */
-     2, 14, 12, 11,  4,  2,  1, 12,  7,  4, 10,  7, 11, 13,  6,  1,
-     8,  5,  5,  0,  3, 15, 15, 10, 13,  3,  0,  9, 14,  8,  9,  6,
-     4, 11,  2,  8,  1, 12, 11,  7, 10,  1, 13, 14,  7,  2,  8, 13,
-    15,  6,  9, 15, 12,  0,  5,  9,  6, 10,  3,  4,  0,  5, 14,  3
+    0x00000080, 0x01040080, 0x01040000, 0x21000080,
+    0x00040000, 0x00000080, 0x20000000, 0x01040000,
+    0x20040080, 0x00040000, 0x01000080, 0x20040080,
+    0x21000080, 0x21040000, 0x00040080, 0x20000000,
+    0x01000000, 0x20040000, 0x20040000, 0x00000000,
+    0x20000080, 0x21040080, 0x21040080, 0x01000080,
+    0x21040000, 0x20000080, 0x00000000, 0x21000000,
+    0x01040080, 0x01000000, 0x21000000, 0x00040080,
+    0x00040000, 0x21000080, 0x00000080, 0x01000000,
+    0x20000000, 0x01040000, 0x21000080, 0x20040080,
+    0x01000080, 0x20000000, 0x21040000, 0x01040080,
+    0x20040080, 0x00000080, 0x01000000, 0x21040000,
+    0x21040080, 0x00040080, 0x21000000, 0x21040080,
+    0x01040000, 0x00000000, 0x20040000, 0x21000000,
+    0x00040080, 0x01000080, 0x20000080, 0x00040000,
+    0x00000000, 0x20040000, 0x01040080, 0x20000080
     },
     {  /* S5 */
-    12, 10,  1, 15, 10,  4, 15,  2,  9,  7,  2, 12,  6,  9,  8,  5,
-     0,  6, 13,  1,  3, 13,  4, 14, 14,  0,  7, 11,  5,  3, 11,  8,
-     9,  4, 14,  3, 15,  2,  5, 12,  2,  9,  8,  5, 12, 15,  3, 10,
-     7, 11,  0, 14,  4,  1, 10,  7,  1,  6, 13,  0, 11,  8,  6, 13
+    0x10000008, 0x10200000, 0x00002000, 0x10202008,
+    0x10200000, 0x00000008, 0x10202008, 0x00200000,
+    0x10002000, 0x00202008, 0x00200000, 0x10000008,
+    0x00200008, 0x10002000, 0x10000000, 0x00002008,
+    0x00000000, 0x00200008, 0x10002008, 0x00002000,
+    0x00202000, 0x10002008, 0x00000008, 0x10200008,
+    0x10200008, 0x00000000, 0x00202008, 0x10202000,
+    0x00002008, 0x00202000, 0x10202000, 0x10000000,
+    0x10002000, 0x00000008, 0x10200008, 0x00202000,
+    0x10202008, 0x00200000, 0x00002008, 0x10000008,
+    0x00200000, 0x10002000, 0x10000000, 0x00002008,
+    0x10000008, 0x10202008, 0x00202000, 0x10200000,
+    0x00202008, 0x10202000, 0x00000000, 0x10200008,
+    0x00000008, 0x00002000, 0x10200000, 0x00202008,
+    0x00002000, 0x00200008, 0x10002008, 0x00000000,
+    0x10202000, 0x10000000, 0x00200008, 0x10002008
     },
     {  /* S6 */
-     4, 13, 11,  0,  2, 11, 14,  7, 15,  4,  0,  9,  8,  1, 13, 10,
-     3, 14, 12,  3,  9,  5,  7, 12,  5,  2, 10, 15,  6,  8,  1,  6,
-     1,  6,  4, 11, 11, 13, 13,  8, 12,  1,  3,  4,  7, 10, 14,  7,
-    10,  9, 15,  5,  6,  0,  8, 15,  0, 14,  5,  2,  9,  3,  2, 12
+    0x00100000, 0x02100001, 0x02000401, 0x00000000,
+    0x00000400, 0x02000401, 0x00100401, 0x02100400,
+    0x02100401, 0x00100000, 0x00000000, 0x02000001,
+    0x00000001, 0x02000000, 0x02100001, 0x00000401,
+    0x02000400, 0x00100401, 0x00100001, 0x02000400,
+    0x02000001, 0x02100000, 0x02100400, 0x00100001,
+    0x02100000, 0x00000400, 0x00000401, 0x02100401,
+    0x00100400, 0x00000001, 0x02000000, 0x00100400,
+    0x02000000, 0x00100400, 0x00100000, 0x02000401,
+    0x02000401, 0x02100001, 0x02100001, 0x00000001,
+    0x00100001, 0x02000000, 0x02000400, 0x00100000,
+    0x02100400, 0x00000401, 0x00100401, 0x02100400,
+    0x00000401, 0x02000001, 0x02100401, 0x02100000,
+    0x00100400, 0x00000000, 0x00000001, 0x02100401,
+    0x00000000, 0x00100401, 0x02100000, 0x00000400,
+    0x02000001, 0x02000400, 0x00000400, 0x00100001
     },
     {  /* S7 */
-    13,  1,  2, 15,  8, 13,  4,  8,  6, 10, 15,  3, 11,  7,  1,  4,
-    10, 12,  9,  5,  3,  6, 14, 11,  5,  0,  0, 14, 12,  9,  7,  2,
-     7,  2, 11,  1,  4, 14,  1,  7,  9,  4, 12, 10, 14,  8,  2, 13,
-     0, 15,  6, 12, 10,  9, 13,  0, 15,  3,  3,  5,  5,  6,  8, 11
+    0x08000820, 0x00000800, 0x00020000, 0x08020820,
+    0x08000000, 0x08000820, 0x00000020, 0x08000000,
+    0x00020020, 0x08020000, 0x08020820, 0x00020800,
+    0x08020800, 0x00020820, 0x00000800, 0x00000020,
+    0x08020000, 0x08000020, 0x08000800, 0x00000820,
+    0x00020800, 0x00020020, 0x08020020, 0x08020800,
+    0x00000820, 0x00000000, 0x00000000, 0x08020020,
+    0x08000020, 0x08000800, 0x00020820, 0x00020000,
+    0x00020820, 0x00020000, 0x08020800, 0x00000800,
+    0x00000020, 0x08020020, 0x00000800, 0x00020820,
+    0x08000800, 0x00000020, 0x08000020, 0x08020000,
+    0x08020020, 0x08000000, 0x00020000, 0x08000820,
+    0x00000000, 0x08020820, 0x00020020, 0x08000020,
+    0x08020000, 0x08000800, 0x08000820, 0x00000000,
+    0x08020820, 0x00020800, 0x00020800, 0x00000820,
+    0x00000820, 0x00020020, 0x08000000, 0x08020800
     }
   };
 
 
-/* P-Box permutation.
- * This permutation is applied to the result of the S-Box Substitutions.
- * It's a straight-forward re-arrangement of the bits.
+/* Final permutation table.
+ * The penultimate step in DES is to swap the left and right hand sides of
+ * the ciphertext.  The inverse of the Initial Permutation is then applied
+ * to produce the final result.  To save a step, this table does the
+ * left/right swap as well as the inverse permutation.
+ *
+ * As with the initial permutation, the bits of each input byte all wind up
+ * in the same bit column, so only the first byte's nibbles are stored here.
+ * The results for the other bytes are shifted right by FPshift[] bits.
+ */
+static const uint32_t FPtab[2][16][2] =
+  {
+    {  /* high nibble */
+    { 0x00000000, 0x00000000 }, { 0x00000000, 0x80000000 },
+    { 0x00000000, 0x00800000 }, { 0x00000000, 0x80800000 },
+    { 0x00000000, 0x00008000 }, { 0x00000000, 0x80008000 },
+    { 0x00000000, 0x00808000 }, { 0x00000000, 0x80808000 },
+    { 0x00000000, 0x00000080 }, { 0x00000000, 0x80000080 },
+    { 0x00000000, 0x00800080 }, { 0x00000000, 0x80800080 },
+    { 0x00000000, 0x00008080 }, { 0x00000000, 0x80008080 },
+    { 0x00000000, 0x00808080 }, { 0x00000000, 0x80808080 }
+    },
+    {  /* low nibble */
+    { 0x00000000, 0x00000000 }, { 0x80000000, 0x00000000 },
+    { 0x00800000, 0x00000000 }, { 0x80800000, 0x00000000 },
+    { 0x00008000, 0x00000000 }, { 0x80008000, 0x00000000 },
+    { 0x00808000, 0x00000000 }, { 0x80808000, 0x00000000 },
+    { 0x00000080, 0x00000000 }, { 0x80000080, 0x00000000 },
+    { 0x00800080, 0x00000000 }, { 0x80800080, 0x00000000 },
+    { 0x00008080, 0x00000000 }, { 0x80008080, 0x00000000 },
+    { 0x00808080, 0x00000000 }, { 0x80808080, 0x00000000 }
+    }
+  };
+
+static const uint8_t FPshift[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+
+
+/* Bitsliced DES maps.
+ * The batch function, auth_DEShashN(), does not use the lookup tables
+ * above.  A bitsliced implementation works one bit position at a time
+ * across many blocks, so permutations cost nothing more than choosing
+ * which array element to read.  It needs the plain maps, given here with
+ * zero-based bit numbering.
+ *
+ * InitialPermuteMap[] is the standard initial permutation.  The final
+ * permutation is its inverse, so the same map is used in reverse at the
+ * end.  PBox[] is the standard P-Box permutation.
  */
+static const uint8_t InitialPermuteMap[64] =
+  {
+  57, 49, 41, 33, 25, 17,  9, 1,
+  59, 51, 43, 35, 27, 19, 11, 3,
+  61, 53, 45, 37, 29, 21, 13, 5,
+  63, 55, 47, 39, 31, 23, 15, 7,
+  56, 48, 40, 32, 24, 16,  8, 0,
+  58, 50, 42, 34, 26, 18, 10, 2,
+  60, 52, 44, 36, 28, 20, 12, 4,
+  62, 54, 46, 38, 30, 22, 14, 6
+  };
+
 static const uint8_t PBox[32] =
   {
   15,  6, 19, 20, 28, 11, 27, 16,
@@ -277,45 +717,116 @@ static const uint8_t PBox[32] =
   18, 12, 29,  5, 21, 10,  3, 24
   };
 
-
-/* Final permutation map.
- * This is supposed to be the inverse of the Initial Permutation,
- * but there's been a bit of fiddling done.
- * As always, the values given are one less than those in the literature
- * (because C starts counting from 0, not 1).  In addition, the penultimate
- * step in DES is to swap the left and right hand sides of the ciphertext.
- * The inverse of the Initial Permutation is then applied to produce the
- * final result.
- * To save a step, the map below does the left/right swap as well as the
- * inverse permutation.
+/* Bitsliced key schedule.
+ * In the bitsliced form, each subkey bit is just one of the 56 bits of the
+ * original 7-byte key.  This table, which was computed from the key
+ * permutation, key rotation, and key compression maps, gives the key bit
+ * used for each of the 48 subkey bits in each of the sixteen rounds.
  */
-static const uint8_t FinalPermuteMap[64] =
+static const uint8_t KeyBits[16][48] =
   {
-   7, 39, 15, 47, 23, 55, 31, 63,
-   6, 38, 14, 46, 22, 54, 30, 62,
-   5, 37, 13, 45, 21, 53, 29, 61,
-   4, 36, 12, 44, 20, 52, 28, 60,
-   3, 35, 11, 43, 19, 51, 27, 59,
-   2, 34, 10, 42, 18, 50, 26, 58,
-   1, 33,  9, 41, 17, 49, 25, 57,
-   0, 32,  8, 40, 16, 48, 24, 56
+    {  /* Round 0 */
+     8, 44, 29, 52, 42, 14, 28, 49,  1,  7, 16, 36,
+     2, 30, 22, 21, 38, 50, 51,  0, 31, 23, 15, 35,
+    19, 24, 34, 47, 32,  3, 41, 26,  4, 46, 20, 25,
+    53, 18, 33, 55, 13, 17, 39, 12, 11, 54, 48, 27
+    },
+    {  /* Round 1 */
+     1, 37, 22, 45, 35,  7, 21, 42, 51,  0,  9, 29,
+    52, 23, 15, 14, 31, 43, 44, 50, 49, 16,  8, 28,
+    12, 17, 27, 40, 25, 55, 34, 19, 24, 39, 13, 18,
+    46, 11, 26, 48,  6, 10, 32,  5,  4, 47, 41, 20
+    },
+    {  /* Round 2 */
+    44, 23,  8, 31, 21, 50,  7, 28, 37, 43, 52, 15,
+    38,  9,  1,  0, 42, 29, 30, 36, 35,  2, 51, 14,
+    53,  3, 13, 26, 11, 41, 20,  5, 10, 25, 54,  4,
+    32, 24, 12, 34, 47, 55, 18, 46, 17, 33, 27,  6
+    },
+    {  /* Round 3 */
+    30,  9, 51, 42,  7, 36, 50, 14, 23, 29, 38,  1,
+    49, 52, 44, 43, 28, 15, 16, 22, 21, 45, 37,  0,
+    39, 48, 54, 12, 24, 27,  6, 46, 55, 11, 40, 17,
+    18, 10, 53, 20, 33, 41,  4, 32,  3, 19, 13, 47
+    },
+    {  /* Round 4 */
+    16, 52, 37, 28, 50, 22, 36,  0,  9, 15, 49, 44,
+    35, 38, 30, 29, 14,  1,  2,  8,  7, 31, 23, 43,
+    25, 34, 40, 53, 10, 13, 47, 32, 41, 24, 26,  3,
+     4, 55, 39,  6, 19, 27, 17, 18, 48,  5, 54, 33
+    },
+    {  /* Round 5 */
+     2, 38, 23, 14, 36,  8, 22, 43, 52,  1, 35, 30,
+    21, 49, 16, 15,  0, 44, 45, 51, 50, 42,  9, 29,
+    11, 20, 26, 39, 55, 54, 33, 18, 27, 10, 12, 48,
+    17, 41, 25, 47,  5, 13,  3,  4, 34, 46, 40, 19
+    },
+    {  /* Round 6 */
+    45, 49,  9,  0, 22, 51,  8, 29, 38, 44, 21, 16,
+     7, 35,  2,  1, 43, 30, 31, 37, 36, 28, 52, 15,
+    24,  6, 12, 25, 41, 40, 19,  4, 13, 55, 53, 34,
+     3, 27, 11, 33, 46, 54, 48, 17, 20, 32, 26,  5
+    },
+    {  /* Round 7 */
+    31, 35, 52, 43,  8, 37, 51, 15, 49, 30,  7,  2,
+    50, 21, 45, 44, 29, 16, 42, 23, 22, 14, 38,  1,
+    10, 47, 53, 11, 27, 26,  5, 17, 54, 41, 39, 20,
+    48, 13, 24, 19, 32, 40, 34,  3,  6, 18, 12, 46
+    },
+    {  /* Round 8 */
+    49, 28, 45, 36,  1, 30, 44,  8, 42, 23,  0, 52,
+    43, 14, 38, 37, 22,  9, 35, 16, 15,  7, 31, 51,
+     3, 40, 46,  4, 20, 19, 53, 10, 47, 34, 32, 13,
+    41,  6, 17, 12, 25, 33, 27, 55, 54, 11,  5, 39
+    },
+    {  /* Round 9 */
+    35, 14, 31, 22, 44, 16, 30, 51, 28,  9, 43, 38,
+    29,  0, 49, 23,  8, 52, 21,  2,  1, 50, 42, 37,
+    48, 26, 32, 17,  6,  5, 39, 55, 33, 20, 18, 54,
+    27, 47,  3, 53, 11, 19, 13, 41, 40, 24, 46, 25
+    },
+    {  /* Round 10 */
+    21,  0, 42,  8, 30,  2, 16, 37, 14, 52, 29, 49,
+    15, 43, 35,  9, 51, 38,  7, 45, 44, 36, 28, 23,
+    34, 12, 18,  3, 47, 46, 25, 41, 19,  6,  4, 40,
+    13, 33, 48, 39, 24,  5, 54, 27, 26, 10, 32, 11
+    },
+    {  /* Round 11 */
+     7, 43, 28, 51, 16, 45,  2, 23,  0, 38, 15, 35,
+     1, 29, 21, 52, 37, 49, 50, 31, 30, 22, 14,  9,
+    20, 53,  4, 48, 33, 32, 11, 27,  5, 47, 17, 26,
+    54, 19, 34, 25, 10, 46, 40, 13, 12, 55, 18, 24
+    },
+    {  /* Round 12 */
+    50, 29, 14, 37,  2, 31, 45,  9, 43, 49,  1, 21,
+    44, 15,  7, 38, 23, 35, 36, 42, 16,  8,  0, 52,
+     6, 39, 17, 34, 19, 18, 24, 13, 46, 33,  3, 12,
+    40,  5, 20, 11, 55, 32, 26, 54, 53, 41,  4, 10
+    },
+    {  /* Round 13 */
+    36, 15,  0, 23, 45, 42, 31, 52, 29, 35, 44,  7,
+    30,  1, 50, 49,  9, 21, 22, 28,  2, 51, 43, 38,
+    47, 25,  3, 20,  5,  4, 10, 54, 32, 19, 48, 53,
+    26, 46,  6, 24, 41, 18, 12, 40, 39, 27, 17, 55
+    },
+    {  /* Round 14 */
+    22,  1, 43,  9, 31, 28, 42, 38, 15, 21, 30, 50,
+    16, 44, 36, 35, 52,  7,  8, 14, 45, 37, 29, 49,
+    33, 11, 48,  6, 46, 17, 55, 40, 18,  5, 34, 39,
+    12, 32, 47, 10, 27,  4, 53, 26, 25, 13,  3, 41
+    },
+    {  /* Round 15 */
+    15, 51, 36,  2, 49, 21, 35, 31,  8, 14, 23, 43,
+     9, 37, 29, 28, 45,  0,  1,  7, 38, 30, 22, 42,
+    26,  4, 41, 54, 39, 10, 48, 33, 11, 53, 27, 32,
+     5, 25, 40,  3, 20, 24, 46, 19, 18,  6, 55, 34
+    }
   };
 
 
 /* -------------------------------------------------------------------------- **
  * Macros:
  *
- *  CLRBIT( STR, IDX )
- *    Input:  STR - (uchar *) pointer to an array of 8-bit bytes.
- *            IDX - (int) bitwise index of a bit within the STR array
- *                  that is to be cleared (that is, given a value of 0).
- *    Notes:  This macro clears a bit within an array of bits (which is
- *            built within an array of bytes).
- *          - The macro converts to an assignment of the form A &= B.
- *          - The string of bytes is viewed as an array of bits, read from
- *            highest order bit first.  The highest order bit of a byte
- *            would, therefore, be bit 0 (within that byte).
- *
  *  SETBIT( STR, IDX )
  *    Input:  STR - (uchar *) pointer to an array of 8-bit bytes.
  *            IDX - (int) bitwise index of a bit within the STR array
@@ -333,15 +844,54 @@ static const uint8_t FinalPermuteMap[64] =
  *                  that is to be read.
  *    Output: True (1) if the indexed bit was set, else false (0).
  *
+ *  ROTL28( X, N )
+ *    Input:  X - (uint32_t) A 28-bit key half, in the low-order bits.
+ *            N - (int) Number of bits by which to rotate (1 or 2).
+ *    Output: <X> rotated left by <N> bits within a 28-bit field.
+ *
+ *  ROTL32( X, N )
+ *    Input:  X - (uint32_t) A 32-bit value.
+ *            N - (int) Number of bits by which to rotate (1..31).
+ *    Output: <X> rotated left by <N> bits.
+ *
  * -------------------------------------------------------------------------- **
  */
 
-#define CLRBIT( STR, IDX ) ( (STR)[(IDX)/8] &= ~(0x01 << (7 - ((IDX)%8))) )
-
 #define SETBIT( STR, IDX ) ( (STR)[(IDX)/8] |= (0x01 << (7 - ((IDX)%8))) )
 
 #define GETBIT( STR, IDX ) (( ((STR)[(IDX)/8]) >> (7 - ((IDX)%8)) ) & 0x01)
 
+#define ROTL28( X, N ) \
+  ( 0x0FFFFFFF & (((X) << (N)) | ((X) >> (28 - (N)))) )
+
+#define ROTL32( X, N ) \
+  ( 0xFFFFFFFF & (((X) << (N)) | ((X) >> (32 - (N)))) )
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  DESslice  - A bitsliced DES value.  Bit n of a DESslice holds one bit
+ *              of DES block n, so a whole array of DESslice values can
+ *              carry as many independent DES blocks as there are bits in
+ *              a DESslice.  When the compiler supports vector types, the
+ *              slice is a 128-bit (SSE2) or 256-bit (AVX2) vector.
+ *              Otherwise, an unsigned long is used.  The selection is
+ *              made at compile time.
+ *
+ *  DES_LANES - The number of blocks carried by a DESslice.
+ */
+
+#if defined( __GNUC__ ) && defined( __AVX2__ )
+typedef uint32_t DESslice __attribute__ ((vector_size (32)));
+#elif defined( __GNUC__ ) && defined( __SSE2__ )
+typedef uint32_t DESslice __attribute__ ((vector_size (16)));
+#else
+typedef unsigned long DESslice;
+#endif
+
+#define DES_LANES ((int)(8 * sizeof( DESslice )))
+
 
 /* -------------------------------------------------------------------------- **
  * Static Functions:
@@ -377,6 +927,10 @@ static void Permute( uchar   *dst,
    *          other than 8 bits.  For our purposes we'll stick with 8-bit
    *          bytes.)
    *
+   *        - This is the slow, bit-at-a-time method.  It is now only used
+   *          by auth_DESkey8to7().  The DES rounds use the pre-computed
+   *          tables instead.
+   *
    * ------------------------------------------------------------------------ **
    */
   {
@@ -398,169 +952,408 @@ static void Permute( uchar   *dst,
   } /* Permute */
 
 
-static void KeyShift( uchar *key, const int numbits )
+static void Xpose32( uint32_t M[32] )
   /* ------------------------------------------------------------------------ **
-   * Split the 56-bit key in half & left rotate each half by <numbits> bits.
+   * Transpose a 32x32 matrix of bits, in place.
    *
-   *  Input:  key     - The 56-bit key to be split-rotated.
-   *          numbits - The number of bits by which to rotate the key.
+   *  Input:  M - An array of 32 rows of 32 bits each.
    *
    *  Output: none.
    *
-   *  Notes:  There are probably several better ways to implement this.
+   *  Notes:  Bit <j> (counting from the high-order end) of M[k] becomes
+   *          bit <k> of M[j].  This is used to move data in and out of
+   *          the bitsliced form, 32 blocks at a time.
+   *
+   *        - See "Hacker's Delight", by Henry S. Warren, section 7-3.
    *
    * ------------------------------------------------------------------------ **
    */
   {
-  int   i;
-  uchar keep = key[0];  /* Copy the highest order bits of the key. */
+  uint32_t m = 0x0000FFFF;
+  uint32_t t;
+  int      j, k;
 
-  /* Repeat the shift process <numbits> times.
-   */
-  for( i = 0; i < numbits; i++ )
+  for( j = 16; j != 0; j >>= 1, m ^= (m << j) )
     {
-    int j;
-
-    /* Shift the entire thing, byte by byte.
-     */
-    for( j = 0; j < 7; j++ )
+    for( k = 0; k < 32; k = (k + j + 1) & ~j )
       {
-      if( j && (key[j] & 0x80) )  /* If the top bit of this byte is set. */
-        key[j-1] |=  0x01;        /* ...shift it to last byte's low bit. */
-      key[j] <<= 1;               /* Then left-shift the whole byte.     */
+      t = (M[k] ^ (M[k + j] >> j)) & m;
+      M[k]     ^= t;
+      M[k + j] ^= (t << j);
       }
+    }
+  } /* Xpose32 */
+
+
+static void SliceLoad( DESslice     *S,
+                       const uchar  *blk[],
+                       const int     count,
+                       const int     len )
+  /* ------------------------------------------------------------------------ **
+   * Convert a set of byte strings into bitsliced form.
+   *
+   *  Input:  S     - Array of (8 * <len>) slices to receive the result.
+   *          blk   - Array of <count> pointers to byte strings.
+   *          count - Number of strings in <blk>.  No more than DES_LANES.
+   *          len   - Number of bytes in each string (7 or 8).
+   *
+   *  Output: none.
+   *
+   *  Notes:  Unused lanes (those beyond <count>) are filled with zeros.
+   *
+   *        - Each slice is treated as an array of 32-bit words, each of
+   *          which holds 32 lanes.  The order in which the lanes are
+   *          numbered within the slice does not matter, so long as
+   *          SliceStore() uses the same order.
+   *
+   *        - If every entry in <blk> is the same pointer (as when a batch
+   *          of keys is used to encrypt the same plaintext), the value is
+   *          simply broadcast to all lanes.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t M[32];
+  int      h, i, j, k;
 
-    /* Now move the high-order bits of each 28-bit half-key to their
-     * correct locations.
-     * Bit 27 is the lowest order bit of the first half-key.
-     * Before the shift, it was the highest order bit of the 2nd half-key.
-     */
-    if( GETBIT( key, 27 ) )     /* If bit 27 is set... */
+  /* Check for a broadcast.
+   */
+  for( k = 1; (k < count) && (blk[k] == blk[0]); k++ )
+    ;
+  if( k == count )
+    {
+    for( i = 0; i < (8 * len); i++ )
       {
-      CLRBIT( key, 27 );        /* ...clear bit 27. */
-      SETBIT( key, 55 );        /* ...set lowest order bit of 2nd half-key. */
+      S[i] = S[i] ^ S[i];
+      if( GETBIT( blk[0], i ) )
+        S[i] = ~S[i];
       }
+    return;
+    }
 
-    /* We kept the highest order bit of the first half-key in <keep>.
-     * If it's set, copy it to bit 27.
-     */
-    if( keep & 0x80 )
-      SETBIT( key, 27 );
+  /* Transpose 32 lanes at a time, 32 bits (four bytes) at a time.
+   */
+  for( h = 0; h < (DES_LANES / 32); h++ )
+    {
+    for( i = 0; i < len; i += 4 )
+      {
+      for( k = 0; k < 32; k++ )
+        {
+        const uchar *p;
 
-    /* Rotate the <keep> byte too, in case <numbits> is 2 and there's
-     * a second round coming.
-     */
-    keep <<= 1;
+        if( (32 * h) + k >= count )
+          {
+          M[k] = 0;
+          continue;
+          }
+        p = blk[(32 * h) + k];
+        if( (i + 4) <= len )
+          M[k] = ((uint32_t)p[i]   << 24) | ((uint32_t)p[i+1] << 16)
+               | ((uint32_t)p[i+2] <<  8) |  (uint32_t)p[i+3];
+        else
+          M[k] = ((uint32_t)p[i]   << 24) | ((uint32_t)p[i+1] << 16)
+               | ((uint32_t)p[i+2] <<  8);
+        }
+      Xpose32( M );
+      for( j = 0; (j < 32) && ((8 * i) + j < (8 * len)); j++ )
+        (void)memcpy( ((uchar *)&S[(8 * i) + j]) + (4 * h), &M[j], 4 );
+      }
     }
-  } /* KeyShift */
+  } /* SliceLoad */
 
 
-static void sbox( uchar *dst, const uchar *src )
+static void SliceStore( uchar          *blk[],
+                        const int       count,
+                        const DESslice *S )
   /* ------------------------------------------------------------------------ **
-   * Perform S-Box substitutions.
+   * Convert bitsliced DES blocks back into a set of byte strings.
    *
-   *  Input:  dst - Destination byte array into which the S-Box substituted
-   *                bitmap will be written.
-   *          src - Source byte array.
+   *  Input:  blk   - Array of <count> pointers to receive the results.
+   *          count - Number of blocks to write.  No more than DES_LANES.
+   *          S     - Array of 64 slices.
    *
    *  Output: none.
    *
-   *  Notes:  It's really not possible (for me, anyway) to understand how
-   *          this works without reading one or more detailed explanations.
-   *          Quick overview, though:
-   *
-   *          After the DataExpansion step (in which a 32-bit bit array is
-   *          expanded to a 48-bit bit array) the expanded data block is
-   *          XOR'd with 48-bits worth of key.  That 48 bits then needs to
-   *          be condensed back into 32 bits.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t M[32];
+  int      h, i, j, k;
+
+  for( h = 0; (32 * h) < count; h++ )
+    {
+    for( i = 0; i < 8; i += 4 )
+      {
+      for( j = 0; j < 32; j++ )
+        (void)memcpy( &M[j], ((const uchar *)&S[(8 * i) + j]) + (4 * h), 4 );
+      Xpose32( M );
+      for( k = 0; (k < 32) && ((32 * h) + k < count); k++ )
+        {
+        uchar *p = blk[(32 * h) + k];
+
+        p[i]   = (uchar)(M[k] >> 24);
+        p[i+1] = (uchar)(M[k] >> 16);
+        p[i+2] = (uchar)(M[k] >>  8);
+        p[i+3] = (uchar)M[k];
+        }
+      }
+    }
+  } /* SliceStore */
+
+
+static void SliceSBox( DESslice *out, const int s, const DESslice x[6] )
+  /* ------------------------------------------------------------------------ **
+   * Bitsliced S-Box substitution.
    *
-   *          The S-Box substitution handles the data reduction by breaking
-   *          the 48-bit value into eight 6-bit values.  For each of these
-   *          6-bit values there is a table (an S-Box table).  The table
-   *          contains 64 possible values.  Conveniently, a 6-bit integer
-   *          can represent a value between 0 and 63.
+   *  Input:  out - Array of four slices to receive the S-Box output, high
+   *                order bit first.
+   *          s   - The S-Box number (0..7).
+   *          x   - The six input slices, high order bit first.
    *
-   *          So, if you think of the 48-bit bit array as an array of 6-bit
-   *          integers, you use S-Box table 0 with the 0th 6-bit value.
-   *          Table 1 is used with the 6-bit value #1, and so on until #7.
-   *          Within each table, the correct substitution is found based
-   *          simply on the value of the 6-bit integer.
+   *  Output: none.
    *
-   *          Well, the original algorithm (and most documentation) don't
-   *          make it so simple.  There's a complex formula for mapping
-   *          the 6-bit values to the correct substitution.  Fortunately,
-   *          those lookups can be precomputed (and have been for this
-   *          implementation).  See pp 274-274 in Schneier.
+   *  Notes:  The outer input bits, x[0] and x[5], select the S-Box row.
+   *          The inner bits, x[1]..x[4], select the column.  Within any
+   *          one row, each output bit is set in exactly eight of the
+   *          sixteen columns, so it is computed by OR'ing together the
+   *          eight matching minterms of the column bits.  The row masks
+   *          then pick the result for the correct row.
    *
-   *          Oh, and the substitute values are all 4-bit values, so each
-   *          6-bits gets reduced to 4-bits resulting in a 32-bit bit array.
+   *        - The minterm lists were generated from the S-Box tables given
+   *          in Schneier.
    *
    * ------------------------------------------------------------------------ **
    */
   {
-  int i;
+  DESslice a[4], b[4], r[4], m[16], f[16];
+  int      i;
 
-  /* Clear the destination array.
-   */
-  for( i = 0; i < 4; i++ )
-    dst[i] = 0;
+  a[0] = ~x[1] & ~x[2];  a[1] = ~x[1] & x[2];
+  a[2] =  x[1] & ~x[2];  a[3] =  x[1] & x[2];
+  b[0] = ~x[3] & ~x[4];  b[1] = ~x[3] & x[4];
+  b[2] =  x[3] & ~x[4];  b[3] =  x[3] & x[4];
+  r[0] = ~x[0] & ~x[5];  r[1] = ~x[0] & x[5];
+  r[2] =  x[0] & ~x[5];  r[3] =  x[0] & x[5];
+  for( i = 0; i < 16; i++ )
+    m[i] = a[i >> 2] & b[i & 3];
 
-  /* For each set of six input bits...
+  /* f[(4 * row) + bit] is the output bit for the given row.
    */
-  for( i = 0; i < 8; i++ )
+  switch( s )
     {
-    int j;
-    int Snum;
-    int bitnum;
-
-    /* Extract the 6-bit integer from the source.
-     * This will be the lookup key within the SBox[i] array.
-     */
-    for( Snum = j = 0, bitnum = (i * 6); j < 6; j++, bitnum++ )
-      {
-      Snum <<= 1;
-      Snum  |= GETBIT( src, bitnum );
-      }
-
-    /* Find the correct value in the correct SBox[]
-     * and copy it into the destination.
-     * Left shift the nibble four bytes for even values of <i>.
-     */
-    if( 0 == (i%2) )
-      dst[i/2] |= ((SBox[i][Snum]) << 4);
-    else
-      dst[i/2] |= SBox[i][Snum];
+      case 0:
+        f[ 0] = m[ 0] | m[ 2] | m[ 5] | m[ 6] | m[ 7] | m[ 9] | m[11] | m[13];
+        f[ 1] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[10] | m[11] | m[12] | m[15];
+        f[ 2] = m[ 0] | m[ 4] | m[ 5] | m[ 6] | m[ 8] | m[ 9] | m[10] | m[15];
+        f[ 3] = m[ 2] | m[ 3] | m[ 5] | m[ 6] | m[ 8] | m[12] | m[13] | m[15];
+        f[ 4] = m[ 1] | m[ 4] | m[ 6] | m[ 8] | m[10] | m[11] | m[12] | m[15];
+        f[ 5] = m[ 1] | m[ 2] | m[ 3] | m[ 4] | m[ 6] | m[ 9] | m[10] | m[13];
+        f[ 6] = m[ 1] | m[ 2] | m[ 4] | m[ 5] | m[ 8] | m[ 9] | m[11] | m[14];
+        f[ 7] = m[ 1] | m[ 2] | m[ 6] | m[ 7] | m[11] | m[12] | m[13] | m[14];
+        f[ 8] = m[ 2] | m[ 3] | m[ 4] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[13];
+        f[ 9] = m[ 0] | m[ 2] | m[ 4] | m[ 5] | m[ 8] | m[ 9] | m[11] | m[14];
+        f[10] = m[ 2] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[11] | m[12] | m[13];
+        f[11] = m[ 1] | m[ 4] | m[ 7] | m[ 8] | m[10] | m[11] | m[12] | m[14];
+        f[12] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[ 9] | m[11] | m[12] | m[15];
+        f[13] = m[ 0] | m[ 1] | m[ 4] | m[ 7] | m[ 8] | m[11] | m[14] | m[15];
+        f[14] = m[ 0] | m[ 3] | m[ 7] | m[ 9] | m[10] | m[11] | m[12] | m[14];
+        f[15] = m[ 0] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[15];
+        break;
+      case 1:
+        f[ 0] = m[ 0] | m[ 2] | m[ 3] | m[ 5] | m[ 8] | m[11] | m[12] | m[15];
+        f[ 1] = m[ 0] | m[ 3] | m[ 4] | m[ 7] | m[ 9] | m[11] | m[12] | m[14];
+        f[ 2] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 6] | m[ 9] | m[10] | m[15];
+        f[ 3] = m[ 0] | m[ 1] | m[ 5] | m[ 6] | m[ 8] | m[ 9] | m[11] | m[14];
+        f[ 4] = m[ 1] | m[ 4] | m[ 6] | m[ 7] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 5] = m[ 1] | m[ 2] | m[ 3] | m[ 4] | m[ 7] | m[ 8] | m[12] | m[15];
+        f[ 6] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 7] | m[11] | m[12] | m[14];
+        f[ 7] = m[ 0] | m[ 1] | m[ 3] | m[ 4] | m[10] | m[13] | m[14] | m[15];
+        f[ 8] = m[ 1] | m[ 3] | m[ 4] | m[ 6] | m[ 9] | m[10] | m[12] | m[15];
+        f[ 9] = m[ 1] | m[ 2] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[11] | m[15];
+        f[10] = m[ 1] | m[ 2] | m[ 3] | m[ 4] | m[11] | m[13] | m[14] | m[15];
+        f[11] = m[ 2] | m[ 3] | m[ 6] | m[ 7] | m[ 8] | m[12] | m[13] | m[15];
+        f[12] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[ 8] | m[11] | m[14] | m[15];
+        f[13] = m[ 0] | m[ 5] | m[ 6] | m[ 9] | m[10] | m[11] | m[13] | m[14];
+        f[14] = m[ 2] | m[ 4] | m[ 5] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[14];
+        f[15] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 8] | m[10] | m[13] | m[15];
+        break;
+      case 2:
+        f[ 0] = m[ 0] | m[ 2] | m[ 3] | m[ 6] | m[ 9] | m[10] | m[12] | m[15];
+        f[ 1] = m[ 3] | m[ 4] | m[ 6] | m[ 7] | m[ 9] | m[10] | m[11] | m[13];
+        f[ 2] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 6] | m[11] | m[12] | m[14];
+        f[ 3] = m[ 2] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[11] | m[12];
+        f[ 4] = m[ 0] | m[ 3] | m[ 7] | m[ 9] | m[11] | m[12] | m[13] | m[14];
+        f[ 5] = m[ 0] | m[ 1] | m[ 5] | m[ 6] | m[10] | m[11] | m[12] | m[14];
+        f[ 6] = m[ 1] | m[ 4] | m[ 6] | m[ 7] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 7] = m[ 0] | m[ 1] | m[ 3] | m[ 4] | m[10] | m[13] | m[14] | m[15];
+        f[ 8] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 9] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[11] | m[12] | m[14] | m[15];
+        f[10] = m[ 1] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[13] | m[14] | m[15];
+        f[11] = m[ 0] | m[ 3] | m[ 5] | m[ 6] | m[ 8] | m[ 9] | m[12] | m[15];
+        f[12] = m[ 1] | m[ 2] | m[ 5] | m[ 6] | m[ 9] | m[10] | m[12] | m[15];
+        f[13] = m[ 2] | m[ 4] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[13] | m[15];
+        f[14] = m[ 1] | m[ 4] | m[ 7] | m[ 9] | m[10] | m[11] | m[12] | m[14];
+        f[15] = m[ 0] | m[ 2] | m[ 5] | m[ 7] | m[ 9] | m[11] | m[12] | m[13];
+        break;
+      case 3:
+        f[ 0] = m[ 1] | m[ 2] | m[ 6] | m[ 7] | m[10] | m[12] | m[13] | m[15];
+        f[ 1] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[11] | m[13] | m[14] | m[15];
+        f[ 2] = m[ 0] | m[ 2] | m[ 3] | m[ 5] | m[ 7] | m[ 9] | m[12] | m[15];
+        f[ 3] = m[ 0] | m[ 1] | m[ 3] | m[ 6] | m[ 8] | m[11] | m[12] | m[15];
+        f[ 4] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[11] | m[13] | m[14] | m[15];
+        f[ 5] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 8] | m[ 9] | m[11] | m[14];
+        f[ 6] = m[ 2] | m[ 4] | m[ 5] | m[ 7] | m[ 9] | m[10] | m[13] | m[14];
+        f[ 7] = m[ 0] | m[ 2] | m[ 3] | m[ 5] | m[ 7] | m[ 9] | m[12] | m[15];
+        f[ 8] = m[ 0] | m[ 2] | m[ 4] | m[ 5] | m[ 7] | m[ 8] | m[11] | m[14];
+        f[ 9] = m[ 1] | m[ 4] | m[ 6] | m[ 7] | m[ 8] | m[11] | m[12] | m[15];
+        f[10] = m[ 0] | m[ 1] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[11] | m[13];
+        f[11] = m[ 2] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[12];
+        f[12] = m[ 1] | m[ 4] | m[ 6] | m[ 7] | m[ 8] | m[11] | m[12] | m[15];
+        f[13] = m[ 1] | m[ 3] | m[ 6] | m[ 9] | m[10] | m[12] | m[13] | m[15];
+        f[14] = m[ 0] | m[ 1] | m[ 3] | m[ 4] | m[11] | m[13] | m[14] | m[15];
+        f[15] = m[ 0] | m[ 1] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[11] | m[13];
+        break;
+      case 4:
+        f[ 0] = m[ 1] | m[ 5] | m[ 6] | m[ 8] | m[11] | m[12] | m[14] | m[15];
+        f[ 1] = m[ 1] | m[ 2] | m[ 4] | m[ 7] | m[ 9] | m[11] | m[12] | m[14];
+        f[ 2] = m[ 0] | m[ 4] | m[ 5] | m[ 6] | m[ 7] | m[10] | m[11] | m[14];
+        f[ 3] = m[ 3] | m[ 4] | m[ 6] | m[ 9] | m[10] | m[11] | m[12] | m[15];
+        f[ 4] = m[ 0] | m[ 1] | m[ 3] | m[ 6] | m[10] | m[11] | m[13] | m[14];
+        f[ 5] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[15];
+        f[ 6] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[10] | m[11] | m[12] | m[15];
+        f[ 7] = m[ 1] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[10] | m[12] | m[13];
+        f[ 8] = m[ 3] | m[ 4] | m[ 5] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[15];
+        f[ 9] = m[ 0] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[11] | m[12] | m[15];
+        f[10] = m[ 1] | m[ 3] | m[ 4] | m[ 6] | m[ 8] | m[12] | m[13] | m[15];
+        f[11] = m[ 2] | m[ 3] | m[ 5] | m[ 6] | m[ 8] | m[ 9] | m[11] | m[13];
+        f[12] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[ 7] | m[ 9] | m[11] | m[12];
+        f[13] = m[ 2] | m[ 3] | m[ 5] | m[ 7] | m[ 8] | m[ 9] | m[13] | m[14];
+        f[14] = m[ 0] | m[ 3] | m[ 5] | m[ 6] | m[ 8] | m[ 9] | m[12] | m[15];
+        f[15] = m[ 0] | m[ 3] | m[ 4] | m[ 7] | m[ 9] | m[11] | m[14] | m[15];
+        break;
+      case 5:
+        f[ 0] = m[ 0] | m[ 2] | m[ 3] | m[ 4] | m[ 7] | m[ 9] | m[12] | m[15];
+        f[ 1] = m[ 0] | m[ 3] | m[ 6] | m[ 9] | m[11] | m[12] | m[13] | m[14];
+        f[ 2] = m[ 2] | m[ 3] | m[ 5] | m[ 6] | m[10] | m[12] | m[13] | m[15];
+        f[ 3] = m[ 1] | m[ 3] | m[ 4] | m[ 9] | m[10] | m[13] | m[14] | m[15];
+        f[ 4] = m[ 0] | m[ 1] | m[ 5] | m[ 6] | m[10] | m[11] | m[13] | m[15];
+        f[ 5] = m[ 1] | m[ 2] | m[ 4] | m[ 5] | m[ 7] | m[ 8] | m[10] | m[11];
+        f[ 6] = m[ 0] | m[ 1] | m[ 3] | m[ 4] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 7] = m[ 1] | m[ 4] | m[ 6] | m[ 7] | m[ 9] | m[10] | m[13] | m[14];
+        f[ 8] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[ 6] | m[11] | m[13] | m[14];
+        f[ 9] = m[ 1] | m[ 2] | m[ 3] | m[ 6] | m[ 8] | m[10] | m[13] | m[15];
+        f[10] = m[ 1] | m[ 2] | m[ 4] | m[ 7] | m[ 8] | m[11] | m[14] | m[15];
+        f[11] = m[ 0] | m[ 2] | m[ 3] | m[ 7] | m[ 8] | m[12] | m[13] | m[14];
+        f[12] = m[ 3] | m[ 4] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[14] | m[15];
+        f[13] = m[ 0] | m[ 3] | m[ 5] | m[ 6] | m[ 9] | m[11] | m[12] | m[15];
+        f[14] = m[ 1] | m[ 2] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[11] | m[12];
+        f[15] = m[ 1] | m[ 4] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[11] | m[15];
+        break;
+      case 6:
+        f[ 0] = m[ 1] | m[ 3] | m[ 4] | m[ 6] | m[ 7] | m[ 9] | m[10] | m[13];
+        f[ 1] = m[ 0] | m[ 3] | m[ 4] | m[ 7] | m[ 9] | m[11] | m[12] | m[14];
+        f[ 2] = m[ 1] | m[ 2] | m[ 3] | m[ 4] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 3] = m[ 1] | m[ 4] | m[ 7] | m[ 8] | m[10] | m[11] | m[12] | m[15];
+        f[ 4] = m[ 0] | m[ 2] | m[ 5] | m[ 7] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 5] = m[ 0] | m[ 3] | m[ 4] | m[ 8] | m[10] | m[11] | m[13] | m[15];
+        f[ 6] = m[ 2] | m[ 3] | m[ 7] | m[ 8] | m[ 9] | m[12] | m[13] | m[15];
+        f[ 7] = m[ 0] | m[ 2] | m[ 3] | m[ 5] | m[ 6] | m[ 9] | m[10] | m[13];
+        f[ 8] = m[ 2] | m[ 3] | m[ 4] | m[ 7] | m[ 8] | m[ 9] | m[11] | m[14];
+        f[ 9] = m[ 1] | m[ 3] | m[ 4] | m[ 6] | m[ 7] | m[ 9] | m[10] | m[13];
+        f[10] = m[ 2] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[15];
+        f[11] = m[ 0] | m[ 2] | m[ 3] | m[ 5] | m[ 6] | m[ 9] | m[13] | m[14];
+        f[12] = m[ 1] | m[ 2] | m[ 3] | m[ 6] | m[ 8] | m[11] | m[12] | m[15];
+        f[13] = m[ 0] | m[ 2] | m[ 5] | m[ 7] | m[ 9] | m[11] | m[12] | m[15];
+        f[14] = m[ 0] | m[ 1] | m[ 6] | m[ 7] | m[11] | m[12] | m[13] | m[14];
+        f[15] = m[ 1] | m[ 2] | m[ 4] | m[ 7] | m[ 8] | m[ 9] | m[11] | m[14];
+        break;
+      case 7:
+        f[ 0] = m[ 0] | m[ 2] | m[ 5] | m[ 6] | m[ 8] | m[ 9] | m[11] | m[14];
+        f[ 1] = m[ 0] | m[ 3] | m[ 4] | m[ 5] | m[11] | m[12] | m[14] | m[15];
+        f[ 2] = m[ 1] | m[ 4] | m[ 5] | m[ 6] | m[ 8] | m[10] | m[11] | m[15];
+        f[ 3] = m[ 0] | m[ 5] | m[ 6] | m[ 7] | m[ 9] | m[10] | m[12] | m[15];
+        f[ 4] = m[ 1] | m[ 2] | m[ 3] | m[ 4] | m[ 8] | m[11] | m[13] | m[14];
+        f[ 5] = m[ 1] | m[ 2] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[13];
+        f[ 6] = m[ 1] | m[ 4] | m[ 5] | m[ 6] | m[10] | m[11] | m[13] | m[15];
+        f[ 7] = m[ 0] | m[ 1] | m[ 2] | m[ 5] | m[ 6] | m[ 9] | m[11] | m[14];
+        f[ 8] = m[ 1] | m[ 4] | m[ 5] | m[ 6] | m[10] | m[11] | m[12] | m[15];
+        f[ 9] = m[ 0] | m[ 2] | m[ 5] | m[ 6] | m[ 9] | m[11] | m[12] | m[14];
+        f[10] = m[ 0] | m[ 1] | m[ 6] | m[ 7] | m[ 9] | m[10] | m[12] | m[13];
+        f[11] = m[ 0] | m[ 1] | m[ 3] | m[ 4] | m[11] | m[12] | m[13] | m[14];
+        f[12] = m[ 2] | m[ 5] | m[ 6] | m[ 7] | m[ 8] | m[ 9] | m[10] | m[15];
+        f[13] = m[ 2] | m[ 3] | m[ 4] | m[ 7] | m[ 8] | m[ 9] | m[13] | m[14];
+        f[14] = m[ 0] | m[ 2] | m[ 3] | m[ 5] | m[ 8] | m[12] | m[14] | m[15];
+        f[15] = m[ 1] | m[ 3] | m[ 7] | m[ 8] | m[10] | m[12] | m[13] | m[15];
+        break;
     }
-  } /* sbox */
+
+  for( i = 0; i < 4; i++ )
+    out[i] = (r[0] & f[i])     | (r[1] & f[4 + i])
+           | (r[2] & f[8 + i]) | (r[3] & f[12 + i]);
+  } /* SliceSBox */
 
 
-static void xor( uchar *dst, const uchar *a, const uchar *b, const int count )
+static void SliceDES( DESslice D[64], const DESslice K[56] )
   /* ------------------------------------------------------------------------ **
-   * Perform an XOR operation on two byte arrays.
+   * Bitsliced DES encryption.
    *
-   *  Input:  dst   - Destination array to which the result will be written.
-   *          a     - The first string of bytes.
-   *          b     - The second string of bytes.
-   *          count - Number of bytes to XOR against one another.
+   *  Input:  D - The bitsliced data blocks.  D[n] holds bit <n> of each
+   *              block (counting from the high-order bit of the first
+   *              byte).  The result is written back to <D>.
+   *          K - The bitsliced keys.  K[n] holds bit <n> of each 7-byte
+   *              key.
    *
    *  Output: none.
    *
-   *  Notes:  This function operates on whole byte chunks.  There's no need
-   *          to XOR partial bytes so no need to write code to handle it.
-   *
-   *        - This function essentially implements dst = a ^ b; for byte
-   *          arrays.
-   *
-   *        - <dst> may safely point to the same location as <a> or <b>.
+   *  Notes:  This is the same algorithm as auth_DESencrypt(), but the
+   *          data movement is done by indexing rather than shifting.
+   *          The expansion permutation selects bits (4s - 1) through
+   *          (4s + 4), modulo 32, of R as the input to S-Box <s>.
    *
    * ------------------------------------------------------------------------ **
    */
   {
-  int i;
+  DESslice  LR[64];
+  DESslice  x[6];
+  DESslice  f[32];
+  DESslice *L = LR;
+  DESslice *R = &LR[32];
+  DESslice *tmp;
+  int       i, j, s;
 
-  for( i = 0; i < count; i++ )
-    dst[i] = a[i] ^ b[i];
-  } /* xor */
+  /* Initial permutation.
+   */
+  for( j = 0; j < 32; j++ )
+    {
+    L[j] = D[InitialPermuteMap[j]];
+    R[j] = D[InitialPermuteMap[32 + j]];
+    }
+
+  /* Sixteen rounds.
+   */
+  for( i = 0; i < 16; i++ )
+    {
+    for( s = 0; s < 8; s++ )
+      {
+      for( j = 0; j < 6; j++ )
+        x[j] = R[((4 * s) + j - 1) & 0x1F] ^ K[KeyBits[i][(6 * s) + j]];
+      SliceSBox( &f[4 * s], s, x );
+      }
+    for( j = 0; j < 32; j++ )
+      L[j] ^= f[PBox[j]];
+    tmp = L;
+    L   = R;
+    R   = tmp;
+    }
+
+  /* Swap the halves and apply the final (inverse initial) permutation.
+   */
+  for( j = 0; j < 32; j++ )
+    {
+    D[InitialPermuteMap[j]]      = R[j];
+    D[InitialPermuteMap[32 + j]] = L[j];
+    }
+  } /* SliceDES */
 
 
 /* -------------------------------------------------------------------------- **
@@ -620,6 +1413,151 @@ uchar *auth_DESkey8to7( uchar *dst, const uchar *key )
   } /* auth_DESkey8to7 */
 
 
+auth_DESschedule *auth_DESexpandKey( auth_DESschedule *ks, const uchar *key )
+  /* ------------------------------------------------------------------------ **
+   * Generate a DES key schedule (all sixteen subkeys) from a 7-byte key.
+   *
+   *  Input:  ks  - Pointer to the key schedule structure to be filled in.
+   *          key - The 7-byte (56-bit) DES key.
+   *
+   *  Output: A pointer to the key schedule (same as <ks>).
+   *
+   *  Notes:  The key permutation, key rotation, and key compression steps
+   *          do not depend upon the data being encrypted, so they can all
+   *          be done up front.  If several blocks are to be encrypted
+   *          using the same key, generate the key schedule once and pass
+   *          it to <auth_DESencrypt()> for each block.
+   *
+   *        - The subkeys are stored in the layout expected by
+   *          <auth_DESencrypt()>.  See the notes above the PC2tab[] table.
+   *
+   *        - The key schedule is derived directly from the key, so treat
+   *          it with the same care.  Clear it when you are done with it.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      i;
+  int      p;
+  uint32_t C = 0;   /* The left (high-order) 28 bits of the permuted key. */
+  uint32_t D = 0;   /* The right (low-order) 28 bits.                     */
+
+  /* Key permutation, one nibble at a time.
+   */
+  for( i = 0; i < 7; i++ )
+    {
+    C |= PC1tab[2*i][key[i] >> 4][0] | PC1tab[(2*i)+1][key[i] & 0x0F][0];
+    D |= PC1tab[2*i][key[i] >> 4][1] | PC1tab[(2*i)+1][key[i] & 0x0F][1];
+    }
+
+  /* Rotate and compress to produce each subkey.
+   */
+  for( i = 0; i < 16; i++ )
+    {
+    uint32_t ke = 0;
+    uint32_t ko = 0;
+
+    C = ROTL28( C, KeyRotation[i] );
+    D = ROTL28( D, KeyRotation[i] );
+    for( p = 0; p < 7; p++ )
+      {
+      const uint32_t *c = PC2tab[p][(C >> (24 - (4 * p))) & 0x0F];
+      const uint32_t *d = PC2tab[p + 7][(D >> (24 - (4 * p))) & 0x0F];
+
+      ke |= c[0] | d[0];
+      ko |= c[1] | d[1];
+      }
+    ks->SubK[i][0] = ke;
+    ks->SubK[i][1] = ko;
+    }
+
+  return( ks );
+  } /* auth_DESexpandKey */
+
+
+uchar *auth_DESencrypt( uchar                  *dst,
+                        const auth_DESschedule *ks,
+                        const uchar            *src )
+  /* ------------------------------------------------------------------------ **
+   * DES encryption of a single 8-byte block using a key schedule.
+   *
+   *  Input:  dst - Destination buffer.  It *must* be at least eight bytes
+   *                in length, to receive the encrypted result.
+   *          ks  - The key schedule, as generated by <auth_DESexpandKey()>.
+   *          src - Source data to be encrypted.  Exactly eight bytes will
+   *                be used.
+   *
+   *  Output: A pointer to the encrypted data (same as <dst>).
+   *
+   *  Notes:  The data block is read in full before any output is written,
+   *          so <dst> may point to the same memory as <src>.
+   *
+   *        - The expansion permutation is not done explicitly.  Rotating
+   *          R left by one bit brings the 6-bit groups for S-boxes 0, 2, 4,
+   *          and 6 into position at bit offsets 26, 18, 10, and 2.
+   *          Rotating R left by 3 bits does the same for S-boxes 1, 3, 5,
+   *          and 7.  The subkeys are stored to match.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      i;
+  uint32_t L = 0;   /* The left half of the data block.   */
+  uint32_t R = 0;   /* The right half of the data block.  */
+  uint32_t a, b, t;
+
+  /* Initial permutation.
+   */
+  for( i = 0; i < 8; i++ )
+    {
+    const uint32_t *hi = IPtab[0][src[i] >> 4];
+    const uint32_t *lo = IPtab[1][src[i] & 0x0F];
+
+    L |= (hi[0] | lo[0]) << i;
+    R |= (hi[1] | lo[1]) << i;
+    }
+
+  /* DES encryption proceeds in 16 rounds.
+   * The stuff inside the loop is known in the literature as "function f".
+   * Expansion and subkey XOR, then the combined S-Box/P-Box lookups,
+   * then the XOR with the left half.
+   */
+  for( i = 0; i < 16; i++ )
+    {
+    a = ROTL32( R, 31 ) ^ ks->SubK[i][0];
+    b = ROTL32( R,  3 ) ^ ks->SubK[i][1];
+    t = L
+      ^ SPtab[0][(a >> 26) & 0x3F] ^ SPtab[1][(b >> 26) & 0x3F]
+      ^ SPtab[2][(a >> 18) & 0x3F] ^ SPtab[3][(b >> 18) & 0x3F]
+      ^ SPtab[4][(a >> 10) & 0x3F] ^ SPtab[5][(b >> 10) & 0x3F]
+      ^ SPtab[6][(a >>  2) & 0x3F] ^ SPtab[7][(b >>  2) & 0x3F];
+    L = R;
+    R = t;
+    }
+
+  /* Final permutation (which includes the left/right swap).
+   */
+  a = b = 0;
+  for( i = 0; i < 4; i++ )
+    {
+    const uint32_t *lh = FPtab[0][(L >> (28 - (8 * i))) & 0x0F];
+    const uint32_t *ll = FPtab[1][(L >> (24 - (8 * i))) & 0x0F];
+    const uint32_t *rh = FPtab[0][(R >> (28 - (8 * i))) & 0x0F];
+    const uint32_t *rl = FPtab[1][(R >> (24 - (8 * i))) & 0x0F];
+
+    a |= ((lh[0] | ll[0]) >> FPshift[i]) | ((rh[0] | rl[0]) >> FPshift[i+4]);
+    b |= ((lh[1] | ll[1]) >> FPshift[i]) | ((rh[1] | rl[1]) >> FPshift[i+4]);
+    }
+  for( i = 0; i < 4; i++ )
+    {
+    dst[i]   = (uchar)(a >> (24 - (8 * i)));
+    dst[i+4] = (uchar)(b >> (24 - (8 * i)));
+    }
+
+  return( dst );
+  } /* auth_DESencrypt */
+
+
 uchar *auth_DEShash( uchar *dst, const uchar *key, const uchar *src )
   /* ------------------------------------------------------------------------ **
    * DES encryption of the input data using the input key.
@@ -649,9 +1587,12 @@ uchar *auth_DEShash( uchar *dst, const uchar *key, const uchar *src )
    *          LM/NTLM responses.  For all practical purposes, however, it
    *          is a full DES encryption implementation.
    *
-   *        - This DES implementation does not need to be fast, nor is a
-   *          DES decryption function needed.  The goal is to keep the
-   *          code small, simple, and well documented.
+   *        - No DES decryption function is provided, since SMB does not
+   *          need one.
+   *
+   *        - The key schedule is regenerated on every call.  If the same
+   *          key is used repeatedly, use <auth_DESexpandKey()> and
+   *          <auth_DESencrypt()> instead.
    *
    *        - The input values are copied and refiddled within the module
    *          and the result is not written to <dst> until the very last
@@ -661,68 +1602,60 @@ uchar *auth_DEShash( uchar *dst, const uchar *key, const uchar *src )
    * ------------------------------------------------------------------------ **
    */
   {
-  int   i;          /* Loop counter.                                */
-  uchar K[7];       /* Holds the key, as we manipulate it.          */
-  uchar D[8];       /* The data block, as we manipulate it.         */
+  auth_DESschedule ks;
 
-  /* Create the permutations of the key and the source.
-   */
-  Permute( K, key, KeyPermuteMap, 7 );
-  Permute( D, src, InitialPermuteMap, 8 );
+  (void)auth_DESexpandKey( &ks, key );
+  return( auth_DESencrypt( dst, &ks, src ) );
+  } /* auth_DEShash */
 
-  /* DES encryption proceeds in 16 rounds.
-   * The stuff inside the loop is known in the literature as "function f".
+
+uchar **auth_DEShashN( uchar       *dst[],
+                       const uchar *key[],
+                       const uchar *src[],
+                       const int    n )
+  /* ------------------------------------------------------------------------ **
+   * DES encryption of a batch of independent key and data pairs.
+   *
+   *  Input:  dst - Array of <n> pointers to destination buffers.  Each
+   *                buffer must be at least eight bytes in length.
+   *          key - Array of <n> pointers to 7-byte keys.
+   *          src - Array of <n> pointers to 8-byte blocks of source data.
+   *          n   - The number of encryptions to perform.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is byte-for-byte the same as calling
+   *          auth_DEShash( dst[i], key[i], src[i] ) for each <i>.
+   *
+   *        - The blocks are processed in a bitsliced layout, as many at
+   *          once as there are bits in the slice type (32 or 64 bits for
+   *          an unsigned long, 128 with SSE2, 256 with AVX2).  There is no
+   *          key setup cost, which makes this well suited to hashing large
+   *          numbers of candidate passwords.  For a small number of blocks
+   *          the scalar functions are faster.
+   *
+   *        - The same pointer may appear more than once in the <key> or
+   *          <src> arrays.  A <dst> buffer may overlap the <key> or <src>
+   *          buffers of the same entry.
+   *
+   * ------------------------------------------------------------------------ **
    */
-  for( i = 0; i < 16; i++ )
+  {
+  DESslice D[64];
+  DESslice K[56];
+  int      i;
+  int      count;
+
+  for( i = 0; i < n; i += DES_LANES )
     {
-    int    j;
-    uchar *L = D;           /* The left 4 bytes (half) of the data block.   */
-    uchar *R = &(D[4]);     /* The right half of the ciphertext block.      */
-    uchar  Rexp[6];         /* Expanded right half.                         */
-    uchar  Rn[4];           /* New value of R, as we manipulate it.         */
-    uchar  SubK[6];         /* The 48-bit subkey.                           */
-
-    /* Generate the subkey for this round.
-     */
-    KeyShift( K, KeyRotation[i] );
-    Permute( SubK, K, KeyCompression, 6 );
-
-    /* Expand the right half (R) of the data block to 48 bytes,
-     * then XOR the result with the Subkey for this round.
-     */
-    Permute( Rexp, R, DataExpansion, 6 );
-    xor( Rexp, Rexp, SubK, 6 );
-
-    /* S-Box substitutions, P-Box permutation, and final XOR.
-     * The S-Box substitutions return a 32-bit value, which is then
-     * run through the 32-bit to 32-bit P-Box permutation.  The P-Box
-     * result is then XOR'd with the left-hand half of the key.
-     * (Rexp is used as a temporary variable between the P-Box & XOR).
-     */
-    sbox( Rn, Rexp );
-    Permute( Rexp, Rn, PBox, 4 );
-    xor( Rn, L, Rexp, 4 );
-
-    /* The previous R becomes the new L,
-     * and Rn is moved into R ready for the next round.
-     */
-    for( j = 0; j < 4; j++ )
-      {
-      L[j] = R[j];
-      R[j] = Rn[j];
-      }
+    count = ((n - i) < DES_LANES) ? (n - i) : DES_LANES;
+    SliceLoad( K, &key[i], count, 7 );
+    SliceLoad( D, &src[i], count, 8 );
+    SliceDES( D, K );
+    SliceStore( &dst[i], count, D );
     }
 
-  /* The encryption is complete.
-   * Now reverse-permute the ciphertext to produce the final result.
-   * We actually combine two steps here.  The penultimate step is to
-   * swap the positions of L and R in the result of the 16 rounds,
-   * after which the reverse of the Initial Permutation is applied.
-   * To save a step, the FinalPermuteMap applies both the L/R swap
-   * and the inverse of the Initial Permutation.
-   */
-  Permute( dst, D, FinalPermuteMap, 8 );
   return( dst );
-  } /* auth_DEShash */
+  } /* auth_DEShashN */
 
 /* ========================================================================== */
@@ -47,11 +47,10 @@
  *
  *  The SMB protocol uses the DES algorithm as a hash function, not an
  *  encryption function.  The auth_DEShash() implemented here is a one-way
- *  function.  The reverse is not implemented in this module.  Also, there
- *  is no attempt at making this either fast or efficient.  There is no
- *  need, as the auth)DEShash() function is used for generating the LM
- *  Response from a 7-byte key and an 8-byte challenge.  It is not intended
- *  for use in encrypting large blocks of data or data streams.
+ *  function.  The reverse is not implemented in this module.
+ *
+ *  The permutations and S-Box lookups are driven by tables that are
+ *  pre-computed from the standard DES maps.  See DES.c for the details.
  *
  *  As stated above, this implementation is based on studying existing work
  *  in the public domain or under Open Source (specifically LGPL) license.
@@ -100,6 +99,21 @@
 #include "auth_common.h"
 
 
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  auth_DESschedule  - A pre-computed DES key schedule.  The sixteen
+ *                      48-bit subkeys are each stored as a pair of 32-bit
+ *                      values, in the layout used internally by DES.c.
+ *                      The contents should be considered opaque.
+ */
+
+typedef struct
+  {
+  uint32_t SubK[16][2];
+  } auth_DESschedule;
+
+
 /* -------------------------------------------------------------------------- **
  * Functions:
  */
@@ -133,6 +147,54 @@ uchar *auth_DESkey8to7( uchar *dst, const uchar *key );
    */
 
 
+auth_DESschedule *auth_DESexpandKey( auth_DESschedule *ks, const uchar *key );
+  /* ------------------------------------------------------------------------ **
+   * Generate a DES key schedule (all sixteen subkeys) from a 7-byte key.
+   *
+   *  Input:  ks  - Pointer to the key schedule structure to be filled in.
+   *          key - The 7-byte (56-bit) DES key.
+   *
+   *  Output: A pointer to the key schedule (same as <ks>).
+   *
+   *  Notes:  The key permutation, key rotation, and key compression steps
+   *          do not depend upon the data being encrypted, so they can all
+   *          be done up front.  If several blocks are to be encrypted
+   *          using the same key, generate the key schedule once and pass
+   *          it to <auth_DESencrypt()> for each block.
+   *
+   *        - The key schedule is derived directly from the key, so treat
+   *          it with the same care.  Clear it when you are done with it.
+   *
+   *  See Also:  <auth_DESencrypt()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_DESencrypt( uchar                  *dst,
+                        const auth_DESschedule *ks,
+                        const uchar            *src );
+  /* ------------------------------------------------------------------------ **
+   * DES encryption of a single 8-byte block using a key schedule.
+   *
+   *  Input:  dst - Destination buffer.  It *must* be at least eight bytes
+   *                in length, to receive the encrypted result.
+   *          ks  - The key schedule, as generated by <auth_DESexpandKey()>.
+   *          src - Source data to be encrypted.  Exactly eight bytes will
+   *                be used.
+   *
+   *  Output: A pointer to the encrypted data (same as <dst>).
+   *
+   *  Notes:  The data block is read in full before any output is written,
+   *          so <dst> may point to the same memory as <src>.
+   *
+   *        - auth_DEShash( dst, key, src ) is equivalent to calling
+   *          <auth_DESexpandKey()> followed by <auth_DESencrypt()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 uchar *auth_DEShash( uchar *dst, const uchar *key, const uchar *src );
   /* ------------------------------------------------------------------------ **
    * DES encryption of the input data using the input key.
@@ -162,9 +224,12 @@ uchar *auth_DEShash( uchar *dst, const uchar *key, const uchar *src );
    *          LM/NTLM responses.  For all practical purposes, however, it
    *          is a full DES encryption implementation.
    *
-   *        - This DES implementation does not need to be fast, nor is a
-   *          DES decryption function needed.  The goal is to keep the
-   *          code small, simple, and well documented.
+   *        - No DES decryption function is provided, since SMB does not
+   *          need one.
+   *
+   *        - The key schedule is regenerated on every call.  If the same
+   *          key is used repeatedly, use <auth_DESexpandKey()> and
+   *          <auth_DESencrypt()> instead.
    *
    *        - The input values are copied and refiddled within the module
    *          and the result is not written to <dst> until the very last
@@ -175,5 +240,38 @@ uchar *auth_DEShash( uchar *dst, const uchar *key, const uchar *src );
    */
 
 
+uchar **auth_DEShashN( uchar       *dst[],
+                       const uchar *key[],
+                       const uchar *src[],
+                       const int    n );
+  /* ------------------------------------------------------------------------ **
+   * DES encryption of a batch of independent key and data pairs.
+   *
+   *  Input:  dst - Array of <n> pointers to destination buffers.  Each
+   *                buffer must be at least eight bytes in length.
+   *          key - Array of <n> pointers to 7-byte keys.
+   *          src - Array of <n> pointers to 8-byte blocks of source data.
+   *          n   - The number of encryptions to perform.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is byte-for-byte the same as calling
+   *          auth_DEShash( dst[i], key[i], src[i] ) for each <i>.
+   *
+   *        - The blocks are processed in a bitsliced layout, as many at
+   *          once as there are bits in the slice type (32 or 64 bits for
+   *          an unsigned long, 128 with SSE2, 256 with AVX2).  There is no
+   *          key setup cost, which makes this well suited to hashing large
+   *          numbers of candidate passwords.  For a small number of blocks
+   *          the scalar functions are faster.
+   *
+   *        - The same pointer may appear more than once in the <key> or
+   *          <src> arrays.  A <dst> buffer may overlap the <key> or <src>
+   *          buffers of the same entry.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 /* ========================================================================== */
 #endif /* AUTH_DES_H */
@@ -0,0 +1,193 @@
+#ifndef AUTH_HMAC_H
+#define AUTH_HMAC_H
+/* ========================================================================== **
+ *
+ *                                   HMAC.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Implements HMAC-MD5, as described in RFC 2104.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  HMAC is described in RFC 2104.  This module implements only HMAC-MD5,
+ *  which is what SMB uses (NTLMv2, LMv2, and SMB message signing with
+ *  extended security).
+ *
+ *  An HMAC computation starts by hashing the key XOR'd with a 64-byte
+ *  "inner pad", and ends by hashing the key XOR'd with an "outer pad".
+ *  Both of those steps depend only upon the key, so they are done once by
+ *  auth_hmacMD5SetKey() and the resulting MD5 contexts are saved in an
+ *  auth_hmacMD5Key structure.  A server can keep that structure with the
+ *  user's account information and skip the pad blocks on every login.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * References:
+ *  IETF RFC 2104: HMAC: Keyed-Hashing for Message Authentication
+ *       H. Krawczyk, M. Bellare, R. Canetti. IETF, February, 1997
+ *
+ *  IETF RFC 2202: Test Cases for HMAC-MD5 and HMAC-SHA-1
+ *       P. Cheng, R. Glenn. IETF, September, 1997
+ *
+ * ========================================================================== **
+ */
+
+#include "auth_common.h"
+#include "MD5.h"
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  auth_hmacMD5Key - The pre-computed state for a given HMAC key.  The
+ *                    <inner> and <outer> MD5 contexts have already
+ *                    absorbed the inner and outer pad blocks.
+ */
+
+typedef struct
+  {
+  auth_md5Ctx inner;
+  auth_md5Ctx outer;
+  } auth_hmacMD5Key;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+auth_hmacMD5Key *auth_hmacMD5SetKey( auth_hmacMD5Key *hkey,
+                                     const uchar     *key,
+                                     const int        keylen );
+  /* ------------------------------------------------------------------------ **
+   * Pre-compute the HMAC-MD5 state for a key.
+   *
+   *  Input:  hkey    - Pointer to the auth_hmacMD5Key structure to be
+   *                    filled in.
+   *          key     - The HMAC key.
+   *          keylen  - The length, in bytes, of <key>.
+   *
+   *  Output: A pointer to the filled-in structure (same as <hkey>).
+   *
+   *  Notes:  Keys longer than 64 bytes are first hashed with MD5, as
+   *          required by RFC 2104.
+   *
+   *          The resulting structure is read-only as far as the other
+   *          functions in this module are concerned, so it may be shared
+   *          and used by any number of HMAC computations at once.  It is
+   *          as sensitive as the key itself.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+auth_md5Ctx *auth_hmacMD5InitCtx( auth_md5Ctx           *ctx,
+                                  const auth_hmacMD5Key *hkey );
+  /* ------------------------------------------------------------------------ **
+   * Start an HMAC-MD5 computation.
+   *
+   *  Input:  ctx   - Pointer to an MD5 context, which will be initialized.
+   *          hkey  - The pre-computed key state.
+   *
+   *  Output: A pointer to the initialized context (same as <ctx>).
+   *
+   *  Notes:  The message is passed to <auth_md5SumCtx()>, as with plain
+   *          MD5.  When the whole message has been added, call
+   *          <auth_hmacMD5CloseCtx()> to get the result.
+   *
+   *  See Also:  <auth_hmacMD5CloseCtx()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+auth_md5Ctx *auth_hmacMD5CloseCtx( auth_md5Ctx           *ctx,
+                                   const auth_hmacMD5Key *hkey,
+                                   uchar                 *dst );
+  /* ------------------------------------------------------------------------ **
+   * Finish an HMAC-MD5 computation.
+   *
+   *  Input:  ctx   - The context, as started by <auth_hmacMD5InitCtx()>.
+   *          hkey  - The same key state that was used to start <ctx>.
+   *          dst   - A pointer to at least 16 bytes of memory, which will
+   *                  receive the HMAC-MD5 result.
+   *
+   *  Output: A pointer to the closed context (same as <ctx>).
+   *
+   *  Notes:  The context (<ctx>) is returned in an undefined state.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_hmacMD5( uchar                 *dst,
+                     const auth_hmacMD5Key *hkey,
+                     const uchar           *src,
+                     const int              len );
+  /* ------------------------------------------------------------------------ **
+   * Compute HMAC-MD5 over a single block of data, using a pre-computed key.
+   *
+   *  Input:  dst   - Destination buffer.  Must be at least 16 bytes.
+   *          hkey  - The pre-computed key state.
+   *          src   - Source data.
+   *          len   - The length, in bytes, of <src>.
+   *
+   *  Output: A pointer to the 16-byte result (same as <dst>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_hmacMD5Sum( uchar       *dst,
+                        const uchar *key,
+                        const int    keylen,
+                        const uchar *src,
+                        const int    len );
+  /* ------------------------------------------------------------------------ **
+   * Compute HMAC-MD5 over a single block of data.
+   *
+   *  Input:  dst     - Destination buffer.  Must be at least 16 bytes.
+   *          key     - The HMAC key.
+   *          keylen  - The length, in bytes, of <key>.
+   *          src     - Source data.
+   *          len     - The length, in bytes, of <src>.
+   *
+   *  Output: A pointer to the 16-byte result (same as <dst>).
+   *
+   *  Notes:  This is a shortcut.  If the same key will be used more than
+   *          once, use <auth_hmacMD5SetKey()> and <auth_hmacMD5()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* AUTH_HMAC_H */
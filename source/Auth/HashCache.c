@@ -0,0 +1,414 @@
+/* ========================================================================== **
+ *
+ *                                HashCache.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  A bounded cache of LM and NT password hashes.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Generating the LM hash costs two DES operations, and the NT hash an
+ *  MD4 pass.  A gateway that sets up many sessions for the same handful
+ *  of service accounts does that work over and over.  This module keeps
+ *  the results around.
+ *
+ *  The cache lives entirely within a block of memory supplied by the
+ *  caller, so the memory budget is fixed when the cache is created.  The
+ *  table is a flat array of entries, divided into sets of HC_WAYS entries
+ *  each.  A credential always maps to the same set, and that set is
+ *  searched linearly.  When a set is full, the least recently used entry
+ *  in that set is evicted.  There are no pointers and no per-entry
+ *  allocation.
+ *
+ *  Entries are keyed by the MD5 of the credential, rather than the
+ *  credential itself, so no cleartext is kept.  The credential is simply
+ *  a string of bytes.  The caller decides what goes into it (eg., the
+ *  domain, user name, and password, all run together).  Evicted and
+ *  removed entries, and the key built on the stack for each call, are
+ *  overwritten with zeros in a way that the compiler cannot optimize
+ *  away.
+ *
+ *  The cache keeps hit, miss, insert, and eviction counters so that the
+ *  memory budget can be tuned.
+ *
+ *  The cache does no locking.  If it is shared between threads, the
+ *  caller must serialize access.
+ *
+ * ========================================================================== **
+ */
+
+#include "HashCache.h"
+#include "MD5.h"
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  HC_WAYS - The number of entries in each set.  A set is searched
+ *            linearly, and the least recently used entry in the set is
+ *            the one evicted.  Eight entries of 52 bytes is a handful of
+ *            cache lines.
+ */
+
+#define HC_WAYS 8
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static auth_hcEntry *SetOf( const auth_HashCache *hc, const uchar key[16] )
+  /* ------------------------------------------------------------------------ **
+   * Find the set to which a key belongs.
+   *
+   *  Input:  hc  - A pointer to the cache.
+   *          key - The 16-byte key (the MD5 of the credential).
+   *
+   *  Output: A pointer to the first entry in the set.
+   *
+   *  Notes:  The key is already a good hash, so the first four bytes are
+   *          used directly.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t h;
+
+  h = (uint32_t)key[0]
+    | ((uint32_t)key[1] << 8)
+    | ((uint32_t)key[2] << 16)
+    | ((uint32_t)key[3] << 24);
+  return( &hc->table[(h & ((hc->slots / HC_WAYS) - 1)) * HC_WAYS] );
+  } /* SetOf */
+
+
+static auth_hcEntry *Find( const auth_HashCache *hc, const uchar key[16] )
+  /* ------------------------------------------------------------------------ **
+   * Search for a key in the cache.
+   *
+   *  Input:  hc  - A pointer to the cache.
+   *          key - The 16-byte key.
+   *
+   *  Output: A pointer to the matching entry, or NULL if not found.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  auth_hcEntry *set = SetOf( hc, key );
+  int           i;
+
+  for( i = 0; i < HC_WAYS; i++ )
+    {
+    if( (0 != set[i].stamp) && (0 == memcmp( set[i].key, key, 16 )) )
+      return( &set[i] );
+    }
+  return( NULL );
+  } /* Find */
+
+
+static uint32_t Tick( auth_HashCache *hc )
+  /* ------------------------------------------------------------------------ **
+   * Advance the cache clock.
+   *
+   *  Input:  hc  - A pointer to the cache.
+   *
+   *  Output: The new clock value, to be used as an entry stamp.
+   *
+   *  Notes:  Zero marks an empty entry, so the clock skips it.  If the
+   *          clock wraps, all live entries are given a stamp of one.
+   *          Recency information is lost, but only once every four
+   *          billion operations.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t i;
+
+  if( 0 == ++(hc->clock) )
+    {
+    for( i = 0; i < hc->slots; i++ )
+      {
+      if( 0 != hc->table[i].stamp )
+        hc->table[i].stamp = 1;
+      }
+    hc->clock = 2;
+    }
+  return( hc->clock );
+  } /* Tick */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+auth_HashCache *auth_hcInit( auth_HashCache *hc,
+                             void           *mem,
+                             const size_t    memsize )
+  /* ------------------------------------------------------------------------ **
+   * Initialize a hash cache within a caller-supplied block of memory.
+   *
+   *  Input:  hc      - A pointer to the cache header to be initialized.
+   *          mem     - A pointer to the memory that will hold the table.
+   *                    It must be suitably aligned for a uint32_t.
+   *          memsize - The size, in bytes, of <mem>.  This is the memory
+   *                    budget for the cache.
+   *
+   *  Output: A pointer to the initialized cache (same as <hc>), or NULL
+   *          if <memsize> is too small to hold even one set of entries.
+   *
+   *  Notes:  The number of sets is rounded down to a power of two, so
+   *          some of <mem> may go unused.  <hc>->slots gives the number
+   *          of entries actually available.
+   *
+   *          The memory is cleared.  It belongs to the cache until
+   *          <auth_hcClear()> has been called.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t max  = (uint32_t)(memsize / (HC_WAYS * sizeof( auth_hcEntry )));
+  uint32_t sets = 1;
+
+  if( max < 1 )
+    return( NULL );
+  while( (sets << 1) <= max )
+    sets <<= 1;
+
+  hc->table     = (auth_hcEntry *)mem;
+  hc->slots     = sets * HC_WAYS;
+  hc->count     = 0;
+  hc->clock     = 0;
+  hc->hits      = 0;
+  hc->misses    = 0;
+  hc->inserts   = 0;
+  hc->evictions = 0;
+  auth_SecureZero( hc->table, hc->slots * sizeof( auth_hcEntry ) );
+  return( hc );
+  } /* auth_hcInit */
+
+
+bool auth_hcLookup( auth_HashCache *hc,
+                    const uchar    *cred,
+                    const int       credlen,
+                    uchar          *lm,
+                    uchar          *nt )
+  /* ------------------------------------------------------------------------ **
+   * Look up the hashes for a credential.
+   *
+   *  Input:  hc      - A pointer to the cache.
+   *          cred    - The credential.
+   *          credlen - The length, in bytes, of <cred>.
+   *          lm      - If not NULL, a pointer to 16 bytes into which the
+   *                    cached LM hash will be copied.
+   *          nt      - If not NULL, a pointer to 16 bytes into which the
+   *                    cached NT hash will be copied.
+   *
+   *  Output: true if the credential was found (a hit), else false.
+   *
+   *  Notes:  A hit marks the entry as most recently used.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar         key[16];
+  auth_hcEntry *e;
+
+  (void)auth_md5Sum( key, cred, credlen );
+  e = Find( hc, key );
+  auth_SecureZero( key, sizeof( key ) );
+  if( NULL == e )
+    {
+    hc->misses++;
+    return( false );
+    }
+
+  hc->hits++;
+  e->stamp = Tick( hc );
+  if( NULL != lm )
+    (void)memcpy( lm, e->lm, 16 );
+  if( NULL != nt )
+    (void)memcpy( nt, e->nt, 16 );
+  return( true );
+  } /* auth_hcLookup */
+
+
+void auth_hcInsert( auth_HashCache *hc,
+                    const uchar    *cred,
+                    const int       credlen,
+                    const uchar    *lm,
+                    const uchar    *nt )
+  /* ------------------------------------------------------------------------ **
+   * Add the hashes for a credential to the cache.
+   *
+   *  Input:  hc      - A pointer to the cache.
+   *          cred    - The credential.
+   *          credlen - The length, in bytes, of <cred>.
+   *          lm      - Pointer to the 16-byte LM hash, or NULL.
+   *          nt      - Pointer to the 16-byte NT hash, or NULL.
+   *
+   *  Output: none.
+   *
+   *  Notes:  If the credential is already cached, the entry is updated.
+   *          Otherwise, an empty entry in the credential's set is used,
+   *          or the least recently used entry in that set is evicted.
+   *
+   *          A NULL <lm> or <nt> is stored as sixteen zero bytes.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar         key[16];
+  auth_hcEntry *set;
+  auth_hcEntry *e;
+  int           i;
+
+  (void)auth_md5Sum( key, cred, credlen );
+  e = Find( hc, key );
+  if( NULL == e )
+    {
+    /* Pick an empty way, or else the one with the oldest stamp.
+     */
+    set = SetOf( hc, key );
+    e   = NULL;
+    for( i = 0; i < HC_WAYS; i++ )
+      {
+      if( 0 == set[i].stamp )
+        {
+        e = &set[i];
+        break;
+        }
+      if( (NULL == e) || (set[i].stamp < e->stamp) )
+        e = &set[i];
+      }
+    if( 0 == e->stamp )
+      hc->count++;
+    else
+      {
+      hc->evictions++;
+      auth_SecureZero( e, sizeof( auth_hcEntry ) );
+      }
+    (void)memcpy( e->key, key, 16 );
+    }
+  auth_SecureZero( key, sizeof( key ) );
+
+  if( NULL == lm )
+    (void)memset( e->lm, 0, 16 );
+  else
+    (void)memcpy( e->lm, lm, 16 );
+  if( NULL == nt )
+    (void)memset( e->nt, 0, 16 );
+  else
+    (void)memcpy( e->nt, nt, 16 );
+  e->stamp = Tick( hc );
+  hc->inserts++;
+  } /* auth_hcInsert */
+
+
+bool auth_hcRemove( auth_HashCache *hc,
+                    const uchar    *cred,
+                    const int       credlen )
+  /* ------------------------------------------------------------------------ **
+   * Remove a credential from the cache.
+   *
+   *  Input:  hc      - A pointer to the cache.
+   *          cred    - The credential.
+   *          credlen - The length, in bytes, of <cred>.
+   *
+   *  Output: true if the credential was found and removed, else false.
+   *
+   *  Notes:  Call this when an account's password changes.  The entry
+   *          is securely cleared.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar         key[16];
+  auth_hcEntry *e;
+
+  (void)auth_md5Sum( key, cred, credlen );
+  e = Find( hc, key );
+  auth_SecureZero( key, sizeof( key ) );
+  if( NULL == e )
+    return( false );
+
+  auth_SecureZero( e, sizeof( auth_hcEntry ) );
+  hc->count--;
+  return( true );
+  } /* auth_hcRemove */
+
+
+void auth_hcClear( auth_HashCache *hc )
+  /* ------------------------------------------------------------------------ **
+   * Securely clear the entire cache.
+   *
+   *  Input:  hc  - A pointer to the cache.
+   *
+   *  Output: none.
+   *
+   *  Notes:  All entries are overwritten with zeros.  The counters are
+   *          not reset.  The cache may still be used afterward, or the
+   *          memory may be released.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  auth_SecureZero( hc->table, hc->slots * sizeof( auth_hcEntry ) );
+  hc->count = 0;
+  hc->clock = 0;
+  } /* auth_hcClear */
+
+
+auth_hcStats *auth_hcGetStats( const auth_HashCache *hc,
+                               auth_hcStats         *stats )
+  /* ------------------------------------------------------------------------ **
+   * Retrieve the cache counters.
+   *
+   *  Input:  hc    - A pointer to the cache.
+   *          stats - A pointer to a structure to receive the counters.
+   *
+   *  Output: A pointer to the filled-in structure (same as <stats>).
+   *
+   *  Notes:  Counters are 32 bits wide, and simply wrap.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  stats->hits      = hc->hits;
+  stats->misses    = hc->misses;
+  stats->inserts   = hc->inserts;
+  stats->evictions = hc->evictions;
+  stats->entries   = hc->count;
+  stats->slots     = hc->slots;
+  return( stats );
+  } /* auth_hcGetStats */
+
+/* ========================================================================== */
@@ -0,0 +1,246 @@
+#ifndef AUTH_HASHCACHE_H
+#define AUTH_HASHCACHE_H
+/* ========================================================================== **
+ *
+ *                                HashCache.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  A bounded cache of LM and NT password hashes.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Generating the LM hash costs two DES operations, and the NT hash an
+ *  MD4 pass.  A gateway that sets up many sessions for the same handful
+ *  of service accounts does that work over and over.  This module keeps
+ *  the results around.
+ *
+ *  The cache lives entirely within a block of memory supplied by the
+ *  caller, so the memory budget is fixed when the cache is created.  The
+ *  table is a flat array of entries, divided into sets of HC_WAYS entries
+ *  each.  A credential always maps to the same set, and that set is
+ *  searched linearly.  When a set is full, the least recently used entry
+ *  in that set is evicted.  There are no pointers and no per-entry
+ *  allocation.
+ *
+ *  Entries are keyed by the MD5 of the credential, rather than the
+ *  credential itself, so no cleartext is kept.  The credential is simply
+ *  a string of bytes.  The caller decides what goes into it (eg., the
+ *  domain, user name, and password, all run together).  Evicted and
+ *  removed entries, and the key built on the stack for each call, are
+ *  overwritten with zeros in a way that the compiler cannot optimize
+ *  away.
+ *
+ *  The cache keeps hit, miss, insert, and eviction counters so that the
+ *  memory budget can be tuned.
+ *
+ *  The cache does no locking.  If it is shared between threads, the
+ *  caller must serialize access.
+ *
+ * ========================================================================== **
+ */
+
+#include "auth_common.h"
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  auth_hcEntry    - One cache entry.  An entry with a <stamp> of zero is
+ *                    empty.
+ *  auth_HashCache  - The cache header.  Treat the fields as read-only.
+ *  auth_hcStats    - Cache counters, as returned by auth_hcGetStats().
+ */
+
+typedef struct
+  {
+  uchar    key[16];       /* MD5 of the credential.      */
+  uchar    lm[16];        /* Cached LM hash.             */
+  uchar    nt[16];        /* Cached NT hash.             */
+  uint32_t stamp;         /* Last use; zero means empty. */
+  } auth_hcEntry;
+
+typedef struct
+  {
+  auth_hcEntry *table;
+  uint32_t      slots;
+  uint32_t      count;
+  uint32_t      clock;
+  uint32_t      hits;
+  uint32_t      misses;
+  uint32_t      inserts;
+  uint32_t      evictions;
+  } auth_HashCache;
+
+typedef struct
+  {
+  uint32_t hits;          /* Lookups that found the credential.     */
+  uint32_t misses;        /* Lookups that did not.                  */
+  uint32_t inserts;       /* Entries added or updated.              */
+  uint32_t evictions;     /* Entries pushed out to make room.       */
+  uint32_t entries;       /* Entries currently in use.              */
+  uint32_t slots;         /* Total number of entries in the table.  */
+  } auth_hcStats;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+auth_HashCache *auth_hcInit( auth_HashCache *hc,
+                             void           *mem,
+                             const size_t    memsize );
+  /* ------------------------------------------------------------------------ **
+   * Initialize a hash cache within a caller-supplied block of memory.
+   *
+   *  Input:  hc      - A pointer to the cache header to be initialized.
+   *          mem     - A pointer to the memory that will hold the table.
+   *                    It must be suitably aligned for a uint32_t.
+   *          memsize - The size, in bytes, of <mem>.  This is the memory
+   *                    budget for the cache.
+   *
+   *  Output: A pointer to the initialized cache (same as <hc>), or NULL
+   *          if <memsize> is too small to hold even one set of entries.
+   *
+   *  Notes:  The number of sets is rounded down to a power of two, so
+   *          some of <mem> may go unused.  <hc>->slots gives the number
+   *          of entries actually available.
+   *
+   *          The memory is cleared.  It belongs to the cache until
+   *          <auth_hcClear()> has been called.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool auth_hcLookup( auth_HashCache *hc,
+                    const uchar    *cred,
+                    const int       credlen,
+                    uchar          *lm,
+                    uchar          *nt );
+  /* ------------------------------------------------------------------------ **
+   * Look up the hashes for a credential.
+   *
+   *  Input:  hc      - A pointer to the cache.
+   *          cred    - The credential.
+   *          credlen - The length, in bytes, of <cred>.
+   *          lm      - If not NULL, a pointer to 16 bytes into which the
+   *                    cached LM hash will be copied.
+   *          nt      - If not NULL, a pointer to 16 bytes into which the
+   *                    cached NT hash will be copied.
+   *
+   *  Output: true if the credential was found (a hit), else false.
+   *
+   *  Notes:  A hit marks the entry as most recently used.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void auth_hcInsert( auth_HashCache *hc,
+                    const uchar    *cred,
+                    const int       credlen,
+                    const uchar    *lm,
+                    const uchar    *nt );
+  /* ------------------------------------------------------------------------ **
+   * Add the hashes for a credential to the cache.
+   *
+   *  Input:  hc      - A pointer to the cache.
+   *          cred    - The credential.
+   *          credlen - The length, in bytes, of <cred>.
+   *          lm      - Pointer to the 16-byte LM hash, or NULL.
+   *          nt      - Pointer to the 16-byte NT hash, or NULL.
+   *
+   *  Output: none.
+   *
+   *  Notes:  If the credential is already cached, the entry is updated.
+   *          Otherwise, an empty entry in the credential's set is used,
+   *          or the least recently used entry in that set is evicted.
+   *
+   *          A NULL <lm> or <nt> is stored as sixteen zero bytes.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool auth_hcRemove( auth_HashCache *hc,
+                    const uchar    *cred,
+                    const int       credlen );
+  /* ------------------------------------------------------------------------ **
+   * Remove a credential from the cache.
+   *
+   *  Input:  hc      - A pointer to the cache.
+   *          cred    - The credential.
+   *          credlen - The length, in bytes, of <cred>.
+   *
+   *  Output: true if the credential was found and removed, else false.
+   *
+   *  Notes:  Call this when an account's password changes.  The entry
+   *          is securely cleared.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void auth_hcClear( auth_HashCache *hc );
+  /* ------------------------------------------------------------------------ **
+   * Securely clear the entire cache.
+   *
+   *  Input:  hc  - A pointer to the cache.
+   *
+   *  Output: none.
+   *
+   *  Notes:  All entries are overwritten with zeros.  The counters are
+   *          not reset.  The cache may still be used afterward, or the
+   *          memory may be released.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+auth_hcStats *auth_hcGetStats( const auth_HashCache *hc,
+                               auth_hcStats         *stats );
+  /* ------------------------------------------------------------------------ **
+   * Retrieve the cache counters.
+   *
+   *  Input:  hc    - A pointer to the cache.
+   *          stats - A pointer to a structure to receive the counters.
+   *
+   *  Output: A pointer to the filled-in structure (same as <stats>).
+   *
+   *  Notes:  Counters are 32 bits wide, and simply wrap.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* AUTH_HASHCACHE_H */
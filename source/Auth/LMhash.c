@@ -74,6 +74,18 @@ static const uchar SMB_LMhash_Magic[8] =
   { 'K', 'G', 'S', '!', '@', '#', '$', '%' };
 
 
+/* -------------------------------------------------------------------------- **
+ * Macros:
+ *
+ *  LM_BATCH  - The number of passwords handled in each pass through
+ *              auth_LMhashN().  Each password produces two DES keys, so
+ *              this is half the number of DES blocks passed to
+ *              auth_DEShashN() at a time.
+ */
+
+#define LM_BATCH 128
+
+
 /* -------------------------------------------------------------------------- **
  * Functions:
  */
@@ -104,9 +116,10 @@ uchar *auth_LMhash( uchar *dst, const uchar *pwd, const int pwdlen )
    * ------------------------------------------------------------------------ **
    */
   {
-  int     i,
-          max14;
-  uint8_t tmp_pwd[14] = { 0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
+  int              i,
+                   max14;
+  uint8_t          tmp_pwd[14] = { 0,0,0,0,0,0,0,0,0,0,0,0,0,0 };
+  auth_DESschedule ks;
 
   /* Copy at most 14 bytes of <pwd> into <tmp_pwd>.
    * If the password is less than 14 bytes long
@@ -120,8 +133,10 @@ uchar *auth_LMhash( uchar *dst, const uchar *pwd, const int pwdlen )
    * are used to DES-encrypt the magic string.  The results are
    * concatonated to produce the 16-byte LM Hash.
    */
-  (void)auth_DEShash(  dst,     tmp_pwd,    SMB_LMhash_Magic );
-  (void)auth_DEShash( &dst[8], &tmp_pwd[7], SMB_LMhash_Magic );
+  (void)auth_DESexpandKey( &ks, tmp_pwd );
+  (void)auth_DESencrypt( dst, &ks, SMB_LMhash_Magic );
+  (void)auth_DESexpandKey( &ks, &tmp_pwd[7] );
+  (void)auth_DESencrypt( &dst[8], &ks, SMB_LMhash_Magic );
 
   /* Return a pointer to the result.
    */
@@ -129,6 +144,137 @@ uchar *auth_LMhash( uchar *dst, const uchar *pwd, const int pwdlen )
   } /* auth_LMhash */
 
 
+uchar **auth_LMhashN( uchar       *dst[],
+                      const uchar *pwd[],
+                      const int    pwdlen[],
+                      const int    n )
+  /* ------------------------------------------------------------------------ **
+   * Generate LM Hashes from a batch of passwords.
+   *
+   *  Input:  dst     - Array of <n> pointers to locations to which to write
+   *                    the LM Hashes.  Each requires 16 bytes minimum.
+   *          pwd     - Array of <n> source passwords.  See auth_LMhash().
+   *          pwdlen  - Array of <n> password lengths, in bytes.
+   *          n       - The number of passwords.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is byte-for-byte the same as calling
+   *          auth_LMhash( dst[i], pwd[i], pwdlen[i] ) for each <i>.
+   *
+   *        - This function uses the bitsliced auth_DEShashN(), so it is
+   *          only worth calling with large numbers of passwords.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar        tmp_pwd[LM_BATCH][14];
+  const uchar *key[2 * LM_BATCH];
+  const uchar *src[2 * LM_BATCH];
+  uchar       *out[2 * LM_BATCH];
+  int          base, count;
+  int          i, j, max14;
+
+  for( i = 0; i < (2 * LM_BATCH); i++ )
+    src[i] = SMB_LMhash_Magic;
+
+  for( base = 0; base < n; base += LM_BATCH )
+    {
+    count = ((n - base) < LM_BATCH) ? (n - base) : LM_BATCH;
+
+    /* Pad each password, and split it into two 7-byte keys.
+     */
+    for( i = 0; i < count; i++ )
+      {
+      max14 = pwdlen[base + i] > 14 ? 14 : pwdlen[base + i];
+      for( j = 0; j < max14; j++ )
+        tmp_pwd[i][j] = pwd[base + i][j];
+      for( ; j < 14; j++ )
+        tmp_pwd[i][j] = 0;
+      key[2 * i]       = tmp_pwd[i];
+      key[(2 * i) + 1] = &tmp_pwd[i][7];
+      out[2 * i]       = dst[base + i];
+      out[(2 * i) + 1] = &dst[base + i][8];
+      }
+
+    (void)auth_DEShashN( out, key, src, 2 * count );
+    }
+
+  return( dst );
+  } /* auth_LMhashN */
+
+
+auth_DESschedule *auth_LMresponseKeys( auth_DESschedule ks[3],
+                                       const uchar     *hash )
+  /* ------------------------------------------------------------------------ **
+   * Generate the three DES key schedules used to compute LM (or NTLM)
+   * responses from a given password hash.
+   *
+   *  Input:  ks    - An array of three key schedules, to be filled in.
+   *          hash  - Pointer to the 16-byte password hash.
+   *
+   *  Output: A pointer to the array of key schedules (same as <ks>).
+   *
+   *  Notes:  The 16-byte hash is split into three 7-byte DES keys.  The
+   *          third key is made up of the last two bytes of the hash plus
+   *          five nul bytes of padding.
+   *
+   *        - The key schedules depend only upon the password hash.  A
+   *          server that validates many responses for the same account
+   *          can generate the key schedules once, keep them with the
+   *          hash, and then call <auth_LMresponseKS()> for each new
+   *          challenge.
+   *
+   *        - The key schedules are as sensitive as the hash itself.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar tmp[7] =
+    { hash[14], hash[15], 0,0,0,0,0 };  /* 3rd key is nul-padded. */
+
+  (void)auth_DESexpandKey( &ks[0],  hash );
+  (void)auth_DESexpandKey( &ks[1], &hash[7] );
+  (void)auth_DESexpandKey( &ks[2],  tmp );
+  return( ks );
+  } /* auth_LMresponseKeys */
+
+
+uchar *auth_LMresponseKS( uchar                  *dst,
+                          const auth_DESschedule  ks[3],
+                          const uchar            *challenge )
+  /* ------------------------------------------------------------------------ **
+   * Generate the LM (or NTLM) response from pre-computed key schedules.
+   *
+   *  Input:  dst       - Pointer to memory into which to write the response.
+   *                      Must have 24 bytes available.
+   *          ks        - The three key schedules, as generated by
+   *                      <auth_LMresponseKeys()>.
+   *          challenge - Pointer to the 8-byte challenge.
+   *
+   *  Output: A pointer to the 24-byte response (same as <dst>).
+   *
+   *  Notes:  The result is identical to that of <auth_LMresponse()>, but
+   *          the key setup is skipped.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar chal[8];
+  int   i;
+
+  /* Copy the challenge, in case <dst> and <challenge> overlap.
+   */
+  for( i = 0; i < 8; i++ )
+    chal[i] = challenge[i];
+
+  (void)auth_DESencrypt(  dst,     &ks[0], chal );
+  (void)auth_DESencrypt( &dst[8],  &ks[1], chal );
+  (void)auth_DESencrypt( &dst[16], &ks[2], chal );
+  return( dst );
+  } /* auth_LMresponseKS */
+
+
 uchar *auth_LMresponse( uchar *dst, const uchar *hash, const uchar *challenge )
   /* ------------------------------------------------------------------------ **
    * Generate the LM (or NTLM) response from the password hash and challenge.
@@ -147,8 +293,7 @@ uchar *auth_LMresponse( uchar *dst, const uchar *hash, const uchar *challenge )
    * ------------------------------------------------------------------------ **
    */
   {
-  uchar tmp[7] =
-    { hash[14], hash[15], 0,0,0,0,0 };  /* 3rd key is nul-padded. */
+  auth_DESschedule ks[3];
 
   /* It's painfully simple...
    * The challenge is DES encrypted three times.
@@ -157,13 +302,8 @@ uchar *auth_LMresponse( uchar *dst, const uchar *hash, const uchar *challenge )
    * The third time, the two remaining hash bytes plus five nuls are used.
    * The three 8-byte results are concatonated to form the 24-byte response.
    */
-  (void)auth_DEShash(  dst,     hash,    challenge );
-  (void)auth_DEShash( &dst[8], &hash[7], challenge );
-  (void)auth_DEShash( &dst[16], tmp,     challenge );
-
-  /* Return the result.
-   */
-  return( dst );
+  (void)auth_LMresponseKeys( ks, hash );
+  return( auth_LMresponseKS( dst, ks, challenge ) );
   } /* auth_LMresponse */
 
 /* ========================================================================== */
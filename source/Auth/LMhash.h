@@ -60,6 +60,8 @@
  * ========================================================================== **
  */
 
+#include "DES.h"
+
 
 /* -------------------------------------------------------------------------- **
  * Functions:
@@ -92,6 +94,31 @@ uchar *auth_LMhash( uchar *dst, const uchar *pwd, const int pwdlen );
    */
 
 
+uchar **auth_LMhashN( uchar       *dst[],
+                      const uchar *pwd[],
+                      const int    pwdlen[],
+                      const int    n );
+  /* ------------------------------------------------------------------------ **
+   * Generate LM Hashes from a batch of passwords.
+   *
+   *  Input:  dst     - Array of <n> pointers to locations to which to write
+   *                    the LM Hashes.  Each requires 16 bytes minimum.
+   *          pwd     - Array of <n> source passwords.  See auth_LMhash().
+   *          pwdlen  - Array of <n> password lengths, in bytes.
+   *          n       - The number of passwords.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is byte-for-byte the same as calling
+   *          auth_LMhash( dst[i], pwd[i], pwdlen[i] ) for each <i>.
+   *
+   *        - This function uses the bitsliced auth_DEShashN(), so it is
+   *          only worth calling with large numbers of passwords.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 uchar *auth_LMresponse( uchar *dst, const uchar *hash, const uchar *challenge );
   /* ------------------------------------------------------------------------ **
    * Generate the LM (or NTLM) response from the password hash and challenge.
@@ -111,5 +138,51 @@ uchar *auth_LMresponse( uchar *dst, const uchar *hash, const uchar *challenge );
    */
 
 
+auth_DESschedule *auth_LMresponseKeys( auth_DESschedule ks[3],
+                                       const uchar     *hash );
+  /* ------------------------------------------------------------------------ **
+   * Generate the three DES key schedules used to compute LM (or NTLM)
+   * responses from a given password hash.
+   *
+   *  Input:  ks    - An array of three key schedules, to be filled in.
+   *          hash  - Pointer to the 16-byte password hash.
+   *
+   *  Output: A pointer to the array of key schedules (same as <ks>).
+   *
+   *  Notes:  The key schedules depend only upon the password hash.  A
+   *          server that validates many responses for the same account
+   *          can generate the key schedules once, keep them with the
+   *          hash, and then call <auth_LMresponseKS()> for each new
+   *          challenge.
+   *
+   *        - The key schedules are as sensitive as the hash itself.
+   *
+   *  See Also:  <auth_LMresponseKS()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_LMresponseKS( uchar                  *dst,
+                          const auth_DESschedule  ks[3],
+                          const uchar            *challenge );
+  /* ------------------------------------------------------------------------ **
+   * Generate the LM (or NTLM) response from pre-computed key schedules.
+   *
+   *  Input:  dst       - Pointer to memory into which to write the response.
+   *                      Must have 24 bytes available.
+   *          ks        - The three key schedules, as generated by
+   *                      <auth_LMresponseKeys()>.
+   *          challenge - Pointer to the 8-byte challenge.
+   *
+   *  Output: A pointer to the 24-byte response (same as <dst>).
+   *
+   *  Notes:  The result is identical to that of <auth_LMresponse()>, but
+   *          the key setup is skipped.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 /* ========================================================================== */
 #endif /* AUTH_LMHASH_H */
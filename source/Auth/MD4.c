@@ -57,6 +57,16 @@
  *     some embedded environments.
  *  Beyond that, cleanliness and clarity are always worth pursuing.
  *
+ *  Later on, speed was added to the list.  MD4 is used to generate the NT
+ *  hash, and some callers (servers validating lots of logins) generate
+ *  a great many of those.  The compression function is now fully unrolled,
+ *  and on little-endian hosts the message words are loaded directly from
+ *  memory.  The portable byte-at-a-time load is still used elsewhere.
+ *  An incremental (context-based) interface has also been added, in the
+ *  same shape as the one in the MD5 module.  Finally, auth_NThash() widens
+ *  the password into the message block itself and, for short passwords,
+ *  runs a single-block MD4 with no context at all.
+ *
  *  As mentioned above, the code really only makes sense if you are familiar
  *  with the MD4 algorithm or are using RFC 1320 as a guide.  This code is
  *  quirky, however, so you'll want to be reading carefully.
@@ -73,55 +83,28 @@
 #include "MD4.h"
 
 
-/* -------------------------------------------------------------------------- **
- * Static Constants:
- *
- *  Round2_k  - In each round, there is a value (given the label 'k') used
- *              to indicate the longword stored in X[] that should be used
- *              per iteration.  In round one, k is simply 0, 1, 2, ... but
- *              it gets a little more complicated in round 2.  I actually
- *              figured out a simple algorithm to calculate the correct k
- *              in round 2, but storing the sequence seems much easier.
- *
- *  Round3_k  - There's probably a way to calculate this sequence on the
- *              fly as well.  Storing it seems easier and quicker (from
- *              a running program point of view).
- *
- *  S[][]     - In each round there is a left rotate operation performed as
- *              part of the 16 permutations.  The number of bits varies in
- *              a repeating patter.  This array keeps track of the patterns
- *              used in each round.
- */
-
-static const uint8_t Round2_k[] =
-  {
-  0, 4,  8, 12,
-  1, 5,  9, 13,
-  2, 6, 10, 14,
-  3, 7, 11, 15
-  };
-
-static const uint8_t Round3_k[] =
-  {
-  0,  8, 4, 12,
-  2, 10, 6, 14,
-  1,  9, 5, 13,
-  3, 11, 7, 15
-  };
-
-static const uint8_t S[3][4] =
-  {
-    { 3, 7, 11, 19 },   /* round 0 */
-    { 3, 5,  9, 13 },   /* round 1 */
-    { 3, 9, 11, 15 }    /* round 2 */
-  };
-
-
 /* -------------------------------------------------------------------------- **
  * Macros:
  *  md4F(), md4G(), and md4H() are described in RFC 1320.
  *  All of these operations are bitwise, and so not impacted by endian-ness.
  *
+ *  ROTL32()
+ *    Rotate a 32-bit value left by <s> bits.
+ *
+ *  md4R1(), md4R2(), md4R3()
+ *    A single step of round 1, 2, or 3 (respectively).  Each step mangles
+ *    one of the four "registers" (<a>), using the other three, the <k>th
+ *    longword of the message block, and a left rotation of <s> bits.  The
+ *    value 0x5A827999 is trunc( (2^30) * sqrt(2) ) and 0x6ED9EBA1 is
+ *    trunc( (2^30) * sqrt(3) ).
+ *
+ *  md4Rounds()
+ *    All three rounds of sixteen steps each, written out in full.  The
+ *    order in which the X[] values are used in each round, and the
+ *    rotation amounts, are given in RFC 1320.  The message block must be
+ *    in an array named X[].  Only plain C operators are used, so the same
+ *    macro also works on vector types (see PermuteLanes4()).
+ *
  *  GetLongByte()
  *    Extract one byte from a (32-bit) longword.  A value of 0 for <idx>
  *    indicates the lowest order byte, while 3 indicates the highest order
@@ -133,9 +116,63 @@ static const uint8_t S[3][4] =
 #define md4G( X, Y, Z ) ( ((X) & (Y)) | ((X) & (Z)) | ((Y) & (Z)) )
 #define md4H( X, Y, Z ) ( (X) ^ (Y) ^ (Z) )
 
+#define ROTL32( V, s ) ( 0xFFFFFFFF & (((V) << (s)) | ((V) >> (32 - (s)))) )
+
+#define md4R1( a, b, c, d, k, s ) \
+  (a) = ROTL32( 0xFFFFFFFF & ((a) + md4F( b, c, d ) + X[k]), s )
+#define md4R2( a, b, c, d, k, s ) \
+  (a) = ROTL32( 0xFFFFFFFF & ((a) + md4G( b, c, d ) + X[k] + 0x5A827999), s )
+#define md4R3( a, b, c, d, k, s ) \
+  (a) = ROTL32( 0xFFFFFFFF & ((a) + md4H( b, c, d ) + X[k] + 0x6ED9EBA1), s )
+
+#define md4Rounds( a, b, c, d ) \
+  md4R1( a, b, c, d,  0,  3 );  md4R1( d, a, b, c,  1,  7 ); \
+  md4R1( c, d, a, b,  2, 11 );  md4R1( b, c, d, a,  3, 19 ); \
+  md4R1( a, b, c, d,  4,  3 );  md4R1( d, a, b, c,  5,  7 ); \
+  md4R1( c, d, a, b,  6, 11 );  md4R1( b, c, d, a,  7, 19 ); \
+  md4R1( a, b, c, d,  8,  3 );  md4R1( d, a, b, c,  9,  7 ); \
+  md4R1( c, d, a, b, 10, 11 );  md4R1( b, c, d, a, 11, 19 ); \
+  md4R1( a, b, c, d, 12,  3 );  md4R1( d, a, b, c, 13,  7 ); \
+  md4R1( c, d, a, b, 14, 11 );  md4R1( b, c, d, a, 15, 19 ); \
+  md4R2( a, b, c, d,  0,  3 );  md4R2( d, a, b, c,  4,  5 ); \
+  md4R2( c, d, a, b,  8,  9 );  md4R2( b, c, d, a, 12, 13 ); \
+  md4R2( a, b, c, d,  1,  3 );  md4R2( d, a, b, c,  5,  5 ); \
+  md4R2( c, d, a, b,  9,  9 );  md4R2( b, c, d, a, 13, 13 ); \
+  md4R2( a, b, c, d,  2,  3 );  md4R2( d, a, b, c,  6,  5 ); \
+  md4R2( c, d, a, b, 10,  9 );  md4R2( b, c, d, a, 14, 13 ); \
+  md4R2( a, b, c, d,  3,  3 );  md4R2( d, a, b, c,  7,  5 ); \
+  md4R2( c, d, a, b, 11,  9 );  md4R2( b, c, d, a, 15, 13 ); \
+  md4R3( a, b, c, d,  0,  3 );  md4R3( d, a, b, c,  8,  9 ); \
+  md4R3( c, d, a, b,  4, 11 );  md4R3( b, c, d, a, 12, 15 ); \
+  md4R3( a, b, c, d,  2,  3 );  md4R3( d, a, b, c, 10,  9 ); \
+  md4R3( c, d, a, b,  6, 11 );  md4R3( b, c, d, a, 14, 15 ); \
+  md4R3( a, b, c, d,  1,  3 );  md4R3( d, a, b, c,  9,  9 ); \
+  md4R3( c, d, a, b,  5, 11 );  md4R3( b, c, d, a, 13, 15 ); \
+  md4R3( a, b, c, d,  3,  3 );  md4R3( d, a, b, c, 11,  9 ); \
+  md4R3( c, d, a, b,  7, 11 );  md4R3( b, c, d, a, 15, 15 )
+
 #define GetLongByte( L, idx ) ((uchar)(( L >> (((idx) & 0x03) << 3) ) & 0xFF))
 
 
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  MULTILANE - Defined if the compiler supports GCC-style vector types and
+ *              run-time CPU feature checks.  If so, auth_md4SumN() hashes
+ *              four (SSE2) or eight (AVX2) messages at once.  Otherwise,
+ *              it simply calls auth_md4Sum() for each message.
+ *
+ *  md4Vec4   - Four 32-bit lanes.
+ *  md4Vec8   - Eight 32-bit lanes.
+ */
+
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#define MULTILANE 1
+typedef uint32_t md4Vec4 __attribute__ ((vector_size (16)));
+typedef uint32_t md4Vec8 __attribute__ ((vector_size (32)));
+#endif
+
+
 /* -------------------------------------------------------------------------- **
  * Static Functions:
  */
@@ -175,94 +212,600 @@ static void Permute( uint32_t ABCD[4], const uchar block[64] )
    * ------------------------------------------------------------------------ **
    */
   {
-  int      round;
-  int      i, j;
-  uint8_t  s;
-  uint32_t a, b, c, d;
-  uint32_t KeepABCD[4];
+  uint32_t a = ABCD[0];
+  uint32_t b = ABCD[1];
+  uint32_t c = ABCD[2];
+  uint32_t d = ABCD[3];
   uint32_t X[16];
 
-  /* Store the current ABCD values for later re-use.
+  /* Convert the input block into an array of unsigned longs, taking care
+   * to read the block in Little Endian order (the algorithm assumes this).
+   * The uint32_t values are then handled in host order.  On little-endian
+   * hosts, the block can simply be copied.
+   */
+#if defined( cifs_LITTLE_ENDIAN )
+  (void)memcpy( X, block, 64 );
+#else
+  {
+  int i, j;
+
+  for( i = 0, j = 0; i < 16; i++, j += 4 )
+    {
+    X[i] =  (uint32_t)block[j]
+         | ((uint32_t)block[j+1] << 8)
+         | ((uint32_t)block[j+2] << 16)
+         | ((uint32_t)block[j+3] << 24);
+    }
+  }
+#endif
+
+  /* All three rounds.
+   */
+  md4Rounds( a, b, c, d );
+
+  /* Add the original A, B, C, D values to perform
+   * one last convolution.
    */
+  ABCD[0] = 0xFFFFFFFF & ( ABCD[0] + a );
+  ABCD[1] = 0xFFFFFFFF & ( ABCD[1] + b );
+  ABCD[2] = 0xFFFFFFFF & ( ABCD[2] + c );
+  ABCD[3] = 0xFFFFFFFF & ( ABCD[3] + d );
+  } /* Permute */
+
+
+static void SumOneBlock( uchar *dst, uint32_t X[16], const int len )
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD4 sum of a message that fits within a single block.
+   *
+   *  Input:  dst - A pointer to at least 16 bytes of memory, which will
+   *                receive the finished MD4 sum.
+   *          X   - The message, already loaded as sixteen little-endian
+   *                longwords.  Bytes beyond the end of the message must be
+   *                zero.  This array is modified.
+   *          len - The length of the message in bytes.  Must be no more
+   *                than 55.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This is Permute() and auth_md4CloseCtx() rolled into one, for
+   *          the case where there is only one block to process.  There is
+   *          no context, no block buffer, and the padding and length are
+   *          written straight into the message words.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t a = 0x67452301;
+  uint32_t b = 0xefcdab89;
+  uint32_t c = 0x98badcfe;
+  uint32_t d = 0x10325476;
+  int      i;
+
+  X[len >> 2] |= (uint32_t)0x80 << ((len & 3) << 3);
+  X[14] = (uint32_t)len << 3;
+  X[15] = 0;
+
+  md4Rounds( a, b, c, d );
+
+  a = 0xFFFFFFFF & ( a + 0x67452301 );
+  b = 0xFFFFFFFF & ( b + 0xefcdab89 );
+  c = 0xFFFFFFFF & ( c + 0x98badcfe );
+  d = 0xFFFFFFFF & ( d + 0x10325476 );
   for( i = 0; i < 4; i++ )
-    KeepABCD[i] = ABCD[i];
+    {
+    dst[ 0+i] = GetLongByte( a, i );
+    dst[ 4+i] = GetLongByte( b, i );
+    dst[ 8+i] = GetLongByte( c, i );
+    dst[12+i] = GetLongByte( d, i );
+    }
+  } /* SumOneBlock */
 
-  /* Convert the input block into an array of unsigned longs, taking care
-   * to read the block in Little Endian order (the algorithm assumes this).
-   * The uint32_t values are then handled in host order.
+
+static int Utf8Next( const uchar *src, const int len, uint32_t *cp )
+  /* ------------------------------------------------------------------------ **
+   * Decode one character from a UTF-8 string.
+   *
+   *  Input:  src - Pointer to the next byte of the string.
+   *          len - Number of bytes remaining in the string.  Must be at
+   *                least one.
+   *          cp  - Pointer to a longword to receive the code point.
+   *
+   *  Output: The number of bytes consumed (1 to 4).
+   *
+   *  Notes:  Anything that is not a valid, shortest-form UTF-8 sequence
+   *          (including encoded surrogates) is taken one byte at a time,
+   *          and the byte value is returned as the code point.  That is,
+   *          invalid input is treated as ISO Latin-1, which is also what
+   *          the simple "add a zero byte" conversion would have done.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t c = src[0];
+  uint32_t v;
+
+  if( c < 0x80 )
+    {
+    *cp = c;
+    return( 1 );
+    }
+
+  if( (0xC0 == (c & 0xE0)) && (len > 1) && (0x80 == (src[1] & 0xC0)) )
+    {
+    v = ((c & 0x1F) << 6) | (src[1] & 0x3F);
+    if( v >= 0x80 )
+      {
+      *cp = v;
+      return( 2 );
+      }
+    }
+  else if( (0xE0 == (c & 0xF0)) && (len > 2)
+        && (0x80 == (src[1] & 0xC0)) && (0x80 == (src[2] & 0xC0)) )
+    {
+    v = ((c & 0x0F) << 12) | ((src[1] & 0x3F) << 6) | (src[2] & 0x3F);
+    if( (v >= 0x800) && ((v < 0xD800) || (v > 0xDFFF)) )
+      {
+      *cp = v;
+      return( 3 );
+      }
+    }
+  else if( (0xF0 == (c & 0xF8)) && (len > 3) && (0x80 == (src[1] & 0xC0))
+        && (0x80 == (src[2] & 0xC0)) && (0x80 == (src[3] & 0xC0)) )
+    {
+    v = ((c & 0x07) << 18) | ((src[1] & 0x3F) << 12)
+      | ((src[2] & 0x3F) << 6) | (src[3] & 0x3F);
+    if( (v >= 0x10000) && (v <= 0x10FFFF) )
+      {
+      *cp = v;
+      return( 4 );
+      }
+    }
+
+  *cp = c;
+  return( 1 );
+  } /* Utf8Next */
+
+
+#if defined( MULTILANE )
+
+static void PermuteLanes4( uint32_t ABCD[4][8], const uint32_t W[16][8] )
+  /* ------------------------------------------------------------------------ **
+   * Permute four sets of ABCD "registers" at once, using SSE2 vectors.
+   *
+   *  Input:  ABCD  - Four registers for each of up to eight lanes.  Only
+   *                  the first four lanes are used.
+   *          W     - The sixteen message longwords for each lane, already
+   *                  converted from little-endian byte order.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This is the same algorithm as Permute(), applied to each
+   *          lane independently.
+   *
+   * ------------------------------------------------------------------------ **
    */
-  for( i = 0, j = 0; i < 16; i++ )
+  {
+  md4Vec4 a, b, c, d;
+  md4Vec4 A, B, C, D;
+  md4Vec4 X[16];
+  int     i;
+
+  for( i = 0; i < 16; i++ )
+    (void)memcpy( &X[i], W[i], sizeof( md4Vec4 ) );
+  (void)memcpy( &A, ABCD[0], sizeof( md4Vec4 ) );
+  (void)memcpy( &B, ABCD[1], sizeof( md4Vec4 ) );
+  (void)memcpy( &C, ABCD[2], sizeof( md4Vec4 ) );
+  (void)memcpy( &D, ABCD[3], sizeof( md4Vec4 ) );
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+
+  md4Rounds( a, b, c, d );
+
+  a += A;
+  b += B;
+  c += C;
+  d += D;
+  (void)memcpy( ABCD[0], &a, sizeof( md4Vec4 ) );
+  (void)memcpy( ABCD[1], &b, sizeof( md4Vec4 ) );
+  (void)memcpy( ABCD[2], &c, sizeof( md4Vec4 ) );
+  (void)memcpy( ABCD[3], &d, sizeof( md4Vec4 ) );
+  } /* PermuteLanes4 */
+
+
+__attribute__ ((target ("avx2")))
+static void PermuteLanes8( uint32_t ABCD[4][8], const uint32_t W[16][8] )
+  /* ------------------------------------------------------------------------ **
+   * Permute eight sets of ABCD "registers" at once, using AVX2 vectors.
+   *
+   *  Input:  ABCD  - Four registers for each of eight lanes.
+   *          W     - The sixteen message longwords for each lane, already
+   *                  converted from little-endian byte order.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This function is compiled for AVX2 regardless of the compiler
+   *          flags.  It must only be called if the CPU supports AVX2.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  md4Vec8 a, b, c, d;
+  md4Vec8 A, B, C, D;
+  md4Vec8 X[16];
+  int     i;
+
+  for( i = 0; i < 16; i++ )
+    (void)memcpy( &X[i], W[i], sizeof( md4Vec8 ) );
+  (void)memcpy( &A, ABCD[0], sizeof( md4Vec8 ) );
+  (void)memcpy( &B, ABCD[1], sizeof( md4Vec8 ) );
+  (void)memcpy( &C, ABCD[2], sizeof( md4Vec8 ) );
+  (void)memcpy( &D, ABCD[3], sizeof( md4Vec8 ) );
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+
+  md4Rounds( a, b, c, d );
+
+  a += A;
+  b += B;
+  c += C;
+  d += D;
+  (void)memcpy( ABCD[0], &a, sizeof( md4Vec8 ) );
+  (void)memcpy( ABCD[1], &b, sizeof( md4Vec8 ) );
+  (void)memcpy( ABCD[2], &c, sizeof( md4Vec8 ) );
+  (void)memcpy( ABCD[3], &d, sizeof( md4Vec8 ) );
+  } /* PermuteLanes8 */
+
+
+static int Lanes( void )
+  /* ------------------------------------------------------------------------ **
+   * Determine how many lanes to use, based upon the CPU we're running on.
+   *
+   *  Input:  none.
+   *
+   *  Output: 8 if the CPU supports AVX2, else 4.
+   *
+   *  Notes:  The result is computed once and cached.  If two threads race
+   *          to fill in the cache, they will both store the same value.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static int lanes = 0;
+
+  if( 0 == lanes )
     {
-    X[i]  =  (uint32_t)block[j++];
-    X[i] |= ((uint32_t)block[j++] << 8);
-    X[i] |= ((uint32_t)block[j++] << 16);
-    X[i] |= ((uint32_t)block[j++] << 24);
+    __builtin_cpu_init();
+    lanes = __builtin_cpu_supports( "avx2" ) ? 8 : 4;
     }
+  return( lanes );
+  } /* Lanes */
 
-  /* This loop performs the three rounds of permutation.
-   * The three rounds are each very similar.  The differences are in three
-   * areas:
-   *   - The function (F, G, or H) used to perform bitwise permutations on
-   *     the registers,
-   *   - The order in which values from X[] are chosen.
-   *   - Changes to the number of bits by which the registers are rotated.
-   * This implementation uses a switch statement to deal with some of the
-   * differences between rounds.  Other differences are handled by storing
-   * values in arrays and using the round number to select the correct set
-   * of values.
-   *
-   * (My implementation appears to be a poor compromise between speed, size,
-   * and clarity.  Ugh.  [crh])
+
+static const uchar *LaneBlock( uchar        tmp[64],
+                               const uchar *src,
+                               const int    len,
+                               const int    blk,
+                               const bool   last )
+  /* ------------------------------------------------------------------------ **
+   * Return a pointer to the <blk>th 64-byte block of a padded message.
+   *
+   *  Input:  tmp   - Scratch space, used if the block must be padded.
+   *          src   - The message.
+   *          len   - The length of the message, in bytes.
+   *          blk   - The block number.
+   *          last  - True if this is the last block of the padded message,
+   *                  in which case the length field is added.
+   *
+   *  Output: Either a pointer into <src> (if the block is made up entirely
+   *          of message bytes) or <tmp>.
+   *
+   * ------------------------------------------------------------------------ **
    */
-  for( round = 0; round < 3; round++ )
+  {
+  int      off = 64 * blk;
+  int      n   = len - off;
+  int      i;
+  uint32_t l;
+
+  if( n >= 64 )
+    return( &src[off] );
+
+  if( n > 0 )
     {
-    for( i = 0; i < 16; i++ )
+    (void)memcpy( tmp, &src[off], n );
+    (void)memset( &tmp[n], 0, 64 - n );
+    tmp[n] = 0x80;
+    }
+  else
+    {
+    (void)memset( tmp, 0, 64 );
+    if( 0 == n )
+      tmp[0] = 0x80;
+    }
+
+  if( last )
+    {
+    l = (uint32_t)len << 3;
+    for( i = 0; i < 4; i++ )
+      tmp[56+i] = GetLongByte( l, i );
+    tmp[60] = ((GetLongByte( (uint32_t)len, 3 ) & 0xE0) >> 5);
+    }
+  return( tmp );
+  } /* LaneBlock */
+
+
+static void SumLanes( uchar       *dst[],
+                      const uchar *src[],
+                      const int    srclen[],
+                      const int    count,
+                      const int    lanes )
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD4 digests of up to <lanes> messages in parallel.
+   *
+   *  Input:  dst     - Array of <count> pointers to 16-byte result buffers.
+   *          src     - Array of <count> pointers to messages.
+   *          srclen  - Array of <count> message lengths.
+   *          count   - Number of messages (no more than <lanes>).
+   *          lanes   - 4 or 8.
+   *
+   *  Output: none.
+   *
+   *  Notes:  All lanes are run in lock step.  A lane whose message has
+   *          run out of blocks is fed zeros, and its result is ignored.
+   *          This works best when the messages are of similar length.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t     ABCD[4][8];
+  uint32_t     W[16][8];
+  uchar        tmp[8][64];
+  int          nblk[8];
+  int          steps = 0;
+  int          i, j, k, t;
+  const uchar *p;
+
+  for( j = 0; j < lanes; j++ )
+    {
+    ABCD[0][j] = 0x67452301;
+    ABCD[1][j] = 0xefcdab89;
+    ABCD[2][j] = 0x98badcfe;
+    ABCD[3][j] = 0x10325476;
+    nblk[j] = (j < count) ? (((srclen[j] + 8) / 64) + 1) : 0;
+    if( nblk[j] > steps )
+      steps = nblk[j];
+    }
+
+  for( t = 0; t < steps; t++ )
+    {
+    /* Gather the next block from each lane.
+     */
+    for( j = 0; j < lanes; j++ )
       {
-      j = (4 - (i % 4)) & 0x3;  /* <j> handles the rotation of ABCD.          */
-      s = S[round][i%4];        /* <s> is the bit shift for this iteration.   */
+      if( t < nblk[j] )
+        {
+        p = LaneBlock( tmp[j], src[j], srclen[j], t, (t == (nblk[j] - 1)) );
+        for( k = 0; k < 16; k++, p += 4 )
+          {
+#if defined( cifs_LITTLE_ENDIAN )
+          (void)memcpy( &W[k][j], p, 4 );
+#else
+          W[k][j] =  (uint32_t)p[0]        | ((uint32_t)p[1] << 8)
+                  | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+#endif
+          }
+        }
+      else
+        {
+        for( k = 0; k < 16; k++ )
+          W[k][j] = 0;
+        }
+      }
 
-      b = ABCD[(j+1) & 0x3];    /* Copy the b,c,d values per ABCD rotation.   */
-      c = ABCD[(j+2) & 0x3];    /* This isn't really necessary, it just looks */
-      d = ABCD[(j+3) & 0x3];    /* clean & will hopefully be optimized away.  */
+    if( 8 == lanes )
+      PermuteLanes8( ABCD, (const uint32_t (*)[8])W );
+    else
+      PermuteLanes4( ABCD, (const uint32_t (*)[8])W );
 
-      /* The actual perumation function.
-       * This is broken out to minimize the code within the switch().
-       */
-      switch( round )
+    /* Write out the results of any lanes that just finished.
+     */
+    for( j = 0; j < count; j++ )
+      {
+      if( t == (nblk[j] - 1) )
         {
-        case 0:
-          /* round 1 */
-          a = md4F( b, c, d ) + X[i];
-          break;
-        case 1:
-          /* round 2 */
-          /* The value 0x5A827999 is trunc( (2^30) * sqrt(2) ). */
-          a = md4G( b, c, d ) + X[ Round2_k[i] ] + 0x5A827999;
-          break;
-        default:
-          /* round 3 */
-          /* The value 0x6ED9EBA1 is trunc( (2^30) * sqrt(3) ). */
-          a = md4H( b, c, d ) + X[ Round3_k[i] ] + 0x6ED9EBA1;
-          break;
+        for( i = 0; i < 4; i++ )
+          {
+          dst[j][ 0+i] = GetLongByte( ABCD[0][j], i );
+          dst[j][ 4+i] = GetLongByte( ABCD[1][j], i );
+          dst[j][ 8+i] = GetLongByte( ABCD[2][j], i );
+          dst[j][12+i] = GetLongByte( ABCD[3][j], i );
+          }
         }
-      a = 0xFFFFFFFF & ( ABCD[j] + a );
-      ABCD[j] = 0xFFFFFFFF & (( a << s ) | ( a >> (32 - s) ));
       }
     }
+  } /* SumLanes */
 
-  /* Use the stored original A, B, C, D values to perform
-   * one last convolution.
-   */
-  for( i = 0; i < 4; i++ )
-    ABCD[i] = 0xFFFFFFFF & ( ABCD[i] + KeepABCD[i] );
-
-  } /* Permute */
+#endif /* MULTILANE */
 
 
 /* -------------------------------------------------------------------------- **
  * Functions:
  */
 
+auth_md4Ctx *auth_md4InitCtx( auth_md4Ctx *ctx )
+  /* ------------------------------------------------------------------------ **
+   * Initialize an MD4 context.
+   *
+   *  Input:  ctx - A pointer to the MD4 context structure to be initialized.
+   *                Contexts are typically created thusly:
+   *                  ctx = (auth_md4Ctx *)malloc( sizeof(auth_md4Ctx) );
+   *
+   *  Output: A pointer to the initialized context (same as <ctx>).
+   *
+   *  Notes:  The purpose of the context is to make it possible to generate
+   *          an MD4 Message Digest in stages, rather than having to pass a
+   *          single large block to a single MD4 function.  The context
+   *          structure keeps track of various bits of state information.
+   *
+   *          Once the context is initialized, the blocks of message data
+   *          are passed to the <auth_md4SumCtx()> function.  Once the
+   *          final bit of data has been handed to <auth_md4SumCtx()> the
+   *          context can be closed out by calling <auth_md4CloseCtx()>,
+   *          which also calculates the final MD4 result.
+   *
+   *  See Also:  <auth_md4SumCtx()>, <auth_md4CloseCtx()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  ctx->len     = 0;
+  ctx->b_used  = 0;
+
+  ctx->ABCD[0] = 0x67452301;    /* The initial values are those given in RFC */
+  ctx->ABCD[1] = 0xefcdab89;    /* 1320 (pg.3).  As with MD5, RFC 1320 gives */
+  ctx->ABCD[2] = 0x98badcfe;    /* these as little-endian bytes.  The values */
+  ctx->ABCD[3] = 0x10325476;    /* here are endian-agnostic C constants.     */
+  return( ctx );
+  } /* auth_md4InitCtx */
+
+
+auth_md4Ctx *auth_md4SumCtx( auth_md4Ctx *ctx,
+                             const uchar *src,
+                             const int    len )
+  /* ------------------------------------------------------------------------ **
+   * Build an MD4 Message Digest within the given context.
+   *
+   *  Input:  ctx - Pointer to the context in which the MD4 sum is being
+   *                built.
+   *          src - A chunk of source data.  This will be used to drive
+   *                the MD4 algorithm.
+   *          len - The number of bytes in <src>.
+   *
+   *  Output: A pointer to the updated context (same as <ctx>).
+   *
+   *  Notes:  Whole 64-byte blocks are passed to Permute() directly from
+   *          <src>.  Only partial blocks are copied into the context.
+   *
+   *  See Also:  <auth_md4InitCtx()>, <auth_md4CloseCtx()>, <auth_md4Sum()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i = 0;
+  int n;
+
+  /* Add the new block's length to the total length.
+   */
+  ctx->len += (uint32_t)len;
+
+  /* If there is a partial block in the context, top it up first.
+   */
+  if( ctx->b_used > 0 )
+    {
+    n = 64 - ctx->b_used;
+    if( n > len )
+      n = len;
+    (void)memcpy( &ctx->block[ctx->b_used], src, n );
+    ctx->b_used += n;
+    i = n;
+    if( 64 == ctx->b_used )
+      {
+      Permute( ctx->ABCD, ctx->block );
+      ctx->b_used = 0;
+      }
+    }
+
+  /* Run whole blocks straight from the source buffer.
+   */
+  for( ; (len - i) >= 64; i += 64 )
+    Permute( ctx->ABCD, &src[i] );
+
+  /* Keep any leftover bytes for next time.
+   */
+  if( i < len )
+    {
+    (void)memcpy( &ctx->block[ctx->b_used], &src[i], len - i );
+    ctx->b_used += (len - i);
+    }
+
+  return( ctx );
+  } /* auth_md4SumCtx */
+
+
+auth_md4Ctx *auth_md4CloseCtx( auth_md4Ctx *ctx, uchar *dst )
+  /* ------------------------------------------------------------------------ **
+   * Close an MD4 Message Digest context and generate the final MD4 sum.
+   *
+   *  Input:  ctx - Pointer to the context in which the MD4 sum is being
+   *                built.
+   *          dst - A pointer to at least 16 bytes of memory, which will
+   *                receive the finished MD4 sum.
+   *
+   *  Output: A pointer to the closed context (same as <ctx>).
+   *
+   *  Notes:  The context (<ctx>) is returned in an undefined state.
+   *          It must be re-initialized before re-use.
+   *
+   *  See Also:  <auth_md4InitCtx()>, <auth_md4SumCtx()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      i;
+  uint32_t l;
+
+  /* Add the required 0x80 padding initiator byte.
+   * auth_md4SumCtx() always permutes and resets the context block when it
+   * gets full, so there must be at least one free byte.
+   */
+  ctx->block[ctx->b_used] = 0x80;
+  (ctx->b_used)++;
+
+  /* Zero out any remaining free bytes in the context block.
+   */
+  for( i = ctx->b_used; i < 64; i++ )
+    ctx->block[i] = 0;
+
+  /* We need 8 bytes to store the length field.
+   * If we don't have 8, call Permute() and reset the context block.
+   */
+  if( 56 < ctx->b_used )
+    {
+    Permute( ctx->ABCD, ctx->block );
+    for( i = 0; i < 64; i++ )
+      ctx->block[i] = 0;
+    }
+
+  /* Write the length (in bits--which is <len> * 8) to the length field.
+   * The length field is an 8-byte, little-endian value.  The 60'th byte
+   * is read from the *original* <ctx->len> value and shifted to the
+   * correct position, which picks up the three high-order bits that
+   * were lost in the multiplication.
+   */
+  l = ctx->len << 3;
+  for( i = 0; i < 4; i++ )
+    ctx->block[56+i] |= GetLongByte( l, i );
+  ctx->block[60] = ((GetLongByte( ctx->len, 3 ) & 0xE0) >> 5);
+  Permute( ctx->ABCD, ctx->block );
+
+  /* Now copy the result into the output buffer and we're done.
+   */
+  for( i = 0; i < 4; i++ )
+    {
+    dst[ 0+i] = GetLongByte( ctx->ABCD[0], i );
+    dst[ 4+i] = GetLongByte( ctx->ABCD[1], i );
+    dst[ 8+i] = GetLongByte( ctx->ABCD[2], i );
+    dst[12+i] = GetLongByte( ctx->ABCD[3], i );
+    }
+
+  return( ctx );
+  } /* auth_md4CloseCtx */
+
+
 uchar *auth_md4Sum( uchar *dst, const uchar *src, const int srclen )
   /* ------------------------------------------------------------------------ **
    * Compute an MD4 message digest.
@@ -276,110 +819,192 @@ uchar *auth_md4Sum( uchar *dst, const uchar *src, const int srclen )
    *  Output: A pointer to a 16-byte array of unsigned characters which
    *          contains the calculated MD4 message digest.  (Same as <dst>).
    *
-   *  Notes:  This implementation takes only a single block.  It does not
-   *          create or keep context, so there is no way to perform the MD4
-   *          over multiple blocks of data.  This is okay for SMB, because
-   *          the MD4 algorithm is used only in creating the NTLM hash and
-   *          the NTLM Session Key, both of which have single-chunk input.
+   *  Notes:  This function is a shortcut.  It takes a single input block.
+   *          For more drawn-out operations, see <auth_md4InitCtx()>.
    *
    *          The MD4 algorithm is designed to work on data with of
    *          arbitrary *bit* length.  Most implementations, this one
    *          included, handle the input data in byte-sized chunks.
    *
-   *          The MD4 algorithm does much of its work using four-byte
-   *          words, and so can be tuned for speed based on the endian-ness
-   *          of the host.  This implementation is intended to be
-   *          endian-neutral, which may make it a teeny bit slower than
-   *          others.
+   *  See Also:  <auth_md4InitCtx()>
    *
    * ------------------------------------------------------------------------ **
    */
   {
-  uchar    block[64];  /* Scratch space. */
-  int      i;
-  uint32_t l;
-  uint32_t m;
-  uint32_t len = (uint32_t)srclen;
-  uint32_t ABCD[4] =  /* ABCD[] contains the four 4-byte "registers" that are */
-    {                 /* manipulated to produce the MD4 digest.  The input    */
-    0x67452301,       /* (<src>) acts upon the registers, not the other way   */
-    0xefcdab89,       /* 'round.  The initial values are those given in RFC   */
-    0x98badcfe,       /* 1320 (pg.3).  Note, however, that RFC 1320 provides  */
-    0x10325476        /* these values as bytes, not as longwords, and the     */
-    };                /* bytes are arranged in little-endian order as if they */
-                      /* were the bytes of (little endian) 32-bit ints.       */
-                      /* That's confusing as all getout.                      */
-                      /* The values given here are provided as 32-bit values  */
-                      /* in C language format, so they are endian-agnostic.   */
-
-  /* MD4 takes the input in 64-byte chunks and uses each chunk to drive the
-   * manglement of the data in the ABCD[] array.  So...
-   * Figure out how many complete 64-byte chunks there are in <src> and send
-   * each to the Permute() function.  Note that if the input is shorter than
-   * 64-bytes (as is the case with things like passwords) then we'll wind up
-   * skipping this loop.
+  auth_md4Ctx ctx[1];
+
+  (void)auth_md4InitCtx( ctx );             /* Open a context.      */
+  (void)auth_md4SumCtx( ctx, src, srclen ); /* Pass only one block. */
+  (void)auth_md4CloseCtx( ctx, dst );       /* Close the context.   */
+
+  return( dst );
+  } /* auth_md4Sum */
+
+
+uchar **auth_md4SumN( uchar       *dst[],
+                      const uchar *src[],
+                      const int    srclen[],
+                      const int    n )
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD4 message digests of a batch of independent messages.
+   *
+   *  Input:  dst     - Array of <n> pointers to destination buffers, each
+   *                    of which must be at least 16 bytes long.
+   *          src     - Array of <n> pointers to source messages.
+   *          srclen  - Array of <n> message lengths, in bytes.
+   *          n       - The number of messages.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is the same as calling
+   *          auth_md4Sum( dst[i], src[i], srclen[i] ) for each <i>.
+   *
+   *        - On x86 platforms with a GCC-compatible compiler, the messages
+   *          are hashed four at a time using SSE2, or eight at a time if
+   *          the CPU supports AVX2.  The choice is made at run time.  On
+   *          other platforms, the messages are simply hashed one by one.
+   *
+   *        - The messages are processed in lock step, so this is most
+   *          effective with lots of short messages of similar length (eg.,
+   *          passwords).
+   *
+   *        - The <dst> buffers must not overlap any of the <src> buffers.
+   *
+   * ------------------------------------------------------------------------ **
    */
-  m = len & ~(uint32_t)63;        /* Number of bytes in whole 64-byte chunks. */
-  for( l = 0; l < m; l += 64 )
+  {
+  int i;
+#if defined( MULTILANE )
+  int lanes = Lanes();
+  int count;
+
+  for( i = 0; i < n; i += lanes )
     {
-    Permute( ABCD, &src[l] );
+    count = ((n - i) < lanes) ? (n - i) : lanes;
+    SumLanes( &dst[i], &src[i], &srclen[i], count, lanes );
     }
+#else
+  for( i = 0; i < n; i++ )
+    (void)auth_md4Sum( dst[i], src[i], srclen[i] );
+#endif
+
+  return( dst );
+  } /* auth_md4SumN */
+
 
-  /* Copy the remainder of the <src> bytes into <block>.
-   * The byte of <block> immediately following the end of the copied <src>
-   * bytes will be set to 0x80.  Fill the rest of <block> with zeros.
+
+uchar *auth_NThash( uchar *dst, const uchar *pwd, const int pwdlen )
+  /* ------------------------------------------------------------------------ **
+   * Generate the NT hash (the MD4 of the UTF-16LE password).
+   *
+   *  Input:  dst     - Pointer to memory into which to write the result.
+   *                    Requires 16 bytes minimum.
+   *          pwd     - The password, in ASCII or UTF-8.
+   *          pwdlen  - The length, in bytes, of <pwd>.
+   *
+   *  Output: A pointer to the 16-byte NT hash (same as <dst>).
+   *
+   *  Notes:  The password is widened to UTF-16LE on the fly, straight into
+   *          the MD4 message words, so no UTF-16 copy is ever made.
+   *
+   *        - Pure ASCII passwords of up to 27 characters (the most common
+   *          case by far) fit in one MD4 block, and are hashed by
+   *          SumOneBlock() without a context.  Other passwords are widened
+   *          into a 64-byte block buffer that is handed to auth_md4SumCtx()
+   *          each time it fills up.  If the final result still fits in
+   *          one block, SumOneBlock() is used anyway.
+   *
+   *        - Characters outside the Basic Multilingual Plane are encoded
+   *          as surrogate pairs.  Invalid UTF-8 bytes are widened as if
+   *          they were ISO Latin-1.  See Utf8Next().
+   *
+   *        - The stack copies of the password are cleared with
+   *          <auth_SecureZero()> before returning.
+   *
+   * ------------------------------------------------------------------------ **
    */
-  for( i = 0; i < 64; i++, l++ )
+  {
+  auth_md4Ctx ctx[1];
+  uint32_t    X[16];
+  uchar       block[64];
+  uint32_t    cp;
+  uint32_t    hibits = 0;
+  int         streamed = 0;
+  int         pos = 0;
+  int         i;
+
+  /* Fast path:  Short ASCII strings go directly into the message words.
+   * Two characters per longword, each in the low byte of a 16-bit unit.
+   */
+  if( pwdlen <= 27 )
     {
-    if( l < len )
-      block[i] = src[l];        /* Copy bytes from <src> to block. */
-    else
+    for( i = 0; i < 16; i++ )
+      X[i] = 0;
+    for( i = 0; i < pwdlen; i++ )
       {
-      if( l == len )
-        block[i] = 0x80;        /* We've written len+1 bytes here. */
-      else /* l > len */
-        block[i] = 0;           /* Filling the tail-end of block with zeros. */
+      hibits |= pwd[i];
+      X[i >> 1] |= (uint32_t)pwd[i] << ((i & 1) << 4);
+      }
+    if( hibits < 0x80 )
+      {
+      SumOneBlock( dst, X, 2 * pwdlen );
+      auth_SecureZero( X, sizeof( X ) );
+      return( dst );
       }
     }
 
-  /* If there is *no room* for the 8-byte length field, then we MD4 this
-   * sub-block, clear it out again, and add the length field later.  If
-   * there *is* room for the length, then we skip this step so that the
-   * length is added to the current sub-block.
+  /* General path:  Decode UTF-8 and write UTF-16LE units into <block>.
+   * A code point may produce two units (a surrogate pair), so there must
+   * always be room for four bytes before the next character is decoded.
    */
-  if( (l - len) <= 8 )          /* Must be '<=' because we wrote len+1 bytes */
+  for( i = 0; i < pwdlen; )
     {
-    Permute( ABCD, block );
-    for( i = 0; i < 64; i++ )   /* Re-clear the buffer. */
-      block[i] = 0;
+    i += Utf8Next( &pwd[i], pwdlen - i, &cp );
+    if( cp > 0xFFFF )
+      {
+      cp -= 0x10000;
+      block[pos++] = (uchar)((0xD800 | (cp >> 10)) & 0xFF);
+      block[pos++] = (uchar)((0xD800 | (cp >> 10)) >> 8);
+      cp = 0xDC00 | (cp & 0x3FF);
+      }
+    block[pos++] = (uchar)(cp & 0xFF);
+    block[pos++] = (uchar)(cp >> 8);
+    if( pos > 60 )
+      {
+      if( !streamed )
+        {
+        (void)auth_md4InitCtx( ctx );
+        streamed = 1;
+        }
+      (void)auth_md4SumCtx( ctx, block, pos );
+      pos = 0;
+      }
     }
 
-  /* Write the length (in bits--which is <len> * 8) to the length field.
-   * The length field is an 8-byte, little-endian value.
-   * First we multiply the length by 8 (shift 3) to get a bit count.
-   * Then copy the calculated bitlength, in little-endian order, to the
-   * length field in the block.  Just to be sure, grab the tree high-order
-   * bits of <len> and copy those as well (only necessary for very large
-   * <src> blocks).  Finally, perform the last Permutation on the sub-block.
-   */
-  l = len << 3;
-  for( i = 0; i < 4; i++ )
-    block[56+i] |= GetLongByte( l, i );
-  block[60] = ((GetLongByte( len, 3 ) & 0xE0) >> 5);  /* 'len' is not a typo. */
-  Permute( ABCD, block );
-
-  /* Now copy the result into the output buffer and we're done.
-   */
-  for( i = 0; i < 4; i++ )
+  if( streamed || (pos > 55) )
     {
-    dst[ 0+i] = GetLongByte( ABCD[0], i );
-    dst[ 4+i] = GetLongByte( ABCD[1], i );
-    dst[ 8+i] = GetLongByte( ABCD[2], i );
-    dst[12+i] = GetLongByte( ABCD[3], i );
+    if( !streamed )
+      (void)auth_md4InitCtx( ctx );
+    (void)auth_md4SumCtx( ctx, block, pos );
+    (void)auth_md4CloseCtx( ctx, dst );
+    auth_SecureZero( ctx, sizeof( auth_md4Ctx ) );
+    }
+  else
+    {
+    (void)memset( &block[pos], 0, 64 - pos );
+    for( i = 0; i < 16; i++ )
+      {
+      X[i] =  (uint32_t)block[4*i]
+           | ((uint32_t)block[(4*i)+1] << 8)
+           | ((uint32_t)block[(4*i)+2] << 16)
+           | ((uint32_t)block[(4*i)+3] << 24);
+      }
+    SumOneBlock( dst, X, pos );
     }
 
+  auth_SecureZero( block, sizeof( block ) );
+  auth_SecureZero( X, sizeof( X ) );
   return( dst );
-  } /* auth_md4Sum */
-
+  } /* auth_NThash */
 
 /* ========================================================================== */
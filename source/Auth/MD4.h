@@ -59,6 +59,8 @@
  *     some embedded environments.
  *  Beyond that, cleanliness and clarity are always worth pursuing.
  *
+ *  Later on, speed was added to the list.  See MD4.c.
+ *
  *  As mentioned above, the code really only makes sense if you are familiar
  *  with the MD4 algorithm or are using RFC 1320 as a guide.  This code is
  *  quirky, however, so you'll want to be reading carefully.
@@ -75,10 +77,90 @@
 #include "auth_common.h"
 
 
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ */
+
+typedef struct
+  {
+  uint32_t len;
+  uint32_t ABCD[4];
+  int      b_used;
+  uchar    block[64];
+  } auth_md4Ctx;
+
+
 /* -------------------------------------------------------------------------- **
  * Functions:
  */
 
+auth_md4Ctx *auth_md4InitCtx( auth_md4Ctx *ctx );
+  /* ------------------------------------------------------------------------ **
+   * Initialize an MD4 context.
+   *
+   *  Input:  ctx - A pointer to the MD4 context structure to be initialized.
+   *                Contexts are typically created thusly:
+   *                  ctx = (auth_md4Ctx *)malloc( sizeof(auth_md4Ctx) );
+   *
+   *  Output: A pointer to the initialized context (same as <ctx>).
+   *
+   *  Notes:  The purpose of the context is to make it possible to generate
+   *          an MD4 Message Digest in stages, rather than having to pass a
+   *          single large block to a single MD4 function.  The context
+   *          structure keeps track of various bits of state information.
+   *
+   *          Once the context is initialized, the blocks of message data
+   *          are passed to the <auth_md4SumCtx()> function.  Once the
+   *          final bit of data has been handed to <auth_md4SumCtx()> the
+   *          context can be closed out by calling <auth_md4CloseCtx()>,
+   *          which also calculates the final MD4 result.
+   *
+   *  See Also:  <auth_md4SumCtx()>, <auth_md4CloseCtx()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+auth_md4Ctx *auth_md4SumCtx( auth_md4Ctx *ctx,
+                             const uchar *src,
+                             const int    len );
+  /* ------------------------------------------------------------------------ **
+   * Build an MD4 Message Digest within the given context.
+   *
+   *  Input:  ctx - Pointer to the context in which the MD4 sum is being
+   *                built.
+   *          src - A chunk of source data.  This will be used to drive
+   *                the MD4 algorithm.
+   *          len - The number of bytes in <src>.
+   *
+   *  Output: A pointer to the updated context (same as <ctx>).
+   *
+   *  See Also:  <auth_md4InitCtx()>, <auth_md4CloseCtx()>, <auth_md4Sum()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+auth_md4Ctx *auth_md4CloseCtx( auth_md4Ctx *ctx, uchar *dst );
+  /* ------------------------------------------------------------------------ **
+   * Close an MD4 Message Digest context and generate the final MD4 sum.
+   *
+   *  Input:  ctx - Pointer to the context in which the MD4 sum is being
+   *                built.
+   *          dst - A pointer to at least 16 bytes of memory, which will
+   *                receive the finished MD4 sum.
+   *
+   *  Output: A pointer to the closed context (same as <ctx>).
+   *
+   *  Notes:  The context (<ctx>) is returned in an undefined state.
+   *          It must be re-initialized before re-use.
+   *
+   *  See Also:  <auth_md4InitCtx()>, <auth_md4SumCtx()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 uchar *auth_md4Sum( uchar *dst, const uchar *src, const int srclen );
   /* ------------------------------------------------------------------------ **
    * Compute an MD4 message digest.
@@ -92,21 +174,74 @@ uchar *auth_md4Sum( uchar *dst, const uchar *src, const int srclen );
    *  Output: A pointer to a 16-byte array of unsigned characters which
    *          contains the calculated MD4 message digest.  (Same as <dst>).
    *
-   *  Notes:  This implementation takes only a single block.  It does not
-   *          create or keep context, so there is no way to perform the MD4
-   *          over multiple blocks of data.  This is okay for SMB, because
-   *          the MD4 algorithm is used only in creating the NTLM hash and
-   *          the NTLM Session Key, both of which have single-chunk input.
+   *  Notes:  This function is a shortcut.  It takes a single input block.
+   *          For more drawn-out operations, see <auth_md4InitCtx()>.
    *
    *          The MD4 algorithm is designed to work on data with of
    *          arbitrary *bit* length.  Most implementations, this one
    *          included, handle the input data in byte-sized chunks.
    *
-   *          The MD4 algorithm does much of its work using four-byte
-   *          words, and so can be tuned for speed based on the endian-ness
-   *          of the host.  This implementation is intended to be
-   *          endian-neutral, which may make it a teeny bit slower than
-   *          others.
+   *  See Also:  <auth_md4InitCtx()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar **auth_md4SumN( uchar       *dst[],
+                      const uchar *src[],
+                      const int    srclen[],
+                      const int    n );
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD4 message digests of a batch of independent messages.
+   *
+   *  Input:  dst     - Array of <n> pointers to destination buffers, each
+   *                    of which must be at least 16 bytes long.
+   *          src     - Array of <n> pointers to source messages.
+   *          srclen  - Array of <n> message lengths, in bytes.
+   *          n       - The number of messages.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is the same as calling
+   *          auth_md4Sum( dst[i], src[i], srclen[i] ) for each <i>.
+   *
+   *        - On x86 platforms with a GCC-compatible compiler, the messages
+   *          are hashed four at a time using SSE2, or eight at a time if
+   *          the CPU supports AVX2.  The choice is made at run time.  On
+   *          other platforms, the messages are simply hashed one by one.
+   *
+   *        - The messages are processed in lock step, so this is most
+   *          effective with lots of short messages of similar length (eg.,
+   *          passwords).
+   *
+   *        - The <dst> buffers must not overlap any of the <src> buffers.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_NThash( uchar *dst, const uchar *pwd, const int pwdlen );
+  /* ------------------------------------------------------------------------ **
+   * Generate the NT hash (the MD4 of the UTF-16LE password).
+   *
+   *  Input:  dst     - Pointer to memory into which to write the result.
+   *                    Requires 16 bytes minimum.
+   *          pwd     - The password, in ASCII or UTF-8.
+   *          pwdlen  - The length, in bytes, of <pwd>.
+   *
+   *  Output: A pointer to the 16-byte NT hash (same as <dst>).
+   *
+   *  Notes:  This is the same as converting the password to UTF-16LE and
+   *          passing the result to <auth_md4Sum()>, but no UTF-16 copy of
+   *          the password is made.  Short ASCII passwords are hashed with
+   *          a special-case single-block MD4.
+   *
+   *        - Characters outside the Basic Multilingual Plane are encoded
+   *          as surrogate pairs.  Bytes that are not part of a valid UTF-8
+   *          sequence are taken to be ISO Latin-1 characters.
+   *
+   *        - Unlike the LM hash, the NT hash is case-sensitive, so the
+   *          password should not be converted to upper case.
    *
    * ------------------------------------------------------------------------ **
    */
@@ -64,6 +64,11 @@
  *
  *  Yeah...most of the comments are cut-and-paste from my MD4 implementation.
  *
+ *  As with MD4, speed was later added to the list of goals.  MD5 is on the
+ *  per-packet path for SMB message signing.  The compression function is
+ *  now fully unrolled, and on little-endian hosts the message words are
+ *  loaded directly from memory.
+ *
  * -------------------------------------------------------------------------- **
  *
  * References:
@@ -76,75 +81,28 @@
 #include "MD5.h"
 
 
-/* -------------------------------------------------------------------------- **
- * Static Constants:
- *
- *  K[][] - In round one, the values of k (which are used to index
- *          particular four-byte sequences in the input) are simply
- *          sequential.  In later rounds, however, they are a bit more
- *          varied.  Rather than calculate the values of k (which may
- *          or may not be possible--I haven't though about it) the
- *          values are stored in this array.
- *
- *  S[][] - In each round there is a left rotate operation performed as
- *          part of the 16 permutations.  The number of bits varies in
- *          a repeating patter.  This array keeps track of the patterns
- *          used in each round.
- *
- *  T[][] - There are four rounds of 16 permutations for a total of 64.
- *          In each of these 64 permutation operations, a different
- *          constant value is added to the mix.  The constants are
- *          based on the sine function...read RFC 1321 for more detail.
- *          In any case, the correct constants are stored in the T[][]
- *          array.  They're divided up into four groups of 16.
- */
-
-static const uint8_t K[3][16] =
-  {
-    /* Round 1: skipped (since it is simply sequential). */
-    {  1,  6, 11,  0,  5, 10, 15,  4,  9, 14,  3,  8, 13,  2,  7, 12 }, /* R2 */
-    {  5,  8, 11, 14,  1,  4,  7, 10, 13,  0,  3,  6,  9, 12, 15,  2 }, /* R3 */
-    {  0,  7, 14,  5, 12,  3, 10,  1,  8, 15,  6, 13,  4, 11,  2,  9 }  /* R4 */
-  };
-
-static const uint8_t S[4][4] =
-  {
-    { 7, 12, 17, 22 },  /* Round 1 */
-    { 5,  9, 14, 20 },  /* Round 2 */
-    { 4, 11, 16, 23 },  /* Round 3 */
-    { 6, 10, 15, 21 }   /* Round 4 */
-  };
-
-
-static const uint32_t T[4][16] =
-  {
-    { 0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,   /* Round 1 */
-      0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
-      0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
-      0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821 },
-
-    { 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,   /* Round 2 */
-      0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
-      0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
-      0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a },
-
-    { 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,   /* Round 3 */
-      0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
-      0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
-      0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665 },
-
-    { 0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,   /* Round 4 */
-      0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
-      0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
-      0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391 },
-  };
-
-
 /* -------------------------------------------------------------------------- **
  * Macros:
  *  md5F(), md5G(), md5H(), and md5I() are described in RFC 1321.
  *  All of these operations are bitwise, and so not impacted by endian-ness.
  *
+ *  ROTL32()
+ *    Rotate a 32-bit value left by <s> bits.
+ *
+ *  md5R1(), md5R2(), md5R3(), md5R4()
+ *    A single step of round 1, 2, 3, or 4 (respectively).  Each step
+ *    mangles one of the four "registers" (<a>), using the other three,
+ *    the <k>th longword of the message block, the constant <t>, and a left
+ *    rotation of <s> bits.
+ *
+ *  md5Rounds()
+ *    All four rounds of sixteen steps each, written out in full.  The
+ *    order in which the X[] values are used, the rotation amounts, and the
+ *    sine-based constants (the T[] values, in RFC 1321 terms) are all given
+ *    in the RFC.  The message block must be in an array named X[].  Only
+ *    plain C operators are used, so the same macro also works on vector
+ *    types (see PermuteLanes4()).
+ *
  *  GetLongByte()
  *    Extract one byte from a (32-bit) longword.  A value of 0 for <idx>
  *    indicates the lowest order byte, while 3 indicates the highest order
@@ -157,9 +115,105 @@ static const uint32_t T[4][16] =
 #define md5H( X, Y, Z ) ( (X) ^ (Y) ^ (Z) )
 #define md5I( X, Y, Z ) ( (Y) ^ ((X) | (~(Z))) )
 
+#define ROTL32( V, s ) ( 0xFFFFFFFF & (((V) << (s)) | ((V) >> (32 - (s)))) )
+
+#define md5Step( f, a, b, c, d, k, s, t ) \
+  (a) = 0xFFFFFFFF & ((a) + f( b, c, d ) + X[k] + (t)); \
+  (a) = 0xFFFFFFFF & ((b) + ROTL32( a, s ))
+
+#define md5R1( a, b, c, d, k, s, t ) md5Step( md5F, a, b, c, d, k, s, t )
+#define md5R2( a, b, c, d, k, s, t ) md5Step( md5G, a, b, c, d, k, s, t )
+#define md5R3( a, b, c, d, k, s, t ) md5Step( md5H, a, b, c, d, k, s, t )
+#define md5R4( a, b, c, d, k, s, t ) md5Step( md5I, a, b, c, d, k, s, t )
+
+#define md5Rounds( a, b, c, d ) \
+  md5R1( a, b, c, d,  0,  7, 0xd76aa478 ); \
+  md5R1( d, a, b, c,  1, 12, 0xe8c7b756 ); \
+  md5R1( c, d, a, b,  2, 17, 0x242070db ); \
+  md5R1( b, c, d, a,  3, 22, 0xc1bdceee ); \
+  md5R1( a, b, c, d,  4,  7, 0xf57c0faf ); \
+  md5R1( d, a, b, c,  5, 12, 0x4787c62a ); \
+  md5R1( c, d, a, b,  6, 17, 0xa8304613 ); \
+  md5R1( b, c, d, a,  7, 22, 0xfd469501 ); \
+  md5R1( a, b, c, d,  8,  7, 0x698098d8 ); \
+  md5R1( d, a, b, c,  9, 12, 0x8b44f7af ); \
+  md5R1( c, d, a, b, 10, 17, 0xffff5bb1 ); \
+  md5R1( b, c, d, a, 11, 22, 0x895cd7be ); \
+  md5R1( a, b, c, d, 12,  7, 0x6b901122 ); \
+  md5R1( d, a, b, c, 13, 12, 0xfd987193 ); \
+  md5R1( c, d, a, b, 14, 17, 0xa679438e ); \
+  md5R1( b, c, d, a, 15, 22, 0x49b40821 ); \
+  md5R2( a, b, c, d,  1,  5, 0xf61e2562 ); \
+  md5R2( d, a, b, c,  6,  9, 0xc040b340 ); \
+  md5R2( c, d, a, b, 11, 14, 0x265e5a51 ); \
+  md5R2( b, c, d, a,  0, 20, 0xe9b6c7aa ); \
+  md5R2( a, b, c, d,  5,  5, 0xd62f105d ); \
+  md5R2( d, a, b, c, 10,  9, 0x02441453 ); \
+  md5R2( c, d, a, b, 15, 14, 0xd8a1e681 ); \
+  md5R2( b, c, d, a,  4, 20, 0xe7d3fbc8 ); \
+  md5R2( a, b, c, d,  9,  5, 0x21e1cde6 ); \
+  md5R2( d, a, b, c, 14,  9, 0xc33707d6 ); \
+  md5R2( c, d, a, b,  3, 14, 0xf4d50d87 ); \
+  md5R2( b, c, d, a,  8, 20, 0x455a14ed ); \
+  md5R2( a, b, c, d, 13,  5, 0xa9e3e905 ); \
+  md5R2( d, a, b, c,  2,  9, 0xfcefa3f8 ); \
+  md5R2( c, d, a, b,  7, 14, 0x676f02d9 ); \
+  md5R2( b, c, d, a, 12, 20, 0x8d2a4c8a ); \
+  md5R3( a, b, c, d,  5,  4, 0xfffa3942 ); \
+  md5R3( d, a, b, c,  8, 11, 0x8771f681 ); \
+  md5R3( c, d, a, b, 11, 16, 0x6d9d6122 ); \
+  md5R3( b, c, d, a, 14, 23, 0xfde5380c ); \
+  md5R3( a, b, c, d,  1,  4, 0xa4beea44 ); \
+  md5R3( d, a, b, c,  4, 11, 0x4bdecfa9 ); \
+  md5R3( c, d, a, b,  7, 16, 0xf6bb4b60 ); \
+  md5R3( b, c, d, a, 10, 23, 0xbebfbc70 ); \
+  md5R3( a, b, c, d, 13,  4, 0x289b7ec6 ); \
+  md5R3( d, a, b, c,  0, 11, 0xeaa127fa ); \
+  md5R3( c, d, a, b,  3, 16, 0xd4ef3085 ); \
+  md5R3( b, c, d, a,  6, 23, 0x04881d05 ); \
+  md5R3( a, b, c, d,  9,  4, 0xd9d4d039 ); \
+  md5R3( d, a, b, c, 12, 11, 0xe6db99e5 ); \
+  md5R3( c, d, a, b, 15, 16, 0x1fa27cf8 ); \
+  md5R3( b, c, d, a,  2, 23, 0xc4ac5665 ); \
+  md5R4( a, b, c, d,  0,  6, 0xf4292244 ); \
+  md5R4( d, a, b, c,  7, 10, 0x432aff97 ); \
+  md5R4( c, d, a, b, 14, 15, 0xab9423a7 ); \
+  md5R4( b, c, d, a,  5, 21, 0xfc93a039 ); \
+  md5R4( a, b, c, d, 12,  6, 0x655b59c3 ); \
+  md5R4( d, a, b, c,  3, 10, 0x8f0ccc92 ); \
+  md5R4( c, d, a, b, 10, 15, 0xffeff47d ); \
+  md5R4( b, c, d, a,  1, 21, 0x85845dd1 ); \
+  md5R4( a, b, c, d,  8,  6, 0x6fa87e4f ); \
+  md5R4( d, a, b, c, 15, 10, 0xfe2ce6e0 ); \
+  md5R4( c, d, a, b,  6, 15, 0xa3014314 ); \
+  md5R4( b, c, d, a, 13, 21, 0x4e0811a1 ); \
+  md5R4( a, b, c, d,  4,  6, 0xf7537e82 ); \
+  md5R4( d, a, b, c, 11, 10, 0xbd3af235 ); \
+  md5R4( c, d, a, b,  2, 15, 0x2ad7d2bb ); \
+  md5R4( b, c, d, a,  9, 21, 0xeb86d391 )
+
 #define GetLongByte( L, idx ) ((uchar)(( L >> (((idx) & 0x03) << 3) ) & 0xFF))
 
 
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  MULTILANE - Defined if the compiler supports GCC-style vector types and
+ *              run-time CPU feature checks.  If so, auth_md5SumN() hashes
+ *              four (SSE2) or eight (AVX2) messages at once.  Otherwise,
+ *              it simply calls auth_md5Sum() for each message.
+ *
+ *  md5Vec4   - Four 32-bit lanes.
+ *  md5Vec8   - Eight 32-bit lanes.
+ */
+
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#define MULTILANE 1
+typedef uint32_t md5Vec4 __attribute__ ((vector_size (16)));
+typedef uint32_t md5Vec8 __attribute__ ((vector_size (32)));
+#endif
+
+
 /* -------------------------------------------------------------------------- **
  * Static Functions:
  */
@@ -198,89 +252,311 @@ static void Permute( uint32_t ABCD[4], const uchar block[64] )
    * ------------------------------------------------------------------------ **
    */
   {
-  int      round;
-  int      i, j;
-  uint8_t  s;
-  uint32_t a, b, c, d;
-  uint32_t KeepABCD[4];
+  uint32_t a = ABCD[0];
+  uint32_t b = ABCD[1];
+  uint32_t c = ABCD[2];
+  uint32_t d = ABCD[3];
   uint32_t X[16];
 
-  /* Store the current ABCD values for later re-use.
-   */
-  for( i = 0; i < 4; i++ )
-    KeepABCD[i] = ABCD[i];
-
   /* Convert the input block into an array of unsigned longs, taking care
    * to read the block in Little Endian order (the algorithm assumes this).
-   * The uint32_t values are then handled in host order.
+   * The uint32_t values are then handled in host order.  On little-endian
+   * hosts, the block can simply be copied.
    */
-  for( i = 0, j = 0; i < 16; i++ )
+#if defined( cifs_LITTLE_ENDIAN )
+  (void)memcpy( X, block, 64 );
+#else
+  {
+  int i, j;
+
+  for( i = 0, j = 0; i < 16; i++, j += 4 )
     {
-    X[i]  =  (uint32_t)block[j++];
-    X[i] |= ((uint32_t)block[j++] << 8);
-    X[i] |= ((uint32_t)block[j++] << 16);
-    X[i] |= ((uint32_t)block[j++] << 24);
+    X[i] =  (uint32_t)block[j]
+         | ((uint32_t)block[j+1] << 8)
+         | ((uint32_t)block[j+2] << 16)
+         | ((uint32_t)block[j+3] << 24);
     }
+  }
+#endif
 
-  /* This loop performs the four rounds of permutations.
-   * The rounds are each very similar.  The differences are in three areas:
-   *   - The function (F, G, H, or I) used to perform bitwise permutations
-   *     on the registers,
-   *   - The order in which values from X[] are chosen.
-   *   - Changes to the number of bits by which the registers are rotated.
-   * This implementation uses a switch statement to deal with some of the
-   * differences between rounds.  Other differences are handled by storing
-   * values in arrays and using the round number to select the correct set
-   * of values.
-   *
-   * (My implementation appears to be a poor compromise between speed, size,
-   * and clarity.  Ugh.  [crh])
+  /* All four rounds.
    */
-  for( round = 0; round < 4; round++ )
+  md5Rounds( a, b, c, d );
+
+  /* Add the original A, B, C, D values to perform
+   * one last convolution.
+   */
+  ABCD[0] = 0xFFFFFFFF & ( ABCD[0] + a );
+  ABCD[1] = 0xFFFFFFFF & ( ABCD[1] + b );
+  ABCD[2] = 0xFFFFFFFF & ( ABCD[2] + c );
+  ABCD[3] = 0xFFFFFFFF & ( ABCD[3] + d );
+  } /* Permute */
+
+
+#if defined( MULTILANE )
+
+static void PermuteLanes4( uint32_t ABCD[4][8], const uint32_t W[16][8] )
+  /* ------------------------------------------------------------------------ **
+   * Permute four sets of ABCD "registers" at once, using SSE2 vectors.
+   *
+   *  Input:  ABCD  - Four registers for each of up to eight lanes.  Only
+   *                  the first four lanes are used.
+   *          W     - The sixteen message longwords for each lane, already
+   *                  converted from little-endian byte order.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This is the same algorithm as Permute(), applied to each
+   *          lane independently.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  md5Vec4 a, b, c, d;
+  md5Vec4 A, B, C, D;
+  md5Vec4 X[16];
+  int     i;
+
+  for( i = 0; i < 16; i++ )
+    (void)memcpy( &X[i], W[i], sizeof( md5Vec4 ) );
+  (void)memcpy( &A, ABCD[0], sizeof( md5Vec4 ) );
+  (void)memcpy( &B, ABCD[1], sizeof( md5Vec4 ) );
+  (void)memcpy( &C, ABCD[2], sizeof( md5Vec4 ) );
+  (void)memcpy( &D, ABCD[3], sizeof( md5Vec4 ) );
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+
+  md5Rounds( a, b, c, d );
+
+  a += A;
+  b += B;
+  c += C;
+  d += D;
+  (void)memcpy( ABCD[0], &a, sizeof( md5Vec4 ) );
+  (void)memcpy( ABCD[1], &b, sizeof( md5Vec4 ) );
+  (void)memcpy( ABCD[2], &c, sizeof( md5Vec4 ) );
+  (void)memcpy( ABCD[3], &d, sizeof( md5Vec4 ) );
+  } /* PermuteLanes4 */
+
+
+__attribute__ ((target ("avx2")))
+static void PermuteLanes8( uint32_t ABCD[4][8], const uint32_t W[16][8] )
+  /* ------------------------------------------------------------------------ **
+   * Permute eight sets of ABCD "registers" at once, using AVX2 vectors.
+   *
+   *  Input:  ABCD  - Four registers for each of eight lanes.
+   *          W     - The sixteen message longwords for each lane, already
+   *                  converted from little-endian byte order.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This function is compiled for AVX2 regardless of the compiler
+   *          flags.  It must only be called if the CPU supports AVX2.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  md5Vec8 a, b, c, d;
+  md5Vec8 A, B, C, D;
+  md5Vec8 X[16];
+  int     i;
+
+  for( i = 0; i < 16; i++ )
+    (void)memcpy( &X[i], W[i], sizeof( md5Vec8 ) );
+  (void)memcpy( &A, ABCD[0], sizeof( md5Vec8 ) );
+  (void)memcpy( &B, ABCD[1], sizeof( md5Vec8 ) );
+  (void)memcpy( &C, ABCD[2], sizeof( md5Vec8 ) );
+  (void)memcpy( &D, ABCD[3], sizeof( md5Vec8 ) );
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+
+  md5Rounds( a, b, c, d );
+
+  a += A;
+  b += B;
+  c += C;
+  d += D;
+  (void)memcpy( ABCD[0], &a, sizeof( md5Vec8 ) );
+  (void)memcpy( ABCD[1], &b, sizeof( md5Vec8 ) );
+  (void)memcpy( ABCD[2], &c, sizeof( md5Vec8 ) );
+  (void)memcpy( ABCD[3], &d, sizeof( md5Vec8 ) );
+  } /* PermuteLanes8 */
+
+
+static int Lanes( void )
+  /* ------------------------------------------------------------------------ **
+   * Determine how many lanes to use, based upon the CPU we're running on.
+   *
+   *  Input:  none.
+   *
+   *  Output: 8 if the CPU supports AVX2, else 4.
+   *
+   *  Notes:  The result is computed once and cached.  If two threads race
+   *          to fill in the cache, they will both store the same value.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static int lanes = 0;
+
+  if( 0 == lanes )
     {
-    for( i = 0; i < 16; i++ )
+    __builtin_cpu_init();
+    lanes = __builtin_cpu_supports( "avx2" ) ? 8 : 4;
+    }
+  return( lanes );
+  } /* Lanes */
+
+
+static const uchar *LaneBlock( uchar        tmp[64],
+                               const uchar *src,
+                               const int    len,
+                               const int    blk,
+                               const bool   last )
+  /* ------------------------------------------------------------------------ **
+   * Return a pointer to the <blk>th 64-byte block of a padded message.
+   *
+   *  Input:  tmp   - Scratch space, used if the block must be padded.
+   *          src   - The message.
+   *          len   - The length of the message, in bytes.
+   *          blk   - The block number.
+   *          last  - True if this is the last block of the padded message,
+   *                  in which case the length field is added.
+   *
+   *  Output: Either a pointer into <src> (if the block is made up entirely
+   *          of message bytes) or <tmp>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      off = 64 * blk;
+  int      n   = len - off;
+  int      i;
+  uint32_t l;
+
+  if( n >= 64 )
+    return( &src[off] );
+
+  if( n > 0 )
+    {
+    (void)memcpy( tmp, &src[off], n );
+    (void)memset( &tmp[n], 0, 64 - n );
+    tmp[n] = 0x80;
+    }
+  else
+    {
+    (void)memset( tmp, 0, 64 );
+    if( 0 == n )
+      tmp[0] = 0x80;
+    }
+
+  if( last )
+    {
+    l = (uint32_t)len << 3;
+    for( i = 0; i < 4; i++ )
+      tmp[56+i] = GetLongByte( l, i );
+    tmp[60] = ((GetLongByte( (uint32_t)len, 3 ) & 0xE0) >> 5);
+    }
+  return( tmp );
+  } /* LaneBlock */
+
+
+static void SumLanes( uchar       *dst[],
+                      const uchar *src[],
+                      const int    srclen[],
+                      const int    count,
+                      const int    lanes )
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD5 digests of up to <lanes> messages in parallel.
+   *
+   *  Input:  dst     - Array of <count> pointers to 16-byte result buffers.
+   *          src     - Array of <count> pointers to messages.
+   *          srclen  - Array of <count> message lengths.
+   *          count   - Number of messages (no more than <lanes>).
+   *          lanes   - 4 or 8.
+   *
+   *  Output: none.
+   *
+   *  Notes:  All lanes are run in lock step.  A lane whose message has
+   *          run out of blocks is fed zeros, and its result is ignored.
+   *          This works best when the messages are of similar length.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t     ABCD[4][8];
+  uint32_t     W[16][8];
+  uchar        tmp[8][64];
+  int          nblk[8];
+  int          steps = 0;
+  int          i, j, k, t;
+  const uchar *p;
+
+  for( j = 0; j < lanes; j++ )
+    {
+    ABCD[0][j] = 0x67452301;
+    ABCD[1][j] = 0xefcdab89;
+    ABCD[2][j] = 0x98badcfe;
+    ABCD[3][j] = 0x10325476;
+    nblk[j] = (j < count) ? (((srclen[j] + 8) / 64) + 1) : 0;
+    if( nblk[j] > steps )
+      steps = nblk[j];
+    }
+
+  for( t = 0; t < steps; t++ )
+    {
+    /* Gather the next block from each lane.
+     */
+    for( j = 0; j < lanes; j++ )
       {
-      j = (4 - (i % 4)) & 0x3;  /* <j> handles the rotation of ABCD.          */
-      s = S[round][i%4];        /* <s> is the bit shift for this iteration.   */
+      if( t < nblk[j] )
+        {
+        p = LaneBlock( tmp[j], src[j], srclen[j], t, (t == (nblk[j] - 1)) );
+        for( k = 0; k < 16; k++, p += 4 )
+          {
+#if defined( cifs_LITTLE_ENDIAN )
+          (void)memcpy( &W[k][j], p, 4 );
+#else
+          W[k][j] =  (uint32_t)p[0]        | ((uint32_t)p[1] << 8)
+                  | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+#endif
+          }
+        }
+      else
+        {
+        for( k = 0; k < 16; k++ )
+          W[k][j] = 0;
+        }
+      }
 
-      b = ABCD[(j+1) & 0x3];    /* Copy the b,c,d values per ABCD rotation.   */
-      c = ABCD[(j+2) & 0x3];    /* This isn't really necessary, it just looks */
-      d = ABCD[(j+3) & 0x3];    /* clean & will hopefully be optimized away.  */
+    if( 8 == lanes )
+      PermuteLanes8( ABCD, (const uint32_t (*)[8])W );
+    else
+      PermuteLanes4( ABCD, (const uint32_t (*)[8])W );
 
-      /* The actual perumation function.
-       * This is broken out to minimize the code within the switch().
-       */
-      switch( round )
+    /* Write out the results of any lanes that just finished.
+     */
+    for( j = 0; j < count; j++ )
+      {
+      if( t == (nblk[j] - 1) )
         {
-        case 0:
-          /* round 1 */
-          a = md5F( b, c, d ) + X[i];
-          break;
-        case 1:
-          /* round 2 */
-          a = md5G( b, c, d ) + X[ K[0][i] ];
-          break;
-        case 2:
-          /* round 3 */
-          a = md5H( b, c, d ) + X[ K[1][i] ];
-          break;
-        default:
-          /* round 4 */
-          a = md5I( b, c, d ) + X[ K[2][i] ];
-          break;
+        for( i = 0; i < 4; i++ )
+          {
+          dst[j][ 0+i] = GetLongByte( ABCD[0][j], i );
+          dst[j][ 4+i] = GetLongByte( ABCD[1][j], i );
+          dst[j][ 8+i] = GetLongByte( ABCD[2][j], i );
+          dst[j][12+i] = GetLongByte( ABCD[3][j], i );
+          }
         }
-      a = 0xFFFFFFFF & ( ABCD[j] + a + T[round][i] );
-      ABCD[j] = b + (0xFFFFFFFF & (( a << s ) | ( a >> (32 - s) )));
       }
     }
+  } /* SumLanes */
 
-  /* Use the stored original A, B, C, D values to perform
-   * one last convolution.
-   */
-  for( i = 0; i < 4; i++ )
-    ABCD[i] = 0xFFFFFFFF & ( ABCD[i] + KeepABCD[i] );
-
-  } /* Permute */
+#endif /* MULTILANE */
 
 
 /* -------------------------------------------------------------------------- **
@@ -349,24 +625,32 @@ auth_md5Ctx *auth_md5SumCtx( auth_md5Ctx *ctx,
    *
    *  Output: A pointer to the updated context (same as <ctx>).
    *
+   *  Notes:  Whole 64-byte blocks are compressed in place, directly from
+   *          <src>.  Only partial blocks are copied into the context.
+   *
    *  See Also:  <auth_md5InitCtx()>, <auth_md5CloseCtx()>, <auth_md5Sum()>
    *
    * ------------------------------------------------------------------------ **
    */
   {
-  int i;
+  int i = 0;
+  int n;
 
   /* Add the new block's length to the total length.
    */
   ctx->len += (uint32_t)len;
 
-  /* Copy the new block's data into the context block.
-   * Call the Permute() function whenever the context block is full.
+  /* If there is a partial block in the context, top it up first.
+   * Call the Permute() function if the context block fills up.
    */
-  for( i = 0; i < len; i++ )
+  if( ctx->b_used > 0 )
     {
-    ctx->block[ ctx->b_used ] = src[i];
-    (ctx->b_used)++;
+    n = 64 - ctx->b_used;
+    if( n > len )
+      n = len;
+    (void)memcpy( &ctx->block[ctx->b_used], src, n );
+    ctx->b_used += n;
+    i = n;
     if( 64 == ctx->b_used )
       {
       Permute( ctx->ABCD, ctx->block );
@@ -374,6 +658,19 @@ auth_md5Ctx *auth_md5SumCtx( auth_md5Ctx *ctx,
       }
     }
 
+  /* Whole 64-byte blocks are passed to Permute() directly from <src>.
+   */
+  for( ; (len - i) >= 64; i += 64 )
+    Permute( ctx->ABCD, &src[i] );
+
+  /* Copy the leftover tail (if any) into the context block.
+   */
+  if( i < len )
+    {
+    (void)memcpy( &ctx->block[ctx->b_used], &src[i], len - i );
+    ctx->b_used += (len - i);
+    }
+
   /* Return the updated context.
    */
   return( ctx );
@@ -479,9 +776,9 @@ uchar *auth_md5Sum( uchar *dst, const uchar *src, const int len )
    *
    *          The MD5 algorithm does much of its work using four-byte
    *          words, and so can be tuned for speed based on the endian-ness
-   *          of the host.  This implementation is intended to be
-   *          endian-neutral, which may make it a teeny bit slower than
-   *          others.  ...maybe.
+   *          of the host.  This implementation is endian-neutral, but
+   *          it will load the message words directly from memory on
+   *          little-endian hosts (see cifs_LITTLE_ENDIAN in platform.h).
    *
    *  See Also:  <auth_md5InitCtx()>
    *
@@ -498,4 +795,55 @@ uchar *auth_md5Sum( uchar *dst, const uchar *src, const int len )
   } /* auth_md5Sum */
 
 
+uchar **auth_md5SumN( uchar       *dst[],
+                      const uchar *src[],
+                      const int    len[],
+                      const int    n )
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD5 message digests of a batch of independent messages.
+   *
+   *  Input:  dst     - Array of <n> pointers to destination buffers, each
+   *                    of which must be at least 16 bytes long.
+   *          src     - Array of <n> pointers to source messages.
+   *          len     - Array of <n> message lengths, in bytes.
+   *          n       - The number of messages.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is the same as calling
+   *          auth_md5Sum( dst[i], src[i], len[i] ) for each <i>.
+   *
+   *        - On x86 platforms with a GCC-compatible compiler, the messages
+   *          are hashed four at a time using SSE2, or eight at a time if
+   *          the CPU supports AVX2.  The choice is made at run time.  On
+   *          other platforms, the messages are simply hashed one by one.
+   *
+   *        - The messages are processed in lock step, so this is most
+   *          effective with lots of short messages of similar length (eg.,
+   *          passwords).
+   *
+   *        - The <dst> buffers must not overlap any of the <src> buffers.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+#if defined( MULTILANE )
+  int lanes = Lanes();
+  int count;
+
+  for( i = 0; i < n; i += lanes )
+    {
+    count = ((n - i) < lanes) ? (n - i) : lanes;
+    SumLanes( &dst[i], &src[i], &len[i], count, lanes );
+    }
+#else
+  for( i = 0; i < n; i++ )
+    (void)auth_md5Sum( dst[i], src[i], len[i] );
+#endif
+
+  return( dst );
+  } /* auth_md5SumN */
+
+
 /* ========================================================================== */
@@ -191,9 +191,9 @@ uchar *auth_md5Sum( uchar *dst, const uchar *src, const int len );
    *
    *          The MD5 algorithm does much of its work using four-byte
    *          words, and so can be tuned for speed based on the endian-ness
-   *          of the host.  This implementation is intended to be
-   *          endian-neutral, which may make it a teeny bit slower than
-   *          others.  ...maybe.
+   *          of the host.  This implementation is endian-neutral, but
+   *          it will load the message words directly from memory on
+   *          little-endian hosts (see cifs_LITTLE_ENDIAN in platform.h).
    *
    *  See Also:  <auth_md5InitCtx()>
    *
@@ -201,5 +201,38 @@ uchar *auth_md5Sum( uchar *dst, const uchar *src, const int len );
    */
 
 
+uchar **auth_md5SumN( uchar       *dst[],
+                      const uchar *src[],
+                      const int    len[],
+                      const int    n );
+  /* ------------------------------------------------------------------------ **
+   * Compute the MD5 message digests of a batch of independent messages.
+   *
+   *  Input:  dst     - Array of <n> pointers to destination buffers, each
+   *                    of which must be at least 16 bytes long.
+   *          src     - Array of <n> pointers to source messages.
+   *          len     - Array of <n> message lengths, in bytes.
+   *          n       - The number of messages.
+   *
+   *  Output: A pointer to the array of results (same as <dst>).
+   *
+   *  Notes:  The result is the same as calling
+   *          auth_md5Sum( dst[i], src[i], len[i] ) for each <i>.
+   *
+   *        - On x86 platforms with a GCC-compatible compiler, the messages
+   *          are hashed four at a time using SSE2, or eight at a time if
+   *          the CPU supports AVX2.  The choice is made at run time.  On
+   *          other platforms, the messages are simply hashed one by one.
+   *
+   *        - The messages are processed in lock step, so this is most
+   *          effective with lots of short messages of similar length (eg.,
+   *          passwords).
+   *
+   *        - The <dst> buffers must not overlap any of the <src> buffers.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 /* ========================================================================== */
 #endif /* AUTH_MD5_H */
@@ -0,0 +1,216 @@
+#ifndef AUTH_NTLMV2_H
+#define AUTH_NTLMV2_H
+/* ========================================================================== **
+ *
+ *                                  NTLMv2.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NTLMv2 and LMv2 challenge/response calculation and verification.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  NTLMv2 and LMv2 replace the DES-based LM and NTLM challenge/response
+ *  calculations (see LMhash.c) with HMAC-MD5.  The steps are:
+ *
+ *    NTLMv2 hash = HMAC-MD5( NT hash, UPPER( user ) + domain )
+ *    NTProofStr  = HMAC-MD5( NTLMv2 hash, server challenge + blob )
+ *    NTLMv2 resp = NTProofStr + blob
+ *    LMv2 resp   = HMAC-MD5( NTLMv2 hash, server challenge + client
+ *                            challenge ) + client challenge
+ *
+ *  The user and domain names are given in UTF-16LE, and the user name must
+ *  already be in upper case.  As with the LM hash, character set handling
+ *  is left to the caller.
+ *
+ *  The <blob> is formatted by the client and is opaque to this module.
+ *
+ *  The NTLMv2 hash is the HMAC key for the response calculations.  A
+ *  server that verifies many responses for the same account can call
+ *  <auth_hmacMD5SetKey()> once per account and keep the resulting
+ *  auth_hmacMD5Key, which saves two MD5 blocks on every verification.
+ *  All of the response functions take the pre-computed key.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * References:
+ *  Implementing CIFS - Christopher R. Hertel
+ *    http://ubiqx.org/cifs/SMB.html#SMB.8.5
+ *
+ * ========================================================================== **
+ */
+
+#include "auth_common.h"
+#include "HMAC.h"
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+uchar *auth_NTLMv2hash( uchar       *dst,
+                        const uchar *hash,
+                        const uchar *user,
+                        const int    userlen,
+                        const uchar *domain,
+                        const int    domainlen );
+  /* ------------------------------------------------------------------------ **
+   * Generate the NTLMv2 hash (the NTLMv2 "response key").
+   *
+   *  Input:  dst       - Pointer to memory into which to write the result.
+   *                      Requires 16 bytes minimum.
+   *          hash      - Pointer to the 16-byte NT password hash.
+   *          user      - The user name, in upper case, encoded as UTF-16LE.
+   *          userlen   - The length, in bytes, of <user>.
+   *          domain    - The domain name, encoded as UTF-16LE.
+   *          domainlen - The length, in bytes, of <domain>.
+   *
+   *  Output: A pointer to the 16-byte NTLMv2 hash (same as <dst>).
+   *
+   *  Notes:  The user and domain names are fed to HMAC-MD5 one after the
+   *          other, so there is no need to concatenate them first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_NTLMv2response( uchar                 *dst,
+                            const auth_hmacMD5Key *key,
+                            const uchar           *challenge,
+                            const uchar           *blob,
+                            const int              bloblen );
+  /* ------------------------------------------------------------------------ **
+   * Generate an NTLMv2 response.
+   *
+   *  Input:  dst       - Pointer to memory into which to write the response.
+   *                      Requires (16 + <bloblen>) bytes.
+   *          key       - The HMAC key state, generated by calling
+   *                      <auth_hmacMD5SetKey()> with the NTLMv2 hash.
+   *          challenge - Pointer to the 8-byte server challenge.
+   *          blob      - The client blob.
+   *          bloblen   - The length, in bytes, of <blob>.
+   *
+   *  Output: A pointer to the response (same as <dst>).
+   *
+   *  Notes:  The response is the 16-byte NTProofStr followed by a copy of
+   *          the blob.  If the blob has already been written in place
+   *          (that is, <blob> == <dst> + 16) then it is not copied.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool auth_NTLMv2verify( const auth_hmacMD5Key *key,
+                        const uchar           *challenge,
+                        const uchar           *response,
+                        const int              resplen );
+  /* ------------------------------------------------------------------------ **
+   * Verify an NTLMv2 response.
+   *
+   *  Input:  key       - The HMAC key state, generated by calling
+   *                      <auth_hmacMD5SetKey()> with the NTLMv2 hash.
+   *          challenge - Pointer to the 8-byte server challenge.
+   *          response  - The NTLMv2 response, as sent by the client.
+   *          resplen   - The length, in bytes, of <response>.
+   *
+   *  Output: true if the response is valid, else false.
+   *
+   *  Notes:  The blob is hashed where it lies, within <response>.  It is
+   *          not parsed, so checking the blob timestamp (to limit replay)
+   *          is up to the caller.
+   *
+   *          The proof comparison takes the same time whether or not the
+   *          response matches.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_LMv2response( uchar                 *dst,
+                          const auth_hmacMD5Key *key,
+                          const uchar           *challenge,
+                          const uchar           *clientchal );
+  /* ------------------------------------------------------------------------ **
+   * Generate an LMv2 response.
+   *
+   *  Input:  dst         - Pointer to memory into which to write the
+   *                        response.  Must have 24 bytes available.
+   *          key         - The HMAC key state, generated by calling
+   *                        <auth_hmacMD5SetKey()> with the NTLMv2 hash.
+   *          challenge   - Pointer to the 8-byte server challenge.
+   *          clientchal  - Pointer to the 8-byte client challenge.
+   *
+   *  Output: A pointer to the 24-byte response (same as <dst>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool auth_LMv2verify( const auth_hmacMD5Key *key,
+                      const uchar           *challenge,
+                      const uchar           *response );
+  /* ------------------------------------------------------------------------ **
+   * Verify an LMv2 response.
+   *
+   *  Input:  key       - The HMAC key state, generated by calling
+   *                      <auth_hmacMD5SetKey()> with the NTLMv2 hash.
+   *          challenge - Pointer to the 8-byte server challenge.
+   *          response  - The 24-byte LMv2 response, as sent by the client.
+   *
+   *  Output: true if the response is valid, else false.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+uchar *auth_NTLMv2sessionKey( uchar                 *dst,
+                              const auth_hmacMD5Key *key,
+                              const uchar           *proof );
+  /* ------------------------------------------------------------------------ **
+   * Generate the NTLMv2 session base key.
+   *
+   *  Input:  dst   - Pointer to memory into which to write the key.
+   *                  Requires 16 bytes minimum.
+   *          key   - The HMAC key state, generated by calling
+   *                  <auth_hmacMD5SetKey()> with the NTLMv2 hash.
+   *          proof - The first 16 bytes (the NTProofStr) of the NTLMv2
+   *                  response.
+   *
+   *  Output: A pointer to the 16-byte session base key (same as <dst>).
+   *
+   *  Notes:  For LMv2, pass the first 16 bytes of the LMv2 response.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* AUTH_NTLMV2_H */
@@ -49,6 +49,9 @@
 #include "MD4.h"
 #include "MD5.h"
 #include "LMhash.h"
+#include "HMAC.h"
+#include "NTLMv2.h"
+#include "HashCache.h"
 
 /* ========================================================================== */
 #endif /* AUTH_H */
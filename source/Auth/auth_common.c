@@ -0,0 +1,76 @@
+/* ========================================================================== **
+ *
+ *                                auth_common.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Helper functions shared by the modules of the auth subsystem.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Passwords, hashes, and keys pass through buffers on the stack and in
+ *  caller-supplied structures.  Those buffers must be cleared with
+ *  <auth_SecureZero()>, not memset(), once they are no longer needed.
+ *
+ * ========================================================================== **
+ */
+
+#include "auth_common.h"
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+void auth_SecureZero( void *ptr, const size_t len )
+  /* ------------------------------------------------------------------------ **
+   * Clear memory in a way that won't be optimized away.
+   *
+   *  Input:  ptr - Pointer to the memory to be cleared.
+   *          len - Number of bytes to clear.
+   *
+   *  Output: none.
+   *
+   *  Notes:  A plain memset() of memory that is never read again may be
+   *          dropped by the compiler.  Writing through a volatile pointer
+   *          prevents that.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  volatile uchar *p = (volatile uchar *)ptr;
+  size_t          i;
+
+  for( i = 0; i < len; i++ )
+    p[i] = 0;
+  } /* auth_SecureZero */
+
+/* ========================================================================== */
@@ -48,5 +48,28 @@
 
 #include "cifs_common.h"
 
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+void auth_SecureZero( void *ptr, const size_t len );
+  /* ------------------------------------------------------------------------ **
+   * Clear memory in a way that won't be optimized away.
+   *
+   *  Input:  ptr - Pointer to the memory to be cleared.
+   *          len - Number of bytes to clear.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Use this, not memset(), to clear passwords, hashes, keys,
+   *          and hash contexts that have seen them.  A plain memset() of
+   *          memory that is never read again may be dropped by the
+   *          compiler.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 /* ========================================================================== */
 #endif /* AUTH_COMMON_H */
@@ -0,0 +1,277 @@
+/* ========================================================================== **
+ *
+ *                                  Packet.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Parse and build NBT Datagram Service messages.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  The Datagram Service (UDP port 138) carries connectionless traffic.
+ *  Its main uses are browser announcements and mailslot messages.  Every
+ *  datagram starts with the same ten bytes (RFC 1002, section 4.4.1):
+ *
+ *    MSG_TYPE    - 1 byte.
+ *    FLAGS       - 1 byte.  More (M) and First (F) fragment bits, and the
+ *                  two bit source node type (SNT).
+ *    DGM_ID      - 2 bytes.  Datagram ID.  All fragments of a datagram
+ *                  share the same ID.
+ *    SOURCE_IP   - 4 bytes.
+ *    SOURCE_PORT - 2 bytes.
+ *
+ *  DIRECT_UNIQUE, DIRECT_GROUP and BROADCAST datagrams follow that with
+ *  DGM_LENGTH and PACKET_OFFSET (two bytes each), the L2 encoded source
+ *  and destination names, and the user data.  DGM_LENGTH counts the bytes
+ *  following PACKET_OFFSET.  PACKET_OFFSET is the position of this
+ *  fragment's user data within the user data of the whole datagram.
+ *
+ *  ERROR datagrams carry a one byte error code.  QUERY REQUEST and the
+ *  two QUERY RESPONSE types carry a destination name.
+ *
+ *  <nbt_dsParse()> fills in an nbt_dsMsg that points into the received
+ *  packet.  Nothing is copied.  The user data is described by a cifs_Block
+ *  view, so it can be handed straight to the mailslot or browser code.
+ *  A packet received by the batched transport (NBT/NS/Transport.h works
+ *  just as well on port 138) is parsed from its <msg.block>.
+ *
+ *  <nbt_dsBuild()> goes the other way, from an nbt_dsMsg to a packet.
+ *  A parsed message can be rebuilt unchanged, which is what a datagram
+ *  distributor needs to forward it.
+ *
+ * ========================================================================== **
+ */
+
+#include "Packet.h"           /* Module header.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_dsParse( nbt_dsMsg *msg, const cifs_Block *pkt )
+  /* ------------------------------------------------------------------------ **
+   * Parse a Datagram Service message.
+   *
+   *  Input:  msg - The structure to be filled in.
+   *          pkt - The received packet.  The used portion of the block
+   *                is the datagram.
+   *
+   *  Output: On success, the message type (one of the nbt_ds* type
+   *          values).  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput       - <pkt> or its buffer is NULL.
+   *          cifs_errTruncatedBufr   - The packet ends before the message
+   *                                    does.
+   *          cifs_errInvalidPacket   - Unknown message type, or reserved
+   *                                    FLAGS bits set.
+   *          cifs_errBadCallingName  - The source name is not a valid L2
+   *                                    encoded name.
+   *          cifs_errBadCalledName   - The destination name is not a valid
+   *                                    L2 encoded name.
+   *
+   *  Notes:  The names and the user data point into <pkt>, so the packet
+   *          must be kept for as long as <msg> is in use.
+   *
+   *          Bytes beyond DGM_LENGTH are ignored.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  const uchar *bufr;
+  long         len;
+  long         end;
+  int          n;
+
+  if( (NULL == pkt) || (NULL == pkt->bufr) )
+    return( cifs_errNullInput );
+  bufr = pkt->bufr;
+  len  = pkt->used;
+  if( len < nbt_dsHEADER_LEN )
+    return( cifs_errTruncatedBufr );
+
+  msg->type     = bufr[0];
+  msg->flags    = bufr[1];
+  msg->dgm_id   = nbt_GetShort( bufr, 2 );
+  msg->src_ip   = nbt_GetLong( bufr, 4 );
+  msg->src_port = nbt_GetShort( bufr, 8 );
+  msg->offset   = 0;
+  msg->error    = 0;
+  msg->src_name = msg->dst_name = NULL;
+  msg->src_name_len = msg->dst_name_len = 0;
+  (void)cifs_BlockInit( &msg->data, 0, NULL );
+  if( msg->flags & nbt_dsFLAG_RESERVED )
+    return( cifs_errInvalidPacket );
+
+  switch( msg->type )
+    {
+    case nbt_dsDIRECT_UNIQUE:
+    case nbt_dsDIRECT_GROUP:
+    case nbt_dsBROADCAST:
+      if( len < nbt_dsDATA_HDR_LEN )
+        return( cifs_errTruncatedBufr );
+      end = nbt_dsDATA_HDR_LEN + nbt_GetShort( bufr, 10 );
+      if( end > len )
+        return( cifs_errTruncatedBufr );
+      msg->offset = nbt_GetShort( bufr, 12 );
+
+      n = nbt_CheckL2Name( bufr, nbt_dsDATA_HDR_LEN, (int)end );
+      if( n < 0 )
+        return( cifs_errBadCallingName );
+      msg->src_name     = &bufr[nbt_dsDATA_HDR_LEN];
+      msg->src_name_len = (uint8_t)n;
+      n = nbt_CheckL2Name( bufr, nbt_dsDATA_HDR_LEN + n, (int)end );
+      if( n < 0 )
+        return( cifs_errBadCalledName );
+      msg->dst_name     = msg->src_name + msg->src_name_len;
+      msg->dst_name_len = (uint8_t)n;
+
+      n = nbt_dsDATA_HDR_LEN + msg->src_name_len + msg->dst_name_len;
+      (void)cifs_BlockInit( &msg->data, end - n, (uchar *)&bufr[n] );
+      msg->data.used = msg->data.size;
+      break;
+
+    case nbt_dsERROR:
+      if( len < (nbt_dsHEADER_LEN + 1) )
+        return( cifs_errTruncatedBufr );
+      msg->error = bufr[nbt_dsHEADER_LEN];
+      break;
+
+    case nbt_dsQUERY_REQUEST:
+    case nbt_dsPOS_QUERY_RESPONSE:
+    case nbt_dsNEG_QUERY_RESPONSE:
+      n = nbt_CheckL2Name( bufr, nbt_dsHEADER_LEN, (int)len );
+      if( n < 0 )
+        return( cifs_errBadCalledName );
+      msg->dst_name     = &bufr[nbt_dsHEADER_LEN];
+      msg->dst_name_len = (uint8_t)n;
+      break;
+
+    default:
+      return( cifs_errInvalidPacket );
+    }
+
+  return( msg->type );
+  } /* nbt_dsParse */
+
+
+long nbt_dsBuild( cifs_Block *pkt, const nbt_dsMsg *msg )
+  /* ------------------------------------------------------------------------ **
+   * Build a Datagram Service message.
+   *
+   *  Input:  pkt - The block into which the message will be written.  The
+   *                message starts at the beginning of the buffer, and
+   *                <pkt->used> is set to its length.
+   *          msg - The message.  All fields that apply to <msg->type> must
+   *                be filled in.  The names must already be L2 encoded
+   *                (see <nbt_EncodeName()>).
+   *
+   *  Output: On success, the length of the message.  On error, a negative
+   *          value.
+   *
+   *  Errors: cifs_errNullInput     - A name required by the message type
+   *                                  is missing.
+   *          cifs_errInvalidPacket - Unknown message type, or the message
+   *                                  is too long for DGM_LENGTH.
+   *          cifs_errBufrTooSmall  - The message will not fit in <pkt>.
+   *
+   *  Notes:  For the data carrying types, the user data is taken from the
+   *          used portion of <msg->data>.  If <msg->data.bufr> is NULL,
+   *          the space is left for the caller to fill in.  It starts
+   *          <msg->data.used> bytes before the end of the message.
+   *
+   *          nbt_dsMAX_LEN is the largest datagram that the RFC allows.
+   *          This function does not enforce it.  Fragmenting is up to the
+   *          caller.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *bufr = pkt->bufr;
+  long   len;
+
+  switch( msg->type )
+    {
+    case nbt_dsDIRECT_UNIQUE:
+    case nbt_dsDIRECT_GROUP:
+    case nbt_dsBROADCAST:
+      if( (NULL == msg->src_name) || (NULL == msg->dst_name) )
+        return( cifs_errNullInput );
+      len = nbt_dsDATA_HDR_LEN + msg->src_name_len + msg->dst_name_len
+          + msg->data.used;
+      if( (len - nbt_dsDATA_HDR_LEN) > 0xFFFF )
+        return( cifs_errInvalidPacket );
+      if( len > pkt->size )
+        return( cifs_errBufrTooSmall );
+      nbt_SetShort( bufr, 10, (len - nbt_dsDATA_HDR_LEN) );
+      nbt_SetShort( bufr, 12, msg->offset );
+      (void)memcpy( &bufr[nbt_dsDATA_HDR_LEN],
+                    msg->src_name, msg->src_name_len );
+      (void)memcpy( &bufr[nbt_dsDATA_HDR_LEN + msg->src_name_len],
+                    msg->dst_name, msg->dst_name_len );
+      if( NULL != msg->data.bufr )
+        (void)memcpy( &bufr[len - msg->data.used],
+                      msg->data.bufr, msg->data.used );
+      break;
+
+    case nbt_dsERROR:
+      len = nbt_dsHEADER_LEN + 1;
+      if( len > pkt->size )
+        return( cifs_errBufrTooSmall );
+      bufr[nbt_dsHEADER_LEN] = msg->error;
+      break;
+
+    case nbt_dsQUERY_REQUEST:
+    case nbt_dsPOS_QUERY_RESPONSE:
+    case nbt_dsNEG_QUERY_RESPONSE:
+      if( NULL == msg->dst_name )
+        return( cifs_errNullInput );
+      len = nbt_dsHEADER_LEN + msg->dst_name_len;
+      if( len > pkt->size )
+        return( cifs_errBufrTooSmall );
+      (void)memcpy( &bufr[nbt_dsHEADER_LEN],
+                    msg->dst_name, msg->dst_name_len );
+      break;
+
+    default:
+      return( cifs_errInvalidPacket );
+    }
+
+  bufr[0] = msg->type;
+  bufr[1] = msg->flags & ~nbt_dsFLAG_RESERVED;
+  nbt_SetShort( bufr, 2, msg->dgm_id );
+  nbt_SetLong( bufr, 4, msg->src_ip );
+  nbt_SetShort( bufr, 8, msg->src_port );
+  pkt->used = len;
+  return( len );
+  } /* nbt_dsBuild */
+
+/* ========================================================================== */
@@ -0,0 +1,254 @@
+#ifndef NBT_DS_PACKET_H
+#define NBT_DS_PACKET_H
+/* ========================================================================== **
+ *
+ *                                  Packet.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Parse and build NBT Datagram Service messages.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  The Datagram Service (UDP port 138) carries connectionless traffic.
+ *  Its main uses are browser announcements and mailslot messages.  Every
+ *  datagram starts with the same ten bytes (RFC 1002, section 4.4.1):
+ *
+ *    MSG_TYPE    - 1 byte.
+ *    FLAGS       - 1 byte.  More (M) and First (F) fragment bits, and the
+ *                  two bit source node type (SNT).
+ *    DGM_ID      - 2 bytes.  Datagram ID.  All fragments of a datagram
+ *                  share the same ID.
+ *    SOURCE_IP   - 4 bytes.
+ *    SOURCE_PORT - 2 bytes.
+ *
+ *  DIRECT_UNIQUE, DIRECT_GROUP and BROADCAST datagrams follow that with
+ *  DGM_LENGTH and PACKET_OFFSET (two bytes each), the L2 encoded source
+ *  and destination names, and the user data.  DGM_LENGTH counts the bytes
+ *  following PACKET_OFFSET.  PACKET_OFFSET is the position of this
+ *  fragment's user data within the user data of the whole datagram.
+ *
+ *  ERROR datagrams carry a one byte error code.  QUERY REQUEST and the
+ *  two QUERY RESPONSE types carry a destination name.
+ *
+ *  <nbt_dsParse()> fills in an nbt_dsMsg that points into the received
+ *  packet.  Nothing is copied.  The user data is described by a cifs_Block
+ *  view, so it can be handed straight to the mailslot or browser code.
+ *  A packet received by the batched transport (NBT/NS/Transport.h works
+ *  just as well on port 138) is parsed from its <msg.block>.
+ *
+ *  <nbt_dsBuild()> goes the other way, from an nbt_dsMsg to a packet.
+ *  A parsed message can be rebuilt unchanged, which is what a datagram
+ *  distributor needs to forward it.
+ *
+ * ========================================================================== **
+ */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/Names.h"        /* L2 encoded names.                  */
+#include "cifs_block.h"       /* User data views.                   */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_dsHEADER_LEN    - Length of the header common to all datagrams.
+ *  nbt_dsDATA_HDR_LEN  - Length of the header of the data carrying types,
+ *                        up to the start of the source name.
+ *  nbt_dsMAX_LEN       - The largest datagram permitted by RFC 1002.
+ *                        Longer datagrams must be fragmented.
+ */
+
+#define nbt_dsHEADER_LEN    10
+#define nbt_dsDATA_HDR_LEN  14
+#define nbt_dsMAX_LEN       576
+
+/*  --
+ *  Message types.  <RFC 1002, 4.4.1>
+ *
+ *  nbt_dsDIRECT_UNIQUE       - Direct unique datagram.
+ *  nbt_dsDIRECT_GROUP        - Direct group datagram.
+ *  nbt_dsBROADCAST           - Broadcast datagram.
+ *  nbt_dsERROR               - Datagram error.
+ *  nbt_dsQUERY_REQUEST       - Datagram query request.  (NBDD)
+ *  nbt_dsPOS_QUERY_RESPONSE  - Positive query response.  (NBDD)
+ *  nbt_dsNEG_QUERY_RESPONSE  - Negative query response.  (NBDD)
+ */
+
+#define nbt_dsDIRECT_UNIQUE       0x10
+#define nbt_dsDIRECT_GROUP        0x11
+#define nbt_dsBROADCAST           0x12
+#define nbt_dsERROR               0x13
+#define nbt_dsQUERY_REQUEST       0x14
+#define nbt_dsPOS_QUERY_RESPONSE  0x15
+#define nbt_dsNEG_QUERY_RESPONSE  0x16
+
+/*  --
+ *  FLAGS bits.
+ *
+ *  nbt_dsFLAG_MORE     - More fragments follow.
+ *  nbt_dsFLAG_FIRST    - This is the first fragment.
+ *  nbt_dsSNT_MASK      - Source node type subfield mask.
+ *  nbt_dsSNT_B         - B node.
+ *  nbt_dsSNT_P         - P node.
+ *  nbt_dsSNT_M         - M node.
+ *  nbt_dsSNT_NBDD      - NBDD.
+ *  nbt_dsFLAG_RESERVED - Reserved bits.  Must be zero.
+ *
+ *  An unfragmented datagram has FIRST set and MORE clear.
+ */
+
+#define nbt_dsFLAG_MORE     0x01
+#define nbt_dsFLAG_FIRST    0x02
+#define nbt_dsSNT_MASK      0x0C
+#define nbt_dsSNT_B         0x00
+#define nbt_dsSNT_P         0x04
+#define nbt_dsSNT_M         0x08
+#define nbt_dsSNT_NBDD      0x0C
+#define nbt_dsFLAG_RESERVED 0xF0
+
+/*  --
+ *  ERROR_CODE values.  <RFC 1002, 4.4.3>
+ *
+ *  nbt_dsERR_DST_NOT_PRESENT - Destination name not present.
+ *  nbt_dsERR_BAD_SRC_FORMAT  - Invalid source name format.
+ *  nbt_dsERR_BAD_DST_FORMAT  - Invalid destination name format.
+ */
+
+#define nbt_dsERR_DST_NOT_PRESENT 0x82
+#define nbt_dsERR_BAD_SRC_FORMAT  0x83
+#define nbt_dsERR_BAD_DST_FORMAT  0x84
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_dsMsg - A parsed (or to be built) datagram.
+ *              type          - Message type.
+ *              flags         - FLAGS field.
+ *              dgm_id        - Datagram ID.
+ *              src_ip        - Source IP, in host byte order.
+ *              src_port      - Source port.
+ *              offset        - PACKET_OFFSET.  Data carrying types only.
+ *              error         - ERROR_CODE.  nbt_dsERROR only.
+ *              src_name      - The L2 encoded source name, or NULL.
+ *              src_name_len  - Length of <src_name>.
+ *              dst_name      - The L2 encoded destination name, or NULL.
+ *              dst_name_len  - Length of <dst_name>.
+ *              data          - The user data.  <data.used> is the length.
+ */
+
+typedef struct
+  {
+  uint8_t      type;
+  uint8_t      flags;
+  uint16_t     dgm_id;
+  uint32_t     src_ip;
+  uint16_t     src_port;
+  uint16_t     offset;
+  uint8_t      error;
+  const uchar *src_name;
+  uint8_t      src_name_len;
+  const uchar *dst_name;
+  uint8_t      dst_name_len;
+  cifs_Block   data;
+  } nbt_dsMsg;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_dsParse( nbt_dsMsg *msg, const cifs_Block *pkt );
+  /* ------------------------------------------------------------------------ **
+   * Parse a Datagram Service message.
+   *
+   *  Input:  msg - The structure to be filled in.
+   *          pkt - The received packet.  The used portion of the block
+   *                is the datagram.
+   *
+   *  Output: On success, the message type (one of the nbt_ds* type
+   *          values).  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput       - <pkt> or its buffer is NULL.
+   *          cifs_errTruncatedBufr   - The packet ends before the message
+   *                                    does.
+   *          cifs_errInvalidPacket   - Unknown message type, or reserved
+   *                                    FLAGS bits set.
+   *          cifs_errBadCallingName  - The source name is not a valid L2
+   *                                    encoded name.
+   *          cifs_errBadCalledName   - The destination name is not a valid
+   *                                    L2 encoded name.
+   *
+   *  Notes:  The names and the user data point into <pkt>, so the packet
+   *          must be kept for as long as <msg> is in use.
+   *
+   *          Bytes beyond DGM_LENGTH are ignored.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+long nbt_dsBuild( cifs_Block *pkt, const nbt_dsMsg *msg );
+  /* ------------------------------------------------------------------------ **
+   * Build a Datagram Service message.
+   *
+   *  Input:  pkt - The block into which the message will be written.  The
+   *                message starts at the beginning of the buffer, and
+   *                <pkt->used> is set to its length.
+   *          msg - The message.  All fields that apply to <msg->type> must
+   *                be filled in.  The names must already be L2 encoded
+   *                (see <nbt_EncodeName()>).
+   *
+   *  Output: On success, the length of the message.  On error, a negative
+   *          value.
+   *
+   *  Errors: cifs_errNullInput     - A name required by the message type
+   *                                  is missing.
+   *          cifs_errInvalidPacket - Unknown message type, or the message
+   *                                  is too long for DGM_LENGTH.
+   *          cifs_errBufrTooSmall  - The message will not fit in <pkt>.
+   *
+   *  Notes:  For the data carrying types, the user data is taken from the
+   *          used portion of <msg->data>.  If <msg->data.bufr> is NULL,
+   *          the space is left for the caller to fill in.  It starts
+   *          <msg->data.used> bytes before the end of the message.
+   *
+   *          nbt_dsMAX_LEN is the largest datagram that the RFC allows.
+   *          This function does not enforce it.  Fragmenting is up to the
+   *          caller.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_DS_PACKET_H */
@@ -0,0 +1,665 @@
+/* ========================================================================== **
+ *
+ *                                  Reasm.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Reassemble fragmented NBT datagrams.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A datagram with more user data than fits in nbt_dsMAX_LEN bytes is
+ *  sent in fragments (RFC 1002, section 4.4).  Each fragment carries
+ *  the full header and both names.  The first has the FIRST flag set,
+ *  all but the last have the MORE flag set, and PACKET_OFFSET gives the
+ *  position of each fragment's user data.  Fragments of one datagram are
+ *  identified by the sender's IP address and the DGM_ID.
+ *
+ *  The reassembly table holds partial datagrams until all of their
+ *  fragments have arrived.  It is built for a receive loop that may see
+ *  floods of traffic, much of it hostile or broken:
+ *
+ *  - Fragments are not copied on arrival.  If the caller passes the
+ *    pooled block that holds the packet (eg., the <bufr> of an
+ *    nbt_nsDatagram), the table just takes a reference to it.  The data
+ *    is copied once, into a single pooled block, when the datagram is
+ *    complete.
+ *
+ *  - Partial datagrams are found through a hash table, and their timers
+ *    are kept in a hashed timer wheel, as in NBT/NS/Resolver.c.
+ *
+ *  - The memory held by partial datagrams is capped.  When a new
+ *    fragment would go over the cap, or when all entries are in use, the
+ *    partial datagram that would time out soonest is thrown away.
+ *
+ *  Unfragmented datagrams pass straight through without being copied,
+ *  so every data carrying datagram can simply be handed to
+ *  <nbt_dsReasmAdd()>.
+ *
+ *  The table is not thread-safe.  Each receive thread should have its
+ *  own.
+ *
+ * ========================================================================== **
+ */
+
+#include <stdlib.h>           /* For calloc(3) and free(3).         */
+#include <time.h>             /* For clock_gettime(2).              */
+
+#include "Reasm.h"            /* Module header.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  REASM_TICKBITS  - Each bucket of the timer wheel covers 2^REASM_TICKBITS
+ *                    milliseconds.  The wheel turns once every 16 seconds
+ *                    or so.
+ */
+
+#define REASM_TICKBITS 6
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static uint32_t Now( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a millisecond clock.
+   *
+   *  Input:  none.
+   *  Output: Milliseconds since some arbitrary point, modulo 2^32.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000) );
+  } /* Now */
+
+
+static nbt_dsReasmEntry **Lookup( nbt_dsReasm    *r,
+                                  const uint32_t  src_ip,
+                                  const uint16_t  dgm_id )
+  /* ------------------------------------------------------------------------ **
+   * Find a partial datagram.
+   *
+   *  Input:  r       - The table.
+   *          src_ip  - Source IP address.
+   *          dgm_id  - Datagram ID.
+   *
+   *  Output: A pointer to the hash chain link that points to the entry.
+   *          If there is no such entry, the link is NULL, and is where a
+   *          new entry should be attached.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t           h = (src_ip ^ ((uint32_t)dgm_id << 16)) * 0x9E3779B1;
+  nbt_dsReasmEntry **pe;
+
+  pe = &r->bucket[(h >> 16) & (r->nbuckets - 1)];
+  while( (NULL != *pe)
+      && (((*pe)->src_ip != src_ip) || ((*pe)->dgm_id != dgm_id)) )
+    pe = &(*pe)->hnext;
+  return( pe );
+  } /* Lookup */
+
+
+static void TimerAdd( nbt_dsReasm *r, nbt_dsReasmEntry *e, const uint32_t when )
+  /* ------------------------------------------------------------------------ **
+   * Start an entry's timer.
+   *
+   *  Input:  r     - The table.
+   *          e     - The entry.
+   *          when  - The time, per <Now()>, at which the timer expires.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_dsReasmEntry **bucket;
+
+  bucket = &r->wheel[(when >> REASM_TICKBITS) & (nbt_dsREASM_WHEEL - 1)];
+  e->expires = when;
+  e->prev    = NULL;
+  e->next    = *bucket;
+  if( NULL != e->next )
+    e->next->prev = e;
+  *bucket = e;
+  } /* TimerAdd */
+
+
+static void Drop( nbt_dsReasm *r, nbt_dsReasmEntry *e )
+  /* ------------------------------------------------------------------------ **
+   * Discard a partial datagram and put its entry on the free list.
+   *
+   *  Input:  r - The table.
+   *          e - The entry.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_dsReasmEntry **pe;
+  int                i;
+
+  /* Stop the timer. */
+  if( NULL != e->next )
+    e->next->prev = e->prev;
+  if( NULL != e->prev )
+    e->prev->next = e->next;
+  else
+    r->wheel[(e->expires >> REASM_TICKBITS) & (nbt_dsREASM_WHEEL - 1)]
+      = e->next;
+
+  /* Unhook it from the hash chain. */
+  pe = Lookup( r, e->src_ip, e->dgm_id );
+  *pe = e->hnext;
+
+  for( i = 0; i < e->nfrag; i++ )
+    cifs_BlockPoolPut( e->frag[i].owner );
+  r->mem  -= e->mem;
+  r->count--;
+  e->nfrag = 0;
+  e->mem   = 0;
+
+  e->prev     = NULL;
+  e->next     = r->freelist;
+  r->freelist = e;
+  } /* Drop */
+
+
+static int Reject( nbt_dsReasm *r, nbt_dsReasmEntry *e, const int err )
+  /* ------------------------------------------------------------------------ **
+   * Discard a partial datagram that cannot be completed.
+   *
+   *  Input:  r   - The table.
+   *          e   - The entry.
+   *          err - The error to be returned.
+   *
+   *  Output: <err>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Drop( r, e );
+  r->rejected++;
+  return( err );
+  } /* Reject */
+
+
+static nbt_dsReasmEntry *Oldest( nbt_dsReasm            *r,
+                                  const nbt_dsReasmEntry *skip )
+  /* ------------------------------------------------------------------------ **
+   * Find the partial datagram that will time out soonest.
+   *
+   *  Input:  r     - The table.
+   *          skip  - An entry that must not be chosen (the one being
+   *                  filled in), or NULL.
+   *
+   *  Output: A pointer to the entry, or NULL if there is no entry other
+   *          than <skip>.
+   *
+   *  Notes:  Timeouts are less than one turn of the wheel, so the first
+   *          non-empty bucket at or after the current tick holds the
+   *          earliest timers.
+   *
+   *          New timers go at the head of their bucket.  Under a flood,
+   *          many entries share the same expiry time, so ties are broken
+   *          in favor of the entry further down the list, which is the
+   *          older one.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_dsReasmEntry *e;
+  nbt_dsReasmEntry *best = NULL;
+  uint32_t          i;
+
+  for( i = 0; (NULL == best) && (i < nbt_dsREASM_WHEEL); i++ )
+    {
+    e = r->wheel[(r->tick + i) & (nbt_dsREASM_WHEEL - 1)];
+    for( ; NULL != e; e = e->next )
+      if( (e != skip)
+          && ((NULL == best) || ((int32_t)(e->expires - best->expires) <= 0)) )
+        best = e;
+    }
+  return( best );
+  } /* Oldest */
+
+
+static int Expire( nbt_dsReasm *r, const uint32_t now )
+  /* ------------------------------------------------------------------------ **
+   * Discard partial datagrams whose time is up.
+   *
+   *  Input:  r   - The table.
+   *          now - The current time, per <Now()>.
+   *
+   *  Output: The number of entries discarded.
+   *
+   *  Notes:  Each wheel bucket between the last tick processed and now
+   *          is examined.  If more than a full turn has passed, every
+   *          bucket is examined once.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t          tick  = now >> REASM_TICKBITS;
+  uint32_t          steps = tick - r->tick + 1;
+  uint32_t          i;
+  int               count = 0;
+  nbt_dsReasmEntry *e;
+  nbt_dsReasmEntry *next;
+
+  if( (int32_t)(tick - r->tick) < 0 )
+    return( 0 );
+  if( steps > nbt_dsREASM_WHEEL )
+    steps = nbt_dsREASM_WHEEL;
+
+  for( i = 0; i < steps; i++ )
+    {
+    e = r->wheel[(r->tick + i) & (nbt_dsREASM_WHEEL - 1)];
+    for( ; NULL != e; e = next )
+      {
+      next = e->next;
+      if( (int32_t)(e->expires - now) > 0 )
+        continue;
+      Drop( r, e );
+      count++;
+      }
+    }
+  r->tick     = tick;
+  r->expired += count;
+  return( count );
+  } /* Expire */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_dsReasm *nbt_dsReasmNew( const int      maxent,
+                             const long     memcap,
+                             const uint32_t timeout )
+  /* ------------------------------------------------------------------------ **
+   * Create a reassembly table.
+   *
+   *  Input:  maxent  - The largest number of partial datagrams that will
+   *                    be held at once.
+   *          memcap  - The most memory, in bytes, that the fragments of
+   *                    partial datagrams may hold.
+   *          timeout - How long, in milliseconds, to wait for the rest of
+   *                    a datagram after its first fragment arrives.  Zero
+   *                    selects nbt_dsREASM_TIMEOUT.  Values greater than
+   *                    nbt_dsREASM_MAXWAIT are reduced to that.
+   *
+   *  Output: A pointer to the new table, or NULL if <maxent> or <memcap>
+   *          is less than one, or if memory could not be allocated.
+   *
+   *  Notes:  The memory for the entries is allocated here.  <memcap> only
+   *          covers the packet buffers held by the entries.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_dsReasm *r;
+  uint32_t     nbuckets = 1;
+  int          i;
+
+  if( (maxent < 1) || (memcap < 1) )
+    return( NULL );
+  while( nbuckets < (uint32_t)maxent * 2 )
+    nbuckets <<= 1;
+
+  r = (nbt_dsReasm *)calloc( 1, sizeof( nbt_dsReasm ) );
+  if( NULL == r )
+    return( NULL );
+  r->entry  = (nbt_dsReasmEntry *)calloc( maxent, sizeof( nbt_dsReasmEntry ) );
+  r->bucket = (nbt_dsReasmEntry **)calloc( nbuckets,
+                                           sizeof( nbt_dsReasmEntry * ) );
+  if( (NULL == r->entry) || (NULL == r->bucket) )
+    {
+    nbt_dsReasmFree( r );
+    return( NULL );
+    }
+
+  r->maxent   = maxent;
+  r->nbuckets = nbuckets;
+  r->memcap   = memcap;
+  r->timeout  = timeout ? timeout : nbt_dsREASM_TIMEOUT;
+  if( r->timeout > nbt_dsREASM_MAXWAIT )
+    r->timeout = nbt_dsREASM_MAXWAIT;
+  r->tick     = Now() >> REASM_TICKBITS;
+
+  /* Chain all of the entries onto the free list. */
+  for( i = 0; i < maxent; i++ )
+    {
+    r->entry[i].next = r->freelist;
+    r->freelist      = &r->entry[i];
+    }
+  return( r );
+  } /* nbt_dsReasmNew */
+
+
+void nbt_dsReasmFree( nbt_dsReasm *r )
+  /* ------------------------------------------------------------------------ **
+   * Destroy a reassembly table.
+   *
+   *  Input:  r - The table.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  All partial datagrams are discarded.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  if( NULL == r )
+    return;
+  if( NULL != r->entry )
+    {
+    for( i = 0; i < r->maxent; i++ )
+      if( r->entry[i].nfrag > 0 )
+        Drop( r, &r->entry[i] );
+    free( r->entry );
+    }
+  free( r->bucket );
+  free( r );
+  } /* nbt_dsReasmFree */
+
+
+int nbt_dsReasmAdd( nbt_dsReasm     *r,
+                    const nbt_dsMsg *frag,
+                    cifs_Block      *owner,
+                    nbt_dsMsg       *out,
+                    cifs_Block     **outblk )
+  /* ------------------------------------------------------------------------ **
+   * Add a received datagram or fragment to the table.
+   *
+   *  Input:  r       - The table.
+   *          frag    - A parsed DIRECT_UNIQUE, DIRECT_GROUP or BROADCAST
+   *                    datagram.  See <nbt_dsParse()>.
+   *          owner   - The pooled block that holds the packet, or NULL.
+   *                    If given, the table takes a reference to it instead
+   *                    of copying the fragment.
+   *          out     - Receives the complete datagram.
+   *          outblk  - Receives the pooled block that holds the complete
+   *                    datagram, or NULL.
+   *
+   *  Output: One if <out> holds a complete datagram, zero if the fragment
+   *          was stored (or was a duplicate), or a negative value if the
+   *          fragment was rejected.
+   *
+   *  Errors: cifs_errInvalidPacket - <frag> is not a data carrying type,
+   *                                  or it overlaps another fragment of
+   *                                  the same datagram, or it disagrees
+   *                                  about where the datagram ends.  The
+   *                                  partial datagram is discarded.
+   *          cifs_errBufrTooSmall  - The fragment would not fit within
+   *                                  the memory cap, or the datagram has
+   *                                  more than nbt_dsREASM_MAXFRAGS
+   *                                  fragments.  The partial datagram is
+   *                                  discarded.  A fragment that is
+   *                                  larger than the whole cap is turned
+   *                                  away before anything is evicted.
+   *          cifs_errGeneric       - Out of memory.
+   *
+   *  Notes:  An unfragmented datagram is simply copied to <out>, and
+   *          <*outblk> is set to NULL.  <out> then points into the same
+   *          packet as <frag>.
+   *
+   *          When a fragmented datagram is complete, <out> describes it
+   *          as if it had arrived in one piece: the FIRST flag is set, the
+   *          MORE flag is clear, and the offset is zero.  The names and
+   *          the data are in <*outblk>, which the caller must give back
+   *          with <cifs_BlockPoolPut()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_dsReasmEntry  *e;
+  nbt_dsReasmEntry **pe;
+  nbt_dsReasmFrag   *f;
+  cifs_Block        *blk;
+  long               cost;
+  long               end = frag->offset + frag->data.used;
+  long               maxend;
+  uint32_t           now;
+  uchar             *p;
+  int                i;
+
+  *outblk = NULL;
+  if( (frag->type < nbt_dsDIRECT_UNIQUE) || (frag->type > nbt_dsBROADCAST) )
+    return( cifs_errInvalidPacket );
+
+  /* Unfragmented datagrams go straight through. */
+  if( (nbt_dsFLAG_FIRST == (frag->flags & nbt_dsFLAG_FIRST))
+   && (0 == (frag->flags & nbt_dsFLAG_MORE)) )
+    {
+    *out = *frag;
+    return( 1 );
+    }
+
+  now = Now();
+  Expire( r, now );
+
+  /* Find the partial datagram. */
+  pe = Lookup( r, frag->src_ip, frag->dgm_id );
+  e  = *pe;
+
+  /* Turn away a fragment bigger than the whole cap before evicting. */
+  cost = (NULL != owner) ? owner->size
+       : (frag->src_name_len + frag->dst_name_len + frag->data.used);
+  if( cost > r->memcap )
+    {
+    if( NULL != e )
+      return( Reject( r, e, cifs_errBufrTooSmall ) );
+    r->rejected++;
+    return( cifs_errBufrTooSmall );
+    }
+
+  /* Start a new one if need be. */
+  if( NULL == e )
+    {
+    if( NULL == r->freelist )
+      {
+      Drop( r, Oldest( r, NULL ) );
+      r->evicted++;
+      pe = Lookup( r, frag->src_ip, frag->dgm_id );
+      }
+    e = r->freelist;
+    r->freelist = e->next;
+    (void)memset( e, 0, sizeof( nbt_dsReasmEntry ) );
+    e->src_ip = frag->src_ip;
+    e->dgm_id = frag->dgm_id;
+    e->total  = -1;
+    e->hnext  = NULL;
+    *pe = e;
+    r->count++;
+    TimerAdd( r, e, now + r->timeout );
+    }
+
+  /* Check the fragment against the ones we have. */
+  for( maxend = 0, i = 0; i < e->nfrag; i++ )
+    {
+    f = &e->frag[i];
+    if( (f->offset == frag->offset) && (f->len == frag->data.used) )
+      {
+      r->duplicates++;
+      return( 0 );
+      }
+    if( (frag->offset < (f->offset + f->len)) && (f->offset < end) )
+      return( Reject( r, e, cifs_errInvalidPacket ) );
+    if( (f->offset + f->len) > maxend )
+      maxend = f->offset + f->len;
+    }
+  if( (frag->flags & nbt_dsFLAG_FIRST) && (0 != frag->offset) )
+    return( Reject( r, e, cifs_errInvalidPacket ) );
+  if( !(frag->flags & nbt_dsFLAG_MORE) )
+    {
+    if( (e->total >= 0) || (end < maxend) )
+      return( Reject( r, e, cifs_errInvalidPacket ) );
+    e->total = end;
+    }
+  else if( (e->total >= 0) && (end > e->total) )
+    return( Reject( r, e, cifs_errInvalidPacket ) );
+  if( e->nfrag >= nbt_dsREASM_MAXFRAGS )
+    return( Reject( r, e, cifs_errBufrTooSmall ) );
+
+  /* Make room within the memory cap, then hold or copy the fragment. */
+  while( (r->mem + cost) > r->memcap )
+    {
+    nbt_dsReasmEntry *victim = Oldest( r, e );
+
+    if( NULL == victim )
+      return( Reject( r, e, cifs_errBufrTooSmall ) );
+    Drop( r, victim );
+    r->evicted++;
+    }
+
+  f = &e->frag[e->nfrag];
+  f->msg = *frag;
+  if( NULL != owner )
+    f->owner = cifs_BlockPoolHold( owner );
+  else
+    {
+    f->owner = cifs_BlockPoolGet( cost );
+    if( NULL == f->owner )
+      return( Reject( r, e, cifs_errGeneric ) );
+    cost = f->owner->size;
+    p = f->owner->bufr;
+    (void)memcpy( p, frag->src_name, frag->src_name_len );
+    f->msg.src_name = p;
+    p += frag->src_name_len;
+    (void)memcpy( p, frag->dst_name, frag->dst_name_len );
+    f->msg.dst_name = p;
+    p += frag->dst_name_len;
+    (void)memcpy( p, frag->data.bufr, frag->data.used );
+    f->msg.data.bufr = p;
+    }
+  f->offset = frag->offset;
+  f->len    = (uint16_t)frag->data.used;
+  f->cost   = cost;
+  if( frag->flags & nbt_dsFLAG_FIRST )
+    e->first = e->nfrag;
+  e->nfrag++;
+  e->have += f->len;
+  e->mem  += cost;
+  r->mem  += cost;
+  r->fragments++;
+
+  /* Not done yet? */
+  if( (e->total < 0) || (e->have < e->total) || (0 == e->have)
+   || !(e->frag[e->first].msg.flags & nbt_dsFLAG_FIRST) )
+    return( 0 );
+
+  /* Put the datagram together. */
+  f   = &e->frag[e->first];
+  blk = cifs_BlockPoolGet( f->msg.src_name_len + f->msg.dst_name_len
+                         + e->total );
+  if( NULL == blk )
+    return( Reject( r, e, cifs_errGeneric ) );
+
+  *out = f->msg;
+  p = blk->bufr;
+  (void)memcpy( p, f->msg.src_name, f->msg.src_name_len );
+  out->src_name = p;
+  p += f->msg.src_name_len;
+  (void)memcpy( p, f->msg.dst_name, f->msg.dst_name_len );
+  out->dst_name = p;
+  p += f->msg.dst_name_len;
+  for( i = 0; i < e->nfrag; i++ )
+    (void)memcpy( &p[e->frag[i].offset],
+                  e->frag[i].msg.data.bufr, e->frag[i].len );
+  (void)cifs_BlockInit( &out->data, e->total, p );
+  out->data.used = e->total;
+  out->flags     = (out->flags | nbt_dsFLAG_FIRST) & ~nbt_dsFLAG_MORE;
+  out->offset    = 0;
+  blk->used      = (p - blk->bufr) + e->total;
+  *outblk        = blk;
+
+  Drop( r, e );
+  r->completed++;
+  return( 1 );
+  } /* nbt_dsReasmAdd */
+
+
+int nbt_dsReasmTick( nbt_dsReasm *r )
+  /* ------------------------------------------------------------------------ **
+   * Discard partial datagrams that have timed out.
+   *
+   *  Input:  r - The table.
+   *
+   *  Output: The number of partial datagrams discarded.
+   *
+   *  Notes:  <nbt_dsReasmAdd()> also does this, so it is only needed when
+   *          the receive loop is idle.  Calling it every few hundred
+   *          milliseconds is plenty.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  return( Expire( r, Now() ) );
+  } /* nbt_dsReasmTick */
+
+
+nbt_dsReasmStats *nbt_dsReasmGetStats( nbt_dsReasm      *r,
+                                       nbt_dsReasmStats *stats )
+  /* ------------------------------------------------------------------------ **
+   * Get the reassembly counters.
+   *
+   *  Input:  r     - The table.
+   *          stats - A pointer to the structure to be filled in.
+   *
+   *  Output: A pointer to the filled-in structure (same as <stats>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  stats->entries    = r->count;
+  stats->mem        = r->mem;
+  stats->fragments  = r->fragments;
+  stats->completed  = r->completed;
+  stats->expired    = r->expired;
+  stats->evicted    = r->evicted;
+  stats->rejected   = r->rejected;
+  stats->duplicates = r->duplicates;
+  return( stats );
+  } /* nbt_dsReasmGetStats */
+
+/* ========================================================================== */
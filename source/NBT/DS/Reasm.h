@@ -0,0 +1,301 @@
+#ifndef NBT_DS_REASM_H
+#define NBT_DS_REASM_H
+/* ========================================================================== **
+ *
+ *                                  Reasm.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Reassemble fragmented NBT datagrams.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A datagram with more user data than fits in nbt_dsMAX_LEN bytes is
+ *  sent in fragments (RFC 1002, section 4.4).  Each fragment carries
+ *  the full header and both names.  The first has the FIRST flag set,
+ *  all but the last have the MORE flag set, and PACKET_OFFSET gives the
+ *  position of each fragment's user data.  Fragments of one datagram are
+ *  identified by the sender's IP address and the DGM_ID.
+ *
+ *  The reassembly table holds partial datagrams until all of their
+ *  fragments have arrived.  It is built for a receive loop that may see
+ *  floods of traffic, much of it hostile or broken:
+ *
+ *  - Fragments are not copied on arrival.  If the caller passes the
+ *    pooled block that holds the packet (eg., the <bufr> of an
+ *    nbt_nsDatagram), the table just takes a reference to it.  The data
+ *    is copied once, into a single pooled block, when the datagram is
+ *    complete.
+ *
+ *  - Partial datagrams are found through a hash table, and their timers
+ *    are kept in a hashed timer wheel, as in NBT/NS/Resolver.c.
+ *
+ *  - The memory held by partial datagrams is capped.  When a new
+ *    fragment would go over the cap, or when all entries are in use, the
+ *    partial datagram that would time out soonest is thrown away.
+ *
+ *  Unfragmented datagrams pass straight through without being copied,
+ *  so every data carrying datagram can simply be handed to
+ *  <nbt_dsReasmAdd()>.
+ *
+ *  The table is not thread-safe.  Each receive thread should have its
+ *  own.
+ *
+ * ========================================================================== **
+ */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/DS/Packet.h"    /* nbt_dsMsg.                         */
+#include "cifs_pool.h"        /* Pooled packet buffers.             */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_dsREASM_MAXFRAGS  - The most fragments a datagram may have.  That
+ *                          is about 35K of user data, far more than any
+ *                          browser or mailslot message needs.
+ *  nbt_dsREASM_TIMEOUT   - The default reassembly timeout, in ms.
+ *  nbt_dsREASM_MAXWAIT   - The longest reassembly timeout, in ms.  This is
+ *                          just under one full turn of the timer wheel.
+ *  nbt_dsREASM_WHEEL     - The number of buckets in the timer wheel.
+ */
+
+#define nbt_dsREASM_MAXFRAGS  64
+#define nbt_dsREASM_TIMEOUT   2000
+#define nbt_dsREASM_MAXWAIT   16000
+#define nbt_dsREASM_WHEEL     256
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_dsReasmFrag   - One stored fragment.
+ *                      msg     - The parsed fragment.  Its pointers point
+ *                                into <owner>.
+ *                      owner   - The pooled block that holds the fragment.
+ *                      offset  - PACKET_OFFSET of the fragment.
+ *                      len     - Length of the fragment's user data.
+ *                      cost    - Bytes charged against the memory cap.
+ *
+ *  nbt_dsReasmEntry  - A partial datagram.  <total> is the length of the
+ *                      user data, or -1 until the last fragment arrives.
+ *                      <first> is the index of the FIRST fragment.
+ *
+ *  nbt_dsReasm       - The reassembly table.  Treat as opaque.
+ *
+ *  nbt_dsReasmStats  - Counters, as returned by <nbt_dsReasmGetStats()>.
+ */
+
+typedef struct
+  {
+  nbt_dsMsg   msg;
+  cifs_Block *owner;
+  uint16_t    offset;
+  uint16_t    len;
+  long        cost;
+  } nbt_dsReasmFrag;
+
+typedef struct nbt_dsReasmEntry
+  {
+  struct nbt_dsReasmEntry *next;      /* Timer bucket or free list.   */
+  struct nbt_dsReasmEntry *prev;      /* Timer bucket.                */
+  struct nbt_dsReasmEntry *hnext;     /* Hash chain.                  */
+  uint32_t                 expires;
+  uint32_t                 src_ip;
+  uint16_t                 dgm_id;
+  long                     total;
+  long                     have;
+  long                     mem;
+  int                      first;
+  int                      nfrag;
+  nbt_dsReasmFrag          frag[nbt_dsREASM_MAXFRAGS];
+  } nbt_dsReasmEntry;
+
+typedef struct
+  {
+  nbt_dsReasmEntry  *entry;
+  nbt_dsReasmEntry **bucket;
+  nbt_dsReasmEntry  *freelist;
+  nbt_dsReasmEntry  *wheel[nbt_dsREASM_WHEEL];
+  int                maxent;
+  uint32_t           nbuckets;
+  uint32_t           timeout;
+  uint32_t           tick;
+  long               memcap;
+  long               mem;
+  uint32_t           count;
+  uint32_t           fragments;
+  uint32_t           completed;
+  uint32_t           expired;
+  uint32_t           evicted;
+  uint32_t           rejected;
+  uint32_t           duplicates;
+  } nbt_dsReasm;
+
+typedef struct
+  {
+  uint32_t entries;       /* Partial datagrams currently held.          */
+  long     mem;           /* Bytes held, as counted against the cap.    */
+  uint32_t fragments;     /* Fragments stored.                          */
+  uint32_t completed;     /* Fragmented datagrams reassembled.          */
+  uint32_t expired;       /* Partial datagrams that timed out.          */
+  uint32_t evicted;       /* Partial datagrams pushed out to make room. */
+  uint32_t rejected;      /* Partial datagrams or fragments refused.    */
+  uint32_t duplicates;    /* Duplicate fragments ignored.               */
+  } nbt_dsReasmStats;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_dsReasm *nbt_dsReasmNew( const int      maxent,
+                             const long     memcap,
+                             const uint32_t timeout );
+  /* ------------------------------------------------------------------------ **
+   * Create a reassembly table.
+   *
+   *  Input:  maxent  - The largest number of partial datagrams that will
+   *                    be held at once.
+   *          memcap  - The most memory, in bytes, that the fragments of
+   *                    partial datagrams may hold.
+   *          timeout - How long, in milliseconds, to wait for the rest of
+   *                    a datagram after its first fragment arrives.  Zero
+   *                    selects nbt_dsREASM_TIMEOUT.  Values greater than
+   *                    nbt_dsREASM_MAXWAIT are reduced to that.
+   *
+   *  Output: A pointer to the new table, or NULL if <maxent> or <memcap>
+   *          is less than one, or if memory could not be allocated.
+   *
+   *  Notes:  The memory for the entries is allocated here.  <memcap> only
+   *          covers the packet buffers held by the entries.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_dsReasmFree( nbt_dsReasm *r );
+  /* ------------------------------------------------------------------------ **
+   * Destroy a reassembly table.
+   *
+   *  Input:  r - The table.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  All partial datagrams are discarded.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_dsReasmAdd( nbt_dsReasm     *r,
+                    const nbt_dsMsg *frag,
+                    cifs_Block      *owner,
+                    nbt_dsMsg       *out,
+                    cifs_Block     **outblk );
+  /* ------------------------------------------------------------------------ **
+   * Add a received datagram or fragment to the table.
+   *
+   *  Input:  r       - The table.
+   *          frag    - A parsed DIRECT_UNIQUE, DIRECT_GROUP or BROADCAST
+   *                    datagram.  See <nbt_dsParse()>.
+   *          owner   - The pooled block that holds the packet, or NULL.
+   *                    If given, the table takes a reference to it instead
+   *                    of copying the fragment.
+   *          out     - Receives the complete datagram.
+   *          outblk  - Receives the pooled block that holds the complete
+   *                    datagram, or NULL.
+   *
+   *  Output: One if <out> holds a complete datagram, zero if the fragment
+   *          was stored (or was a duplicate), or a negative value if the
+   *          fragment was rejected.
+   *
+   *  Errors: cifs_errInvalidPacket - <frag> is not a data carrying type,
+   *                                  or it overlaps another fragment of
+   *                                  the same datagram, or it disagrees
+   *                                  about where the datagram ends.  The
+   *                                  partial datagram is discarded.
+   *          cifs_errBufrTooSmall  - The fragment would not fit within
+   *                                  the memory cap, or the datagram has
+   *                                  more than nbt_dsREASM_MAXFRAGS
+   *                                  fragments.  The partial datagram is
+   *                                  discarded.  A fragment that is
+   *                                  larger than the whole cap is turned
+   *                                  away before anything is evicted.
+   *          cifs_errGeneric       - Out of memory.
+   *
+   *  Notes:  An unfragmented datagram is simply copied to <out>, and
+   *          <*outblk> is set to NULL.  <out> then points into the same
+   *          packet as <frag>.
+   *
+   *          When a fragmented datagram is complete, <out> describes it
+   *          as if it had arrived in one piece: the FIRST flag is set, the
+   *          MORE flag is clear, and the offset is zero.  The names and
+   *          the data are in <*outblk>, which the caller must give back
+   *          with <cifs_BlockPoolPut()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_dsReasmTick( nbt_dsReasm *r );
+  /* ------------------------------------------------------------------------ **
+   * Discard partial datagrams that have timed out.
+   *
+   *  Input:  r - The table.
+   *
+   *  Output: The number of partial datagrams discarded.
+   *
+   *  Notes:  <nbt_dsReasmAdd()> also does this, so it is only needed when
+   *          the receive loop is idle.  Calling it every few hundred
+   *          milliseconds is plenty.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_dsReasmStats *nbt_dsReasmGetStats( nbt_dsReasm      *r,
+                                       nbt_dsReasmStats *stats );
+  /* ------------------------------------------------------------------------ **
+   * Get the reassembly counters.
+   *
+   *  Input:  r     - The table.
+   *          stats - A pointer to the structure to be filled in.
+   *
+   *  Output: A pointer to the filled-in structure (same as <stats>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_DS_REASM_H */
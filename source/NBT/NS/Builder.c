@@ -0,0 +1,447 @@
+/* ========================================================================== **
+ *
+ *                                 Builder.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Build NBT Name Service messages in place.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Building a message with <nbt_nsSetHdr()> and friends means keeping
+ *  track of offsets and record counts by hand.  The functions in this
+ *  module do that bookkeeping.  A message is built into a cifs_Block,
+ *  one piece at a time, in the order in which the pieces appear on the
+ *  wire:
+ *
+ *    nbt_nsBuildInit()       - The header, with all counts set to zero.
+ *    nbt_nsBuildQuestion()   - The question record, if any.
+ *    nbt_nsBuildRR()         - Answer, Name Server, and Additional
+ *                              records, in that order.
+ *    nbt_nsBuildEnd()        - Set the block's <used> field.
+ *
+ *  The count fields in the header are updated as each record is added.
+ *  If the name of a resource record is the same as the question name,
+ *  a label string pointer (nbt_nsLSP) is written in place of the name,
+ *  as RFC 1002 does for registration, refresh, and release requests.
+ *
+ *  Responses are normally built from the request.  The question record
+ *  of an NBT request holds the same name, type, and class as the single
+ *  resource record of the response, so <nbt_nsBuildReply()> rewrites the
+ *  header of the request and turns its question record into the start
+ *  of a resource record.  <nbt_nsBuildRData()> then adds the TTL and the
+ *  RDATA.  Nothing is copied, apart from the RDATA.
+ *
+ *  The builder does no syntax checking on names.  Names passed in are
+ *  expected to be L2 encoded already, and names in requests should have
+ *  been checked by the parser.
+ *
+ * ========================================================================== **
+ */
+
+#include "Builder.h"          /* Module header.                     */
+#include "NBT/NS/Packet.h"    /* Header fields and flags.           */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static void AddCount( nbt_nsBuilder *bld, const uint8_t section )
+  /* ------------------------------------------------------------------------ **
+   * Bump the header count field for a section.
+   *
+   *  Input:  bld     - The builder context.
+   *          section - nbt_nsQUERYREC, nbt_nsANSREC, nbt_nsNSREC, or
+   *                    nbt_nsADDREC.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar   *bufr = bld->block->bufr;
+  int      offset;
+  uint16_t count;
+
+  switch( section )
+    {
+    case nbt_nsQUERYREC: offset = 4;  break;
+    case nbt_nsANSREC:   offset = 6;  break;
+    case nbt_nsNSREC:    offset = 8;  break;
+    default:             offset = 10; break;
+    }
+  count = nbt_GetShort( bufr, offset );
+  nbt_SetShort( bufr, offset, count + 1 );
+  bld->last = section;
+  } /* AddCount */
+
+
+static int Question( nbt_nsBuilder *bld, const int namelen, uint16_t qtype )
+  /* ------------------------------------------------------------------------ **
+   * Finish a question record once the name has been written.
+   *
+   *  Input:  bld     - The builder context.
+   *          namelen - Length of the question name, which is already in
+   *                    place at the end of the header.
+   *          qtype   - The question type.
+   *
+   *  Output: The number of bytes used so far.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *bufr = bld->block->bufr;
+  long   pos  = bld->pos + namelen;
+
+  nbt_SetShort( bufr, pos, qtype );
+  nbt_SetShort( bufr, pos + 2, nbt_nsQCLASS_IN );
+  bld->pos  = pos + 4;
+  bld->qlen = namelen;
+  AddCount( bld, nbt_nsQUERYREC );
+  return( (int)bld->pos );
+  } /* Question */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_nsBuildInit( nbt_nsBuilder  *bld,
+                     cifs_Block     *block,
+                     const uint16_t  tid,
+                     const uint16_t  flags )
+  /* ------------------------------------------------------------------------ **
+   * Start building a message.
+   *
+   *  Input:  bld   - The builder context to initialize.
+   *          block - The destination block.  The message is written at
+   *                  the start of the block's buffer.
+   *          tid   - The Transaction ID.
+   *          flags - NBT header flags, as for <nbt_nsSetHdr()>.
+   *
+   *  Output: On success, <nbt_nsHEADER_LEN>.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall - The block is too small to hold a
+   *                                 header.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int result;
+
+  result = nbt_nsSetHdr( block->bufr, block->size, flags, 0 );
+  if( result < 0 )
+    return( result );
+  nbt_nsSetTID( block->bufr, tid );
+
+  bld->block   = block;
+  bld->pos     = nbt_nsHEADER_LEN;
+  bld->qlen    = 0;
+  bld->last    = 0;
+  bld->pending = false;
+  return( result );
+  } /* nbt_nsBuildInit */
+
+
+int nbt_nsBuildQuestion( nbt_nsBuilder  *bld,
+                         const uchar    *name,
+                         const int       namelen,
+                         const uint16_t  qtype )
+  /* ------------------------------------------------------------------------ **
+   * Add the question record.
+   *
+   *  Input:  bld     - The builder context.
+   *          name    - The L2 encoded question name.
+   *          namelen - Length of <name>, including the final nul label.
+   *          qtype   - nbt_nsQTYPE_NB or nbt_nsQTYPE_NBSTAT.
+   *
+   *  Output: On success, the number of bytes used so far.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - A record has already been added.
+   *          cifs_errBufrTooSmall  - The record does not fit.
+   *
+   *  Notes:  The question class is always nbt_nsQCLASS_IN.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *bufr = bld->block->bufr;
+
+  if( (0 != bld->last) || bld->pending )
+    return( cifs_errInvalidPacket );
+  if( (bld->pos + namelen + 4) > bld->block->size )
+    return( cifs_errBufrTooSmall );
+
+  (void)memcpy( &bufr[bld->pos], name, namelen );
+  return( Question( bld, namelen, qtype ) );
+  } /* nbt_nsBuildQuestion */
+
+
+int nbt_nsBuildQuestionName( nbt_nsBuilder     *bld,
+                             const nbt_NameRec *namerec,
+                             const uint16_t     qtype )
+  /* ------------------------------------------------------------------------ **
+   * Encode a name directly into the question record.
+   *
+   *  Input:  bld     - The builder context.
+   *          namerec - The name to be encoded.  See <nbt_L2Encode()>.
+   *          qtype   - nbt_nsQTYPE_NB or nbt_nsQTYPE_NBSTAT.
+   *
+   *  Output: On success, the number of bytes used so far.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - A record has already been added.
+   *          cifs_errBufrTooSmall  - There may not be room for the record.
+   *
+   *  Notes:  As with <nbt_L2Encode()>, no syntax checking is done on the
+   *          name or the scope.  Room must be available for the longest
+   *          possible name (nbt_NAME_MAX bytes), since the length of the
+   *          encoded name is not known until it has been written.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( (0 != bld->last) || bld->pending )
+    return( cifs_errInvalidPacket );
+  if( (bld->pos + nbt_NAME_MAX + 4) > bld->block->size )
+    return( cifs_errBufrTooSmall );
+
+  return( Question( bld,
+                    nbt_L2Encode( &bld->block->bufr[bld->pos], namerec ),
+                    qtype ) );
+  } /* nbt_nsBuildQuestionName */
+
+
+int nbt_nsBuildRR( nbt_nsBuilder  *bld,
+                   const uint8_t   section,
+                   const uchar    *name,
+                   const int       namelen,
+                   const uint16_t  rrtype,
+                   const uint32_t  ttl,
+                   const uchar    *rdata,
+                   const int       rdata_len )
+  /* ------------------------------------------------------------------------ **
+   * Add a resource record.
+   *
+   *  Input:  bld       - The builder context.
+   *          section   - One of nbt_nsANSREC, nbt_nsNSREC, or nbt_nsADDREC.
+   *          name      - The L2 encoded RR name, or NULL.  If NULL, or if
+   *                      the name matches the question name, a label
+   *                      string pointer to the question name is written.
+   *          namelen   - Length of <name>.
+   *          rrtype    - The RR type (nbt_nsRRTYPE_NB, etc.).
+   *          ttl       - The TTL, in seconds.
+   *          rdata     - The RDATA, or NULL.  If NULL, <rdata_len> bytes
+   *                      are set aside, and the caller fills them in.
+   *          rdata_len - Length of the RDATA.
+   *
+   *  Output: On success, the offset of the RDATA within the block.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - Records were added out of order, or
+   *                                  <name> is NULL and there is no
+   *                                  question record.
+   *          cifs_errBufrTooSmall  - The record does not fit.
+   *
+   *  Notes:  The RR class is always nbt_nsRRCLASS_IN.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *bufr = bld->block->bufr;
+  long   pos  = bld->pos;
+  int    pfx;
+
+  if( bld->pending || (section <= bld->last)
+   || ((section != nbt_nsANSREC)
+    && (section != nbt_nsNSREC)
+    && (section != nbt_nsADDREC)) )
+    return( cifs_errInvalidPacket );
+
+  /* Use a label string pointer if the name matches the question. */
+  if( (NULL == name)
+   || ((namelen == bld->qlen)
+    && (0 == memcmp( name, &bufr[nbt_nsHEADER_LEN], namelen ))) )
+    {
+    if( 0 == bld->qlen )
+      return( cifs_errInvalidPacket );
+    pfx = 2;
+    }
+  else
+    pfx = namelen;
+
+  if( (pos + pfx + 10 + rdata_len) > bld->block->size )
+    return( cifs_errBufrTooSmall );
+
+  if( 2 == pfx )
+    nbt_SetShort( bufr, pos, nbt_nsLSP );
+  else
+    (void)memcpy( &bufr[pos], name, namelen );
+  pos += pfx;
+  nbt_SetShort( bufr, pos, rrtype );
+  nbt_SetShort( bufr, pos + 2, nbt_nsRRCLASS_IN );
+  bld->pos = pos + 4;
+  AddCount( bld, section );
+  bld->pending = true;
+
+  return( nbt_nsBuildRData( bld, ttl, rdata, rdata_len ) );
+  } /* nbt_nsBuildRR */
+
+
+int nbt_nsBuildReply( nbt_nsBuilder  *bld,
+                      cifs_Block     *request,
+                      const uint16_t  flags,
+                      const uint8_t   section )
+  /* ------------------------------------------------------------------------ **
+   * Turn a request into a response, in place.
+   *
+   *  Input:  bld     - The builder context to initialize.
+   *          request - The block holding the request.  The response will
+   *                    overwrite it.
+   *          flags   - NBT header flags for the response.
+   *          section - The section that will hold the response record.
+   *                    Normally nbt_nsANSREC.
+   *
+   *  Output: On success, the number of bytes used so far.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - The request has no question record,
+   *                                  or <section> is not valid.
+   *          Other errors may be passed back from <nbt_CheckL2Name()>.
+   *
+   *  Notes:  The Transaction ID is kept, the header is rewritten, and the
+   *          question name, type, and class become the RR name, type, and
+   *          class of the response.  Call <nbt_nsBuildRData()> next to
+   *          finish the record.
+   *
+   *          The rest of the request is left where it is until it is
+   *          overwritten, so the RDATA passed to <nbt_nsBuildRData()> may
+   *          point into the request.  For example, a registration
+   *          response can echo the RDATA of the request's additional
+   *          record.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *bufr = request->bufr;
+  int    len;
+
+  if( (request->used < nbt_nsHEADER_LEN)
+   || (0 == nbt_nsGetQDCOUNT( bufr ))
+   || ((section != nbt_nsANSREC)
+    && (section != nbt_nsNSREC)
+    && (section != nbt_nsADDREC)) )
+    return( cifs_errInvalidPacket );
+
+  len = nbt_CheckL2Name( bufr, nbt_nsHEADER_LEN, request->used );
+  if( len < 0 )
+    return( len );
+  if( (nbt_nsHEADER_LEN + len + 4) > request->used )
+    return( cifs_errInvalidPacket );
+
+  (void)nbt_nsSetHdr( bufr, request->size, flags, section );
+
+  bld->block   = request;
+  bld->pos     = nbt_nsHEADER_LEN + len + 4;
+  bld->qlen    = 0;
+  bld->last    = section;
+  bld->pending = true;
+  return( bld->pos );
+  } /* nbt_nsBuildReply */
+
+
+int nbt_nsBuildRData( nbt_nsBuilder  *bld,
+                      const uint32_t  ttl,
+                      const uchar    *rdata,
+                      const int       rdata_len )
+  /* ------------------------------------------------------------------------ **
+   * Finish the resource record started by <nbt_nsBuildReply()>.
+   *
+   *  Input:  bld       - The builder context.
+   *          ttl       - The TTL, in seconds.
+   *          rdata     - The RDATA, or NULL.  If NULL, <rdata_len> bytes
+   *                      are set aside, and the caller fills them in.
+   *          rdata_len - Length of the RDATA.
+   *
+   *  Output: On success, the offset of the RDATA within the block.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - There is no unfinished record.
+   *          cifs_errBufrTooSmall  - The RDATA does not fit.
+   *
+   *  Notes:  <rdata> may overlap the destination.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *bufr = bld->block->bufr;
+  long   pos  = bld->pos;
+
+  if( !bld->pending )
+    return( cifs_errInvalidPacket );
+  if( (pos + 6 + rdata_len) > bld->block->size )
+    return( cifs_errBufrTooSmall );
+
+  if( NULL != rdata )
+    (void)memmove( &bufr[pos + 6], rdata, rdata_len );
+  nbt_SetLong( bufr, pos, ttl );
+  nbt_SetShort( bufr, pos + 4, rdata_len );
+  bld->pos     = pos + 6 + rdata_len;
+  bld->pending = false;
+  return( (int)(pos + 6) );
+  } /* nbt_nsBuildRData */
+
+
+long nbt_nsBuildEnd( nbt_nsBuilder *bld )
+  /* ------------------------------------------------------------------------ **
+   * Finish a message.
+   *
+   *  Input:  bld - The builder context.
+   *
+   *  Output: On success, the length of the message, which is also stored
+   *          in the <used> field of the block.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - A resource record was left unfinished.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( bld->pending )
+    return( cifs_errInvalidPacket );
+  bld->block->used = bld->pos;
+  return( bld->pos );
+  } /* nbt_nsBuildEnd */
+
+/* ========================================================================== */
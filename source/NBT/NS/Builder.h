@@ -0,0 +1,294 @@
+#ifndef NBT_NS_BUILDER_H
+#define NBT_NS_BUILDER_H
+/* ========================================================================== **
+ *
+ *                                 Builder.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Build NBT Name Service messages in place.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Building a message with <nbt_nsSetHdr()> and friends means keeping
+ *  track of offsets and record counts by hand.  The functions in this
+ *  module do that bookkeeping.  A message is built into a cifs_Block,
+ *  one piece at a time, in the order in which the pieces appear on the
+ *  wire:
+ *
+ *    nbt_nsBuildInit()       - The header, with all counts set to zero.
+ *    nbt_nsBuildQuestion()   - The question record, if any.
+ *    nbt_nsBuildRR()         - Answer, Name Server, and Additional
+ *                              records, in that order.
+ *    nbt_nsBuildEnd()        - Set the block's <used> field.
+ *
+ *  The count fields in the header are updated as each record is added.
+ *  If the name of a resource record is the same as the question name,
+ *  a label string pointer (nbt_nsLSP) is written in place of the name,
+ *  as RFC 1002 does for registration, refresh, and release requests.
+ *
+ *  Responses are normally built from the request.  The question record
+ *  of an NBT request holds the same name, type, and class as the single
+ *  resource record of the response, so <nbt_nsBuildReply()> rewrites the
+ *  header of the request and turns its question record into the start
+ *  of a resource record.  <nbt_nsBuildRData()> then adds the TTL and the
+ *  RDATA.  Nothing is copied, apart from the RDATA.
+ *
+ *  The builder does no syntax checking on names.  Names passed in are
+ *  expected to be L2 encoded already, and names in requests should have
+ *  been checked by the parser.
+ *
+ * ========================================================================== **
+ */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/Names.h"        /* nbt_NameRec.                       */
+#include "cifs_block.h"       /* cifs_Block.                        */
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_nsBuilder - Message builder context.
+ *
+ *                  block   - The block into which the message is being
+ *                            written.
+ *                  pos     - Offset of the next byte to be written.
+ *                  qlen    - Length of the question name, or 0 if there
+ *                            is no question record.
+ *                  last    - The last section written to (an nbt_nsANSREC,
+ *                            etc. value), or 0.
+ *                  pending - True if a resource record is waiting for
+ *                            its TTL and RDATA.
+ */
+
+typedef struct
+  {
+  cifs_Block *block;
+  long        pos;
+  int         qlen;
+  uint8_t     last;
+  bool        pending;
+  } nbt_nsBuilder;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_nsBuildInit( nbt_nsBuilder  *bld,
+                     cifs_Block     *block,
+                     const uint16_t  tid,
+                     const uint16_t  flags );
+  /* ------------------------------------------------------------------------ **
+   * Start building a message.
+   *
+   *  Input:  bld   - The builder context to initialize.
+   *          block - The destination block.  The message is written at
+   *                  the start of the block's buffer.
+   *          tid   - The Transaction ID.
+   *          flags - NBT header flags, as for <nbt_nsSetHdr()>.
+   *
+   *  Output: On success, <nbt_nsHEADER_LEN>.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall - The block is too small to hold a
+   *                                 header.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsBuildQuestion( nbt_nsBuilder  *bld,
+                         const uchar    *name,
+                         const int       namelen,
+                         const uint16_t  qtype );
+  /* ------------------------------------------------------------------------ **
+   * Add the question record.
+   *
+   *  Input:  bld     - The builder context.
+   *          name    - The L2 encoded question name.
+   *          namelen - Length of <name>, including the final nul label.
+   *          qtype   - nbt_nsQTYPE_NB or nbt_nsQTYPE_NBSTAT.
+   *
+   *  Output: On success, the number of bytes used so far.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - A record has already been added.
+   *          cifs_errBufrTooSmall  - The record does not fit.
+   *
+   *  Notes:  The question class is always nbt_nsQCLASS_IN.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsBuildQuestionName( nbt_nsBuilder     *bld,
+                             const nbt_NameRec *namerec,
+                             const uint16_t     qtype );
+  /* ------------------------------------------------------------------------ **
+   * Encode a name directly into the question record.
+   *
+   *  Input:  bld     - The builder context.
+   *          namerec - The name to be encoded.  See <nbt_L2Encode()>.
+   *          qtype   - nbt_nsQTYPE_NB or nbt_nsQTYPE_NBSTAT.
+   *
+   *  Output: On success, the number of bytes used so far.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - A record has already been added.
+   *          cifs_errBufrTooSmall  - There may not be room for the record.
+   *
+   *  Notes:  As with <nbt_L2Encode()>, no syntax checking is done on the
+   *          name or the scope.  Room must be available for the longest
+   *          possible name (nbt_NAME_MAX bytes), since the length of the
+   *          encoded name is not known until it has been written.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsBuildRR( nbt_nsBuilder  *bld,
+                   const uint8_t   section,
+                   const uchar    *name,
+                   const int       namelen,
+                   const uint16_t  rrtype,
+                   const uint32_t  ttl,
+                   const uchar    *rdata,
+                   const int       rdata_len );
+  /* ------------------------------------------------------------------------ **
+   * Add a resource record.
+   *
+   *  Input:  bld       - The builder context.
+   *          section   - One of nbt_nsANSREC, nbt_nsNSREC, or nbt_nsADDREC.
+   *          name      - The L2 encoded RR name, or NULL.  If NULL, or if
+   *                      the name matches the question name, a label
+   *                      string pointer to the question name is written.
+   *          namelen   - Length of <name>.
+   *          rrtype    - The RR type (nbt_nsRRTYPE_NB, etc.).
+   *          ttl       - The TTL, in seconds.
+   *          rdata     - The RDATA, or NULL.  If NULL, <rdata_len> bytes
+   *                      are set aside, and the caller fills them in.
+   *          rdata_len - Length of the RDATA.
+   *
+   *  Output: On success, the offset of the RDATA within the block.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - Records were added out of order, or
+   *                                  <name> is NULL and there is no
+   *                                  question record.
+   *          cifs_errBufrTooSmall  - The record does not fit.
+   *
+   *  Notes:  The RR class is always nbt_nsRRCLASS_IN.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsBuildReply( nbt_nsBuilder  *bld,
+                      cifs_Block     *request,
+                      const uint16_t  flags,
+                      const uint8_t   section );
+  /* ------------------------------------------------------------------------ **
+   * Turn a request into a response, in place.
+   *
+   *  Input:  bld     - The builder context to initialize.
+   *          request - The block holding the request.  The response will
+   *                    overwrite it.
+   *          flags   - NBT header flags for the response.
+   *          section - The section that will hold the response record.
+   *                    Normally nbt_nsANSREC.
+   *
+   *  Output: On success, the number of bytes used so far.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - The request has no question record,
+   *                                  or <section> is not valid.
+   *          Other errors may be passed back from <nbt_CheckL2Name()>.
+   *
+   *  Notes:  The Transaction ID is kept, the header is rewritten, and the
+   *          question name, type, and class become the RR name, type, and
+   *          class of the response.  Call <nbt_nsBuildRData()> next to
+   *          finish the record.
+   *
+   *          The rest of the request is left where it is until it is
+   *          overwritten, so the RDATA passed to <nbt_nsBuildRData()> may
+   *          point into the request.  For example, a registration
+   *          response can echo the RDATA of the request's additional
+   *          record.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsBuildRData( nbt_nsBuilder  *bld,
+                      const uint32_t  ttl,
+                      const uchar    *rdata,
+                      const int       rdata_len );
+  /* ------------------------------------------------------------------------ **
+   * Finish the resource record started by <nbt_nsBuildReply()>.
+   *
+   *  Input:  bld       - The builder context.
+   *          ttl       - The TTL, in seconds.
+   *          rdata     - The RDATA, or NULL.  If NULL, <rdata_len> bytes
+   *                      are set aside, and the caller fills them in.
+   *          rdata_len - Length of the RDATA.
+   *
+   *  Output: On success, the offset of the RDATA within the block.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - There is no unfinished record.
+   *          cifs_errBufrTooSmall  - The RDATA does not fit.
+   *
+   *  Notes:  <rdata> may overlap the destination.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+long nbt_nsBuildEnd( nbt_nsBuilder *bld );
+  /* ------------------------------------------------------------------------ **
+   * Finish a message.
+   *
+   *  Input:  bld - The builder context.
+   *
+   *  Output: On success, the length of the message, which is also stored
+   *          in the <used> field of the block.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - A resource record was left unfinished.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_NS_BUILDER_H */
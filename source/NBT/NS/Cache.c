@@ -0,0 +1,640 @@
+/* ========================================================================== **
+ *
+ *                                  Cache.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NetBIOS name cache for the NBT Name Service.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Name query replies carry a TTL, which says how long the answer may be
+ *  trusted.  This module keeps positive answers until their TTL runs
+ *  out, so that repeated lookups of the same name don't go back to the
+ *  wire.  Negative answers are kept too, but only for a short time set
+ *  by the caller, so that a name that doesn't exist isn't queried over
+ *  and over either.
+ *
+ *  Entries are keyed on the L2 encoded name, exactly as it appears in
+ *  the message (the QR_name or RR_name bytes found by nbt_nsParseMsg()).
+ *  That covers the NetBIOS name, the padding, the suffix, and the scope.
+ *  Names are compared byte-for-byte, so the scope is case-sensitive.
+ *
+ *  Like the hash cache in Auth/HashCache.c, the cache lives entirely
+ *  within a block of memory supplied by the caller, so the memory budget
+ *  is fixed when the cache is created.  The table is divided into sets
+ *  of NC_WAYS entries, and a name always maps to the same set.  When a
+ *  set is full, an expired entry is reused if there is one.  Otherwise
+ *  the entry that would expire soonest is evicted.  Entries are a fixed
+ *  size, so names with very long scopes and answers with very many
+ *  addresses (large groups) are simply not cached.
+ *
+ *  Lookups take no locks and write nothing to shared memory, so any
+ *  number of threads can read the cache at once without contending.
+ *  Each entry carries a sequence count that a writer makes odd while
+ *  it is changing the entry.  A reader copies the entry out and then
+ *  checks that the count has not changed; if it has, the copy is thrown
+ *  away and the read is retried.  Writers (inserts and removals) are
+ *  serialized by a spin lock.  This scheme depends upon cifs_ATOMICS.
+ *  Without it, the cache is not thread-safe.
+ *
+ * ========================================================================== **
+ */
+
+#include <time.h>             /* For clock_gettime(2).  */
+
+#include "Cache.h"            /* Module header.         */
+#include "NBT/NS/Packet.h"    /* RCODE values.          */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  NC_WAYS   - The number of entries in each set.
+ *  NC_CLOCK  - The clock used for expiry times.  The coarse clock is
+ *              plenty for TTLs measured in seconds, and is cheaper to
+ *              read where it exists.
+ */
+
+#define NC_WAYS 4
+
+#if defined( CLOCK_MONOTONIC_COARSE )
+#define NC_CLOCK CLOCK_MONOTONIC_COARSE
+#else
+#define NC_CLOCK CLOCK_MONOTONIC
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Macros:
+ *
+ *  AtomicLoad( P ) - Read <*P> without tearing.
+ *  Lock( NC )      - Take the writer lock.
+ *  Unlock( NC )    - Release the writer lock.
+ *  Pause()         - Be polite while spinning.
+ *
+ *  Without cifs_ATOMICS these reduce to plain accesses and no-ops.
+ */
+
+#if defined( cifs_ATOMICS )
+#define AtomicLoad( P ) __atomic_load_n( (P), __ATOMIC_RELAXED )
+#define Lock( NC ) \
+  while( __atomic_exchange_n( &(NC)->lock, 1, __ATOMIC_ACQUIRE ) ) Pause()
+#define Unlock( NC ) __atomic_store_n( &(NC)->lock, 0, __ATOMIC_RELEASE )
+#if defined( __i386__ ) || defined( __x86_64__ )
+#define Pause() __builtin_ia32_pause()
+#else
+#define Pause() ((void)0)
+#endif
+#else
+#define AtomicLoad( P ) (*(P))
+#define Lock( NC )      ((void)0)
+#define Unlock( NC )    ((void)0)
+#define Pause()         ((void)0)
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static uint32_t Now( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a clock in seconds.
+   *
+   *  Input:  none.
+   *  Output: Seconds since some arbitrary point.
+   *
+   *  Notes:  The clock starts at one rather than zero so that an expiry
+   *          time of zero is always in the past.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( NC_CLOCK, &ts );
+  return( (uint32_t)ts.tv_sec + 1 );
+  } /* Now */
+
+
+static uint32_t Hash( const uchar *name, const int namelen )
+  /* ------------------------------------------------------------------------ **
+   * Hash an L2 encoded name.
+   *
+   *  Input:  name    - The name.
+   *          namelen - Its length, in bytes.
+   *
+   *  Output: A non-zero 32-bit hash (FNV-1a).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t h = 2166136261u;
+  int      i;
+
+  for( i = 0; i < namelen; i++ )
+    h = (h ^ name[i]) * 16777619u;
+  return( h ? h : 1 );
+  } /* Hash */
+
+
+static nbt_nsCacheEntry *SetOf( const nbt_nsCache *nc, const uint32_t hash )
+  /* ------------------------------------------------------------------------ **
+   * Find the set to which a hash belongs.
+   *
+   *  Input:  nc    - The cache.
+   *          hash  - The hash of the name.
+   *
+   *  Output: A pointer to the first entry in the set.
+   *
+   *  Notes:  The number of sets is a power of two.  FNV mixes the high
+   *          bits best, so they are folded into the low bits first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t sets = nc->slots / NC_WAYS;
+
+  return( &nc->table[((hash ^ (hash >> 16)) & (sets - 1)) * NC_WAYS] );
+  } /* SetOf */
+
+
+static void ReadEntry( const nbt_nsCacheEntry *e, nbt_nsCacheEntry *copy )
+  /* ------------------------------------------------------------------------ **
+   * Take a consistent copy of an entry.
+   *
+   *  Input:  e     - The entry.
+   *          copy  - Where to put the copy.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This is the reader side of the sequence lock.  The copy is
+   *          retried until it was made while no writer was active.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+#if defined( cifs_ATOMICS )
+  uint32_t seq;
+
+  for(;;)
+    {
+    seq = __atomic_load_n( &e->seq, __ATOMIC_ACQUIRE );
+    if( seq & 1 )
+      {
+      Pause();
+      continue;
+      }
+    *copy = *e;
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    if( seq == __atomic_load_n( &e->seq, __ATOMIC_RELAXED ) )
+      return;
+    }
+#else
+  *copy = *e;
+#endif
+  } /* ReadEntry */
+
+
+static void BeginWrite( nbt_nsCacheEntry *e )
+  /* ------------------------------------------------------------------------ **
+   * Mark an entry as being written.
+   *
+   *  Input:  e - The entry.  The writer lock must be held.
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+#if defined( cifs_ATOMICS )
+  __atomic_store_n( &e->seq, e->seq + 1, __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_RELEASE );
+#else
+  e->seq++;
+#endif
+  } /* BeginWrite */
+
+
+static void EndWrite( nbt_nsCacheEntry *e )
+  /* ------------------------------------------------------------------------ **
+   * Mark an entry as stable again.
+   *
+   *  Input:  e - The entry.  The writer lock must be held.
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+#if defined( cifs_ATOMICS )
+  __atomic_store_n( &e->seq, e->seq + 1, __ATOMIC_RELEASE );
+#else
+  e->seq++;
+#endif
+  } /* EndWrite */
+
+
+static nbt_nsCacheEntry *Find( nbt_nsCacheEntry *set,
+                               const uint32_t    hash,
+                               const uchar      *name,
+                               const int         namelen )
+  /* ------------------------------------------------------------------------ **
+   * Search a set for a name.
+   *
+   *  Input:  set     - The first entry of the set.
+   *          hash    - Hash of the name.
+   *          name    - The name.
+   *          namelen - Its length.
+   *
+   *  Output: A pointer to the matching entry, or NULL.
+   *
+   *  Notes:  Writers only.  The writer lock must be held.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  for( i = 0; i < NC_WAYS; i++ )
+    {
+    if( (hash == set[i].hash)
+     && (namelen == set[i].namelen)
+     && (0 == memcmp( name, set[i].name, namelen )) )
+      return( &set[i] );
+    }
+  return( NULL );
+  } /* Find */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsCache *nbt_nsCacheInit( nbt_nsCache    *nc,
+                              void           *mem,
+                              const size_t    memsize,
+                              const uint32_t  negttl )
+  /* ------------------------------------------------------------------------ **
+   * Initialize a name cache within a caller-supplied block of memory.
+   *
+   *  Input:  nc      - A pointer to the cache header to be initialized.
+   *          mem     - A pointer to the memory that will hold the table.
+   *                    It must be suitably aligned for a uint32_t.
+   *          memsize - The size, in bytes, of <mem>.  This is the memory
+   *                    budget for the cache.
+   *          negttl  - The number of seconds for which negative answers
+   *                    are kept.
+   *
+   *  Output: A pointer to the initialized cache (same as <nc>), or NULL
+   *          if <memsize> is too small to hold even one set of entries.
+   *
+   *  Notes:  The number of sets is rounded down to a power of two, so
+   *          some of <mem> may go unused.  <nc>->slots gives the number
+   *          of entries actually available.
+   *
+   *          The memory is cleared.  The cache must not be in use by any
+   *          other thread while it is being initialized.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t sets;
+
+  if( NULL == nc || NULL == mem )
+    return( NULL );
+
+  sets = (uint32_t)(memsize / (NC_WAYS * sizeof( nbt_nsCacheEntry )));
+  if( sets < 1 )
+    return( NULL );
+  while( sets & (sets - 1) )
+    sets &= (sets - 1);
+
+  (void)memset( mem, 0, sets * NC_WAYS * sizeof( nbt_nsCacheEntry ) );
+  (void)memset( nc, 0, sizeof( nbt_nsCache ) );
+  nc->table  = (nbt_nsCacheEntry *)mem;
+  nc->slots  = sets * NC_WAYS;
+  nc->negttl = negttl;
+  return( nc );
+  } /* nbt_nsCacheInit */
+
+
+nbt_nsCacheResult nbt_nsCacheLookup( nbt_nsCache        *nc,
+                                     const uchar        *name,
+                                     const int           namelen,
+                                     nbt_nsCacheAnswer  *ans )
+  /* ------------------------------------------------------------------------ **
+   * Look up a name.
+   *
+   *  Input:  nc      - A pointer to the cache.
+   *          name    - The L2 encoded name.
+   *          namelen - The length, in bytes, of <name>.
+   *          ans     - If not NULL, a pointer to a structure that will
+   *                    receive the cached answer.
+   *
+   *  Output: nbt_nsCACHE_POSITIVE if a positive answer was found, in which
+   *          case <ans>->rdata holds the cached RDATA.
+   *          nbt_nsCACHE_NEGATIVE if a negative answer was found, in which
+   *          case <ans>->rcode holds the cached RCODE.
+   *          nbt_nsCACHE_MISS if the name is not cached, or the cached
+   *          answer has expired.
+   *
+   *  Notes:  In all cases except a miss, <ans>->ttl is set to the number
+   *          of seconds before the entry expires.  Pass that along in
+   *          any reply built from the cached answer.
+   *
+   *          This function is lock-free and may be called by any number
+   *          of threads at once, even while another thread is writing.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t          hash;
+  uint32_t          now;
+  nbt_nsCacheEntry *set;
+  nbt_nsCacheEntry  copy;
+  int               i;
+
+  if( (NULL == nc) || (NULL == name)
+   || (namelen < 1) || (namelen > nbt_nsCACHE_NAMEMAX) )
+    return( nbt_nsCACHE_MISS );
+
+  hash = Hash( name, namelen );
+  set  = SetOf( nc, hash );
+  for( i = 0; i < NC_WAYS; i++ )
+    {
+    if( hash != AtomicLoad( &set[i].hash ) )
+      continue;
+    ReadEntry( &set[i], &copy );
+    if( (hash != copy.hash)
+     || (namelen != copy.namelen)
+     || (0 != memcmp( name, copy.name, namelen )) )
+      continue;
+
+    now = Now();
+    if( (int32_t)(copy.expires - now) <= 0 )
+      return( nbt_nsCACHE_MISS );
+    if( NULL != ans )
+      {
+      ans->ttl       = copy.expires - now;
+      ans->rcode     = copy.rcode;
+      ans->rdata_len = copy.rdata_len;
+      (void)memcpy( ans->rdata, copy.rdata, copy.rdata_len );
+      }
+    return( copy.negative ? nbt_nsCACHE_NEGATIVE : nbt_nsCACHE_POSITIVE );
+    }
+  return( nbt_nsCACHE_MISS );
+  } /* nbt_nsCacheLookup */
+
+
+bool nbt_nsCacheInsert( nbt_nsCache    *nc,
+                        const uchar    *name,
+                        const int       namelen,
+                        const uint16_t  rcode,
+                        const uint32_t  ttl,
+                        const uchar    *rdata,
+                        const int       rdata_len )
+  /* ------------------------------------------------------------------------ **
+   * Add an answer to the cache.
+   *
+   *  Input:  nc        - A pointer to the cache.
+   *          name      - The L2 encoded name.
+   *          namelen   - The length, in bytes, of <name>.
+   *          rcode     - The RCODE of the answer.  Zero for a positive
+   *                      answer, non-zero for a negative answer.
+   *          ttl       - For a positive answer, the TTL from the answer
+   *                      record, in seconds.  Ignored for a negative
+   *                      answer, which is kept for the cache's <negttl>.
+   *          rdata     - The RDATA of a positive answer.  Ignored for a
+   *                      negative answer.
+   *          rdata_len - The length, in bytes, of <rdata>.
+   *
+   *  Output: true if the answer was cached, else false.  Answers are not
+   *          cached if the name is longer than nbt_nsCACHE_NAMEMAX, the
+   *          RDATA is longer than nbt_nsCACHE_RDMAX, or the TTL is zero.
+   *
+   *  Notes:  If the name is already cached, the entry is replaced.
+   *          Otherwise an empty or expired entry in the name's set is
+   *          used, or the entry that would expire soonest is evicted.
+   *
+   *          A TTL of zero means "infinite" in some NBT messages.  For
+   *          the purposes of this cache it means "do not cache".  TTLs
+   *          longer than nbt_nsCACHE_MAXTTL are cut down to that value.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t          hash;
+  uint32_t          now;
+  uint32_t          life;
+  nbt_nsCacheEntry *set;
+  nbt_nsCacheEntry *e;
+  int               i;
+
+  if( (NULL == nc) || (NULL == name)
+   || (namelen < 1) || (namelen > nbt_nsCACHE_NAMEMAX) )
+    return( false );
+  if( 0 == rcode )
+    {
+    if( (0 == ttl) || (rdata_len < 0) || (rdata_len > nbt_nsCACHE_RDMAX)
+     || ((rdata_len > 0) && (NULL == rdata)) )
+      return( false );
+    life = (ttl > nbt_nsCACHE_MAXTTL) ? nbt_nsCACHE_MAXTTL : ttl;
+    }
+  else
+    {
+    if( 0 == nc->negttl )
+      return( false );
+    life = nc->negttl;
+    }
+
+  hash = Hash( name, namelen );
+  set  = SetOf( nc, hash );
+  now  = Now();
+
+  Lock( nc );
+  e = Find( set, hash, name, namelen );
+  if( NULL == e )
+    {
+    /* Choose a victim: empty, then expired, then soonest to expire. */
+    e = set;
+    for( i = 0; i < NC_WAYS; i++ )
+      {
+      if( 0 == set[i].hash )
+        {
+        e = &set[i];
+        nc->count++;
+        break;
+        }
+      if( (int32_t)(set[i].expires - e->expires) < 0 )
+        e = &set[i];
+      }
+    if( 0 != e->hash )
+      {
+      if( (int32_t)(e->expires - now) > 0 )
+        nc->evictions++;
+      else
+        nc->expired++;
+      }
+    }
+
+  BeginWrite( e );
+  e->hash     = hash;
+  e->expires  = now + life;
+  e->namelen  = (uint8_t)namelen;
+  e->negative = (0 != rcode);
+  e->rcode    = rcode;
+  (void)memcpy( e->name, name, namelen );
+  if( 0 == rcode )
+    {
+    e->rdata_len = (uint16_t)rdata_len;
+    (void)memcpy( e->rdata, rdata, rdata_len );
+    }
+  else
+    e->rdata_len = 0;
+  EndWrite( e );
+
+  nc->inserts++;
+  Unlock( nc );
+  return( true );
+  } /* nbt_nsCacheInsert */
+
+
+bool nbt_nsCacheInsertMsg( nbt_nsCache *nc, const nbt_nsMsgBlock *msg )
+  /* ------------------------------------------------------------------------ **
+   * Add the answer from a parsed name query reply to the cache.
+   *
+   *  Input:  nc  - A pointer to the cache.
+   *          msg - A message that has been parsed by <nbt_nsParseMsg()>.
+   *
+   *  Output: true if the answer was cached, else false.
+   *
+   *  Notes:  Only positive and negative name query replies are cached.
+   *          Anything else (eg., a node status reply or a WACK) is
+   *          ignored.  A positive reply with an RCODE of zero is stored
+   *          with its TTL and RDATA.  A negative reply is stored with its
+   *          RCODE.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint16_t rcode;
+
+  if( NULL == msg || NULL == msg->RR_name )
+    return( false );
+
+  rcode = msg->flags & nbt_nsRCODE_MASK;
+  switch( msg->type )
+    {
+    case nbt_nsNAME_QUERY_REPLY_POS:
+      if( 0 != rcode )
+        return( false );
+      return( nbt_nsCacheInsert( nc, msg->RR_name, msg->RR_name_len, 0,
+                                 msg->ttl, msg->rdata, msg->rdata_len ) );
+    case nbt_nsNAME_QUERY_REPLY_NEG:
+      return( nbt_nsCacheInsert( nc, msg->RR_name, msg->RR_name_len,
+                                 rcode ? rcode : nbt_nsRCODE_NAM_ERR,
+                                 0, NULL, 0 ) );
+    default:
+      break;
+    }
+  return( false );
+  } /* nbt_nsCacheInsertMsg */
+
+
+bool nbt_nsCacheRemove( nbt_nsCache *nc,
+                        const uchar *name,
+                        const int    namelen )
+  /* ------------------------------------------------------------------------ **
+   * Remove a name from the cache.
+   *
+   *  Input:  nc      - A pointer to the cache.
+   *          name    - The L2 encoded name.
+   *          namelen - The length, in bytes, of <name>.
+   *
+   *  Output: true if the name was found and removed, else false.
+   *
+   *  Notes:  Use this when a cached answer is known to be wrong (eg., a
+   *          session request to the cached address was refused).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t          hash;
+  nbt_nsCacheEntry *e;
+
+  if( (NULL == nc) || (NULL == name)
+   || (namelen < 1) || (namelen > nbt_nsCACHE_NAMEMAX) )
+    return( false );
+
+  hash = Hash( name, namelen );
+  Lock( nc );
+  e = Find( SetOf( nc, hash ), hash, name, namelen );
+  if( NULL != e )
+    {
+    BeginWrite( e );
+    e->hash    = 0;
+    e->expires = 0;
+    EndWrite( e );
+    nc->count--;
+    }
+  Unlock( nc );
+  return( NULL != e );
+  } /* nbt_nsCacheRemove */
+
+
+nbt_nsCacheStats *nbt_nsCacheGetStats( nbt_nsCache      *nc,
+                                       nbt_nsCacheStats *stats )
+  /* ------------------------------------------------------------------------ **
+   * Return the cache counters.
+   *
+   *  Input:  nc    - A pointer to the cache.
+   *          stats - A pointer to a structure to receive the counters.
+   *
+   *  Output: A pointer to the filled-in statistics (same as <stats>).
+   *
+   *  Notes:  Lookups are not counted, since counting them would mean
+   *          writing to shared memory on every read.  Count hits and
+   *          misses in the caller if they are needed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Lock( nc );
+  stats->inserts   = nc->inserts;
+  stats->evictions = nc->evictions;
+  stats->expired   = nc->expired;
+  stats->entries   = nc->count;
+  stats->slots     = nc->slots;
+  Unlock( nc );
+  return( stats );
+  } /* nbt_nsCacheGetStats */
+
+/* ========================================================================== */
@@ -0,0 +1,321 @@
+#ifndef NBT_NS_CACHE_H
+#define NBT_NS_CACHE_H
+/* ========================================================================== **
+ *
+ *                                  Cache.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NetBIOS name cache for the NBT Name Service.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Name query replies carry a TTL, which says how long the answer may be
+ *  trusted.  This module keeps positive answers until their TTL runs
+ *  out, so that repeated lookups of the same name don't go back to the
+ *  wire.  Negative answers are kept too, but only for a short time set
+ *  by the caller, so that a name that doesn't exist isn't queried over
+ *  and over either.
+ *
+ *  Entries are keyed on the L2 encoded name, exactly as it appears in
+ *  the message (the QR_name or RR_name bytes found by nbt_nsParseMsg()).
+ *  That covers the NetBIOS name, the padding, the suffix, and the scope.
+ *  Names are compared byte-for-byte, so the scope is case-sensitive.
+ *
+ *  Like the hash cache in Auth/HashCache.c, the cache lives entirely
+ *  within a block of memory supplied by the caller, so the memory budget
+ *  is fixed when the cache is created.  The table is divided into sets
+ *  of NC_WAYS entries, and a name always maps to the same set.  When a
+ *  set is full, an expired entry is reused if there is one.  Otherwise
+ *  the entry that would expire soonest is evicted.  Entries are a fixed
+ *  size, so names with very long scopes and answers with very many
+ *  addresses (large groups) are simply not cached.
+ *
+ *  Lookups take no locks and write nothing to shared memory, so any
+ *  number of threads can read the cache at once without contending.
+ *  Each entry carries a sequence count that a writer makes odd while
+ *  it is changing the entry.  A reader copies the entry out and then
+ *  checks that the count has not changed; if it has, the copy is thrown
+ *  away and the read is retried.  Writers (inserts and removals) are
+ *  serialized by a spin lock.  This scheme depends upon cifs_ATOMICS.
+ *  Without it, the cache is not thread-safe.
+ *
+ * ========================================================================== **
+ */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/NS/Message.h"   /* nbt_nsMsgBlock.                    */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_nsCACHE_NAMEMAX - The longest L2 encoded name that will be cached.
+ *                        An unscoped name is 34 bytes, so this leaves
+ *                        room for a scope of about 60 bytes.
+ *  nbt_nsCACHE_RDMAX   - The most RDATA that will be cached.  Enough for
+ *                        sixteen NB_FLAGS/address pairs.
+ *  nbt_nsCACHE_MAXTTL  - The longest, in seconds, that a positive answer
+ *                        will be kept, regardless of its TTL.  One day.
+ */
+
+#define nbt_nsCACHE_NAMEMAX 96
+#define nbt_nsCACHE_RDMAX   96
+#define nbt_nsCACHE_MAXTTL  86400
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_nsCacheResult - The outcome of a lookup.
+ *
+ *  nbt_nsCacheEntry  - One cache entry.  An entry with a <hash> of zero
+ *                      is empty.  <seq> is odd while the entry is being
+ *                      written.
+ *
+ *  nbt_nsCache       - The cache header.  Treat the fields as read-only.
+ *
+ *  nbt_nsCacheAnswer - A cached answer, as returned by a lookup.
+ *
+ *  nbt_nsCacheStats  - Cache counters, as returned by
+ *                      <nbt_nsCacheGetStats()>.
+ */
+
+typedef enum
+  {
+  nbt_nsCACHE_MISS = 0,
+  nbt_nsCACHE_POSITIVE,
+  nbt_nsCACHE_NEGATIVE
+  } nbt_nsCacheResult;
+
+typedef struct
+  {
+  uint32_t seq;                         /* Sequence count.            */
+  uint32_t hash;                        /* Hash of the name.          */
+  uint32_t expires;                     /* Expiry time, in seconds.   */
+  uint16_t rcode;                       /* RCODE of the answer.       */
+  uint16_t rdata_len;                   /* Bytes used in <rdata>.     */
+  uint8_t  namelen;                     /* Bytes used in <name>.      */
+  bool     negative;                    /* Negative answer.           */
+  uchar    name[nbt_nsCACHE_NAMEMAX];   /* L2 encoded name.           */
+  uchar    rdata[nbt_nsCACHE_RDMAX];    /* RDATA of a positive answer. */
+  } nbt_nsCacheEntry;
+
+typedef struct
+  {
+  nbt_nsCacheEntry *table;
+  uint32_t          slots;
+  uint32_t          negttl;
+  uint32_t          lock;
+  uint32_t          count;
+  uint32_t          inserts;
+  uint32_t          evictions;
+  uint32_t          expired;
+  } nbt_nsCache;
+
+typedef struct
+  {
+  uint32_t ttl;                         /* Seconds left before expiry. */
+  uint16_t rcode;                       /* RCODE of a negative answer. */
+  uint16_t rdata_len;                   /* Bytes used in <rdata>.      */
+  uchar    rdata[nbt_nsCACHE_RDMAX];    /* RDATA of a positive answer. */
+  } nbt_nsCacheAnswer;
+
+typedef struct
+  {
+  uint32_t inserts;       /* Entries added or replaced.                 */
+  uint32_t evictions;     /* Live entries pushed out to make room.      */
+  uint32_t expired;       /* Expired entries reused.                    */
+  uint32_t entries;       /* Entries in use (including expired ones).   */
+  uint32_t slots;         /* Total number of entries in the table.      */
+  } nbt_nsCacheStats;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsCache *nbt_nsCacheInit( nbt_nsCache    *nc,
+                              void           *mem,
+                              const size_t    memsize,
+                              const uint32_t  negttl );
+  /* ------------------------------------------------------------------------ **
+   * Initialize a name cache within a caller-supplied block of memory.
+   *
+   *  Input:  nc      - A pointer to the cache header to be initialized.
+   *          mem     - A pointer to the memory that will hold the table.
+   *                    It must be suitably aligned for a uint32_t.
+   *          memsize - The size, in bytes, of <mem>.  This is the memory
+   *                    budget for the cache.
+   *          negttl  - The number of seconds for which negative answers
+   *                    are kept.
+   *
+   *  Output: A pointer to the initialized cache (same as <nc>), or NULL
+   *          if <memsize> is too small to hold even one set of entries.
+   *
+   *  Notes:  The number of sets is rounded down to a power of two, so
+   *          some of <mem> may go unused.  <nc>->slots gives the number
+   *          of entries actually available.
+   *
+   *          The memory is cleared.  The cache must not be in use by any
+   *          other thread while it is being initialized.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_nsCacheResult nbt_nsCacheLookup( nbt_nsCache        *nc,
+                                     const uchar        *name,
+                                     const int           namelen,
+                                     nbt_nsCacheAnswer  *ans );
+  /* ------------------------------------------------------------------------ **
+   * Look up a name.
+   *
+   *  Input:  nc      - A pointer to the cache.
+   *          name    - The L2 encoded name.
+   *          namelen - The length, in bytes, of <name>.
+   *          ans     - If not NULL, a pointer to a structure that will
+   *                    receive the cached answer.
+   *
+   *  Output: nbt_nsCACHE_POSITIVE if a positive answer was found, in which
+   *          case <ans>->rdata holds the cached RDATA.
+   *          nbt_nsCACHE_NEGATIVE if a negative answer was found, in which
+   *          case <ans>->rcode holds the cached RCODE.
+   *          nbt_nsCACHE_MISS if the name is not cached, or the cached
+   *          answer has expired.
+   *
+   *  Notes:  In all cases except a miss, <ans>->ttl is set to the number
+   *          of seconds before the entry expires.  Pass that along in
+   *          any reply built from the cached answer.
+   *
+   *          This function is lock-free and may be called by any number
+   *          of threads at once, even while another thread is writing.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool nbt_nsCacheInsert( nbt_nsCache    *nc,
+                        const uchar    *name,
+                        const int       namelen,
+                        const uint16_t  rcode,
+                        const uint32_t  ttl,
+                        const uchar    *rdata,
+                        const int       rdata_len );
+  /* ------------------------------------------------------------------------ **
+   * Add an answer to the cache.
+   *
+   *  Input:  nc        - A pointer to the cache.
+   *          name      - The L2 encoded name.
+   *          namelen   - The length, in bytes, of <name>.
+   *          rcode     - The RCODE of the answer.  Zero for a positive
+   *                      answer, non-zero for a negative answer.
+   *          ttl       - For a positive answer, the TTL from the answer
+   *                      record, in seconds.  Ignored for a negative
+   *                      answer, which is kept for the cache's <negttl>.
+   *          rdata     - The RDATA of a positive answer.  Ignored for a
+   *                      negative answer.
+   *          rdata_len - The length, in bytes, of <rdata>.
+   *
+   *  Output: true if the answer was cached, else false.  Answers are not
+   *          cached if the name is longer than nbt_nsCACHE_NAMEMAX, the
+   *          RDATA is longer than nbt_nsCACHE_RDMAX, or the TTL is zero.
+   *
+   *  Notes:  If the name is already cached, the entry is replaced.
+   *          Otherwise an empty or expired entry in the name's set is
+   *          used, or the entry that would expire soonest is evicted.
+   *
+   *          A TTL of zero means "infinite" in some NBT messages.  For
+   *          the purposes of this cache it means "do not cache".  TTLs
+   *          longer than nbt_nsCACHE_MAXTTL are cut down to that value.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool nbt_nsCacheInsertMsg( nbt_nsCache *nc, const nbt_nsMsgBlock *msg );
+  /* ------------------------------------------------------------------------ **
+   * Add the answer from a parsed name query reply to the cache.
+   *
+   *  Input:  nc  - A pointer to the cache.
+   *          msg - A message that has been parsed by <nbt_nsParseMsg()>.
+   *
+   *  Output: true if the answer was cached, else false.
+   *
+   *  Notes:  Only positive and negative name query replies are cached.
+   *          Anything else (eg., a node status reply or a WACK) is
+   *          ignored.  A positive reply with an RCODE of zero is stored
+   *          with its TTL and RDATA.  A negative reply is stored with its
+   *          RCODE.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+bool nbt_nsCacheRemove( nbt_nsCache *nc,
+                        const uchar *name,
+                        const int    namelen );
+  /* ------------------------------------------------------------------------ **
+   * Remove a name from the cache.
+   *
+   *  Input:  nc      - A pointer to the cache.
+   *          name    - The L2 encoded name.
+   *          namelen - The length, in bytes, of <name>.
+   *
+   *  Output: true if the name was found and removed, else false.
+   *
+   *  Notes:  Use this when a cached answer is known to be wrong (eg., a
+   *          session request to the cached address was refused).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_nsCacheStats *nbt_nsCacheGetStats( nbt_nsCache      *nc,
+                                       nbt_nsCacheStats *stats );
+  /* ------------------------------------------------------------------------ **
+   * Return the cache counters.
+   *
+   *  Input:  nc    - A pointer to the cache.
+   *          stats - A pointer to a structure to receive the counters.
+   *
+   *  Output: A pointer to the filled-in statistics (same as <stats>).
+   *
+   *  Notes:  Lookups are not counted, since counting them would mean
+   *          writing to shared memory on every read.  Count hits and
+   *          misses in the caller if they are needed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_NS_CACHE_H */
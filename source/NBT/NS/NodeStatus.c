@@ -0,0 +1,172 @@
+/* ========================================================================== **
+ *
+ *                                NodeStatus.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Parse the RDATA of a Node Status Response.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A Node Status Response (RFC 1002, section 4.2.18) carries the name
+ *  table of the responding node, followed by a block of statistics:
+ *
+ *    NUM_NAMES   - 1 byte.
+ *    NODE_NAME[] - NUM_NAMES entries of 18 bytes each: a 15 byte NetBIOS
+ *                  name, a one byte suffix, and 2 bytes of NAME_FLAGS.
+ *    STATISTICS  - The rest of the RDATA.  The first six bytes are the
+ *                  UNIT_ID, which is usually the MAC address.  RFC 1002
+ *                  defines 46 bytes in all.  Windows sends all of them;
+ *                  some implementations send only the UNIT_ID, or nothing.
+ *
+ *  <nbt_nsNodeStatusParse()> checks the layout once and fills in an
+ *  iterator.  <nbt_nsNodeStatusNext()> then steps through the names.
+ *  Everything points into the original RDATA.  Nothing is copied and
+ *  nothing is allocated, so the RDATA must not be released while the
+ *  iterator is in use.
+ *
+ * ========================================================================== **
+ */
+
+#include "NodeStatus.h"       /* Module header.                     */
+#include "NBT/NS/Packet.h"    /* nbt_nsRRTYPE_NBSTAT.               */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_nsNodeStatusParse( nbt_nsNodeStatus *ns,
+                           const uchar      *rdata,
+                           const int         rdata_len )
+  /* ------------------------------------------------------------------------ **
+   * Check Node Status RDATA and set up an iterator over it.
+   *
+   *  Input:  ns        - The iterator to be initialized.
+   *          rdata     - The RDATA of an NBSTAT resource record.
+   *          rdata_len - Length of <rdata>, in bytes.
+   *
+   *  Output: On success, the number of names in the name table.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput     - <rdata> is NULL.
+   *          cifs_errTruncatedBufr - The RDATA is too short to hold the
+   *                                  number of names it claims to hold.
+   *
+   *  Notes:  The <stats> field of <ns> is set to point to whatever
+   *          follows the name table, and <stats_len> is set to its length.
+   *          If at least six bytes are present, <unit_id> points to the
+   *          UNIT_ID.  Otherwise, it is NULL.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int num_names;
+  int offset;
+
+  if( NULL == rdata )
+    return( cifs_errNullInput );
+  if( rdata_len < 1 )
+    return( cifs_errTruncatedBufr );
+
+  num_names = rdata[0];
+  offset    = 1 + (num_names * nbt_nsNBSTAT_ENTRY_LEN);
+  if( offset > rdata_len )
+    return( cifs_errTruncatedBufr );
+
+  ns->next      = &rdata[1];
+  ns->num_names = num_names;
+  ns->left      = num_names;
+  ns->stats     = &rdata[offset];
+  ns->stats_len = rdata_len - offset;
+  ns->unit_id   = (ns->stats_len >= 6) ? ns->stats : NULL;
+  return( num_names );
+  } /* nbt_nsNodeStatusParse */
+
+
+int nbt_nsNodeStatusParseMsg( nbt_nsNodeStatus     *ns,
+                              const nbt_nsMsgBlock *msg )
+  /* ------------------------------------------------------------------------ **
+   * Set up a Node Status iterator from a parsed message.
+   *
+   *  Input:  ns  - The iterator to be initialized.
+   *          msg - A message that has been through <nbt_nsParseMsg()>.
+   *
+   *  Output: On success, the number of names in the name table.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errInvalidPacket - The message is not a Node Status
+   *                                  Response.
+   *          Others, as for <nbt_nsNodeStatusParse()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( (nbt_nsNODE_STATUS_REPLY != msg->type)
+   || (nbt_nsRRTYPE_NBSTAT != msg->RR_type) )
+    return( cifs_errInvalidPacket );
+  return( nbt_nsNodeStatusParse( ns, msg->rdata, msg->rdata_len ) );
+  } /* nbt_nsNodeStatusParseMsg */
+
+
+bool nbt_nsNodeStatusNext( nbt_nsNodeStatus *ns, nbt_nsNodeName *entry )
+  /* ------------------------------------------------------------------------ **
+   * Return the next entry in a Node Status name table.
+   *
+   *  Input:  ns    - An iterator set up by <nbt_nsNodeStatusParse()>.
+   *          entry - Receives the next entry.
+   *
+   *  Output: True if an entry was returned, false if there are no more.
+   *
+   *  Notes:  <entry>->name points to the 15-byte NetBIOS name within the
+   *          RDATA.  The name is padded (usually with spaces), and is not
+   *          nul terminated.
+   *
+   *          Test <entry>->flags against nbt_nsGROUP_BIT, nbt_nsONT_MASK,
+   *          and the state bits (nbt_nsDRG, nbt_nsCNF, nbt_nsACT, and
+   *          nbt_nsPRM).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  const uchar *p = ns->next;
+
+  if( ns->left < 1 )
+    return( false );
+  entry->name  = p;
+  entry->sfx   = p[15];
+  entry->flags = nbt_GetShort( p, 16 );
+  ns->next     = p + nbt_nsNBSTAT_ENTRY_LEN;
+  ns->left--;
+  return( true );
+  } /* nbt_nsNodeStatusNext */
+
+/* ========================================================================== */
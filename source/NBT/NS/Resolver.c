@@ -0,0 +1,855 @@
+/* ========================================================================== **
+ *
+ *                                 Resolver.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Asynchronous NBT Name Service resolver.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  This module keeps many NBT name queries in flight at once over a
+ *  single UDP socket.  The caller starts queries with
+ *  <nbt_nsResolverQuery()> and then turns the crank with
+ *  <nbt_nsResolverRun()>.  Each call sends any queries that are waiting
+ *  to go out, reads and matches whatever replies have arrived, and
+ *  retransmits or times out queries whose timers have expired.
+ *
+ *  Completion is reported in one of two ways.  If a callback was given
+ *  when the query was started, it is called from within
+ *  <nbt_nsResolverRun()>, and the query slot is recycled as soon as the
+ *  callback returns.  Otherwise, finished queries are queued and can be
+ *  collected with <nbt_nsResolverDone()>.  They must then be returned
+ *  with <nbt_nsResolverFree()>.
+ *
+ *  Pending queries live in a fixed table of nbt_nsRES_MAXQ slots.  The
+ *  Transaction ID of each query encodes its slot number in the low bits
+ *  and a per-slot generation count in the high bits, so a reply is
+ *  matched with one table lookup.  Stale replies (replies to an earlier
+ *  use of the same slot) fail the generation check.  A reply must also
+ *  come from the address that the query was sent to, unless the query
+ *  was a broadcast, and must name the same name and RR type as the
+ *  query.  The whole TID is XOR'd with a per-resolver mask, read from
+ *  /dev/urandom, so the TIDs are not predictable.
+ *
+ *  Retransmit timers are kept in a hashed timer wheel with a resolution
+ *  of one millisecond.  Starting, cancelling, and expiring a timer are
+ *  all constant-time operations.
+ *
+ *  On Linux the socket is watched with epoll(7), and the epoll file
+ *  descriptor is returned by <nbt_nsResolverFd()> so that the resolver
+ *  can be nested within a larger event loop.  Elsewhere, poll(2) is used
+ *  and the socket itself is returned.
+ *
+ *  The resolver is not thread-safe.  Use one resolver per thread.
+ *
+ * ========================================================================== **
+ */
+
+#include <stdlib.h>           /* For calloc(3), free(3).            */
+#include <unistd.h>           /* For close(2), read(2), getpid(2).  */
+#include <fcntl.h>            /* For fcntl(2), open(2).             */
+#include <errno.h>            /* For errno.                         */
+#include <poll.h>             /* For poll(2).                       */
+#include <time.h>             /* For clock_gettime(2).              */
+#include <sys/socket.h>       /* Sockets.                           */
+
+#if defined( __linux__ )
+#include <sys/epoll.h>        /* For epoll(7).                      */
+#define RES_EPOLL 1
+#endif
+
+#include "Resolver.h"         /* Module header.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  RES_SLOTBITS  - The number of Transaction ID bits that hold the slot
+ *                  number.  log2( nbt_nsRES_MAXQ ).
+ *  RES_SLOTMASK  - Mask for the slot number bits.
+ *  RES_PKTMAX    - Size of the query message buffer in each slot.
+ *  RES_WACKMAX   - Upper limit on the time, in ms, that a WACK may extend
+ *                  a query.  The TTL of a WACK is normally a few seconds.
+ *  RES_SOCKBUF   - Requested socket buffer size.  A burst of a few
+ *                  thousand queries, or the replies to them, can easily
+ *                  overrun the system default.
+ */
+
+#define RES_SLOTBITS 12
+#define RES_SLOTMASK (nbt_nsRES_MAXQ - 1)
+#define RES_PKTMAX   (nbt_nsHEADER_LEN + nbt_NAME_MAX + 4)
+#define RES_WACKMAX  60000
+#define RES_SOCKBUF  (1024 * 1024)
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static uint32_t Now( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a millisecond clock.
+   *
+   *  Input:  none.
+   *  Output: Milliseconds since some arbitrary point, modulo 2^32.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000) );
+  } /* Now */
+
+
+static uint16_t RandomMask( void )
+  /* ------------------------------------------------------------------------ **
+   * Pick a random Transaction ID mask.
+   *
+   *  Input:  none.
+   *  Output: Sixteen random bits.
+   *
+   *  Notes:  The mask is read from /dev/urandom.  If that cannot be read,
+   *          the clock and process ID are mixed together instead, which
+   *          is guessable but better than nothing.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint16_t mask;
+  ssize_t  len = -1;
+  int      fd;
+
+  fd = open( "/dev/urandom", O_RDONLY );
+  if( fd >= 0 )
+    {
+    len = read( fd, &mask, sizeof( mask ) );
+    (void)close( fd );
+    }
+  if( sizeof( mask ) != len )
+    mask = (uint16_t)(Now() ^ (getpid() * 0x9E37u));
+  return( mask );
+  } /* RandomMask */
+
+
+static void TimerAdd( nbt_nsResolver *r, nbt_nsQuery *q, const uint32_t when )
+  /* ------------------------------------------------------------------------ **
+   * Start a query's timer.
+   *
+   *  Input:  r     - The resolver.
+   *          q     - The query.
+   *          when  - The time, per <Now()>, at which the timer expires.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsQuery **bucket = &r->wheel[when & (nbt_nsRES_WHEEL - 1)];
+
+  q->expires = when;
+  q->prev    = NULL;
+  q->next    = *bucket;
+  if( NULL != q->next )
+    q->next->prev = q;
+  *bucket = q;
+  } /* TimerAdd */
+
+
+static void TimerDel( nbt_nsResolver *r, nbt_nsQuery *q )
+  /* ------------------------------------------------------------------------ **
+   * Stop a query's timer.
+   *
+   *  Input:  r - The resolver.
+   *          q - The query.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( NULL != q->next )
+    q->next->prev = q->prev;
+  if( NULL != q->prev )
+    q->prev->next = q->next;
+  else
+    r->wheel[q->expires & (nbt_nsRES_WHEEL - 1)] = q->next;
+  q->next = q->prev = NULL;
+  } /* TimerDel */
+
+
+static void Finish( nbt_nsResolver *r, nbt_nsQuery *q, nbt_nsMsgBlock *msg )
+  /* ------------------------------------------------------------------------ **
+   * Report a finished query.
+   *
+   *  Input:  r   - The resolver.
+   *          q   - The query, with its timer already stopped and its
+   *                status set.
+   *          msg - The reply, or NULL on timeout.
+   *
+   *  Output: none.
+   *
+   *  Notes:  If the query has a callback, the callback is called and the
+   *          slot is freed.  Otherwise the query is added to the end of
+   *          the done list.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  r->pending--;
+  r->finished++;
+  if( NULL != q->cb )
+    {
+    q->cb( q, msg );
+    nbt_nsResolverFree( r, q );
+    }
+  else
+    {
+    q->next = NULL;
+    if( NULL == r->donetail )
+      r->donehead = q;
+    else
+      r->donetail->next = q;
+    r->donetail = q;
+    }
+  } /* Finish */
+
+
+static void Flush( nbt_nsResolver *r )
+  /* ------------------------------------------------------------------------ **
+   * Send queued queries and start their retransmit timers.
+   *
+   *  Input:  r - The resolver.
+   *
+   *  Output: none.
+   *
+   *  Notes:  If the socket stops accepting datagrams (eg., because the
+   *          send buffer is full), the queries that were not sent are
+   *          left on the queue for the next call.  Their timers are not
+   *          started and their tries are not used up.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_Block         *msg[nbt_nsRING_SIZE];
+  struct sockaddr_in  addr[nbt_nsRING_SIZE];
+  uint32_t            now;
+  int                 i;
+  int                 j;
+  int                 n;
+  int                 sent;
+
+  if( r->nout < 1 )
+    return;
+
+  now = Now();
+  for( i = 0; i < r->nout; i += sent )
+    {
+    n = r->nout - i;
+    if( n > nbt_nsRING_SIZE )
+      n = nbt_nsRING_SIZE;
+    for( j = 0; j < n; j++ )
+      {
+      msg[j]  = r->outq[i + j]->blk;
+      addr[j] = r->outq[i + j]->dest;
+      }
+    sent = nbt_nsTransportSend( r->xport, msg, addr, n );
+    if( sent < 0 )
+      sent = 0;
+    for( j = 0; j < sent; j++ )
+      {
+      nbt_nsQuery *q = r->outq[i + j];
+
+      q->queued = false;
+      q->sent   = true;
+      q->tries--;
+      TimerAdd( r, q, now + (uint32_t)q->wait );
+      q->wait += q->inc;
+      }
+    if( sent < n )
+      {
+      i += sent;
+      break;
+      }
+    }
+
+  /* Keep whatever could not be sent. */
+  r->nout -= i;
+  if( r->nout > 0 )
+    (void)memmove( r->outq, &r->outq[i], r->nout * sizeof( nbt_nsQuery * ) );
+  } /* Flush */
+
+
+static void Match( nbt_nsResolver *r, nbt_nsDatagram *dg )
+  /* ------------------------------------------------------------------------ **
+   * Match a received datagram against the pending queries.
+   *
+   *  Input:  r   - The resolver.
+   *          dg  - The datagram.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Anything that is not a reply to one of our pending queries,
+   *          from the right source, is silently dropped.  Apart from a
+   *          WACK, a reply must also carry the name and RR type that
+   *          were asked for.  The generation count is only four bits,
+   *          so a late reply to an earlier use of the slot could
+   *          otherwise complete the wrong query.
+   *
+   *          A WACK stops retransmission and pushes the query timeout
+   *          out by the TTL given in the WACK.
+   *
+   *          Replies to a query that is waiting to be retransmitted are
+   *          ignored.  The retransmission has the same Transaction ID, so
+   *          its reply will be accepted instead.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *msg = &dg->msg;
+  nbt_nsQuery    *q;
+  int             type;
+
+  type = nbt_nsParseMsg( msg );
+  switch( type )
+    {
+    case nbt_nsNAME_QUERY_REPLY_POS:
+    case nbt_nsNAME_QUERY_REPLY_NEG:
+    case nbt_nsNODE_STATUS_REPLY:
+    case nbt_nsWACK_REPLY:
+      break;
+    default:
+      return;
+    }
+
+  q = &r->q[(msg->tid ^ r->tidmask) & RES_SLOTMASK];
+  if( (nbt_nsRES_PENDING != q->status) || (q->tid != msg->tid)
+   || q->queued || !q->sent )
+    return;
+  if( !q->bcast && (dg->addr.sin_addr.s_addr != q->dest.sin_addr.s_addr) )
+    return;
+
+  if( (nbt_nsWACK_REPLY != type)
+   && ( (msg->RR_type != q->qtype)
+     || (msg->RR_name_len != (q->blk->used - nbt_nsHEADER_LEN - 4))
+     || (0 != memcmp( msg->RR_name, &q->pkt[nbt_nsHEADER_LEN],
+                      msg->RR_name_len )) ) )
+    return;
+
+  TimerDel( r, q );
+  if( nbt_nsWACK_REPLY == type )
+    {
+    uint32_t ttl = (msg->ttl < RES_WACKMAX / 1000) ? msg->ttl * 1000
+                                                   : RES_WACKMAX;
+    q->tries = 0;
+    TimerAdd( r, q, Now() + ttl + 1 );
+    return;
+    }
+
+  q->from  = dg->addr.sin_addr;
+  q->rcode = msg->flags & nbt_nsRCODE_MASK;
+  if( (nbt_nsNAME_QUERY_REPLY_POS == type) && (msg->rdata_len >= 6) )
+    {
+    q->nbflags = nbt_GetShort( msg->rdata, 0 );
+    (void)memcpy( &q->addr.s_addr, &msg->rdata[2], 4 );
+    }
+  q->status = ( (nbt_nsNAME_QUERY_REPLY_NEG == type) || (0 != q->rcode) )
+              ? nbt_nsRES_NEGATIVE : nbt_nsRES_POSITIVE;
+  Finish( r, q, msg );
+  } /* Match */
+
+
+static void Expire( nbt_nsResolver *r )
+  /* ------------------------------------------------------------------------ **
+   * Process expired timers.
+   *
+   *  Input:  r - The resolver.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Each wheel bucket between the last tick processed and now
+   *          is examined.  A bucket may hold timers that are one or more
+   *          full turns of the wheel in the future; those are skipped.
+   *          If more than a full turn has passed, every bucket is
+   *          examined once.
+   *
+   *          An expired query is queued for retransmission if it has any
+   *          tries left.  Otherwise it times out.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t     now   = Now();
+  uint32_t     steps = now - r->tick + 1;
+  uint32_t     i;
+  nbt_nsQuery *q;
+  nbt_nsQuery *next;
+
+  if( (int32_t)(now - r->tick) < 0 )
+    return;
+  if( steps > nbt_nsRES_WHEEL )
+    steps = nbt_nsRES_WHEEL;
+
+  for( i = 0; i < steps; i++ )
+    {
+    for( q = r->wheel[(r->tick + i) & (nbt_nsRES_WHEEL - 1)]; q; q = next )
+      {
+      next = q->next;
+      if( (int32_t)(q->expires - now) > 0 )
+        continue;
+      TimerDel( r, q );
+      if( q->tries > 0 )
+        {
+        q->queued = true;
+        r->outq[r->nout++] = q;
+        }
+      else
+        {
+        q->status = nbt_nsRES_TIMEOUT;
+        Finish( r, q, NULL );
+        }
+      }
+    }
+  r->tick = now + 1;
+  } /* Expire */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsResolver *nbt_nsResolverOpen( const int port )
+  /* ------------------------------------------------------------------------ **
+   * Create a resolver.
+   *
+   *  Input:  port  - The local UDP port to which the socket will be bound.
+   *                  Zero means any available port.  Some older systems
+   *                  will only reply to queries sent from port 137.
+   *
+   *  Output: A pointer to the new resolver, or NULL on error, in which
+   *          case <errno> describes the problem.
+   *
+   *  Notes:  The socket is opened with broadcast enabled, and is placed
+   *          in non-blocking mode.  Larger than default socket buffers
+   *          are requested, but the system may impose a lower limit.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsResolver     *r;
+  struct sockaddr_in  sox;
+  int                 on  = 1;
+  int                 buf = RES_SOCKBUF;
+  int                 i;
+
+  r = (nbt_nsResolver *)calloc( 1, sizeof( nbt_nsResolver ) );
+  if( NULL == r )
+    return( NULL );
+
+  r->sock = socket( AF_INET, SOCK_DGRAM, 0 );
+  if( r->sock < 0 )
+    {
+    free( r );
+    return( NULL );
+    }
+  (void)setsockopt( r->sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof( on ) );
+  (void)setsockopt( r->sock, SOL_SOCKET, SO_SNDBUF, &buf, sizeof( buf ) );
+  (void)setsockopt( r->sock, SOL_SOCKET, SO_RCVBUF, &buf, sizeof( buf ) );
+  (void)fcntl( r->sock, F_SETFL, fcntl( r->sock, F_GETFL ) | O_NONBLOCK );
+
+  (void)memset( &sox, 0, sizeof( sox ) );
+  sox.sin_family      = AF_INET;
+  sox.sin_port        = htons( (uint16_t)port );
+  sox.sin_addr.s_addr = htonl( INADDR_ANY );
+  if( bind( r->sock, (struct sockaddr *)&sox, sizeof( sox ) ) < 0 )
+    {
+    i = errno;
+    (void)close( r->sock );
+    free( r );
+    errno = i;
+    return( NULL );
+    }
+
+#if defined( RES_EPOLL )
+  {
+  struct epoll_event ev;
+
+  r->pollfd = epoll_create1( 0 );
+  ev.events  = EPOLLIN;
+  ev.data.fd = r->sock;
+  if( (r->pollfd < 0)
+   || (epoll_ctl( r->pollfd, EPOLL_CTL_ADD, r->sock, &ev ) < 0) )
+    {
+    i = errno;
+    if( r->pollfd >= 0 )
+      (void)close( r->pollfd );
+    (void)close( r->sock );
+    free( r );
+    errno = i;
+    return( NULL );
+    }
+  }
+#else
+  r->pollfd = r->sock;
+#endif
+
+  (void)nbt_nsTransportInit( r->xport, r->sock );
+
+  /* All slots start out free. */
+  for( i = 0; i < nbt_nsRES_MAXQ; i++ )
+    r->freeq[i] = (uint16_t)(nbt_nsRES_MAXQ - 1 - i);
+  r->nfree = nbt_nsRES_MAXQ;
+
+  r->tidmask   = RandomMask();
+  r->tick      = Now();
+  r->wait      = 250;
+  r->inc       = 250;
+  r->tries     = 3;
+  return( r );
+  } /* nbt_nsResolverOpen */
+
+
+void nbt_nsResolverClose( nbt_nsResolver *r )
+  /* ------------------------------------------------------------------------ **
+   * Shut down a resolver.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Pending queries are dropped without calling their callbacks.
+   *          Any query handles held by the caller become invalid.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( NULL == r )
+    return;
+  nbt_nsTransportFree( r->xport );
+#if defined( RES_EPOLL )
+  (void)close( r->pollfd );
+#endif
+  (void)close( r->sock );
+  free( r );
+  } /* nbt_nsResolverClose */
+
+
+int nbt_nsResolverFd( const nbt_nsResolver *r )
+  /* ------------------------------------------------------------------------ **
+   * Return a file descriptor that becomes readable when there is work.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: A file descriptor that can be watched with poll(2), select(2),
+   *          or an epoll(7) set.
+   *
+   *  Notes:  The resolver also has timers.  Call <nbt_nsResolverRun()>
+   *          with a timeout of zero at least every nbt_nsRES_TICK
+   *          milliseconds while queries are pending.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  return( r->pollfd );
+  } /* nbt_nsResolverFd */
+
+
+void nbt_nsResolverSetRetry( nbt_nsResolver *r,
+                             const int       wait,
+                             const int       inc,
+                             const int       tries )
+  /* ------------------------------------------------------------------------ **
+   * Set the retransmit schedule for queries started from now on.
+   *
+   *  Input:  r     - A pointer to the resolver.
+   *          wait  - Milliseconds to wait for a reply to the first send.
+   *          inc   - Milliseconds added to the wait for each retry.
+   *          tries - Total number of times to send each query.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The defaults match those of nbtquery: 250ms, plus 250ms per
+   *          retry, three tries.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  r->wait  = (wait  > 0) ? wait  : 1;
+  r->inc   = (inc  >= 0) ? inc   : 0;
+  r->tries = (tries > 0) ? tries : 1;
+  } /* nbt_nsResolverSetRetry */
+
+
+nbt_nsQuery *nbt_nsResolverQuery( nbt_nsResolver    *r,
+                                  const nbt_NameRec *name,
+                                  const uint16_t     qtype,
+                                  const uint16_t     flags,
+                                  const struct sockaddr_in *dest,
+                                  nbt_nsResolverCB   cb,
+                                  void              *ctx )
+  /* ------------------------------------------------------------------------ **
+   * Start a name query or node status query.
+   *
+   *  Input:  r     - A pointer to the resolver.
+   *          name  - The name to be queried.  The name should already be
+   *                  upper-cased and checked.  See <nbt_EncodeName()>.
+   *                  The wildcard name ("*") is accepted with
+   *                  nbt_nsQTYPE_NBSTAT.
+   *          qtype - Either nbt_nsQTYPE_NB or nbt_nsQTYPE_NBSTAT.
+   *          flags - Header flags, such as nbt_nsRD_BIT and nbt_nsB_BIT.
+   *                  The opcode is always nbt_nsOPCODE_QUERY.
+   *          dest  - The address to which the query will be sent.  If the
+   *                  port is zero, the query goes to UDP port 137.
+   *          cb    - A function to call when the query finishes, or NULL
+   *                  to collect the result with <nbt_nsResolverDone()>.
+   *          ctx   - A pointer for the caller's use.  It is stored in the
+   *                  <ctx> field of the query.
+   *
+   *  Output: A pointer to the query, or NULL on error.  If the resolver is
+   *          full, <errno> is set to EAGAIN.  If the name could not be
+   *          encoded, <errno> is set to EINVAL.
+   *
+   *  Notes:  The query is not sent until the next call to
+   *          <nbt_nsResolverRun()>, so a large number of queries can be
+   *          started and then sent as a batch.
+   *
+   *          If nbt_nsB_BIT is set in <flags>, replies are accepted from
+   *          any source address.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsQuery *q;
+  uint16_t     slot;
+  int          len;
+
+  if( r->nfree < 1 )
+    {
+    errno = EAGAIN;
+    return( NULL );
+    }
+  slot = r->freeq[r->nfree - 1];
+  q    = &r->q[slot];
+
+  /* Build the query message. */
+  len = nbt_EncodeName( q->pkt, nbt_nsHEADER_LEN,
+                        RES_PKTMAX - 4, name );
+  if( (cifs_warnAsterisk == len) && (nbt_nsQTYPE_NBSTAT == qtype) )
+    {
+    /* The wildcard name is refused by nbt_EncodeName(), but it is what
+     * a node status query normally asks for.  Check the scope ourselves.
+     */
+    if( (NULL != name->scope_id) && ('\0' != *(name->scope_id)) )
+      len = nbt_CheckScope( name->scope_id );
+    if( (len >= 0) || cifs_errIsWarn( len ) )
+      len = nbt_L2Encode( &q->pkt[nbt_nsHEADER_LEN], name );
+    }
+  if( len < 0 )
+    {
+    errno = EINVAL;
+    return( NULL );
+    }
+  r->nfree--;
+  (void)nbt_nsSetHdr( q->pkt, RES_PKTMAX,
+                      (uint16_t)(nbt_nsOPCODE_QUERY | flags), nbt_nsQUERYREC );
+  len += nbt_nsHEADER_LEN;
+  nbt_SetShort( q->pkt, len, qtype );
+  len += 2;
+  nbt_SetShort( q->pkt, len, nbt_nsQCLASS_IN );
+  len += 2;
+  (void)cifs_BlockInit( q->blk, RES_PKTMAX, q->pkt );
+  q->blk->used = len;
+
+  q->qtype = qtype;
+  q->gen++;
+  q->tid = (uint16_t)(((q->gen << RES_SLOTBITS) | slot) ^ r->tidmask);
+  nbt_nsSetTID( q->pkt, q->tid );
+
+  q->dest = *dest;
+  if( 0 == q->dest.sin_port )
+    q->dest.sin_port = htons( 137 );
+  q->bcast   = (0 != (flags & nbt_nsB_BIT));
+  q->cb      = cb;
+  q->ctx     = ctx;
+  q->status  = nbt_nsRES_PENDING;
+  q->rcode   = 0;
+  q->nbflags = 0;
+  q->addr.s_addr = 0;
+  q->from.s_addr = 0;
+  q->sent    = false;
+  q->queued  = true;
+  q->tries   = r->tries;
+  q->wait    = r->wait;
+  q->inc     = r->inc;
+
+  r->outq[r->nout++] = q;
+  r->pending++;
+  return( q );
+  } /* nbt_nsResolverQuery */
+
+
+int nbt_nsResolverRun( nbt_nsResolver *r, const int timeout )
+  /* ------------------------------------------------------------------------ **
+   * Send, receive, match, and retransmit.
+   *
+   *  Input:  r       - A pointer to the resolver.
+   *          timeout - The longest time, in milliseconds, to wait for a
+   *                    reply.  Zero means don't wait.  A negative value
+   *                    means wait until something happens.
+   *
+   *  Output: The number of queries that finished during this call, or -1
+   *          on a socket error, in which case <errno> describes the
+   *          problem.
+   *
+   *  Notes:  While queries are pending, the wait is capped at
+   *          nbt_nsRES_TICK milliseconds so that retransmit timers are
+   *          serviced on time.  If some queries could not be sent because
+   *          the socket was busy, the wait is cut to one millisecond.
+   *
+   *          Callbacks are made from within this function.  A callback
+   *          may start new queries.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int             wait = timeout;
+  int             n;
+  nbt_nsDatagram *dg;
+
+  r->finished = 0;
+  Flush( r );
+
+  if( (r->pending > 0) && ((wait < 0) || (wait > nbt_nsRES_TICK)) )
+    wait = nbt_nsRES_TICK;
+  if( (r->nout > 0) && (wait != 0) )
+    wait = 1;
+
+#if defined( RES_EPOLL )
+  {
+  struct epoll_event ev[1];
+
+  n = epoll_wait( r->pollfd, ev, 1, wait );
+  }
+#else
+  {
+  struct pollfd pfd[1];
+
+  pfd->fd     = r->sock;
+  pfd->events = POLLIN;
+  n = poll( pfd, 1, wait );
+  }
+#endif
+  if( (n < 0) && (EINTR != errno) )
+    return( -1 );
+
+  /* Drain the socket. */
+  if( n > 0 )
+    {
+    while( (n = nbt_nsTransportRecv( r->xport, 0 )) > 0 )
+      {
+      while( NULL != (dg = nbt_nsTransportNext( r->xport )) )
+        {
+        Match( r, dg );
+        nbt_nsTransportRelease( r->xport );
+        }
+      }
+    if( n < 0 )
+      return( -1 );
+    }
+
+  Expire( r );
+  Flush( r );
+  return( r->finished );
+  } /* nbt_nsResolverRun */
+
+
+nbt_nsQuery *nbt_nsResolverDone( nbt_nsResolver *r )
+  /* ------------------------------------------------------------------------ **
+   * Collect a finished query.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: A pointer to the oldest finished query that has no callback,
+   *          or NULL if there are none.
+   *
+   *  Notes:  The result fields of the query are valid until the query is
+   *          returned to the resolver with <nbt_nsResolverFree()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsQuery *q = r->donehead;
+
+  if( NULL != q )
+    {
+    r->donehead = q->next;
+    if( NULL == r->donehead )
+      r->donetail = NULL;
+    q->next = NULL;
+    }
+  return( q );
+  } /* nbt_nsResolverDone */
+
+
+void nbt_nsResolverFree( nbt_nsResolver *r, nbt_nsQuery *q )
+  /* ------------------------------------------------------------------------ **
+   * Return a finished query to the resolver.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *          q - A query returned by <nbt_nsResolverDone()>.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  q->status = nbt_nsRES_FREE;
+  r->freeq[r->nfree++] = (uint16_t)(q - r->q);
+  } /* nbt_nsResolverFree */
+
+
+int nbt_nsResolverPending( const nbt_nsResolver *r )
+  /* ------------------------------------------------------------------------ **
+   * Return the number of queries that have not yet finished.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: The number of queries still waiting for a reply.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  return( r->pending );
+  } /* nbt_nsResolverPending */
+
+/* ========================================================================== */
@@ -0,0 +1,383 @@
+#ifndef NBT_NS_RESOLVER_H
+#define NBT_NS_RESOLVER_H
+/* ========================================================================== **
+ *
+ *                                 Resolver.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Asynchronous NBT Name Service resolver.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  This module keeps many NBT name queries in flight at once over a
+ *  single UDP socket.  The caller starts queries with
+ *  <nbt_nsResolverQuery()> and then turns the crank with
+ *  <nbt_nsResolverRun()>.  Each call sends any queries that are waiting
+ *  to go out, reads and matches whatever replies have arrived, and
+ *  retransmits or times out queries whose timers have expired.
+ *
+ *  Completion is reported in one of two ways.  If a callback was given
+ *  when the query was started, it is called from within
+ *  <nbt_nsResolverRun()>, and the query slot is recycled as soon as the
+ *  callback returns.  Otherwise, finished queries are queued and can be
+ *  collected with <nbt_nsResolverDone()>.  They must then be returned
+ *  with <nbt_nsResolverFree()>.
+ *
+ *  Pending queries live in a fixed table of nbt_nsRES_MAXQ slots.  The
+ *  Transaction ID of each query encodes its slot number in the low bits
+ *  and a per-slot generation count in the high bits, so a reply is
+ *  matched with one table lookup.  Stale replies (replies to an earlier
+ *  use of the same slot) fail the generation check.  A reply must also
+ *  come from the address that the query was sent to, unless the query
+ *  was a broadcast, and must name the same name and RR type as the
+ *  query.  The whole TID is XOR'd with a per-resolver mask, read from
+ *  /dev/urandom, so the TIDs are not predictable.
+ *
+ *  Retransmit timers are kept in a hashed timer wheel with a resolution
+ *  of one millisecond.  Starting, cancelling, and expiring a timer are
+ *  all constant-time operations.
+ *
+ *  On Linux the socket is watched with epoll(7), and the epoll file
+ *  descriptor is returned by <nbt_nsResolverFd()> so that the resolver
+ *  can be nested within a larger event loop.  Elsewhere, poll(2) is used
+ *  and the socket itself is returned.
+ *
+ *  The resolver is not thread-safe.  Use one resolver per thread.
+ *
+ * ========================================================================== **
+ */
+
+#include <netinet/in.h>       /* struct in_addr, sockaddr_in.       */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/Names.h"        /* nbt_NameRec.                       */
+#include "NBT/NS/Packet.h"    /* nbt_nsHEADER_LEN.                  */
+#include "NBT/NS/Transport.h" /* Batched send and receive.          */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_nsRES_MAXQ  - The largest number of queries that can be in flight
+ *                    at once in one resolver.  Must be a power of two no
+ *                    larger than 4096, because the slot number and a
+ *                    generation count share the 16-bit Transaction ID.
+ *
+ *  nbt_nsRES_TICK  - The longest that <nbt_nsResolverRun()> will wait
+ *                    while queries are pending, in milliseconds.
+ *
+ *  nbt_nsRES_WHEEL - The number of buckets in the timer wheel.  Each
+ *                    bucket covers one millisecond.
+ */
+
+#define nbt_nsRES_MAXQ  4096
+#define nbt_nsRES_TICK  10
+#define nbt_nsRES_WHEEL 1024
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_nsResStatus   - The state of a query.
+ *                      nbt_nsRES_FREE      - Slot not in use.
+ *                      nbt_nsRES_PENDING   - Waiting for a reply.
+ *                      nbt_nsRES_POSITIVE  - A positive reply was received.
+ *                      nbt_nsRES_NEGATIVE  - A negative reply was received.
+ *                                            See <rcode>.
+ *                      nbt_nsRES_TIMEOUT   - No reply before the last retry
+ *                                            timed out.
+ *
+ *  nbt_nsResolverCB  - Completion callback.  <reply> points to the parsed
+ *                      reply message, and is valid only for the duration
+ *                      of the call.  It is NULL if the query timed out.
+ *
+ *  nbt_nsQuery       - One query.  The fields from <status> through <ctx>
+ *                      may be read by the caller.  The rest are private.
+ *                      status  - See nbt_nsResStatus.
+ *                      rcode   - The RCODE of the reply.
+ *                      from    - The address that sent the reply.
+ *                      nbflags - NB_FLAGS of the first address in a
+ *                                positive name query reply.
+ *                      addr    - The first address in a positive name
+ *                                query reply.
+ *                      ctx     - The caller's context pointer.
+ *
+ *  nbt_nsResolver    - The resolver.  Treat as opaque.
+ */
+
+typedef enum
+  {
+  nbt_nsRES_FREE = 0,
+  nbt_nsRES_PENDING,
+  nbt_nsRES_POSITIVE,
+  nbt_nsRES_NEGATIVE,
+  nbt_nsRES_TIMEOUT
+  } nbt_nsResStatus;
+
+typedef struct nbt_nsQuery nbt_nsQuery;
+
+typedef void (*nbt_nsResolverCB)( nbt_nsQuery *q, nbt_nsMsgBlock *reply );
+
+struct nbt_nsQuery
+  {
+  nbt_nsResStatus     status;
+  uint16_t            rcode;
+  struct in_addr      from;
+  uint16_t            nbflags;
+  struct in_addr      addr;
+  void               *ctx;
+
+  nbt_nsQuery        *next;       /* Timer bucket or done list.       */
+  nbt_nsQuery        *prev;       /* Timer bucket.                    */
+  uint32_t            expires;    /* Timer expiry, in ms.             */
+  uint16_t            tid;        /* Transaction ID.                  */
+  uint16_t            gen;        /* Slot generation.                 */
+  uint16_t            qtype;      /* nbt_nsQTYPE_NB or _NBSTAT.       */
+  bool                bcast;      /* Accept replies from anyone.      */
+  bool                sent;       /* Sent at least once.              */
+  bool                queued;     /* Waiting in the send queue.       */
+  int                 tries;      /* Sends remaining.                 */
+  int                 wait;       /* Current wait, in ms.             */
+  int                 inc;        /* Wait increment, in ms.           */
+  nbt_nsResolverCB    cb;         /* Callback, or NULL.               */
+  struct sockaddr_in  dest;       /* Where to send the query.         */
+  cifs_Block          blk[1];     /* Describes <pkt>.                 */
+  uchar               pkt[nbt_nsHEADER_LEN + nbt_NAME_MAX + 4];
+  };
+
+typedef struct
+  {
+  int              sock;
+  int              pollfd;
+  uint16_t         tidmask;
+  int              wait;
+  int              inc;
+  int              tries;
+  int              pending;
+  int              finished;
+  uint32_t         tick;
+  int              nfree;
+  int              nout;
+  nbt_nsQuery     *donehead;
+  nbt_nsQuery     *donetail;
+  nbt_nsTransport  xport[1];
+  nbt_nsQuery     *wheel[nbt_nsRES_WHEEL];
+  nbt_nsQuery     *outq[nbt_nsRES_MAXQ];
+  uint16_t         freeq[nbt_nsRES_MAXQ];
+  nbt_nsQuery      q[nbt_nsRES_MAXQ];
+  } nbt_nsResolver;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsResolver *nbt_nsResolverOpen( const int port );
+  /* ------------------------------------------------------------------------ **
+   * Create a resolver.
+   *
+   *  Input:  port  - The local UDP port to which the socket will be bound.
+   *                  Zero means any available port.  Some older systems
+   *                  will only reply to queries sent from port 137.
+   *
+   *  Output: A pointer to the new resolver, or NULL on error, in which
+   *          case <errno> describes the problem.
+   *
+   *  Notes:  The socket is opened with broadcast enabled, and is placed
+   *          in non-blocking mode.  Larger than default socket buffers
+   *          are requested, but the system may impose a lower limit.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsResolverClose( nbt_nsResolver *r );
+  /* ------------------------------------------------------------------------ **
+   * Shut down a resolver.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Pending queries are dropped without calling their callbacks.
+   *          Any query handles held by the caller become invalid.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsResolverFd( const nbt_nsResolver *r );
+  /* ------------------------------------------------------------------------ **
+   * Return a file descriptor that becomes readable when there is work.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: A file descriptor that can be watched with poll(2), select(2),
+   *          or an epoll(7) set.
+   *
+   *  Notes:  The resolver also has timers.  Call <nbt_nsResolverRun()>
+   *          with a timeout of zero at least every nbt_nsRES_TICK
+   *          milliseconds while queries are pending.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsResolverSetRetry( nbt_nsResolver *r,
+                             const int       wait,
+                             const int       inc,
+                             const int       tries );
+  /* ------------------------------------------------------------------------ **
+   * Set the retransmit schedule for queries started from now on.
+   *
+   *  Input:  r     - A pointer to the resolver.
+   *          wait  - Milliseconds to wait for a reply to the first send.
+   *          inc   - Milliseconds added to the wait for each retry.
+   *          tries - Total number of times to send each query.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The defaults match those of nbtquery: 250ms, plus 250ms per
+   *          retry, three tries.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_nsQuery *nbt_nsResolverQuery( nbt_nsResolver    *r,
+                                  const nbt_NameRec *name,
+                                  const uint16_t     qtype,
+                                  const uint16_t     flags,
+                                  const struct sockaddr_in *dest,
+                                  nbt_nsResolverCB   cb,
+                                  void              *ctx );
+  /* ------------------------------------------------------------------------ **
+   * Start a name query or node status query.
+   *
+   *  Input:  r     - A pointer to the resolver.
+   *          name  - The name to be queried.  The name should already be
+   *                  upper-cased and checked.  See <nbt_EncodeName()>.
+   *                  The wildcard name ("*") is accepted with
+   *                  nbt_nsQTYPE_NBSTAT.
+   *          qtype - Either nbt_nsQTYPE_NB or nbt_nsQTYPE_NBSTAT.
+   *          flags - Header flags, such as nbt_nsRD_BIT and nbt_nsB_BIT.
+   *                  The opcode is always nbt_nsOPCODE_QUERY.
+   *          dest  - The address to which the query will be sent.  If the
+   *                  port is zero, the query goes to UDP port 137.
+   *          cb    - A function to call when the query finishes, or NULL
+   *                  to collect the result with <nbt_nsResolverDone()>.
+   *          ctx   - A pointer for the caller's use.  It is stored in the
+   *                  <ctx> field of the query.
+   *
+   *  Output: A pointer to the query, or NULL on error.  If the resolver is
+   *          full, <errno> is set to EAGAIN.  If the name could not be
+   *          encoded, <errno> is set to EINVAL.
+   *
+   *  Notes:  The query is not sent until the next call to
+   *          <nbt_nsResolverRun()>, so a large number of queries can be
+   *          started and then sent as a batch.
+   *
+   *          If nbt_nsB_BIT is set in <flags>, replies are accepted from
+   *          any source address.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsResolverRun( nbt_nsResolver *r, const int timeout );
+  /* ------------------------------------------------------------------------ **
+   * Send, receive, match, and retransmit.
+   *
+   *  Input:  r       - A pointer to the resolver.
+   *          timeout - The longest time, in milliseconds, to wait for a
+   *                    reply.  Zero means don't wait.  A negative value
+   *                    means wait until something happens.
+   *
+   *  Output: The number of queries that finished during this call, or -1
+   *          on a socket error, in which case <errno> describes the
+   *          problem.
+   *
+   *  Notes:  While queries are pending, the wait is capped at
+   *          nbt_nsRES_TICK milliseconds so that retransmit timers are
+   *          serviced on time.  If some queries could not be sent because
+   *          the socket was busy, the wait is cut to one millisecond.
+   *
+   *          Callbacks are made from within this function.  A callback
+   *          may start new queries.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_nsQuery *nbt_nsResolverDone( nbt_nsResolver *r );
+  /* ------------------------------------------------------------------------ **
+   * Collect a finished query.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: A pointer to the oldest finished query that has no callback,
+   *          or NULL if there are none.
+   *
+   *  Notes:  The result fields of the query are valid until the query is
+   *          returned to the resolver with <nbt_nsResolverFree()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsResolverFree( nbt_nsResolver *r, nbt_nsQuery *q );
+  /* ------------------------------------------------------------------------ **
+   * Return a finished query to the resolver.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *          q - A query returned by <nbt_nsResolverDone()>.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsResolverPending( const nbt_nsResolver *r );
+  /* ------------------------------------------------------------------------ **
+   * Return the number of queries that have not yet finished.
+   *
+   *  Input:  r - A pointer to the resolver.
+   *
+   *  Output: The number of queries still waiting for a reply.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_NS_RESOLVER_H */
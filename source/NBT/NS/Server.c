@@ -0,0 +1,1283 @@
+/* ========================================================================== **
+ *
+ *                                  Server.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NBT Name Server (NBNS) engine.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  This module implements the name server side of the NBT Name Service,
+ *  as described in RFC 1001 and RFC 1002, for point-to-point (P, M, and
+ *  H mode) clients.  It answers name queries, and handles registration,
+ *  refresh, release, and multi-homed registration requests.
+ *
+ *  The engine and the network front-end are separate.  The engine,
+ *  <nbt_nsServerHandle()>, takes one received datagram and queues zero
+ *  or more reply datagrams in an nbt_nsServerOut structure.  It knows
+ *  nothing about sockets, so it can be driven by any event loop.  The
+ *  front-end, <nbt_nsServerRun()>, is a ready-made multi-threaded UDP
+ *  loop.  Each thread has its own socket bound with SO_REUSEPORT, so the
+ *  kernel spreads incoming queries across the threads.  Where
+ *  SO_REUSEPORT is not available, the threads share a single socket.
+ *
+ *  The name table is split into nbt_nsSRV_SHARDS shards, each with its
+ *  own hash table and read/write lock.  Queries take a read lock, so
+ *  they run in parallel even within a shard.  Registrations and releases
+ *  take a write lock on one shard only.
+ *
+ *  Registration conflicts are handled as described in RFC 1002, section
+ *  5.1.4.  If a unique name is already owned by another node, the server
+ *  sends the requester a WAIT FOR ACKNOWLEDGEMENT (WACK) response and
+ *  challenges the current owner with a name query.  If the owner says
+ *  that it still has the name, the registration is refused.  If the
+ *  owner denies it, or fails to answer after nbt_nsSRV_CHAL_TRIES
+ *  tries, the name is given to the requester.  Challenge timeouts are
+ *  processed by <nbt_nsServerTick()>.
+ *
+ *  Group names may have up to nbt_nsSRV_MAXADDR members, which is the
+ *  limit that Windows applies to internet group (<1C>) names.  Queries
+ *  for a group name return the member list.
+ *
+ *  Names are held until their TTL runs out.  Expired names are treated
+ *  as absent, and are swept out of the table a shard at a time by
+ *  <nbt_nsServerTick()>.
+ *
+ *  Broadcast (B bit) requests are ignored.  Those are for the local
+ *  nodes to sort out among themselves.
+ *
+ * ========================================================================== **
+ */
+
+#include <stdlib.h>           /* For calloc(3), free(3).            */
+#include <unistd.h>           /* For close(2).                      */
+#include <errno.h>            /* For errno.                         */
+#include <time.h>             /* For clock_gettime(2).              */
+#include <pthread.h>          /* Worker threads and shard locks.    */
+#include <sys/socket.h>       /* Sockets.                           */
+
+#include "Server.h"           /* Module header.                     */
+#include "NBT/NS/Packet.h"    /* Header fields and flags.           */
+#include "NBT/NS/Message.h"   /* nbt_nsParseMsg().                  */
+#include "NBT/NS/Builder.h"   /* Reply construction.                */
+#include "cifs_pool.h"        /* Reply buffers.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  SRV_BUCKETS   - Hash buckets per shard.  Must be a power of two.  With
+ *                  64 shards, the table holds a million names with an
+ *                  average chain length of four.
+ *  SRV_MAXTTL    - Upper limit on the TTL of a name, in seconds.  Times
+ *                  are kept in milliseconds in 32 bits, and compared as
+ *                  signed differences, so this must stay below 24 days.
+ *  SRV_WACK_TTL  - The TTL, in seconds, sent in a WACK.  This must cover
+ *                  all of the challenge retries.
+ *  SRV_SOCKBUF   - Requested socket receive buffer size.
+ */
+
+#define SRV_BUCKETS   4096
+#define SRV_MAXTTL    (20 * 86400)
+#define SRV_WACK_TTL  ((nbt_nsSRV_CHAL_WAIT * nbt_nsSRV_CHAL_TRIES) / 1000 + 1)
+#define SRV_SOCKBUF   (4 * 1024 * 1024)
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  SrvChal   - A pending registration challenge.  Kept within the name
+ *              record that is being challenged.
+ *  SrvName   - A name record.  The L2 encoded name follows the record.
+ *  SrvShard  - One shard of the name table.
+ *  SrvWorker - State for one front-end thread.
+ */
+
+typedef struct SrvName SrvName;
+
+typedef struct
+  {
+  bool               active;      /* A challenge is in progress.        */
+  bool               multi;       /* Multi-homed registration.          */
+  int                tries;       /* Challenges left to send.           */
+  uint32_t           deadline;    /* When to give up on this try.       */
+  uint16_t           tid;         /* TID of the challenge query.        */
+  uint16_t           reqtid;      /* TID of the registration request.   */
+  uint16_t           reqflags;    /* Header flags of the request.       */
+  uint16_t           nbflags;     /* NB_FLAGS the requester wants.      */
+  uint32_t           ttl;         /* TTL to grant the requester.        */
+  uchar              addr[4];     /* Address the requester wants.       */
+  struct sockaddr_in requester;   /* Where to send the final answer.    */
+  SrvName           *next;        /* Next record with a challenge.      */
+  } SrvChal;
+
+struct SrvName
+  {
+  SrvName  *next;                       /* Hash chain.                  */
+  uint32_t  hash;                       /* Hash of the name.            */
+  uint32_t  expires;                    /* Expiry time, per Now().      */
+  uint16_t  nbflags;                    /* Group bit and owner type.    */
+  bool      multi;                      /* Registered as multi-homed.   */
+  uint8_t   naddr;                      /* Addresses in <addr>.         */
+  uint8_t   namelen;                    /* Length of <name>.            */
+  SrvChal   chal;                       /* Pending challenge, if any.   */
+  uchar     addr[nbt_nsSRV_MAXADDR][4]; /* Owner or member addresses.   */
+  uchar     name[];                     /* L2 encoded name.             */
+  };
+
+typedef struct
+  {
+  pthread_rwlock_t lock;
+  SrvName        **bucket;
+  SrvName         *chal;
+  unsigned long    count;
+  } SrvShard;
+
+struct nbt_nsServer
+  {
+  uint32_t          ttl;
+  int               stop;
+  uint32_t          lasttick;
+  uint16_t          chaltid;
+  unsigned int      sweep;
+  pthread_mutex_t   ticklock;
+  nbt_nsServerStats stats;
+  SrvShard          shard[nbt_nsSRV_SHARDS];
+  };
+
+typedef struct
+  {
+  nbt_nsServer    *srv;
+  int              sock;
+  pthread_t        thread;
+  nbt_nsTransport  xport;
+  nbt_nsServerOut  out;
+  } SrvWorker;
+
+
+/* -------------------------------------------------------------------------- **
+ * Macros:
+ *
+ *  Count( P )          - Bump a statistics counter.
+ *  AtomicLoad( P )     - Read a value that other threads may be writing.
+ *  AtomicLoadPtr( P )  - Same, for a pointer.
+ *  AtomicStore( P, V ) - Write a value that other threads may be reading.
+ *  Expired( R, N )     - True if record <R> has expired at time <N>.
+ *  SameAddr( A, B )    - True if the 4-byte addresses at <A> and <B> match.
+ */
+
+#if defined( cifs_ATOMICS )
+#define Count( P ) (void)__atomic_add_fetch( (P), 1, __ATOMIC_RELAXED )
+#define AtomicLoad( P )     __atomic_load_n( (P), __ATOMIC_RELAXED )
+#define AtomicLoadPtr( P )  __atomic_load_n( (P), __ATOMIC_RELAXED )
+#define AtomicStore( P, V ) __atomic_store_n( (P), (V), __ATOMIC_RELAXED )
+#else
+#define Count( P )          (void)(++(*(P)))
+#define AtomicLoad( P )     (*(P))
+#define AtomicLoadPtr( P )  (*(P))
+#define AtomicStore( P, V ) (void)(*(P) = (V))
+#endif
+
+#define Expired( R, N ) ((int32_t)((N) - (R)->expires) >= 0)
+#define SameAddr( A, B ) (0 == memcmp( (A), (B), 4 ))
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static uint32_t Now( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a millisecond clock.
+   *
+   *  Input:  none.
+   *  Output: Milliseconds since some arbitrary point, modulo 2^32.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000) );
+  } /* Now */
+
+
+static uint32_t Hash( const uchar *name, const int namelen )
+  /* ------------------------------------------------------------------------ **
+   * Hash an L2 encoded name (FNV-1a).
+   *
+   *  Input:  name    - The name.
+   *          namelen - Its length, in bytes.
+   *
+   *  Output: The hash.  The low bits select the shard, and the next bits
+   *          select the bucket within the shard.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t h = 2166136261u;
+  int      i;
+
+  for( i = 0; i < namelen; i++ )
+    h = (h ^ name[i]) * 16777619u;
+  return( h ^ (h >> 15) );
+  } /* Hash */
+
+
+static SrvName **Bucket( SrvShard *sh, const uint32_t hash )
+  /* ------------------------------------------------------------------------ **
+   * Return the hash chain for a name within its shard.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  return( &sh->bucket[(hash / nbt_nsSRV_SHARDS) & (SRV_BUCKETS - 1)] );
+  } /* Bucket */
+
+
+static SrvName *Find( SrvShard       *sh,
+                      const uint32_t  hash,
+                      const uchar    *name,
+                      const int       namelen )
+  /* ------------------------------------------------------------------------ **
+   * Look up a name record.
+   *
+   *  Input:  sh      - The shard, which must be locked (read or write).
+   *          hash    - Hash of the name.
+   *          name    - The L2 encoded name.
+   *          namelen - Its length.
+   *
+   *  Output: A pointer to the record, or NULL.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  SrvName *rec;
+
+  for( rec = *Bucket( sh, hash ); NULL != rec; rec = rec->next )
+    {
+    if( (hash == rec->hash)
+     && (namelen == rec->namelen)
+     && (0 == memcmp( name, rec->name, namelen )) )
+      return( rec );
+    }
+  return( NULL );
+  } /* Find */
+
+
+static SrvName *NewName( SrvShard       *sh,
+                         const uint32_t  hash,
+                         const uchar    *name,
+                         const int       namelen )
+  /* ------------------------------------------------------------------------ **
+   * Add an empty name record to a shard.
+   *
+   *  Input:  sh      - The shard, which must be write-locked.
+   *          hash    - Hash of the name.
+   *          name    - The L2 encoded name.
+   *          namelen - Its length.
+   *
+   *  Output: A pointer to the new record, or NULL if memory could not be
+   *          allocated.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  SrvName **bucket = Bucket( sh, hash );
+  SrvName  *rec;
+
+  rec = (SrvName *)calloc( 1, sizeof( SrvName ) + namelen );
+  if( NULL == rec )
+    return( NULL );
+  rec->hash    = hash;
+  rec->namelen = (uint8_t)namelen;
+  (void)memcpy( rec->name, name, namelen );
+  rec->next = *bucket;
+  *bucket   = rec;
+  sh->count++;
+  return( rec );
+  } /* NewName */
+
+
+static int HasAddr( const SrvName *rec, const uchar *addr )
+  /* ------------------------------------------------------------------------ **
+   * Find an address in a name record.
+   *
+   *  Output: The index of the address in <rec>->addr, or -1.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  for( i = 0; i < rec->naddr; i++ )
+    if( SameAddr( rec->addr[i], addr ) )
+      return( i );
+  return( -1 );
+  } /* HasAddr */
+
+
+static cifs_Block *NewOut( nbt_nsServerOut          *out,
+                           const struct sockaddr_in *to )
+  /* ------------------------------------------------------------------------ **
+   * Add a datagram to a reply queue.
+   *
+   *  Input:  out     - The reply queue.
+   *          to      - The destination.
+   *
+   *  Output: A pointer to the new block, or NULL if the queue is full or
+   *          no block could be had from the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_Block *b;
+
+  if( out->count >= nbt_nsSRV_OUTMAX )
+    return( NULL );
+  b = cifs_BlockPoolGet( cifs_poolNS_SIZE );
+  if( NULL == b )
+    return( NULL );
+  out->msg[out->count]  = b;
+  out->addr[out->count] = *to;
+  out->count++;
+  return( b );
+  } /* NewOut */
+
+
+static void Answer( nbt_nsServerOut          *out,
+                    const struct sockaddr_in *to,
+                    const uint16_t            tid,
+                    const uint16_t            flags,
+                    const uchar              *name,
+                    const int                 namelen,
+                    const uint32_t            ttl,
+                    const uchar              *rdata,
+                    const int                 rdata_len )
+  /* ------------------------------------------------------------------------ **
+   * Queue a response containing a single NB resource record.
+   *
+   *  Input:  out       - The reply queue.
+   *          to        - The destination.
+   *          tid       - The Transaction ID (copied from the request).
+   *          flags     - The complete header flags, including the opcode
+   *                      and RCODE.
+   *          name      - The L2 encoded RR_NAME.
+   *          namelen   - Its length.
+   *          ttl       - The TTL, in seconds.
+   *          rdata     - The RDATA.
+   *          rdata_len - Its length.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsBuilder bld[1];
+  cifs_Block   *b;
+
+  b = NewOut( out, to );
+  if( NULL == b )
+    return;
+
+  (void)nbt_nsBuildInit( bld, b, tid, flags );
+  (void)nbt_nsBuildRR( bld, nbt_nsANSREC, name, namelen,
+                       nbt_nsRRTYPE_NB, ttl, rdata, rdata_len );
+  (void)nbt_nsBuildEnd( bld );
+  } /* Answer */
+
+
+static void Challenge( nbt_nsServerOut *out, const SrvName *rec )
+  /* ------------------------------------------------------------------------ **
+   * Queue a challenge: a name query sent to the current owner of a name.
+   *
+   *  Input:  out - The reply queue.
+   *          rec - The name record.  The challenge must be active.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsBuilder      bld[1];
+  struct sockaddr_in to;
+  cifs_Block        *b;
+
+  (void)memset( &to, 0, sizeof( to ) );
+  to.sin_family = AF_INET;
+  to.sin_port   = htons( 137 );
+  (void)memcpy( &to.sin_addr.s_addr, rec->addr[0], 4 );
+
+  b = NewOut( out, &to );
+  if( NULL == b )
+    return;
+
+  (void)nbt_nsBuildInit( bld, b, rec->chal.tid, nbt_nsOPCODE_QUERY );
+  (void)nbt_nsBuildQuestion( bld, rec->name, rec->namelen, nbt_nsQTYPE_NB );
+  (void)nbt_nsBuildEnd( bld );
+  } /* Challenge */
+
+
+static void RegReply( nbt_nsServerOut          *out,
+                      const struct sockaddr_in *to,
+                      const uint16_t            tid,
+                      const uint16_t            reqflags,
+                      const uint16_t            rcode,
+                      const uchar              *name,
+                      const int                 namelen,
+                      const uint32_t            ttl,
+                      const uint16_t            nbflags,
+                      const uchar              *addr )
+  /* ------------------------------------------------------------------------ **
+   * Queue a positive or negative name registration response.
+   *
+   *  Notes:  Refresh and multi-homed registration requests get the same
+   *          response as a plain registration.  The RR echoes the NB_FLAGS
+   *          and address from the request.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar rdata[6];
+
+  nbt_SetShort( rdata, 0, nbflags );
+  (void)memcpy( &rdata[2], addr, 4 );
+  Answer( out, to, tid,
+          nbt_nsR_BIT | nbt_nsOPCODE_REGISTER | nbt_nsAA_BIT
+            | (reqflags & nbt_nsRD_BIT) | nbt_nsRA_BIT | rcode,
+          name, namelen, rcode ? 0 : ttl, rdata, 6 );
+  } /* RegReply */
+
+
+static void ChallengeDone( SrvName *rec, nbt_nsServerOut *out, bool granted )
+  /* ------------------------------------------------------------------------ **
+   * Finish a challenge, and answer the requester.
+   *
+   *  Input:  rec     - The name record.  Its shard must be write-locked,
+   *                    and it must already be off the challenge list.
+   *          out     - The reply queue.
+   *          granted - If true, the owner lost the name and the requester
+   *                    gets it.  If false, the owner kept it.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  SrvChal *c = &rec->chal;
+
+  c->active = false;
+  if( granted )
+    {
+    rec->naddr   = 1;
+    rec->nbflags = c->nbflags;
+    rec->multi   = c->multi;
+    rec->expires = Now() + (c->ttl * 1000);
+    (void)memcpy( rec->addr[0], c->addr, 4 );
+    }
+  RegReply( out, &c->requester, c->reqtid, c->reqflags,
+            granted ? nbt_nsRCODE_POS_RSP : nbt_nsRCODE_ACT_ERR,
+            rec->name, rec->namelen, c->ttl, c->nbflags, c->addr );
+  } /* ChallengeDone */
+
+
+static void Query( nbt_nsServer    *srv,
+                   nbt_nsDatagram  *dg,
+                   nbt_nsServerOut *out )
+  /* ------------------------------------------------------------------------ **
+   * Answer a name query request.
+   *
+   *  Notes:  Only NB queries are answered.  Anything else (a node status
+   *          query is the likely case) is for the node itself, not the
+   *          name server, so it is counted as dropped and ignored.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *msg   = &dg->msg;
+  uint16_t        flags = nbt_nsR_BIT | nbt_nsOPCODE_QUERY | nbt_nsAA_BIT
+                        | (msg->flags & nbt_nsRD_BIT) | nbt_nsRA_BIT;
+  uchar           rdata[6 * nbt_nsSRV_MAXADDR];
+  int             rdata_len = 0;
+  uint32_t        ttl = 0;
+  uint32_t        hash;
+  uint32_t        now;
+  SrvShard       *sh;
+  SrvName        *rec;
+  int             i;
+
+  if( nbt_nsQTYPE_NB != msg->QR_type )
+    {
+    Count( &srv->stats.dropped );
+    return;
+    }
+
+  hash = Hash( msg->QR_name, msg->QR_name_len );
+  sh   = &srv->shard[hash % nbt_nsSRV_SHARDS];
+  now  = Now();
+
+  (void)pthread_rwlock_rdlock( &sh->lock );
+  rec = Find( sh, hash, msg->QR_name, msg->QR_name_len );
+  if( (NULL != rec) && !Expired( rec, now ) )
+    {
+    for( i = 0; i < rec->naddr; i++ )
+      {
+      nbt_SetShort( rdata, rdata_len, rec->nbflags );
+      (void)memcpy( &rdata[rdata_len + 2], rec->addr[i], 4 );
+      rdata_len += 6;
+      }
+    ttl = (rec->expires - now) / 1000;
+    }
+  (void)pthread_rwlock_unlock( &sh->lock );
+
+  if( rdata_len > 0 )
+    {
+    Count( &srv->stats.answered );
+    Answer( out, &dg->addr, msg->tid, flags,
+            msg->QR_name, msg->QR_name_len, ttl, rdata, rdata_len );
+    }
+  else
+    Answer( out, &dg->addr, msg->tid, flags | nbt_nsRCODE_NAM_ERR,
+            msg->QR_name, msg->QR_name_len, 0, NULL, 0 );
+  } /* Query */
+
+
+static void Register( nbt_nsServer    *srv,
+                      nbt_nsDatagram  *dg,
+                      nbt_nsServerOut *out,
+                      const bool       multi )
+  /* ------------------------------------------------------------------------ **
+   * Handle a registration, refresh, or multi-homed registration request.
+   *
+   *  Notes:  A refresh of a name that the server does not know about, or
+   *          that belongs to someone else, is handled exactly like a
+   *          registration.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *msg = &dg->msg;
+  uint16_t        rcode = nbt_nsRCODE_POS_RSP;
+  uint16_t        nbflags;
+  uchar          *addr;
+  uint32_t        ttl;
+  uint32_t        hash;
+  uint32_t        now;
+  bool            group;
+  SrvShard       *sh;
+  SrvName        *rec;
+
+  if( (msg->rdata_len < 6) || (NULL == msg->QR_name) )
+    {
+    Count( &srv->stats.dropped );
+    return;
+    }
+  nbflags = nbt_GetShort( msg->rdata, 0 );
+  addr    = &msg->rdata[2];
+  group   = (0 != (nbflags & nbt_nsGROUP_BIT));
+  ttl     = ((0 == msg->ttl) || (msg->ttl > srv->ttl)) ? srv->ttl : msg->ttl;
+
+  hash = Hash( msg->QR_name, msg->QR_name_len );
+  sh   = &srv->shard[hash % nbt_nsSRV_SHARDS];
+  now  = Now();
+
+  (void)pthread_rwlock_wrlock( &sh->lock );
+  rec = Find( sh, hash, msg->QR_name, msg->QR_name_len );
+  if( (NULL != rec) && rec->chal.active )
+    {
+    /* A challenge is already under way.  If this is the requester
+     * trying again, remind it to wait.  Anyone else is refused.
+     */
+    if( (rec->chal.reqtid == msg->tid)
+     && (rec->chal.requester.sin_addr.s_addr == dg->addr.sin_addr.s_addr)
+     && (rec->chal.requester.sin_port == dg->addr.sin_port) )
+      {
+      uchar rdata[2];
+
+      nbt_SetShort( rdata, 0, msg->flags );
+      Answer( out, &dg->addr, msg->tid,
+              nbt_nsR_BIT | nbt_nsOPCODE_WACK | nbt_nsAA_BIT,
+              rec->name, rec->namelen, SRV_WACK_TTL, rdata, 2 );
+      (void)pthread_rwlock_unlock( &sh->lock );
+      return;
+      }
+    rcode = nbt_nsRCODE_ACT_ERR;
+    }
+  else
+    {
+    if( NULL == rec )
+      rec = NewName( sh, hash, msg->QR_name, msg->QR_name_len );
+    else
+      if( Expired( rec, now ) )
+        rec->naddr = 0;
+
+    if( NULL == rec )
+      rcode = nbt_nsRCODE_SRV_ERR;
+    else if( 0 == rec->naddr )
+      {
+      /* New, expired, or released name. */
+      rec->naddr   = 1;
+      rec->nbflags = nbflags;
+      rec->multi   = multi;
+      rec->expires = now + (ttl * 1000);
+      (void)memcpy( rec->addr[0], addr, 4 );
+      }
+    else if( group != (0 != (rec->nbflags & nbt_nsGROUP_BIT)) )
+      {
+      /* Unique vs. group.  No contest. */
+      rcode = nbt_nsRCODE_ACT_ERR;
+      }
+    else if( HasAddr( rec, addr ) >= 0 )
+      {
+      /* Re-registration or refresh by an owner or member. */
+      rec->expires = now + (ttl * 1000);
+      }
+    else if( group || (multi && rec->multi) )
+      {
+      /* Another group member, or another address of a multi-homed
+       * host.
+       */
+      if( rec->naddr < nbt_nsSRV_MAXADDR )
+        {
+        (void)memcpy( rec->addr[rec->naddr++], addr, 4 );
+        rec->expires = now + (ttl * 1000);
+        }
+      else
+        rcode = nbt_nsRCODE_RFS_ERR;
+      }
+    else
+      {
+      /* Someone else owns the name.  Challenge them. */
+      SrvChal *c = &rec->chal;
+      uchar    rdata[2];
+
+      c->active    = true;
+      c->multi     = multi;
+      c->tries     = nbt_nsSRV_CHAL_TRIES;
+      c->deadline  = now + nbt_nsSRV_CHAL_WAIT;
+#if defined( cifs_ATOMICS )
+      c->tid       = __atomic_add_fetch( &srv->chaltid, 1, __ATOMIC_RELAXED );
+#else
+      c->tid       = ++srv->chaltid;
+#endif
+      c->reqtid    = msg->tid;
+      c->reqflags  = msg->flags;
+      c->nbflags   = nbflags;
+      c->ttl       = ttl;
+      c->requester = dg->addr;
+      (void)memcpy( c->addr, addr, 4 );
+      c->next      = sh->chal;
+      sh->chal     = rec;
+      Count( &srv->stats.conflicts );
+
+      nbt_SetShort( rdata, 0, msg->flags );
+      Answer( out, &dg->addr, msg->tid,
+              nbt_nsR_BIT | nbt_nsOPCODE_WACK | nbt_nsAA_BIT,
+              rec->name, rec->namelen, SRV_WACK_TTL, rdata, 2 );
+      Challenge( out, rec );
+      (void)pthread_rwlock_unlock( &sh->lock );
+      return;
+      }
+    }
+  (void)pthread_rwlock_unlock( &sh->lock );
+
+  RegReply( out, &dg->addr, msg->tid, msg->flags, rcode,
+            msg->QR_name, msg->QR_name_len, ttl, nbflags, addr );
+  } /* Register */
+
+
+static void Release( nbt_nsServer    *srv,
+                     nbt_nsDatagram  *dg,
+                     nbt_nsServerOut *out )
+  /* ------------------------------------------------------------------------ **
+   * Handle a name release request.
+   *
+   *  Notes:  The address in the request is removed from the name.  When
+   *          the last address goes, the name is marked as expired and is
+   *          swept out later.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *msg = &dg->msg;
+  uint16_t        rcode = nbt_nsRCODE_POS_RSP;
+  uint32_t        hash;
+  SrvShard       *sh;
+  SrvName        *rec;
+  int             i;
+
+  if( (msg->rdata_len < 6) || (NULL == msg->QR_name) )
+    {
+    Count( &srv->stats.dropped );
+    return;
+    }
+
+  hash = Hash( msg->QR_name, msg->QR_name_len );
+  sh   = &srv->shard[hash % nbt_nsSRV_SHARDS];
+
+  (void)pthread_rwlock_wrlock( &sh->lock );
+  rec = Find( sh, hash, msg->QR_name, msg->QR_name_len );
+  if( (NULL == rec) || (0 == rec->naddr) )
+    rcode = nbt_nsRCODE_NAM_ERR;
+  else if( rec->chal.active
+        || ((i = HasAddr( rec, &msg->rdata[2] )) < 0) )
+    rcode = nbt_nsRCODE_ACT_ERR;
+  else
+    {
+    rec->naddr--;
+    (void)memmove( rec->addr[i], rec->addr[i + 1], (rec->naddr - i) * 4 );
+    if( 0 == rec->naddr )
+      rec->expires = Now();
+    }
+  (void)pthread_rwlock_unlock( &sh->lock );
+
+  Answer( out, &dg->addr, msg->tid,
+          nbt_nsR_BIT | nbt_nsOPCODE_RELEASE | nbt_nsAA_BIT | rcode,
+          msg->QR_name, msg->QR_name_len, 0, msg->rdata, 6 );
+  } /* Release */
+
+
+static void ChallengeReply( nbt_nsServer    *srv,
+                            nbt_nsDatagram  *dg,
+                            nbt_nsServerOut *out,
+                            const bool       positive )
+  /* ------------------------------------------------------------------------ **
+   * Handle the owner's answer to a challenge.
+   *
+   *  Notes:  The answer must carry the challenge TID and come from the
+   *          owner's address.  Anything else is dropped.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *msg = &dg->msg;
+  uint32_t        hash;
+  SrvShard       *sh;
+  SrvName        *rec;
+  SrvName       **pp;
+
+  hash = Hash( msg->RR_name, msg->RR_name_len );
+  sh   = &srv->shard[hash % nbt_nsSRV_SHARDS];
+
+  (void)pthread_rwlock_wrlock( &sh->lock );
+  rec = Find( sh, hash, msg->RR_name, msg->RR_name_len );
+  if( (NULL == rec)
+   || !rec->chal.active
+   || (rec->chal.tid != msg->tid)
+   || !SameAddr( &dg->addr.sin_addr.s_addr, rec->addr[0] ) )
+    {
+    (void)pthread_rwlock_unlock( &sh->lock );
+    Count( &srv->stats.dropped );
+    return;
+    }
+
+  for( pp = &sh->chal; *pp != rec; pp = &(*pp)->chal.next )
+    ;
+  *pp = rec->chal.next;
+  ChallengeDone( rec, out, !positive );
+  (void)pthread_rwlock_unlock( &sh->lock );
+  } /* ChallengeReply */
+
+
+static int OpenSocket( const struct sockaddr_in *addr )
+  /* ------------------------------------------------------------------------ **
+   * Open and bind a front-end socket.
+   *
+   *  Input:  addr  - The address to bind to.
+   *
+   *  Output: The socket, or -1 on error.
+   *
+   *  Notes:  SO_REUSEPORT is set where available, so that each worker can
+   *          bind its own socket to the same address.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int sock;
+  int on  = 1;
+  int buf = SRV_SOCKBUF;
+  int err;
+
+  sock = socket( AF_INET, SOCK_DGRAM, 0 );
+  if( sock < 0 )
+    return( -1 );
+  (void)setsockopt( sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof( on ) );
+#if defined( SO_REUSEPORT )
+  (void)setsockopt( sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof( on ) );
+#endif
+  (void)setsockopt( sock, SOL_SOCKET, SO_RCVBUF, &buf, sizeof( buf ) );
+  if( bind( sock, (const struct sockaddr *)addr, sizeof( *addr ) ) < 0 )
+    {
+    err = errno;
+    (void)close( sock );
+    errno = err;
+    return( -1 );
+    }
+  return( sock );
+  } /* OpenSocket */
+
+
+static void *Worker( void *arg )
+  /* ------------------------------------------------------------------------ **
+   * Front-end thread.
+   *
+   *  Input:  arg - A pointer to this thread's SrvWorker.
+   *
+   *  Output: NULL.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  SrvWorker      *w   = (SrvWorker *)arg;
+  nbt_nsServer   *srv = w->srv;
+  nbt_nsDatagram *dg;
+
+  (void)nbt_nsTransportInit( &w->xport, w->sock );
+  while( !AtomicLoad( &srv->stop ) )
+    {
+    (void)nbt_nsTransportRecv( &w->xport, nbt_nsSRV_TICK );
+    while( NULL != (dg = nbt_nsTransportNext( &w->xport )) )
+      {
+      if( w->out.count > (nbt_nsSRV_OUTMAX - 2) )
+        (void)nbt_nsServerFlush( &w->out, &w->xport );
+      (void)nbt_nsServerHandle( srv, dg, &w->out );
+      nbt_nsTransportRelease( &w->xport );
+      }
+    (void)nbt_nsServerFlush( &w->out, &w->xport );
+    nbt_nsServerTick( srv, &w->out );
+    (void)nbt_nsServerFlush( &w->out, &w->xport );
+    }
+  nbt_nsTransportFree( &w->xport );
+  return( NULL );
+  } /* Worker */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsServer *nbt_nsServerNew( const uint32_t ttl )
+  /* ------------------------------------------------------------------------ **
+   * Create a name server engine.
+   *
+   *  Input:  ttl - The TTL, in seconds, granted to registered names.  A
+   *                client may ask for a shorter TTL, but not a longer one.
+   *                Zero selects nbt_nsSRV_DEFAULT_TTL.
+   *
+   *  Output: A pointer to the new server, or NULL if memory could not be
+   *          allocated.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsServer *srv;
+  int           i;
+
+  srv = (nbt_nsServer *)calloc( 1, sizeof( nbt_nsServer ) );
+  if( NULL == srv )
+    return( NULL );
+
+  for( i = 0; i < nbt_nsSRV_SHARDS; i++ )
+    {
+    srv->shard[i].bucket = (SrvName **)calloc( SRV_BUCKETS,
+                                               sizeof( SrvName * ) );
+    if( NULL == srv->shard[i].bucket )
+      {
+      while( --i >= 0 )
+        {
+        free( srv->shard[i].bucket );
+        (void)pthread_rwlock_destroy( &srv->shard[i].lock );
+        }
+      free( srv );
+      return( NULL );
+      }
+    (void)pthread_rwlock_init( &srv->shard[i].lock, NULL );
+    }
+  (void)pthread_mutex_init( &srv->ticklock, NULL );
+
+  srv->ttl = (0 == ttl) ? nbt_nsSRV_DEFAULT_TTL : ttl;
+  if( srv->ttl > SRV_MAXTTL )
+    srv->ttl = SRV_MAXTTL;
+  srv->chaltid = (uint16_t)Now();
+  return( srv );
+  } /* nbt_nsServerNew */
+
+
+void nbt_nsServerFree( nbt_nsServer *srv )
+  /* ------------------------------------------------------------------------ **
+   * Destroy a name server engine.
+   *
+   *  Input:  srv - A pointer to the server.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The server must not be running.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  SrvName *rec;
+  SrvName *next;
+  int      i;
+  int      j;
+
+  if( NULL == srv )
+    return;
+  for( i = 0; i < nbt_nsSRV_SHARDS; i++ )
+    {
+    for( j = 0; j < SRV_BUCKETS; j++ )
+      {
+      for( rec = srv->shard[i].bucket[j]; NULL != rec; rec = next )
+        {
+        next = rec->next;
+        free( rec );
+        }
+      }
+    free( srv->shard[i].bucket );
+    (void)pthread_rwlock_destroy( &srv->shard[i].lock );
+    }
+  (void)pthread_mutex_destroy( &srv->ticklock );
+  free( srv );
+  } /* nbt_nsServerFree */
+
+
+int nbt_nsServerHandle( nbt_nsServer    *srv,
+                        nbt_nsDatagram  *dg,
+                        nbt_nsServerOut *out )
+  /* ------------------------------------------------------------------------ **
+   * Process one received datagram.
+   *
+   *  Input:  srv - A pointer to the server.
+   *          dg  - The received datagram.  Its message is parsed in place.
+   *          out - Reply datagrams are added to this queue.
+   *
+   *  Output: The number of reply datagrams queued (possibly zero).
+   *
+   *  Notes:  Requests that the server does not handle (eg., node status
+   *          queries) and malformed messages are dropped, and counted.
+   *
+   *          Up to two datagrams may be queued per call (a WACK and a
+   *          challenge).  If <out> does not have room for them, they are
+   *          dropped.  Flush <out> with <nbt_nsServerFlush()> before it
+   *          gets within two of nbt_nsSRV_OUTMAX.
+   *
+   *          This function may be called by several threads at once, as
+   *          long as each has its own <out>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int start = out->count;
+  int type;
+
+  type = nbt_nsParseMsg( &dg->msg );
+  if( (type > 0) && (dg->msg.flags & nbt_nsB_BIT) )
+    type = 0;
+
+  switch( type )
+    {
+    case nbt_nsNAME_QUERY_REQST:
+      Count( &srv->stats.queries );
+      Query( srv, dg, out );
+      break;
+    case nbt_nsNAME_REG_REQST:
+    case nbt_nsNAME_OVERWRITE_DEMAND:
+      /* The parser tells these apart by the RD bit.  Both are simply
+       * registration requests when they arrive by unicast.
+       */
+      Count( &srv->stats.registrations );
+      Register( srv, dg, out, false );
+      break;
+    case nbt_nsMULTI_REG_REQST:
+      Count( &srv->stats.registrations );
+      Register( srv, dg, out, true );
+      break;
+    case nbt_nsNAME_REFRESH_REQST:
+      Count( &srv->stats.refreshes );
+      Register( srv, dg, out, false );
+      break;
+    case nbt_nsNAME_RELEASE_REQST:
+      Count( &srv->stats.releases );
+      Release( srv, dg, out );
+      break;
+    case nbt_nsNAME_QUERY_REPLY_POS:
+    case nbt_nsNAME_QUERY_REPLY_NEG:
+      ChallengeReply( srv, dg, out, nbt_nsNAME_QUERY_REPLY_POS == type );
+      break;
+    default:
+      Count( &srv->stats.dropped );
+      break;
+    }
+  return( out->count - start );
+  } /* nbt_nsServerHandle */
+
+
+void nbt_nsServerTick( nbt_nsServer *srv, nbt_nsServerOut *out )
+  /* ------------------------------------------------------------------------ **
+   * Handle timeouts.
+   *
+   *  Input:  srv - A pointer to the server.
+   *          out - Challenge retries and registration replies are added to
+   *                this queue.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Call this every nbt_nsSRV_TICK milliseconds or so.  It is
+   *          cheap to call more often; if the last run was less than a
+   *          tick ago, or another thread is already running it, it
+   *          returns at once.
+   *
+   *          Each run retries or resolves any challenges whose time is
+   *          up, and sweeps expired names out of one shard.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t  now = Now();
+  SrvShard *sh;
+  SrvName **pp;
+  SrvName  *rec;
+  int       i;
+
+  if( (int32_t)(now - AtomicLoad( &srv->lasttick )) < nbt_nsSRV_TICK )
+    return;
+  if( 0 != pthread_mutex_trylock( &srv->ticklock ) )
+    return;
+  AtomicStore( &srv->lasttick, now );
+
+  /* Challenges. */
+  for( i = 0; i < nbt_nsSRV_SHARDS; i++ )
+    {
+    sh = &srv->shard[i];
+    if( NULL == AtomicLoadPtr( &sh->chal ) )
+      continue;
+    (void)pthread_rwlock_wrlock( &sh->lock );
+    pp = &sh->chal;
+    while( NULL != (rec = *pp) )
+      {
+      if( (int32_t)(now - rec->chal.deadline) < 0 )
+        {
+        pp = &rec->chal.next;
+        continue;
+        }
+      if( --rec->chal.tries > 0 )
+        {
+        rec->chal.deadline = now + nbt_nsSRV_CHAL_WAIT;
+        Challenge( out, rec );
+        pp = &rec->chal.next;
+        continue;
+        }
+      /* The owner never answered.  The requester gets the name. */
+      *pp = rec->chal.next;
+      Count( &srv->stats.takeovers );
+      ChallengeDone( rec, out, true );
+      }
+    (void)pthread_rwlock_unlock( &sh->lock );
+    }
+
+  /* Sweep one shard. */
+  sh = &srv->shard[srv->sweep++ % nbt_nsSRV_SHARDS];
+  (void)pthread_rwlock_wrlock( &sh->lock );
+  for( i = 0; i < SRV_BUCKETS; i++ )
+    {
+    pp = &sh->bucket[i];
+    while( NULL != (rec = *pp) )
+      {
+      if( !rec->chal.active && ((int32_t)(now - rec->expires) >= 0) )
+        {
+        *pp = rec->next;
+        free( rec );
+        sh->count--;
+        }
+      else
+        pp = &rec->next;
+      }
+    }
+  (void)pthread_rwlock_unlock( &sh->lock );
+
+  (void)pthread_mutex_unlock( &srv->ticklock );
+  } /* nbt_nsServerTick */
+
+
+int nbt_nsServerFlush( nbt_nsServerOut *out, nbt_nsTransport *xport )
+  /* ------------------------------------------------------------------------ **
+   * Send the queued replies, and empty the queue.
+   *
+   *  Input:  out   - The reply queue.
+   *          xport - The transport to send them with.
+   *
+   *  Output: The number of datagrams sent, or -1 on error.
+   *
+   *  Notes:  Datagrams that could not be sent are dropped.  Either way,
+   *          the blocks are returned to the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int sent = 0;
+  int i;
+
+  if( out->count > 0 )
+    sent = nbt_nsTransportSend( xport, out->msg, out->addr, out->count );
+  for( i = 0; i < out->count; i++ )
+    cifs_BlockPoolPut( out->msg[i] );
+  out->count = 0;
+  return( sent );
+  } /* nbt_nsServerFlush */
+
+
+int nbt_nsServerRun( nbt_nsServer             *srv,
+                     const struct sockaddr_in *addr,
+                     const int                 threads )
+  /* ------------------------------------------------------------------------ **
+   * Run the multi-threaded UDP front-end.
+   *
+   *  Input:  srv     - A pointer to the server.
+   *          addr    - The address and port to listen on (normally
+   *                    INADDR_ANY, port 137).
+   *          threads - The number of worker threads.
+   *
+   *  Output: Zero after <nbt_nsServerStop()> is called, or -1 if the
+   *          front-end could not be started, in which case <errno>
+   *          describes the problem.
+   *
+   *  Notes:  This function does not return until the server is stopped.
+   *
+   *          Each worker receives and sends in batches using the NS
+   *          transport module, and takes its turn calling
+   *          <nbt_nsServerTick()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  SrvWorker *w;
+  int        n = (threads < 1) ? 1 : threads;
+  int        shared = -1;
+  int        err = 0;
+  int        i;
+
+  w = (SrvWorker *)calloc( n, sizeof( SrvWorker ) );
+  if( NULL == w )
+    return( -1 );
+
+  AtomicStore( &srv->stop, 0 );
+  for( i = 0; i < n; i++ )
+    {
+    w[i].srv = srv;
+#if defined( SO_REUSEPORT )
+    w[i].sock = OpenSocket( addr );
+#else
+    if( shared < 0 )
+      shared = OpenSocket( addr );
+    w[i].sock = shared;
+#endif
+    if( w[i].sock < 0 )
+      {
+      err = errno;
+      break;
+      }
+    if( 0 != pthread_create( &w[i].thread, NULL, Worker, &w[i] ) )
+      {
+      err = EAGAIN;
+      if( w[i].sock != shared )
+        (void)close( w[i].sock );
+      break;
+      }
+    }
+
+  /* If any worker failed to start, stop the rest. */
+  if( i < n )
+    AtomicStore( &srv->stop, 1 );
+  n = i;
+  for( i = 0; i < n; i++ )
+    {
+    (void)pthread_join( w[i].thread, NULL );
+    if( w[i].sock != shared )
+      (void)close( w[i].sock );
+    }
+  if( shared >= 0 )
+    (void)close( shared );
+  free( w );
+
+  if( 0 != err )
+    {
+    errno = err;
+    return( -1 );
+    }
+  return( 0 );
+  } /* nbt_nsServerRun */
+
+
+void nbt_nsServerStop( nbt_nsServer *srv )
+  /* ------------------------------------------------------------------------ **
+   * Ask the front-end to stop.
+   *
+   *  Input:  srv - A pointer to the server.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This may be called from any thread, or from a signal
+   *          handler.  The workers notice within nbt_nsSRV_TICK
+   *          milliseconds, and <nbt_nsServerRun()> then returns.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  AtomicStore( &srv->stop, 1 );
+  } /* nbt_nsServerStop */
+
+
+nbt_nsServerStats *nbt_nsServerGetStats( nbt_nsServer      *srv,
+                                         nbt_nsServerStats *stats )
+  /* ------------------------------------------------------------------------ **
+   * Return the server counters.
+   *
+   *  Input:  srv   - A pointer to the server.
+   *          stats - A pointer to a structure to receive the counters.
+   *
+   *  Output: A pointer to the filled-in statistics (same as <stats>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  stats->queries       = AtomicLoad( &srv->stats.queries );
+  stats->answered      = AtomicLoad( &srv->stats.answered );
+  stats->registrations = AtomicLoad( &srv->stats.registrations );
+  stats->refreshes     = AtomicLoad( &srv->stats.refreshes );
+  stats->releases      = AtomicLoad( &srv->stats.releases );
+  stats->conflicts     = AtomicLoad( &srv->stats.conflicts );
+  stats->takeovers     = AtomicLoad( &srv->stats.takeovers );
+  stats->dropped       = AtomicLoad( &srv->stats.dropped );
+  stats->names         = 0;
+  for( i = 0; i < nbt_nsSRV_SHARDS; i++ )
+    stats->names += AtomicLoad( &srv->shard[i].count );
+  return( stats );
+  } /* nbt_nsServerGetStats */
+
+/* ========================================================================== */
@@ -0,0 +1,306 @@
+#ifndef NBT_NS_SERVER_H
+#define NBT_NS_SERVER_H
+/* ========================================================================== **
+ *
+ *                                  Server.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NBT Name Server (NBNS) engine.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  This module implements the name server side of the NBT Name Service,
+ *  as described in RFC 1001 and RFC 1002, for point-to-point (P, M, and
+ *  H mode) clients.  It answers name queries, and handles registration,
+ *  refresh, release, and multi-homed registration requests.
+ *
+ *  The engine and the network front-end are separate.  The engine,
+ *  <nbt_nsServerHandle()>, takes one received datagram and queues zero
+ *  or more reply datagrams in an nbt_nsServerOut structure.  It knows
+ *  nothing about sockets, so it can be driven by any event loop.  The
+ *  front-end, <nbt_nsServerRun()>, is a ready-made multi-threaded UDP
+ *  loop.  Each thread has its own socket bound with SO_REUSEPORT, so the
+ *  kernel spreads incoming queries across the threads.  Where
+ *  SO_REUSEPORT is not available, the threads share a single socket.
+ *
+ *  The name table is split into nbt_nsSRV_SHARDS shards, each with its
+ *  own hash table and read/write lock.  Queries take a read lock, so
+ *  they run in parallel even within a shard.  Registrations and releases
+ *  take a write lock on one shard only.
+ *
+ *  Registration conflicts are handled as described in RFC 1002, section
+ *  5.1.4.  If a unique name is already owned by another node, the server
+ *  sends the requester a WAIT FOR ACKNOWLEDGEMENT (WACK) response and
+ *  challenges the current owner with a name query.  If the owner says
+ *  that it still has the name, the registration is refused.  If the
+ *  owner denies it, or fails to answer after nbt_nsSRV_CHAL_TRIES
+ *  tries, the name is given to the requester.  Challenge timeouts are
+ *  processed by <nbt_nsServerTick()>.
+ *
+ *  Group names may have up to nbt_nsSRV_MAXADDR members, which is the
+ *  limit that Windows applies to internet group (<1C>) names.  Queries
+ *  for a group name return the member list.
+ *
+ *  Names are held until their TTL runs out.  Expired names are treated
+ *  as absent, and are swept out of the table a shard at a time by
+ *  <nbt_nsServerTick()>.
+ *
+ *  Broadcast (B bit) requests are ignored.  Those are for the local
+ *  nodes to sort out among themselves.
+ *
+ * ========================================================================== **
+ */
+
+#include <netinet/in.h>       /* struct sockaddr_in.                */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/NS/Transport.h" /* Batched send and receive.          */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_nsSRV_SHARDS      - The number of shards in the name table.
+ *  nbt_nsSRV_MAXADDR     - The most addresses that one name may have (group
+ *                          members, or the addresses of a multi-homed host).
+ *  nbt_nsSRV_DEFAULT_TTL - The default TTL granted to registered names, in
+ *                          seconds.  Six days, as used by WINS.
+ *  nbt_nsSRV_TICK        - How often, in milliseconds, timeouts need to be
+ *                          processed.
+ *  nbt_nsSRV_CHAL_WAIT   - How long, in milliseconds, to wait for the owner
+ *                          of a name to answer a challenge.
+ *  nbt_nsSRV_CHAL_TRIES  - How many times to challenge the owner before
+ *                          giving up on it.
+ *  nbt_nsSRV_OUTMAX      - The size of a reply queue.
+ */
+
+#define nbt_nsSRV_SHARDS      64
+#define nbt_nsSRV_MAXADDR     25
+#define nbt_nsSRV_DEFAULT_TTL 518400
+#define nbt_nsSRV_TICK        100
+#define nbt_nsSRV_CHAL_WAIT   500
+#define nbt_nsSRV_CHAL_TRIES  3
+#define nbt_nsSRV_OUTMAX      (2 * nbt_nsRING_SIZE)
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_nsServer      - A name server engine.  Opaque.
+ *
+ *  nbt_nsServerOut   - A queue of reply datagrams.  Each block comes from
+ *                      the block pool.  The layout matches the arguments
+ *                      to <nbt_nsTransportSend()>.
+ *
+ *  nbt_nsServerStats - Server counters, as returned by
+ *                      <nbt_nsServerGetStats()>.
+ */
+
+typedef struct nbt_nsServer nbt_nsServer;
+
+typedef struct
+  {
+  int                count;
+  cifs_Block        *msg[nbt_nsSRV_OUTMAX];
+  struct sockaddr_in addr[nbt_nsSRV_OUTMAX];
+  } nbt_nsServerOut;
+
+typedef struct
+  {
+  unsigned long queries;        /* Name queries received.                 */
+  unsigned long answered;       /* Positive name query responses sent.    */
+  unsigned long registrations;  /* Registration requests received.        */
+  unsigned long refreshes;      /* Refresh requests received.             */
+  unsigned long releases;       /* Release requests received.             */
+  unsigned long conflicts;      /* Registrations that led to a challenge. */
+  unsigned long takeovers;      /* Challenges the owner failed to answer. */
+  unsigned long dropped;        /* Messages ignored.                      */
+  unsigned long names;          /* Names in the table (including expired
+                                 * names that have not been swept yet).   */
+  } nbt_nsServerStats;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsServer *nbt_nsServerNew( const uint32_t ttl );
+  /* ------------------------------------------------------------------------ **
+   * Create a name server engine.
+   *
+   *  Input:  ttl - The TTL, in seconds, granted to registered names.  A
+   *                client may ask for a shorter TTL, but not a longer one.
+   *                Zero selects nbt_nsSRV_DEFAULT_TTL.
+   *
+   *  Output: A pointer to the new server, or NULL if memory could not be
+   *          allocated.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsServerFree( nbt_nsServer *srv );
+  /* ------------------------------------------------------------------------ **
+   * Destroy a name server engine.
+   *
+   *  Input:  srv - A pointer to the server.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The server must not be running.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsServerHandle( nbt_nsServer    *srv,
+                        nbt_nsDatagram  *dg,
+                        nbt_nsServerOut *out );
+  /* ------------------------------------------------------------------------ **
+   * Process one received datagram.
+   *
+   *  Input:  srv - A pointer to the server.
+   *          dg  - The received datagram.  Its message is parsed in place.
+   *          out - Reply datagrams are added to this queue.
+   *
+   *  Output: The number of reply datagrams queued (possibly zero).
+   *
+   *  Notes:  Requests that the server does not handle (eg., node status
+   *          queries) and malformed messages are dropped, and counted.
+   *
+   *          Up to two datagrams may be queued per call (a WACK and a
+   *          challenge).  If <out> does not have room for them, they are
+   *          dropped.  Flush <out> with <nbt_nsServerFlush()> before it
+   *          gets within two of nbt_nsSRV_OUTMAX.
+   *
+   *          This function may be called by several threads at once, as
+   *          long as each has its own <out>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsServerTick( nbt_nsServer *srv, nbt_nsServerOut *out );
+  /* ------------------------------------------------------------------------ **
+   * Handle timeouts.
+   *
+   *  Input:  srv - A pointer to the server.
+   *          out - Challenge retries and registration replies are added to
+   *                this queue.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Call this every nbt_nsSRV_TICK milliseconds or so.  It is
+   *          cheap to call more often; if the last run was less than a
+   *          tick ago, or another thread is already running it, it
+   *          returns at once.
+   *
+   *          Each run retries or resolves any challenges whose time is
+   *          up, and sweeps expired names out of one shard.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsServerFlush( nbt_nsServerOut *out, nbt_nsTransport *xport );
+  /* ------------------------------------------------------------------------ **
+   * Send the queued replies, and empty the queue.
+   *
+   *  Input:  out   - The reply queue.
+   *          xport - The transport to send them with.
+   *
+   *  Output: The number of datagrams sent, or -1 on error.
+   *
+   *  Notes:  Datagrams that could not be sent are dropped.  Either way,
+   *          the blocks are returned to the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsServerRun( nbt_nsServer             *srv,
+                     const struct sockaddr_in *addr,
+                     const int                 threads );
+  /* ------------------------------------------------------------------------ **
+   * Run the multi-threaded UDP front-end.
+   *
+   *  Input:  srv     - A pointer to the server.
+   *          addr    - The address and port to listen on (normally
+   *                    INADDR_ANY, port 137).
+   *          threads - The number of worker threads.
+   *
+   *  Output: Zero after <nbt_nsServerStop()> is called, or -1 if the
+   *          front-end could not be started, in which case <errno>
+   *          describes the problem.
+   *
+   *  Notes:  This function does not return until the server is stopped.
+   *
+   *          Each worker receives and sends in batches using the NS
+   *          transport module, and takes its turn calling
+   *          <nbt_nsServerTick()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsServerStop( nbt_nsServer *srv );
+  /* ------------------------------------------------------------------------ **
+   * Ask the front-end to stop.
+   *
+   *  Input:  srv - A pointer to the server.
+   *
+   *  Output: none.
+   *
+   *  Notes:  This may be called from any thread, or from a signal
+   *          handler.  The workers notice within nbt_nsSRV_TICK
+   *          milliseconds, and <nbt_nsServerRun()> then returns.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_nsServerStats *nbt_nsServerGetStats( nbt_nsServer      *srv,
+                                         nbt_nsServerStats *stats );
+  /* ------------------------------------------------------------------------ **
+   * Return the server counters.
+   *
+   *  Input:  srv   - A pointer to the server.
+   *          stats - A pointer to a structure to receive the counters.
+   *
+   *  Output: A pointer to the filled-in statistics (same as <stats>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_NS_SERVER_H */
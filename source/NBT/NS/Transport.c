@@ -0,0 +1,437 @@
+/* ========================================================================== **
+ *
+ *                                Transport.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Batched UDP transport for the NBT Name Service.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A wildcard or broadcast query can bring back hundreds of replies, and a
+ *  busy name server sees a steady stream of requests.  Reading them one
+ *  recvfrom(2) at a time, with a poll(2) in between, costs two system
+ *  calls per datagram.  This module reads as many waiting datagrams as it
+ *  can with a single recvmmsg(2) call, and sends batches of replies with
+ *  sendmmsg(2).  On systems without those calls it falls back to looping
+ *  over recvmsg(2) and sendto(2), with the same interface.
+ *
+ *  Received datagrams land in a ring of nbt_nsRING_SIZE slots.  Each slot
+ *  has an nbt_nsMsgBlock whose block header already describes the
+ *  received message, so it can be passed straight to nbt_nsParseMsg().
+ *  The buffers come from the block pool (see cifs_pool.h).  When a slot is
+ *  released the ring drops its reference to the buffer, so anything that
+ *  still holds a reference (eg., a slice created with cifs_BlockSliceInit()
+ *  from the slot's <bufr>) keeps the data alive, and the ring simply
+ *  gets a fresh buffer for the next receive.
+ *
+ *  The transport does not create or own the socket.  Open and bind it as
+ *  usual, then hand it to nbt_nsTransportInit().
+ *
+ * ========================================================================== **
+ */
+
+#if defined( __linux__ ) && !defined( _GNU_SOURCE )
+#define _GNU_SOURCE           /* For recvmmsg(2) and sendmmsg(2). */
+#endif
+
+#include <errno.h>            /* For errno.                       */
+#include <poll.h>             /* For poll(2).                     */
+
+#include "Transport.h"        /* Module header.                   */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  NS_MMSG - Defined if recvmmsg(2) and sendmmsg(2) are available.
+ *            MSG_WAITFORONE was added along with them, so its presence
+ *            is used as the test.
+ */
+
+#if defined( MSG_WAITFORONE )
+#define NS_MMSG 1
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static bool WouldBlock( void )
+  /* ------------------------------------------------------------------------ **
+   * Check whether the last socket error simply meant "nothing to read".
+   *
+   *  Input:  none.
+   *  Output: true if <errno> is EAGAIN or EWOULDBLOCK, else false.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  return( (EAGAIN == errno) || (EWOULDBLOCK == errno) );
+  } /* WouldBlock */
+
+
+static void SetMsg( nbt_nsDatagram *d, const long len )
+  /* ------------------------------------------------------------------------ **
+   * Set up the message block of a newly received datagram.
+   *
+   *  Input:  d   - The datagram slot.
+   *          len - The number of bytes received.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The parsed fields are cleared, so that a message that fails
+   *          to parse won't be confused with the previous occupant.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)memset( &d->msg, 0, sizeof( nbt_nsMsgBlock ) );
+  (void)cifs_BlockInit( &d->msg.block, d->bufr->size, d->bufr->bufr );
+  d->msg.block.used = len;
+  } /* SetMsg */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsTransport *nbt_nsTransportInit( nbt_nsTransport *t, const int sock )
+  /* ------------------------------------------------------------------------ **
+   * Initialize a transport.
+   *
+   *  Input:  t     - A pointer to the transport structure to be
+   *                  initialized.
+   *          sock  - An open, bound, UDP socket.
+   *
+   *  Output: A pointer to the initialized transport (same as <t>).
+   *
+   *  Notes:  No buffers are allocated until the first receive.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  t->sock      = sock;
+  t->head      = 0;
+  t->count     = 0;
+  t->truncated = 0;
+  for( i = 0; i < nbt_nsRING_SIZE; i++ )
+    t->ring[i].bufr = NULL;
+  return( t );
+  } /* nbt_nsTransportInit */
+
+
+int nbt_nsTransportRecv( nbt_nsTransport *t, const int timeout )
+  /* ------------------------------------------------------------------------ **
+   * Receive any waiting datagrams into the ring.
+   *
+   *  Input:  t       - A pointer to the transport.
+   *          timeout - The number of milliseconds to wait for something to
+   *                    arrive.  Zero means don't wait, and a negative value
+   *                    means wait forever (as with poll(2)).
+   *
+   *  Output: The number of datagrams added to the ring (possibly zero),
+   *          or -1 on error, in which case <errno> describes the problem.
+   *
+   *  Notes:  Datagrams are added until the socket has no more to give or
+   *          the ring is full.  Use <nbt_nsTransportNext()> to retrieve
+   *          them.
+   *
+   *          The block header of each received message is set up so that
+   *          msg.block.used is the datagram length.  The other fields of
+   *          the nbt_nsMsgBlock are left for nbt_nsParseMsg() to fill in.
+   *
+   *          A datagram that is too large for its buffer is dropped, and
+   *          counted in <t->truncated>, rather than being passed on with
+   *          its tail cut off.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int           slot[nbt_nsRING_SIZE];
+  int           avail = nbt_nsRING_SIZE - t->count;
+  int           n;
+  int           i;
+  int           got;
+  struct pollfd pfd[1];
+
+  if( avail < 1 )
+    return( 0 );
+
+  if( 0 != timeout )
+    {
+    pfd->fd     = t->sock;
+    pfd->events = POLLIN;
+    i = poll( pfd, 1, timeout );
+    if( i <= 0 )
+      return( i );
+    }
+
+  /* Make sure that each free slot has a buffer.
+   */
+  for( n = 0; n < avail; n++ )
+    {
+    slot[n] = (t->head + t->count + n) % nbt_nsRING_SIZE;
+    if( NULL == t->ring[slot[n]].bufr )
+      {
+      t->ring[slot[n]].bufr = cifs_BlockPoolGet( cifs_poolNS_SIZE );
+      if( NULL == t->ring[slot[n]].bufr )
+        break;
+      }
+    }
+  if( 0 == n )
+    {
+    errno = ENOMEM;
+    return( -1 );
+    }
+
+#if defined( NS_MMSG )
+  {
+  struct mmsghdr mh[nbt_nsRING_SIZE];
+  struct iovec   iov[nbt_nsRING_SIZE];
+
+  (void)memset( mh, 0, n * sizeof( struct mmsghdr ) );
+  for( i = 0; i < n; i++ )
+    {
+    nbt_nsDatagram *d = &t->ring[slot[i]];
+
+    iov[i].iov_base           = d->bufr->bufr;
+    iov[i].iov_len            = (size_t)d->bufr->size;
+    mh[i].msg_hdr.msg_iov     = &iov[i];
+    mh[i].msg_hdr.msg_iovlen  = 1;
+    mh[i].msg_hdr.msg_name    = &d->addr;
+    mh[i].msg_hdr.msg_namelen = sizeof( struct sockaddr_in );
+    }
+  n = recvmmsg( t->sock, mh, (unsigned int)n, MSG_DONTWAIT, NULL );
+  if( n < 0 )
+    return( WouldBlock() ? 0 : -1 );
+
+  /* Keep the datagrams that fit, closing up the gaps left by any that
+   * were truncated.
+   */
+  for( i = got = 0; i < n; i++ )
+    {
+    if( 0 != (mh[i].msg_hdr.msg_flags & MSG_TRUNC) )
+      {
+      t->truncated++;
+      continue;
+      }
+    if( got != i )
+      {
+      nbt_nsDatagram tmp = t->ring[slot[got]];
+
+      t->ring[slot[got]] = t->ring[slot[i]];
+      t->ring[slot[i]]   = tmp;
+      }
+    SetMsg( &t->ring[slot[got++]], (long)mh[i].msg_len );
+    }
+  }
+#else
+  for( i = got = 0; i < n; i++ )
+    {
+    nbt_nsDatagram *d = &t->ring[slot[got]];
+    struct msghdr   mh;
+    struct iovec    iov;
+    ssize_t         len;
+
+    (void)memset( &mh, 0, sizeof( struct msghdr ) );
+    iov.iov_base   = d->bufr->bufr;
+    iov.iov_len    = (size_t)d->bufr->size;
+    mh.msg_iov     = &iov;
+    mh.msg_iovlen  = 1;
+    mh.msg_name    = &d->addr;
+    mh.msg_namelen = sizeof( struct sockaddr_in );
+    len = recvmsg( t->sock, &mh, MSG_DONTWAIT );
+    if( len < 0 )
+      {
+      if( (got > 0) || WouldBlock() )
+        break;
+      return( -1 );
+      }
+    if( 0 != (mh.msg_flags & MSG_TRUNC) )
+      {
+      t->truncated++;
+      continue;
+      }
+    SetMsg( d, (long)len );
+    got++;
+    }
+#endif
+
+  t->count += got;
+  return( got );
+  } /* nbt_nsTransportRecv */
+
+
+nbt_nsDatagram *nbt_nsTransportNext( nbt_nsTransport *t )
+  /* ------------------------------------------------------------------------ **
+   * Return the oldest received datagram.
+   *
+   *  Input:  t - A pointer to the transport.
+   *
+   *  Output: A pointer to the oldest datagram in the ring, or NULL if the
+   *          ring is empty.
+   *
+   *  Notes:  The datagram stays in the ring until it is released with
+   *          <nbt_nsTransportRelease()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( t->count < 1 )
+    return( NULL );
+  return( &t->ring[t->head] );
+  } /* nbt_nsTransportNext */
+
+
+void nbt_nsTransportRelease( nbt_nsTransport *t )
+  /* ------------------------------------------------------------------------ **
+   * Release the oldest received datagram.
+   *
+   *  Input:  t - A pointer to the transport.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The ring's reference to the buffer is dropped.  If nothing
+   *          else holds a reference, the buffer goes back to the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( t->count < 1 )
+    return;
+
+  cifs_BlockPoolPut( t->ring[t->head].bufr );
+  t->ring[t->head].bufr = NULL;
+  t->head = (t->head + 1) % nbt_nsRING_SIZE;
+  t->count--;
+  } /* nbt_nsTransportRelease */
+
+
+int nbt_nsTransportSend( nbt_nsTransport          *t,
+                         cifs_Block               *msg[],
+                         const struct sockaddr_in  addr[],
+                         const int                 n )
+  /* ------------------------------------------------------------------------ **
+   * Send a batch of datagrams.
+   *
+   *  Input:  t     - A pointer to the transport.
+   *          msg   - An array of <n> blocks.  The used portion of each
+   *                  block is sent as one datagram.
+   *          addr  - An array of <n> destination addresses.
+   *          n     - The number of datagrams to send.
+   *
+   *  Output: The number of datagrams sent, or -1 if an error occurred
+   *          before any were sent, in which case <errno> describes the
+   *          problem.
+   *
+   *  Notes:  Datagrams are sent up to nbt_nsRING_SIZE at a time.  A short
+   *          count means that the socket stopped accepting datagrams
+   *          (eg., the send buffer is full); the remainder can be sent
+   *          again later.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int sent = 0;
+  int i;
+
+#if defined( NS_MMSG )
+  struct mmsghdr mh[nbt_nsRING_SIZE];
+  struct iovec   iov[nbt_nsRING_SIZE];
+  int            batch;
+  int            got;
+
+  while( sent < n )
+    {
+    batch = n - sent;
+    if( batch > nbt_nsRING_SIZE )
+      batch = nbt_nsRING_SIZE;
+    (void)memset( mh, 0, batch * sizeof( struct mmsghdr ) );
+    for( i = 0; i < batch; i++ )
+      {
+      iov[i].iov_base           = msg[sent + i]->bufr;
+      iov[i].iov_len            = (size_t)msg[sent + i]->used;
+      mh[i].msg_hdr.msg_iov     = &iov[i];
+      mh[i].msg_hdr.msg_iovlen  = 1;
+      mh[i].msg_hdr.msg_name    = (void *)&addr[sent + i];
+      mh[i].msg_hdr.msg_namelen = sizeof( struct sockaddr_in );
+      }
+    got = sendmmsg( t->sock, mh, (unsigned int)batch, 0 );
+    if( got < 0 )
+      return( (sent > 0) ? sent : -1 );
+    sent += got;
+    if( got < batch )
+      break;
+    }
+#else
+  for( i = 0; i < n; i++, sent++ )
+    {
+    if( sendto( t->sock, msg[i]->bufr, (size_t)msg[i]->used, 0,
+                (const struct sockaddr *)&addr[i],
+                sizeof( struct sockaddr_in ) ) < 0 )
+      return( (sent > 0) ? sent : -1 );
+    }
+#endif
+
+  return( sent );
+  } /* nbt_nsTransportSend */
+
+
+void nbt_nsTransportFree( nbt_nsTransport *t )
+  /* ------------------------------------------------------------------------ **
+   * Release all of the buffers held by a transport.
+   *
+   *  Input:  t - A pointer to the transport.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Any datagrams still in the ring are discarded.  The socket
+   *          is not closed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  for( i = 0; i < nbt_nsRING_SIZE; i++ )
+    {
+    cifs_BlockPoolPut( t->ring[i].bufr );
+    t->ring[i].bufr = NULL;
+    }
+  t->head  = 0;
+  t->count = 0;
+  } /* nbt_nsTransportFree */
+
+/* ========================================================================== */
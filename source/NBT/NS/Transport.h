@@ -0,0 +1,234 @@
+#ifndef NBT_NS_TRANSPORT_H
+#define NBT_NS_TRANSPORT_H
+/* ========================================================================== **
+ *
+ *                                Transport.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Batched UDP transport for the NBT Name Service.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A wildcard or broadcast query can bring back hundreds of replies, and a
+ *  busy name server sees a steady stream of requests.  Reading them one
+ *  recvfrom(2) at a time, with a poll(2) in between, costs two system
+ *  calls per datagram.  This module reads as many waiting datagrams as it
+ *  can with a single recvmmsg(2) call, and sends batches of replies with
+ *  sendmmsg(2).  On systems without those calls it falls back to looping
+ *  over recvmsg(2) and sendto(2), with the same interface.
+ *
+ *  Received datagrams land in a ring of nbt_nsRING_SIZE slots.  Each slot
+ *  has an nbt_nsMsgBlock whose block header already describes the
+ *  received message, so it can be passed straight to nbt_nsParseMsg().
+ *  The buffers come from the block pool (see cifs_pool.h).  When a slot is
+ *  released the ring drops its reference to the buffer, so anything that
+ *  still holds a reference (eg., a slice created with cifs_BlockSliceInit()
+ *  from the slot's <bufr>) keeps the data alive, and the ring simply
+ *  gets a fresh buffer for the next receive.
+ *
+ *  The transport does not create or own the socket.  Open and bind it as
+ *  usual, then hand it to nbt_nsTransportInit().
+ *
+ * ========================================================================== **
+ */
+
+#include <sys/socket.h>       /* Sockets.                           */
+#include <netinet/in.h>       /* struct sockaddr_in.                */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/NS/Message.h"   /* nbt_nsMsgBlock.                    */
+#include "cifs_pool.h"        /* Pooled receive buffers.            */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_nsRING_SIZE - The number of receive slots in a transport, which is
+ *                    also the largest number of datagrams handled by a
+ *                    single system call.
+ */
+
+#define nbt_nsRING_SIZE 64
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  nbt_nsDatagram  - One received datagram.
+ *                    msg   - The message, ready for nbt_nsParseMsg().
+ *                    addr  - The address of the sender.
+ *                    bufr  - The pooled block that holds the message.
+ *
+ *  nbt_nsTransport - A socket and its receive ring.
+ *                    truncated - Count of datagrams that were dropped
+ *                                because they did not fit in a buffer.
+ */
+
+typedef struct
+  {
+  nbt_nsMsgBlock     msg;
+  struct sockaddr_in addr;
+  cifs_Block        *bufr;
+  } nbt_nsDatagram;
+
+typedef struct
+  {
+  int            sock;
+  int            head;
+  int            count;
+  unsigned long  truncated;
+  nbt_nsDatagram ring[nbt_nsRING_SIZE];
+  } nbt_nsTransport;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+nbt_nsTransport *nbt_nsTransportInit( nbt_nsTransport *t, const int sock );
+  /* ------------------------------------------------------------------------ **
+   * Initialize a transport.
+   *
+   *  Input:  t     - A pointer to the transport structure to be
+   *                  initialized.
+   *          sock  - An open, bound, UDP socket.
+   *
+   *  Output: A pointer to the initialized transport (same as <t>).
+   *
+   *  Notes:  No buffers are allocated until the first receive.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsTransportRecv( nbt_nsTransport *t, const int timeout );
+  /* ------------------------------------------------------------------------ **
+   * Receive any waiting datagrams into the ring.
+   *
+   *  Input:  t       - A pointer to the transport.
+   *          timeout - The number of milliseconds to wait for something to
+   *                    arrive.  Zero means don't wait, and a negative value
+   *                    means wait forever (as with poll(2)).
+   *
+   *  Output: The number of datagrams added to the ring (possibly zero),
+   *          or -1 on error, in which case <errno> describes the problem.
+   *
+   *  Notes:  Datagrams are added until the socket has no more to give or
+   *          the ring is full.  Use <nbt_nsTransportNext()> to retrieve
+   *          them.
+   *
+   *          The block header of each received message is set up so that
+   *          msg.block.used is the datagram length.  The other fields of
+   *          the nbt_nsMsgBlock are left for nbt_nsParseMsg() to fill in.
+   *
+   *          A datagram that is too large for its buffer is dropped, and
+   *          counted in <t->truncated>, rather than being passed on with
+   *          its tail cut off.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+nbt_nsDatagram *nbt_nsTransportNext( nbt_nsTransport *t );
+  /* ------------------------------------------------------------------------ **
+   * Return the oldest received datagram.
+   *
+   *  Input:  t - A pointer to the transport.
+   *
+   *  Output: A pointer to the oldest datagram in the ring, or NULL if the
+   *          ring is empty.
+   *
+   *  Notes:  The datagram stays in the ring until it is released with
+   *          <nbt_nsTransportRelease()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsTransportRelease( nbt_nsTransport *t );
+  /* ------------------------------------------------------------------------ **
+   * Release the oldest received datagram.
+   *
+   *  Input:  t - A pointer to the transport.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The ring's reference to the buffer is dropped.  If nothing
+   *          else holds a reference, the buffer goes back to the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_nsTransportSend( nbt_nsTransport          *t,
+                         cifs_Block               *msg[],
+                         const struct sockaddr_in  addr[],
+                         const int                 n );
+  /* ------------------------------------------------------------------------ **
+   * Send a batch of datagrams.
+   *
+   *  Input:  t     - A pointer to the transport.
+   *          msg   - An array of <n> blocks.  The used portion of each
+   *                  block is sent as one datagram.
+   *          addr  - An array of <n> destination addresses.
+   *          n     - The number of datagrams to send.
+   *
+   *  Output: The number of datagrams sent, or -1 if an error occurred
+   *          before any were sent, in which case <errno> describes the
+   *          problem.
+   *
+   *  Notes:  Datagrams are sent up to nbt_nsRING_SIZE at a time.  A short
+   *          count means that the socket stopped accepting datagrams
+   *          (eg., the send buffer is full); the remainder can be sent
+   *          again later.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void nbt_nsTransportFree( nbt_nsTransport *t );
+  /* ------------------------------------------------------------------------ **
+   * Release all of the buffers held by a transport.
+   *
+   *  Input:  t - A pointer to the transport.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Any datagrams still in the ring are discarded.  The socket
+   *          is not closed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_NS_TRANSPORT_H */
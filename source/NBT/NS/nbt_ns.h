@@ -50,6 +50,12 @@
 
 #include "NBT/NS/Packet.h"
 #include "NBT/NS/Message.h"
+#include "NBT/NS/Builder.h"
+#include "NBT/NS/NodeStatus.h"
+#include "NBT/NS/Transport.h"
+#include "NBT/NS/Resolver.h"
+#include "NBT/NS/Cache.h"
+#include "NBT/NS/Server.h"
 
 /* ========================================================================== */
 #endif /* NBT_NS_H */
@@ -75,9 +75,14 @@
  */
 
 #include <ctype.h>      /* Need toupper() and isalnum() functions.  */
-#include <string.h>     /* We use strlen(). */
+#include <string.h>     /* We use strlen() and memcpy(). */
 #include "NBT/Names.h"  /* Module header.   */
 
+#if defined( cifs_LITTLE_ENDIAN ) && defined( __GNUC__ ) \
+ && (defined( __x86_64__ ) || defined( __i386__ ))
+#include <emmintrin.h>  /* SSE2 intrinsics. */
+#endif
+
 
 /* -------------------------------------------------------------------------- **
  * Macros:
@@ -103,6 +108,504 @@
 #define EncLoNibble( I ) ('A' + (uchar)((I) & 0x0F))
 
 
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  L1_SWAR - Defined if the host is little-endian, in which case the
+ *            64-bit SWAR ("SIMD within a register") coders are used when
+ *            SSE2 is not available.
+ *  L1_SSE2 - Defined if the compiler can build the SSE2 L1 coders.  They
+ *            are only used if the CPU supports SSE2 (which every x86_64
+ *            CPU does).
+ *
+ *  L1_REF    - Implementation codes returned by <L1Impl()>.
+ *  L1_SWAR64
+ *  L1_SSE2X
+ *
+ *  Ones( N ) - The byte <N> repeated in every byte of a 64-bit word.
+ *  Zeros( W )
+ *            - 0x80 in each byte of <W> that is zero, 0x00 in all others.
+ */
+
+#if defined( cifs_LITTLE_ENDIAN )
+#define L1_SWAR 1
+#if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+#define L1_SSE2 1
+#endif
+#endif
+
+#define L1_REF    1
+#define L1_SWAR64 2
+#define L1_SSE2X  3
+
+#define Ones( N ) ((uint64_t)(N) * 0x0101010101010101ULL)
+#define Zeros( W ) \
+  (~((((W) & Ones( 0x7F )) + Ones( 0x7F )) | (W) | Ones( 0x7F )))
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ *
+ *  There are three versions each of the L1 encoder and decoder.  The
+ *  byte-at-a-time versions (L1EncodeRef() and L1DecodeRef()) are the
+ *  reference implementations, and work everywhere.  The others must give
+ *  exactly the same results.  <L1Impl()> picks one at run time.
+ *
+ *  The faster encoders take the full 16-byte NetBIOS name (name, padding,
+ *  and suffix) as two little-endian words, built by <L1Word()>.  The
+ *  decoders all take
+ *  32 encoded bytes and behave exactly as <nbt_L1Decode()> does, except
+ *  that they write nothing to <dst> if the input is bad.
+ */
+
+static int L1Impl( void )
+  /* ------------------------------------------------------------------------ **
+   * Select the L1 coders to use, based upon the CPU we're running on.
+   *
+   *  Input:  none.
+   *
+   *  Output: L1_SSE2X if SSE2 is available, else L1_SWAR64 on little
+   *          endian hosts, else L1_REF.
+   *
+   *  Notes:  The result is computed once and cached.  If two threads race
+   *          to fill in the cache, they will both store the same value.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static int impl = 0;
+
+  if( 0 == impl )
+    {
+#if defined( L1_SSE2 )
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "sse2" ) )
+      impl = L1_SSE2X;
+#endif
+#if defined( L1_SWAR )
+    if( 0 == impl )
+      impl = L1_SWAR64;
+#endif
+    if( 0 == impl )
+      impl = L1_REF;
+    }
+  return( impl );
+  } /* L1Impl */
+
+
+static int L1EncodeRef( uchar *dst, const nbt_NameRec *src )
+  /* ------------------------------------------------------------------------ **
+   * Encode a NetBIOS name, one byte at a time.
+   *
+   *  Input:  dst - Target buffer, at least 33 bytes.
+   *          src - The name record, as given to <nbt_L1Encode()>.
+   *
+   *  Output: 32.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int   i,  j;
+  uchar hi, lo;
+
+  /* Encode the name using RFC 1001/1002 First Level Encoding.
+   */
+  hi = ( src->namelen > 15 ) ? 15 : src->namelen;   /* Ensure max 15 bytes. */
+  for( i = 0, j = 0; i < hi; i++ )
+    {
+    dst[j++] = EncHiNibble( src->name[i] );
+    dst[j++] = EncLoNibble( src->name[i] );
+    }
+
+  /* Encode the pad byte and fill in any unused name bytes.
+   */
+  hi = EncHiNibble( src->pad );
+  lo = EncLoNibble( src->pad );
+  while( j < 30 )
+    {
+    dst[j++] = hi;
+    dst[j++] = lo;
+    }
+
+  /* Encode the suffix byte and place it at the end,
+   * then terminate the string.
+   */
+  dst[30] = EncHiNibble( src->sfx );
+  dst[31] = EncLoNibble( src->sfx );
+  dst[32] = '\0';
+
+  /* Return the resulting string length. */
+  return( 32 );
+  } /* L1EncodeRef */
+
+
+static int L1DecodeRef( uchar       *dst,
+                        const uchar *src,
+                        const uchar  pad,
+                        uchar       *sfx )
+  /* ------------------------------------------------------------------------ **
+   * Decode a Level One Encoded NetBIOS name, one byte at a time.
+   *
+   *  Input:  dst - Target buffer, at least 16 bytes.
+   *          src - The 32 encoded bytes.
+   *          pad - The padding character, as given to <nbt_L1Decode()>.
+   *          sfx - Receives the suffix byte.
+   *
+   *  Output: The length of the decoded name, or cifs_errBadL1Value.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar tmp[nbt_NB_NAME_MAX];
+  int   i, j;
+  int   nibble;
+
+  /* Every two encoded bytes reduces to a single NetBIOS name byte.
+   * Decode into <tmp> so that <dst> is untouched on error.
+   */
+  for( i = 0, j = 0; i < nbt_NB_NAME_MAX; i++ )
+    {
+    nibble = (src[j++] - 'A');              /* First nibble. */
+    if( (nibble < 0) || (nibble > 0x0F) )
+      return( cifs_errBadL1Value );
+    tmp[i] = (uchar)(nibble << 4);
+
+    nibble = (src[j++] - 'A');              /* Second nibble. */
+    if( (nibble < 0) || (nibble > 0x0F) )
+      return( cifs_errBadL1Value );
+    tmp[i] |= nibble;
+    }
+  (void)memcpy( dst, tmp, nbt_NB_NAME_MAX );
+
+  /* Move the suffix out of the way and terminate the string.
+   */
+  *sfx = dst[15];
+  dst[15] = '\0';
+
+  /* Return 15 if we're not stripping the padding.
+   */
+  if( '\0' == pad )
+    return( 15 );
+
+  /* Trim padding from end and return the resulting string length.
+   */
+  for( i = 14; (i >= 0) && (pad == dst[i]); i-- )
+    dst[i] = '\0';
+  return( i + 1 );
+  } /* L1DecodeRef */
+
+#if defined( L1_SWAR )
+
+static uint64_t Load( const uchar *p, const int n )
+  /* ------------------------------------------------------------------------ **
+   * Load up to eight bytes as a little-endian word.
+   *
+   *  Input:  p - Source.
+   *          n - Number of bytes to load (0..8).
+   *
+   *  Output: The bytes, zero extended.
+   *
+   *  Notes:  Two overlapping fixed-size loads cover any length from four
+   *          to eight without reading past <p[n-1]>.  Three byte loads
+   *          cover one to three.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t a, b;
+
+  if( n >= 4 )
+    {
+    (void)memcpy( &a, p, 4 );
+    (void)memcpy( &b, &p[n - 4], 4 );
+    return( a | ((uint64_t)b << (8 * (n - 4))) );
+    }
+  if( n > 0 )
+    return( (uint64_t)p[0]
+          | ((uint64_t)p[n >> 1] << (8 * (n >> 1)))
+          | ((uint64_t)p[n - 1]  << (8 * (n - 1))) );
+  return( 0 );
+  } /* Load */
+
+
+static uint64_t L1Word( const nbt_NameRec *src, const int half )
+  /* ------------------------------------------------------------------------ **
+   * Assemble one half of the 16-byte NetBIOS name as a little-endian word.
+   *
+   *  Input:  src   - The name record, as given to <nbt_L1Encode()>.
+   *          half  - 0 for bytes 0..7, 1 for bytes 8..15.
+   *
+   *  Output: The eight name bytes, including padding and (in the second
+   *          half) the suffix.
+   *
+   *  Notes:  The word is built in a register.  Building the name in a byte
+   *          array and then loading it costs more than the encoding does,
+   *          because the wide load cannot be forwarded from the narrow
+   *          stores.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      n = (( src->namelen > 15 ) ? 15 : src->namelen) - (8 * half);
+  uint64_t w = 0;
+
+  if( n > 8 )
+    n = 8;
+  if( n > 0 )
+    w = Load( &src->name[8 * half], n );
+  else
+    n = 0;
+  if( n < 8 )
+    w |= Ones( src->pad ) << (8 * n);
+  if( half )
+    w = (w & 0x00FFFFFFFFFFFFFFULL) | ((uint64_t)src->sfx << 56);
+  return( w );
+  } /* L1Word */
+
+static int L1Plain( const nbt_NameRec *src, const uint64_t lo,
+                                            const uint64_t hi )
+  /* ------------------------------------------------------------------------ **
+   * Quick check of a NetBIOS name that has already been split into words.
+   *
+   *  Input:  src - The name record.
+   *          lo  - Bytes 0..7 of the name, from <L1Word()>.
+   *          hi  - Bytes 8..15.
+   *
+   *  Output: True if <nbt_CheckNbName()> would certainly accept the name,
+   *          else false.
+   *
+   *  Notes:  A false result does not mean that the name is bad, only that
+   *          the caller needs to ask <nbt_CheckNbName()>.  The dot and nul
+   *          tests are done on the whole name at once.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      len = src->namelen;
+  uint64_t l   = Zeros( lo ) | Zeros( lo ^ Ones( '.' ) );
+  uint64_t h   = Zeros( hi ) | Zeros( hi ^ Ones( '.' ) );
+
+  if( len < 1 || len > 15 || '*' == src->name[0] )
+    return( 0 );
+  if( len < 8 )
+    {
+    l &= (1ULL << (8 * len)) - 1;
+    h  = 0;
+    }
+  else
+    h &= (1ULL << (8 * (len - 8))) - 1;
+  return( 0 == (l | h) );
+  } /* L1Plain */
+
+
+static void L1EncodeSWAR( uchar *dst, const uint64_t lo, const uint64_t hi )
+  /* ------------------------------------------------------------------------ **
+   * Encode a 16-byte NetBIOS name, eight bytes at a time.
+   *
+   *  Input:  dst - Target buffer, at least 32 bytes.
+   *          lo  - Bytes 0..7 of the NetBIOS name, from <L1Word()>.
+   *          hi  - Bytes 8..15.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Each group of four name bytes is spread out so that byte <k>
+   *          lands in byte <2k> of a 64-bit word.  The high nibble of
+   *          each is then shifted down into its own byte, the low nibble
+   *          up into the next, and 'A' is added to all eight bytes at
+   *          once.  None of the byte additions can carry.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint64_t x;
+  int      i;
+
+  for( i = 0; i < 4; i++ )
+    {
+    x = (((i < 2) ? lo : hi) >> (32 * (i & 1))) & 0xFFFFFFFF;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+    x = ((x >> 4) & 0x000F000F000F000FULL) | ((x & 0x000F000F000F000FULL) << 8);
+    x += Ones( 'A' );
+    (void)memcpy( &dst[8 * i], &x, 8 );
+    }
+  } /* L1EncodeSWAR */
+
+
+static int L1DecodeSWAR( uchar       *dst,
+                         const uchar *src,
+                         const uchar  pad,
+                         uchar       *sfx )
+  /* ------------------------------------------------------------------------ **
+   * Decode a Level One Encoded NetBIOS name, eight bytes at a time.
+   *
+   *  Input:  dst - Target buffer, at least 16 bytes.
+   *          src - The 32 encoded bytes.
+   *          pad - The padding character, as given to <nbt_L1Decode()>.
+   *          sfx - Receives the suffix byte.
+   *
+   *  Output: The length of the decoded name, or cifs_errBadL1Value.
+   *
+   *  Notes:  A byte is out of range if its high bit is set, if it is less
+   *          than 'A', or if it is greater than 'P'.  The two comparisons
+   *          are the usual "has a byte less than" and "has a byte greater
+   *          than" tricks, which are exact as to whether *any* byte in the
+   *          word is out of range.  That is all that is needed.
+   *
+   *          Once the range is known to be good, subtracting 'A' from all
+   *          bytes at once cannot borrow.  Each pair of nibbles is then
+   *          merged and the four results are packed together.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint64_t w[4];
+  uint64_t out[2];
+  uint64_t bad = 0;
+  uint64_t x;
+  int      i;
+
+  (void)memcpy( w, src, 32 );
+  for( i = 0; i < 4; i++ )
+    {
+    x    = w[i];
+    bad |= x;
+    bad |= (x - Ones( 'A' )) & ~x;
+    bad |= x + Ones( 127 - 'P' );
+    }
+  if( bad & Ones( 0x80 ) )
+    return( cifs_errBadL1Value );
+
+  for( i = 0; i < 4; i++ )
+    {
+    x = w[i] - Ones( 'A' );
+    x = ((x & 0x00FF00FF00FF00FFULL) << 4) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+    x = (x | (x >> 8))  & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    w[i] = x;
+    }
+  out[0] = w[0] | (w[1] << 32);
+  out[1] = w[2] | (w[3] << 32);
+
+  /* Suffix, termination and padding, as in L1DecodeRef().
+   */
+  *sfx    = (uchar)(out[1] >> 56);
+  out[1] &= 0x00FFFFFFFFFFFFFFULL;
+  (void)memcpy( dst, out, 16 );
+  if( '\0' == pad )
+    return( 15 );
+  for( i = 14; (i >= 0) && (pad == dst[i]); i-- )
+    dst[i] = '\0';
+  return( i + 1 );
+  } /* L1DecodeSWAR */
+
+#endif /* L1_SWAR */
+#if defined( L1_SSE2 )
+
+__attribute__ ((target ("sse2")))
+static void L1EncodeSSE2( uchar *dst, const uint64_t lo, const uint64_t hi )
+  /* ------------------------------------------------------------------------ **
+   * Encode a 16-byte NetBIOS name using SSE2.
+   *
+   *  Input:  dst - Target buffer, at least 32 bytes.
+   *          lo  - Bytes 0..7 of the NetBIOS name, from <L1Word()>.
+   *          hi  - Bytes 8..15.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The high and low nibbles are split into two vectors, 'A' is
+   *          added to both, and the two are interleaved.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  const __m128i mask = _mm_set1_epi8( 0x0F );
+  const __m128i A    = _mm_set1_epi8( 'A' );
+  __m128i       v    = _mm_set_epi64x( (long long)hi, (long long)lo );
+  __m128i       h;
+  __m128i       l;
+
+  h = _mm_add_epi8( _mm_and_si128( _mm_srli_epi16( v, 4 ), mask ), A );
+  l = _mm_add_epi8( _mm_and_si128( v, mask ), A );
+  _mm_storeu_si128( (__m128i *)dst, _mm_unpacklo_epi8( h, l ) );
+  _mm_storeu_si128( (__m128i *)&dst[16], _mm_unpackhi_epi8( h, l ) );
+  } /* L1EncodeSSE2 */
+
+
+__attribute__ ((target ("sse2")))
+static int L1DecodeSSE2( uchar       *dst,
+                         const uchar *src,
+                         const uchar  pad,
+                         uchar       *sfx )
+  /* ------------------------------------------------------------------------ **
+   * Decode a Level One Encoded NetBIOS name using SSE2.
+   *
+   *  Input:  dst - Target buffer, at least 16 bytes.
+   *          src - The 32 encoded bytes.
+   *          pad - The padding character, as given to <nbt_L1Decode()>.
+   *          sfx - Receives the suffix byte.
+   *
+   *  Output: The length of the decoded name, or cifs_errBadL1Value.
+   *
+   *  Notes:  After 'A' is subtracted, every byte must be 15 or less
+   *          (unsigned), which is checked with one max and one compare.
+   *          The nibble pairs are merged within 16-bit lanes and packed
+   *          down to bytes.
+   *
+   *          Trailing padding is found with a byte compare and a bit
+   *          scan, and the padding and the suffix byte are cleared with
+   *          a single mask.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  const __m128i A   = _mm_set1_epi8( 'A' );
+  const __m128i n15 = _mm_set1_epi8( 0x0F );
+  const __m128i lo8 = _mm_set1_epi16( 0x00FF );
+  __m128i       a;
+  __m128i       b;
+  __m128i       ok;
+  __m128i       out;
+  unsigned int  m;
+  int           len = 15;
+
+  a  = _mm_sub_epi8( _mm_loadu_si128( (const __m128i *)src ), A );
+  b  = _mm_sub_epi8( _mm_loadu_si128( (const __m128i *)&src[16] ), A );
+  ok = _mm_and_si128( _mm_cmpeq_epi8( _mm_max_epu8( a, n15 ), n15 ),
+                      _mm_cmpeq_epi8( _mm_max_epu8( b, n15 ), n15 ) );
+  if( 0xFFFF != _mm_movemask_epi8( ok ) )
+    return( cifs_errBadL1Value );
+
+  a   = _mm_or_si128( _mm_slli_epi16( _mm_and_si128( a, lo8 ), 4 ),
+                      _mm_srli_epi16( a, 8 ) );
+  b   = _mm_or_si128( _mm_slli_epi16( _mm_and_si128( b, lo8 ), 4 ),
+                      _mm_srli_epi16( b, 8 ) );
+  out = _mm_packus_epi16( a, b );
+  *sfx = (uchar)(_mm_extract_epi16( out, 7 ) >> 8);
+
+  /* Bits 0..14 of <m> are clear for name bytes that are not padding.
+   * The highest clear bit marks the end of the name.
+   */
+  if( '\0' != pad )
+    {
+    m = (unsigned int)_mm_movemask_epi8(
+                        _mm_cmpeq_epi8( out, _mm_set1_epi8( (char)pad ) ) );
+    m = ~m & 0x7FFF;
+    len = m ? (32 - __builtin_clz( m )) : 0;
+    }
+  out = _mm_and_si128( out,
+                       _mm_cmplt_epi8( _mm_setr_epi8(  0,  1,  2,  3,
+                                                       4,  5,  6,  7,
+                                                       8,  9, 10, 11,
+                                                      12, 13, 14, 15 ),
+                                       _mm_set1_epi8( (char)len ) ) );
+  _mm_storeu_si128( (__m128i *)dst, out );
+  return( len );
+  } /* L1DecodeSSE2 */
+
+#endif /* L1_SSE2 */
+
+
 /* -------------------------------------------------------------------------- **
  * Functions:
  */
@@ -556,36 +1059,22 @@ int nbt_L1Encode( uchar *dst, const nbt_NameRec *src )
    * ------------------------------------------------------------------------ **
    */
   {
-  int   i,  j;
-  uchar hi, lo;
-
-  /* Encode the name using RFC 1001/1002 First Level Encoding.
-   */
-  hi = ( src->namelen > 15 ) ? 15 : src->namelen;   /* Ensure max 15 bytes. */
-  for( i = 0, j = 0; i < hi; i++ )
+  switch( L1Impl() )
     {
-    dst[j++] = EncHiNibble( src->name[i] );
-    dst[j++] = EncLoNibble( src->name[i] );
+#if defined( L1_SSE2 )
+    case L1_SSE2X:
+      L1EncodeSSE2( dst, L1Word( src, 0 ), L1Word( src, 1 ) );
+      break;
+#endif
+#if defined( L1_SWAR )
+    case L1_SWAR64:
+      L1EncodeSWAR( dst, L1Word( src, 0 ), L1Word( src, 1 ) );
+      break;
+#endif
+    default:
+      return( L1EncodeRef( dst, src ) );
     }
-
-  /* Encode the pad byte and fill in any unused name bytes.
-   */
-  hi = EncHiNibble( src->pad );
-  lo = EncLoNibble( src->pad );
-  while( j < 30 )
-    {
-    dst[j++] = hi;
-    dst[j++] = lo;
-    }
-
-  /* Encode the suffix byte and place it at the end,
-   * then terminate the string.
-   */
-  dst[30] = EncHiNibble( src->sfx );
-  dst[31] = EncLoNibble( src->sfx );
   dst[32] = '\0';
-
-  /* Return the resulting string length. */
   return( 32 );
   } /* nbt_L1Encode */
 
@@ -648,40 +1137,20 @@ int nbt_L1Decode( uchar       *dst,
    * ------------------------------------------------------------------------ **
    */
   {
-  int i, j;
-  int nibble;
-
-  /* Every two encoded bytes reduces to a single NetBIOS name byte.
-   */
-  for( i = 0, j = srcpos; i < nbt_NB_NAME_MAX; i++ )
+  switch( L1Impl() )
     {
-    nibble = (src[j++] - 'A');              /* First nibble. */
-    if( (nibble < 0) || (nibble > 0x0F) )
-      return( cifs_errBadL1Value );
-    dst[i] = (uchar)(nibble << 4);
-
-    nibble = (src[j++] - 'A');              /* Second nibble. */
-    if( (nibble < 0) || (nibble > 0x0F) )
-      return( cifs_errBadL1Value );
-    dst[i] |= nibble;
+#if defined( L1_SSE2 )
+    case L1_SSE2X:
+      return( L1DecodeSSE2( dst, &src[srcpos], pad, sfx ) );
+#endif
+#if defined( L1_SWAR )
+    case L1_SWAR64:
+      return( L1DecodeSWAR( dst, &src[srcpos], pad, sfx ) );
+#endif
+    default:
+      break;
     }
-
-  /* Move the suffix out of the way and terminate the string.
-   */
-  *sfx = dst[15];
-  dst[15] = '\0';
-
-  /* Return 15 if we're not stripping the padding.
-   */
-  if( '\0' == pad )
-    return( 15 );
-
-  /* Trim padding from end and return the resulting string length.
-   */
-  for( i = 14; (i >= 0) && (pad == dst[i]); i-- )
-    dst[i] = '\0';
-  return( i + 1 );
-
+  return( L1DecodeRef( dst, &src[srcpos], pad, sfx ) );
   } /* nbt_L1Decode */
 
 
@@ -940,4 +1409,172 @@ int nbt_EncodeName( uchar             *dst,
   } /* nbt_EncodeName */
 
 
+int nbt_ScopeCacheInit( nbt_ScopeCache *sc, const uchar *scope )
+  /* ------------------------------------------------------------------------ **
+   * Check and L2 encode a Scope ID for use with <nbt_EncodeNames()>.
+   *
+   *  Input:  sc    - Pointer to the cache structure to be filled in.
+   *          scope - The Scope ID, as a nul-terminated string.  NULL is
+   *                  equivalent to the empty scope ("").
+   *
+   *  Output: If positive, the length of the encoded scope (the bytes
+   *          that follow the encoded NetBIOS name, including the final
+   *          nul label).  If negative, an error or warning code.
+   *
+   *  Errors: cifs_errNullInput     - <sc> was NULL.
+   *          Any of the errors returned by <nbt_CheckScope()>.
+   *
+   *  Warnings:
+   *          Any of the warnings returned by <nbt_CheckScope()>.
+   *
+   *  Notes:  As with <nbt_EncodeName()>, a warning does not prevent the
+   *          scope from being encoded.  If a warning is returned then
+   *          <sc> is ready for use, and the warning is also kept in
+   *          <sc->warning>.  If an error is returned, <sc> is not usable.
+   *
+   *          The Scope ID is not upper-cased.  Do that first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_NameRec rec;
+  nbt_Name    tmp;
+  int         result = 0;
+
+  if( NULL == sc )
+    return( cifs_errNullInput );
+  sc->warning = 0;
+
+  /* Check the scope.  Errors are fatal, warnings are remembered.
+   */
+  if( (NULL != scope) && ('\0' != *scope) )
+    {
+    result = nbt_CheckScope( scope );
+    if( result < 0 && cifs_errIsError( result ) )
+      return( result );
+    if( cifs_errIsWarn( result ) )
+      sc->warning = result;
+    }
+
+  /* Let nbt_L2Encode() do the label encoding, using a throw-away name.
+   * The scope starts right after the 0x20 length byte and the L1 name.
+   */
+  rec.namelen  = 0;
+  rec.name     = (uchar *)"";
+  rec.pad      = ' ';
+  rec.sfx      = '\0';
+  rec.scope_id = (uchar *)scope;
+  sc->len = nbt_L2Encode( tmp, &rec ) - nbt_L1_NB_NAME_MAX;
+  (void)memcpy( sc->tail, &tmp[nbt_L1_NB_NAME_MAX], sc->len );
+
+  return( sc->warning ? sc->warning : sc->len );
+  } /* nbt_ScopeCacheInit */
+
+
+int nbt_EncodeNames( uchar                *dst,
+                     const int             dstpos,
+                     const int             dstlen,
+                     const nbt_ScopeCache *sc,
+                     const nbt_NameRec    *names,
+                     const int             count )
+  /* ------------------------------------------------------------------------ **
+   * Encode a set of NBT names that share a single Scope ID.
+   *
+   *  Input:  dst     - Pointer to the destination buffer.
+   *          dstpos  - Offset into <dst> at which to write the first
+   *                    encoded name.
+   *          dstlen  - Total bytes in <dst>.
+   *          sc      - An encoded Scope ID, as prepared by
+   *                    <nbt_ScopeCacheInit()>.
+   *          names   - An array of <count> name records.  The <scope_id>
+   *                    field of each record is ignored.
+   *          count   - Number of entries in <names>.
+   *
+   *  Output: If negative, an error code.  Otherwise, the number of names
+   *          that were encoded.  This will be less than <count> if one
+   *          of the names failed the <nbt_CheckNbName()> syntax check
+   *          or had a NULL <name> field.  In that case, encoding stopped
+   *          at names[result].
+   *
+   *  Errors: cifs_errNullInput     - <dst>, <sc>, or <names> was NULL.
+   *          cifs_errBufrTooSmall  - Not enough room in <dst> to hold all
+   *                                  <count> encoded names.
+   *
+   *  Notes:  The encoded names are written one after another with no gaps
+   *          between them.  Each is (nbt_L1_NB_NAME_MAX + sc->len) bytes
+   *          long, so names[i] is found at:
+   *            dstpos + (i * (nbt_L1_NB_NAME_MAX + sc->len))
+   *
+   *          Each name is checked in the same way as by <nbt_EncodeName()>,
+   *          so a name that causes a warning (eg., the "*" wildcard) will
+   *          stop the batch.  Use <nbt_L2Encode()> for such names.
+   *
+   *          This is faster than calling <nbt_EncodeName()> in a loop
+   *          because the Scope ID is checked and encoded only once, the
+   *          L1 encoder is selected once for the whole set and, where
+   *          the word-at-a-time encoders are in use, the name check is
+   *          done on the same words that are encoded.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int      impl;
+  int      stride;
+  int      i;
+  uchar   *p;
+#if defined( L1_SWAR )
+  uint64_t lo;
+  uint64_t hi;
+#endif
+
+  if( NULL == dst || NULL == sc || NULL == names )
+    return( cifs_errNullInput );
+
+  /* Check the space once, for the whole set.
+   */
+  stride = nbt_L1_NB_NAME_MAX + sc->len;
+  if( count < 0 || (dstlen - dstpos) / stride < count )
+    return( cifs_errBufrTooSmall );
+
+  impl = L1Impl();
+  p    = &dst[dstpos];
+  for( i = 0; i < count; i++, p += stride )
+    {
+    /* The word-at-a-time coders read the name before it is checked.
+     */
+    if( NULL == names[i].name )
+      break;
+#if defined( L1_SWAR )
+    if( L1_REF != impl )
+      {
+      /* Build the name words once, and use them for the syntax check
+       * as well as the encoding.
+       */
+      lo = L1Word( &names[i], 0 );
+      hi = L1Word( &names[i], 1 );
+      if( !L1Plain( &names[i], lo, hi )
+          && (nbt_CheckNbName( names[i].name, names[i].namelen ) < 0) )
+        break;
+      p[0] = 0x20;
+#if defined( L1_SSE2 )
+      if( L1_SSE2X == impl )
+        L1EncodeSSE2( &p[1], lo, hi );
+      else
+#endif
+        L1EncodeSWAR( &p[1], lo, hi );
+      }
+    else
+#endif
+      {
+      if( nbt_CheckNbName( names[i].name, names[i].namelen ) < 0 )
+        break;
+      p[0] = 0x20;
+      (void)L1EncodeRef( &p[1], &names[i] );
+      }
+    (void)memcpy( &p[nbt_L1_NB_NAME_MAX], sc->tail, sc->len );
+    }
+  return( i );
+  } /* nbt_EncodeNames */
+
+
 /* ========================================================================== */
@@ -159,6 +159,11 @@
  *  nbt_NameRec - This structure keeps track of the various bytes and
  *                pieces that are used to build an NBT name from a NetBIOS
  *                name, suffix, padding, and Scope ID.
+ *
+ *  nbt_ScopeCache
+ *              - A Scope ID that has been checked and L2 encoded once so
+ *                that it can be appended to any number of encoded NetBIOS
+ *                names.  See <nbt_ScopeCacheInit()> and <nbt_EncodeNames()>.
  */
 
 typedef uchar nbt_Name[nbt_NAME_MAX];
@@ -174,6 +179,13 @@ typedef struct
   uchar *scope_id;    /* Scope ID as a nul-terminated string.   */
   } nbt_NameRec;
 
+typedef struct
+  {
+  int   len;          /* Length of tail[], including the root label.  */
+  int   warning;      /* Warning from nbt_CheckScope(), or 0.         */
+  uchar tail[nbt_NAME_MAX - nbt_L1_NB_NAME_MAX];  /* Encoded scope.   */
+  } nbt_ScopeCache;
+
 
 /* -------------------------------------------------------------------------- **
  * Functions:
@@ -649,5 +661,82 @@ int nbt_EncodeName( uchar             *dst,
    */
 
 
+int nbt_ScopeCacheInit( nbt_ScopeCache *sc, const uchar *scope );
+  /* ------------------------------------------------------------------------ **
+   * Check and L2 encode a Scope ID for use with <nbt_EncodeNames()>.
+   *
+   *  Input:  sc    - Pointer to the cache structure to be filled in.
+   *          scope - The Scope ID, as a nul-terminated string.  NULL is
+   *                  equivalent to the empty scope ("").
+   *
+   *  Output: If positive, the length of the encoded scope (the bytes
+   *          that follow the encoded NetBIOS name, including the final
+   *          nul label).  If negative, an error or warning code.
+   *
+   *  Errors: cifs_errNullInput     - <sc> was NULL.
+   *          Any of the errors returned by <nbt_CheckScope()>.
+   *
+   *  Warnings:
+   *          Any of the warnings returned by <nbt_CheckScope()>.
+   *
+   *  Notes:  As with <nbt_EncodeName()>, a warning does not prevent the
+   *          scope from being encoded.  If a warning is returned then
+   *          <sc> is ready for use, and the warning is also kept in
+   *          <sc->warning>.  If an error is returned, <sc> is not usable.
+   *
+   *          The Scope ID is not upper-cased.  Do that first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_EncodeNames( uchar                *dst,
+                     const int             dstpos,
+                     const int             dstlen,
+                     const nbt_ScopeCache *sc,
+                     const nbt_NameRec    *names,
+                     const int             count );
+  /* ------------------------------------------------------------------------ **
+   * Encode a set of NBT names that share a single Scope ID.
+   *
+   *  Input:  dst     - Pointer to the destination buffer.
+   *          dstpos  - Offset into <dst> at which to write the first
+   *                    encoded name.
+   *          dstlen  - Total bytes in <dst>.
+   *          sc      - An encoded Scope ID, as prepared by
+   *                    <nbt_ScopeCacheInit()>.
+   *          names   - An array of <count> name records.  The <scope_id>
+   *                    field of each record is ignored.
+   *          count   - Number of entries in <names>.
+   *
+   *  Output: If negative, an error code.  Otherwise, the number of names
+   *          that were encoded.  This will be less than <count> if one
+   *          of the names failed the <nbt_CheckNbName()> syntax check
+   *          or had a NULL <name> field.  In that case, encoding stopped
+   *          at names[result].
+   *
+   *  Errors: cifs_errNullInput     - <dst>, <sc>, or <names> was NULL.
+   *          cifs_errBufrTooSmall  - Not enough room in <dst> to hold all
+   *                                  <count> encoded names.
+   *
+   *  Notes:  The encoded names are written one after another with no gaps
+   *          between them.  Each is (nbt_L1_NB_NAME_MAX + sc->len) bytes
+   *          long, so names[i] is found at:
+   *            dstpos + (i * (nbt_L1_NB_NAME_MAX + sc->len))
+   *
+   *          Each name is checked in the same way as by <nbt_EncodeName()>,
+   *          so a name that causes a warning (eg., the "*" wildcard) will
+   *          stop the batch.  Use <nbt_L2Encode()> for such names.
+   *
+   *          This is faster than calling <nbt_EncodeName()> in a loop
+   *          because the Scope ID is checked and encoded only once, the
+   *          L1 encoder is selected once for the whole set and, where
+   *          the word-at-a-time encoders are in use, the name check is
+   *          done on the same words that are encoded.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
 /* ========================================================================== */
 #endif /* NBT_NAMES_H */
@@ -0,0 +1,464 @@
+/* ========================================================================== **
+ *
+ *                                  Packet.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NBT Session Service message framing.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Every NBT Session Service message starts with a four byte header
+ *  (RFC 1002, section 4.3.1):
+ *
+ *    TYPE    - 1 byte.  The session packet type.
+ *    FLAGS   - 1 byte.  Only the low order bit is defined.  It is the
+ *              length extension (E) bit, which is the 17th bit of the
+ *              length.  The other seven bits must be zero.
+ *    LENGTH  - 2 bytes.  The number of bytes following the header.
+ *
+ *  So a session message can carry at most (2^17)-1 bytes.
+ *
+ *  SMB over naked TCP (port 445) uses the same four bytes, but the TYPE
+ *  is always zero and the next 24 bits are the length.  These are called
+ *  "raw" headers here.  A raw header with a length of less than 2^17 is
+ *  also a valid session message header, so the same parsing code can be
+ *  used for both; only the limits differ.
+ *
+ *  Like NBT/NS/Packet.c, this module works with plain byte arrays.
+ *  Reassembly of messages from a byte stream is handled in
+ *  NBT/SS/Stream.c.
+ *
+ * ========================================================================== **
+ */
+
+#include "Packet.h"           /* Module header.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static int CheckLen( const uint8_t type, const long len )
+  /* ------------------------------------------------------------------------ **
+   * Check a payload length against the packet type.
+   *
+   *  Input:  type  - The session packet type.
+   *          len   - The payload length.
+   *
+   *  Output: Zero if the length is valid for the type, else a negative
+   *          value.
+   *
+   *  Errors: cifs_errIllegalSSType - <type> is not a known packet type.
+   *          cifs_errInvalidSSLen  - <len> is wrong for <type>.
+   *
+   *  Notes:  A Session Request carries two L2 encoded names, each of
+   *          which is between nbt_L2_NB_NAME_MIN and nbt_NAME_MAX bytes.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  switch( type )
+    {
+    case nbt_ssSESSION_MESSAGE:
+      if( (len < 0) || (len > nbt_ssMAX_LEN) )
+        return( cifs_errInvalidSSLen );
+      break;
+    case nbt_ssSESSION_REQUEST:
+      if( (len < (2 * nbt_L2_NB_NAME_MIN)) || (len > (2 * nbt_NAME_MAX)) )
+        return( cifs_errInvalidSSLen );
+      break;
+    case nbt_ssPOSITIVE_RESPONSE:
+    case nbt_ssKEEPALIVE:
+      if( 0 != len )
+        return( cifs_errInvalidSSLen );
+      break;
+    case nbt_ssNEGATIVE_RESPONSE:
+      if( 1 != len )
+        return( cifs_errInvalidSSLen );
+      break;
+    case nbt_ssRETARGET_RESPONSE:
+      if( nbt_ssRETARGET_LEN != len )
+        return( cifs_errInvalidSSLen );
+      break;
+    default:
+      return( cifs_errIllegalSSType );
+    }
+  return( 0 );
+  } /* CheckLen */
+
+
+static int EncodedLen( const nbt_NameRec *namerec )
+  /* ------------------------------------------------------------------------ **
+   * Calculate the length of an L2 encoded name.
+   *
+   *  Input:  namerec - The name record.
+   *
+   *  Output: The number of bytes <nbt_L2Encode()> would write, or a
+   *          negative value on error.
+   *
+   *  Errors: cifs_errNullInput     - <namerec> or its <name> is NULL.
+   *          cifs_errScopeTooLong  - The encoded name would exceed
+   *                                  nbt_NAME_MAX bytes.
+   *          Any other error returned by <nbt_CheckScope()>.
+   *
+   *  Notes:  The scope is checked with <nbt_CheckScope()>.  An empty or
+   *          oversized label would be mangled by <nbt_L2Encode()>, and the
+   *          names in the message would then not match the length given
+   *          in its header.  Warnings are ignored.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  size_t len = nbt_L2_NB_NAME_MIN;
+  int    result;
+
+  if( (NULL == namerec) || (NULL == namerec->name) )
+    return( cifs_errNullInput );
+  if( (NULL != namerec->scope_id) && ('\0' != *(namerec->scope_id)) )
+    {
+    result = nbt_CheckScope( namerec->scope_id );
+    if( (result < 0) && cifs_errIsError( result ) )
+      return( result );
+    len += strlen( (char *)namerec->scope_id ) + 1;
+    }
+  if( len > nbt_NAME_MAX )
+    return( cifs_errScopeTooLong );
+  return( (int)len );
+  } /* EncodedLen */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_ssSetHdr( uchar         *bufr,
+                  const long     bSize,
+                  const uint8_t  type,
+                  const long     len )
+  /* ------------------------------------------------------------------------ **
+   * Write a Session Service message header.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.  Must be at least
+   *                  <nbt_ssHEADER_LEN>.
+   *          type  - The session packet type.  One of the nbt_ss*
+   *                  packet type values.
+   *          len   - The number of bytes that will follow the header.
+   *
+   *  Output: On success, <nbt_ssHEADER_LEN>.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than nbt_ssHEADER_LEN.
+   *          cifs_errIllegalSSType - <type> is not a known packet type.
+   *          cifs_errInvalidSSLen  - <len> is negative, exceeds
+   *                                  nbt_ssMAX_LEN, or is wrong for the
+   *                                  given packet type.
+   *
+   *  Notes:  The length extension bit is set as needed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int result;
+
+  if( bSize < nbt_ssHEADER_LEN )
+    return( cifs_errBufrTooSmall );
+  result = CheckLen( type, len );
+  if( result < 0 )
+    return( result );
+
+  bufr[0] = type;
+  bufr[1] = (uchar)((len >> 16) & nbt_ssLEN_EXT);
+  nbt_SetShort( bufr, 2, (len & 0xFFFF) );
+  return( nbt_ssHEADER_LEN );
+  } /* nbt_ssSetHdr */
+
+
+int nbt_ssSetRawHdr( uchar *bufr, const long bSize, const long len )
+  /* ------------------------------------------------------------------------ **
+   * Write a naked TCP (port 445) message header.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.  Must be at least
+   *                  <nbt_ssHEADER_LEN>.
+   *          len   - The number of bytes that will follow the header.
+   *
+   *  Output: On success, <nbt_ssHEADER_LEN>.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than nbt_ssHEADER_LEN.
+   *          cifs_errInvalidSSLen  - <len> is negative or exceeds
+   *                                  nbt_ssMAX_RAW_LEN.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( bSize < nbt_ssHEADER_LEN )
+    return( cifs_errBufrTooSmall );
+  if( (len < 0) || (len > nbt_ssMAX_RAW_LEN) )
+    return( cifs_errInvalidSSLen );
+
+  nbt_SetLong( bufr, 0, len );
+  return( nbt_ssHEADER_LEN );
+  } /* nbt_ssSetRawHdr */
+
+
+long nbt_ssGetHdr( const uchar *bufr, const long bLen, uint8_t *type )
+  /* ------------------------------------------------------------------------ **
+   * Read and check a Session Service message header.
+   *
+   *  Input:  bufr  - Pointer to the start of the message.
+   *          bLen  - Number of bytes available at <bufr>.
+   *          type  - Pointer to a byte that will receive the session
+   *                  packet type.  May be NULL.
+   *
+   *  Output: On success, the number of bytes that follow the header.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errTruncatedBufr - <bLen> is less than nbt_ssHEADER_LEN.
+   *          cifs_errIllegalSSType - The packet type is not known.
+   *          cifs_errInvalidSSLen  - One of the reserved FLAGS bits is set,
+   *                                  or the length is wrong for the packet
+   *                                  type.
+   *
+   *  Notes:  Only the header is examined.  <bufr> need not hold the whole
+   *          message.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long len;
+  int  result;
+
+  if( bLen < nbt_ssHEADER_LEN )
+    return( cifs_errTruncatedBufr );
+  if( bufr[1] & ~nbt_ssLEN_EXT )
+    return( cifs_errInvalidSSLen );
+
+  len = ((long)(bufr[1] & nbt_ssLEN_EXT) << 16) | nbt_GetShort( bufr, 2 );
+  result = CheckLen( bufr[0], len );
+  if( result < 0 )
+    return( result );
+
+  if( NULL != type )
+    *type = bufr[0];
+  return( len );
+  } /* nbt_ssGetHdr */
+
+
+long nbt_ssGetRawHdr( const uchar *bufr, const long bLen )
+  /* ------------------------------------------------------------------------ **
+   * Read and check a naked TCP (port 445) message header.
+   *
+   *  Input:  bufr  - Pointer to the start of the message.
+   *          bLen  - Number of bytes available at <bufr>.
+   *
+   *  Output: On success, the number of bytes that follow the header.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errTruncatedBufr - <bLen> is less than nbt_ssHEADER_LEN.
+   *          cifs_errIllegalSSType - The first byte is not zero.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( bLen < nbt_ssHEADER_LEN )
+    return( cifs_errTruncatedBufr );
+  if( nbt_ssSESSION_MESSAGE != bufr[0] )
+    return( cifs_errIllegalSSType );
+
+  return( (long)(nbt_GetLong( bufr, 0 ) & nbt_ssMAX_RAW_LEN) );
+  } /* nbt_ssGetRawHdr */
+
+
+int nbt_ssSessionRequest( uchar             *bufr,
+                          const long         bSize,
+                          const nbt_NameRec *called,
+                          const nbt_NameRec *calling )
+  /* ------------------------------------------------------------------------ **
+   * Build a complete Session Request message.
+   *
+   *  Input:  bufr    - Destination buffer.
+   *          bSize   - Size of <bufr>, in bytes.
+   *          called  - The name of the node being called.
+   *          calling - The name of the calling node.
+   *
+   *  Output: On success, the total length of the message, including the
+   *          header.  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput     - A name record, or its <name>, is
+   *                                  NULL.
+   *          cifs_errScopeTooLong  - An encoded name would exceed
+   *                                  nbt_NAME_MAX bytes.
+   *          cifs_errBufrTooSmall  - The message will not fit in <bufr>.
+   *          Any other error returned by <nbt_CheckScope()>.
+   *
+   *  Notes:  As with <nbt_L2Encode()>, no syntax checking is done on the
+   *          NetBIOS names, so the "*SMBSERVER" called name can be used.
+   *          The scopes are checked, though, since a malformed scope
+   *          would not encode to the expected length.  Both names should
+   *          carry the same scope.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int calledlen;
+  int callinglen;
+  int result;
+
+  calledlen  = EncodedLen( called );
+  if( calledlen < 0 )
+    return( calledlen );
+  callinglen = EncodedLen( calling );
+  if( callinglen < 0 )
+    return( callinglen );
+  if( bSize < (nbt_ssHEADER_LEN + calledlen + callinglen) )
+    return( cifs_errBufrTooSmall );
+
+  /* Use the lengths actually written, so that the header can't disagree
+   * with the layout of the names.
+   */
+  calledlen  = nbt_L2Encode( &bufr[nbt_ssHEADER_LEN], called );
+  callinglen = nbt_L2Encode( &bufr[nbt_ssHEADER_LEN + calledlen], calling );
+  result     = nbt_ssSetHdr( bufr, bSize, nbt_ssSESSION_REQUEST,
+                             calledlen + callinglen );
+  if( result < 0 )
+    return( result );
+  return( nbt_ssHEADER_LEN + calledlen + callinglen );
+  } /* nbt_ssSessionRequest */
+
+
+int nbt_ssSessionRequestNames( const uchar  *msg,
+                               const long    len,
+                               const uchar **called,
+                               const uchar **calling )
+  /* ------------------------------------------------------------------------ **
+   * Find and check the names in a received Session Request.
+   *
+   *  Input:  msg     - The message payload (the bytes following the
+   *                    header).
+   *          len     - The payload length, as returned by
+   *                    <nbt_ssGetHdr()>.
+   *          called  - Receives a pointer to the L2 encoded called name.
+   *          calling - Receives a pointer to the L2 encoded calling name.
+   *
+   *  Output: On success, zero.  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput       - <msg> is NULL.
+   *          cifs_errBadCalledName   - The called name is not a valid L2
+   *                                    encoded name.
+   *          cifs_errBadCallingName  - The calling name is not a valid L2
+   *                                    encoded name, or does not end
+   *                                    exactly at the end of the payload.
+   *
+   *  Notes:  The names are not copied.  Use <nbt_L2Decode()> to extract
+   *          the NetBIOS name from each.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int calledlen;
+  int callinglen;
+
+  if( NULL == msg )
+    return( cifs_errNullInput );
+
+  calledlen = nbt_CheckL2Name( msg, 0, (int)len );
+  if( calledlen < 0 )
+    return( cifs_errBadCalledName );
+  callinglen = nbt_CheckL2Name( msg, calledlen, (int)len );
+  if( (callinglen < 0) || ((calledlen + callinglen) != len) )
+    return( cifs_errBadCallingName );
+
+  *called  = msg;
+  *calling = &msg[calledlen];
+  return( 0 );
+  } /* nbt_ssSessionRequestNames */
+
+
+int nbt_ssNegResponse( uchar *bufr, const long bSize, const uint8_t code )
+  /* ------------------------------------------------------------------------ **
+   * Build a complete Negative Session Response message.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.
+   *          code  - The error code.  One of the nbt_ssERR_* values.
+   *
+   *  Output: On success, the total length of the message (always 5).
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than 5.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( bSize < (nbt_ssHEADER_LEN + 1) )
+    return( cifs_errBufrTooSmall );
+
+  (void)nbt_ssSetHdr( bufr, bSize, nbt_ssNEGATIVE_RESPONSE, 1 );
+  bufr[nbt_ssHEADER_LEN] = code;
+  return( nbt_ssHEADER_LEN + 1 );
+  } /* nbt_ssNegResponse */
+
+
+int nbt_ssRetargetResponse( uchar         *bufr,
+                            const long     bSize,
+                            const uint32_t ip,
+                            const uint16_t port )
+  /* ------------------------------------------------------------------------ **
+   * Build a complete Session Retarget Response message.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.
+   *          ip    - The IPv4 address to which the caller should retry,
+   *                  in host byte order.
+   *          port  - The TCP port to which the caller should retry.
+   *
+   *  Output: On success, the total length of the message (always 10).
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than 10.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( bSize < (nbt_ssHEADER_LEN + nbt_ssRETARGET_LEN) )
+    return( cifs_errBufrTooSmall );
+
+  (void)nbt_ssSetHdr( bufr, bSize, nbt_ssRETARGET_RESPONSE,
+                      nbt_ssRETARGET_LEN );
+  nbt_SetLong( bufr, nbt_ssHEADER_LEN, ip );
+  nbt_SetShort( bufr, nbt_ssHEADER_LEN + 4, port );
+  return( nbt_ssHEADER_LEN + nbt_ssRETARGET_LEN );
+  } /* nbt_ssRetargetResponse */
+
+/* ========================================================================== */
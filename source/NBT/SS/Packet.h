@@ -0,0 +1,321 @@
+#ifndef NBT_SS_PACKET_H
+#define NBT_SS_PACKET_H
+/* ========================================================================== **
+ *
+ *                                  Packet.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  NBT Session Service message framing.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Every NBT Session Service message starts with a four byte header
+ *  (RFC 1002, section 4.3.1):
+ *
+ *    TYPE    - 1 byte.  The session packet type.
+ *    FLAGS   - 1 byte.  Only the low order bit is defined.  It is the
+ *              length extension (E) bit, which is the 17th bit of the
+ *              length.  The other seven bits must be zero.
+ *    LENGTH  - 2 bytes.  The number of bytes following the header.
+ *
+ *  So a session message can carry at most (2^17)-1 bytes.
+ *
+ *  SMB over naked TCP (port 445) uses the same four bytes, but the TYPE
+ *  is always zero and the next 24 bits are the length.  These are called
+ *  "raw" headers here.  A raw header with a length of less than 2^17 is
+ *  also a valid session message header, so the same parsing code can be
+ *  used for both; only the limits differ.
+ *
+ *  Like NBT/NS/Packet.c, this module works with plain byte arrays.
+ *  Reassembly of messages from a byte stream is handled in
+ *  NBT/SS/Stream.c.
+ *
+ * ========================================================================== **
+ */
+
+#include "NBT/nbt_common.h"   /* NBT subsystem common include file. */
+#include "NBT/Names.h"        /* nbt_NameRec.                       */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  nbt_ssHEADER_LEN    - Byte length of a session message header.  Always 4.
+ *  nbt_ssMAX_LEN       - The largest payload a session message can carry.
+ *  nbt_ssMAX_RAW_LEN   - The largest payload a naked TCP message can carry.
+ *  nbt_ssLEN_EXT       - The length extension (E) bit in the FLAGS byte.
+ *  nbt_ssRETARGET_LEN  - Payload length of a Retarget Response.
+ */
+
+#define nbt_ssHEADER_LEN    4
+#define nbt_ssMAX_LEN       0x0001FFFF
+#define nbt_ssMAX_RAW_LEN   0x00FFFFFF
+#define nbt_ssLEN_EXT       0x01
+#define nbt_ssRETARGET_LEN  6
+
+/*  --
+ *  Session packet types.  <RFC 1002, 4.3.1>
+ *
+ *  nbt_ssSESSION_MESSAGE     - Session Message.  Carries the data.
+ *  nbt_ssSESSION_REQUEST     - Session Request.  Carries the called and
+ *                              calling names.
+ *  nbt_ssPOSITIVE_RESPONSE   - Positive Session Response.
+ *  nbt_ssNEGATIVE_RESPONSE   - Negative Session Response.  Carries a one
+ *                              byte error code.
+ *  nbt_ssRETARGET_RESPONSE   - Retarget Session Response.  Carries an IP
+ *                              address and port.
+ *  nbt_ssKEEPALIVE           - Session Keep Alive.
+ */
+
+#define nbt_ssSESSION_MESSAGE   0x00
+#define nbt_ssSESSION_REQUEST   0x81
+#define nbt_ssPOSITIVE_RESPONSE 0x82
+#define nbt_ssNEGATIVE_RESPONSE 0x83
+#define nbt_ssRETARGET_RESPONSE 0x84
+#define nbt_ssKEEPALIVE         0x85
+
+/*  --
+ *  Negative Session Response error codes.  <RFC 1002, 4.3.4>
+ *
+ *  nbt_ssERR_NOT_LISTENING_CALLED  - Not listening on called name.
+ *  nbt_ssERR_NOT_LISTENING_CALLING - Not listening for calling name.
+ *  nbt_ssERR_CALLED_NOT_PRESENT    - Called name not present.
+ *  nbt_ssERR_INSUFFICIENT_RESOURCES  - Called name present, but
+ *                                      insufficient resources.
+ *  nbt_ssERR_UNSPECIFIED           - Unspecified error.
+ */
+
+#define nbt_ssERR_NOT_LISTENING_CALLED    0x80
+#define nbt_ssERR_NOT_LISTENING_CALLING   0x81
+#define nbt_ssERR_CALLED_NOT_PRESENT      0x82
+#define nbt_ssERR_INSUFFICIENT_RESOURCES  0x83
+#define nbt_ssERR_UNSPECIFIED             0x8F
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_ssSetHdr( uchar         *bufr,
+                  const long     bSize,
+                  const uint8_t  type,
+                  const long     len );
+  /* ------------------------------------------------------------------------ **
+   * Write a Session Service message header.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.  Must be at least
+   *                  <nbt_ssHEADER_LEN>.
+   *          type  - The session packet type.  One of the nbt_ss*
+   *                  packet type values.
+   *          len   - The number of bytes that will follow the header.
+   *
+   *  Output: On success, <nbt_ssHEADER_LEN>.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than nbt_ssHEADER_LEN.
+   *          cifs_errIllegalSSType - <type> is not a known packet type.
+   *          cifs_errInvalidSSLen  - <len> is negative, exceeds
+   *                                  nbt_ssMAX_LEN, or is wrong for the
+   *                                  given packet type.
+   *
+   *  Notes:  The length extension bit is set as needed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_ssSetRawHdr( uchar *bufr, const long bSize, const long len );
+  /* ------------------------------------------------------------------------ **
+   * Write a naked TCP (port 445) message header.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.  Must be at least
+   *                  <nbt_ssHEADER_LEN>.
+   *          len   - The number of bytes that will follow the header.
+   *
+   *  Output: On success, <nbt_ssHEADER_LEN>.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than nbt_ssHEADER_LEN.
+   *          cifs_errInvalidSSLen  - <len> is negative or exceeds
+   *                                  nbt_ssMAX_RAW_LEN.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+long nbt_ssGetHdr( const uchar *bufr, const long bLen, uint8_t *type );
+  /* ------------------------------------------------------------------------ **
+   * Read and check a Session Service message header.
+   *
+   *  Input:  bufr  - Pointer to the start of the message.
+   *          bLen  - Number of bytes available at <bufr>.
+   *          type  - Pointer to a byte that will receive the session
+   *                  packet type.  May be NULL.
+   *
+   *  Output: On success, the number of bytes that follow the header.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errTruncatedBufr - <bLen> is less than nbt_ssHEADER_LEN.
+   *          cifs_errIllegalSSType - The packet type is not known.
+   *          cifs_errInvalidSSLen  - One of the reserved FLAGS bits is set,
+   *                                  or the length is wrong for the packet
+   *                                  type.
+   *
+   *  Notes:  Only the header is examined.  <bufr> need not hold the whole
+   *          message.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+long nbt_ssGetRawHdr( const uchar *bufr, const long bLen );
+  /* ------------------------------------------------------------------------ **
+   * Read and check a naked TCP (port 445) message header.
+   *
+   *  Input:  bufr  - Pointer to the start of the message.
+   *          bLen  - Number of bytes available at <bufr>.
+   *
+   *  Output: On success, the number of bytes that follow the header.
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errTruncatedBufr - <bLen> is less than nbt_ssHEADER_LEN.
+   *          cifs_errIllegalSSType - The first byte is not zero.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_ssSessionRequest( uchar             *bufr,
+                          const long         bSize,
+                          const nbt_NameRec *called,
+                          const nbt_NameRec *calling );
+  /* ------------------------------------------------------------------------ **
+   * Build a complete Session Request message.
+   *
+   *  Input:  bufr    - Destination buffer.
+   *          bSize   - Size of <bufr>, in bytes.
+   *          called  - The name of the node being called.
+   *          calling - The name of the calling node.
+   *
+   *  Output: On success, the total length of the message, including the
+   *          header.  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput     - A name record, or its <name>, is
+   *                                  NULL.
+   *          cifs_errScopeTooLong  - An encoded name would exceed
+   *                                  nbt_NAME_MAX bytes.
+   *          cifs_errBufrTooSmall  - The message will not fit in <bufr>.
+   *          Any other error returned by <nbt_CheckScope()>.
+   *
+   *  Notes:  As with <nbt_L2Encode()>, no syntax checking is done on the
+   *          NetBIOS names, so the "*SMBSERVER" called name can be used.
+   *          The scopes are checked, though, since a malformed scope
+   *          would not encode to the expected length.  Both names should
+   *          carry the same scope.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_ssSessionRequestNames( const uchar  *msg,
+                               const long    len,
+                               const uchar **called,
+                               const uchar **calling );
+  /* ------------------------------------------------------------------------ **
+   * Find and check the names in a received Session Request.
+   *
+   *  Input:  msg     - The message payload (the bytes following the
+   *                    header).
+   *          len     - The payload length, as returned by
+   *                    <nbt_ssGetHdr()>.
+   *          called  - Receives a pointer to the L2 encoded called name.
+   *          calling - Receives a pointer to the L2 encoded calling name.
+   *
+   *  Output: On success, zero.  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput       - <msg> is NULL.
+   *          cifs_errBadCalledName   - The called name is not a valid L2
+   *                                    encoded name.
+   *          cifs_errBadCallingName  - The calling name is not a valid L2
+   *                                    encoded name, or does not end
+   *                                    exactly at the end of the payload.
+   *
+   *  Notes:  The names are not copied.  Use <nbt_L2Decode()> to extract
+   *          the NetBIOS name from each.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_ssNegResponse( uchar *bufr, const long bSize, const uint8_t code );
+  /* ------------------------------------------------------------------------ **
+   * Build a complete Negative Session Response message.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.
+   *          code  - The error code.  One of the nbt_ssERR_* values.
+   *
+   *  Output: On success, the total length of the message (always 5).
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than 5.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int nbt_ssRetargetResponse( uchar         *bufr,
+                            const long     bSize,
+                            const uint32_t ip,
+                            const uint16_t port );
+  /* ------------------------------------------------------------------------ **
+   * Build a complete Session Retarget Response message.
+   *
+   *  Input:  bufr  - Destination buffer.
+   *          bSize - Size of <bufr>, in bytes.
+   *          ip    - The IPv4 address to which the caller should retry,
+   *                  in host byte order.
+   *          port  - The TCP port to which the caller should retry.
+   *
+   *  Output: On success, the total length of the message (always 10).
+   *          On error, a negative value.
+   *
+   *  Errors: cifs_errBufrTooSmall  - <bSize> is less than 10.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* NBT_SS_PACKET_H */
@@ -0,0 +1,362 @@
+/* ========================================================================== **
+ *
+ *                                  Stream.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Reassemble NBT Session Service messages from a byte stream.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  TCP delivers a stream of bytes, not messages.  A single read may
+ *  return part of a message, or several messages and part of another.
+ *  The reassembler takes care of that.  Data is read directly into a
+ *  ring buffer, and each complete message is handed out as a cifs_Block
+ *  that points at the message payload within the ring.  The payload is
+ *  never copied.
+ *
+ *  The usual loop looks something like this:
+ *
+ *    for(;;)
+ *      {
+ *      while( (result = nbt_ssStreamNext( s, frame, &type )) > 0 )
+ *        {
+ *        ...handle the frame...
+ *        nbt_ssStreamRelease( s, frame );
+ *        }
+ *      if( result < 0 )
+ *        ...the stream is out of sync; drop the connection...
+ *      bufr = nbt_ssStreamRecvBufr( s, &len );
+ *      n = recv( sock, bufr, len, 0 );
+ *      ...check for errors and EOF...
+ *      (void)nbt_ssStreamCommit( s, n );
+ *      }
+ *
+ *  Frames need not be released right away.  They may be held while more
+ *  data is read, but they must be released in the order in which they
+ *  were handed out.  The space a frame occupies is not reused until it
+ *  has been released.
+ *
+ *  Each message must occupy contiguous space in the ring.  When a
+ *  message will not fit in the space left at the end of the ring, it is
+ *  started again at the beginning.  To make that cheap, the reads are
+ *  cut short near the end of the ring so that they stop at the next
+ *  message boundary, or after the next header.  The most that is ever
+ *  moved is one four byte header.  Whenever the ring is empty, it is
+ *  reset to the beginning, which keeps the reads long in the common case
+ *  where each message is handled as soon as it arrives.
+ *
+ *  The same code handles NBT session messages (port 139) and naked TCP
+ *  framing (port 445).  See NBT/SS/Packet.h.
+ *
+ * ========================================================================== **
+ */
+
+#include "Stream.h"           /* Module header.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static long FrameLen( nbt_ssStream *s )
+  /* ------------------------------------------------------------------------ **
+   * Find the total length of the next message.
+   *
+   *  Input:  s - The reassembler.
+   *
+   *  Output: The length of the message at <rpos>, including the header,
+   *          or zero if the header has not yet been received.  A negative
+   *          value indicates an invalid header.
+   *
+   *  Errors: cifs_errIllegalSSType - Unknown packet type.
+   *          cifs_errInvalidSSLen  - Invalid length, or too large.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long have = s->wpos - s->rpos;
+  long len;
+
+  if( have < nbt_ssHEADER_LEN )
+    return( 0 );
+
+  if( s->raw )
+    len = nbt_ssGetRawHdr( &s->bufr[s->rpos], have );
+  else
+    len = nbt_ssGetHdr( &s->bufr[s->rpos], have, NULL );
+  if( len < 0 )
+    return( len );
+  if( len > s->maxlen )
+    return( cifs_errInvalidSSLen );
+  return( nbt_ssHEADER_LEN + len );
+  } /* FrameLen */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int nbt_ssStreamInit( nbt_ssStream *s,
+                      cifs_Block   *ring,
+                      const long    maxlen,
+                      const bool    raw )
+  /* ------------------------------------------------------------------------ **
+   * Initialize a stream reassembler.
+   *
+   *  Input:  s       - The reassembler to be initialized.
+   *          ring    - The block that will hold the ring buffer.  The whole
+   *                    buffer is used.  The block header itself is not
+   *                    referenced again.
+   *          maxlen  - The largest message payload that will be accepted.
+   *                    Zero means the largest allowed by the framing.
+   *          raw     - If true, expect naked TCP (port 445) framing.
+   *                    Otherwise, expect NBT session messages.
+   *
+   *  Output: On success, zero.  On error, a negative value.
+   *
+   *  Errors: cifs_errNullInput     - <ring> is NULL, or has no buffer.
+   *          cifs_errInvalidSSLen  - <maxlen> is negative, or exceeds the
+   *                                  limit for the framing.
+   *          cifs_errBufrTooSmall  - The ring cannot hold a message of
+   *                                  <maxlen> bytes plus its header.
+   *
+   *  Notes:  The ring should be at least twice the size of the largest
+   *          message, so that one message can be handled while the next
+   *          one is being received.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long limit = raw ? nbt_ssMAX_RAW_LEN : nbt_ssMAX_LEN;
+
+  if( (NULL == ring) || (NULL == ring->bufr) )
+    return( cifs_errNullInput );
+  if( (maxlen < 0) || (maxlen > limit) )
+    return( cifs_errInvalidSSLen );
+  if( 0 == maxlen )
+    {
+    if( ring->size < (nbt_ssHEADER_LEN + limit) )
+      return( cifs_errBufrTooSmall );
+    }
+  else
+    {
+    if( ring->size < (nbt_ssHEADER_LEN + maxlen) )
+      return( cifs_errBufrTooSmall );
+    limit = maxlen;
+    }
+
+  s->bufr    = ring->bufr;
+  s->size    = ring->size;
+  s->maxlen  = limit;
+  s->raw     = raw;
+  s->head    = 0;
+  s->rpos    = 0;
+  s->wpos    = 0;
+  s->mark    = 0;
+  s->wrapped = false;
+  return( 0 );
+  } /* nbt_ssStreamInit */
+
+
+uchar *nbt_ssStreamRecvBufr( nbt_ssStream *s, long *len )
+  /* ------------------------------------------------------------------------ **
+   * Find the space into which the next read should go.
+   *
+   *  Input:  s   - The reassembler.
+   *          len - Receives the number of bytes that may be read.
+   *
+   *  Output: A pointer to the space into which to read, or NULL (with
+   *          <*len> set to zero) if there is no space.
+   *
+   *  Notes:  There is no space if all of the room in the ring is taken by
+   *          frames that have not been released, or if a complete frame
+   *          is waiting to be collected with <nbt_ssStreamNext()>, or if
+   *          the stream is out of sync.
+   *
+   *          The length may be much less than the free space in the ring.
+   *          Near the end of the ring, reads are cut short at message
+   *          boundaries.  See the notes at the top of this module.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long total;
+  long want;
+  long top;
+  long zone;
+  long n;
+
+  *len = 0;
+
+  /* If everything has been handed out and released, start over. */
+  if( !s->wrapped && (s->head == s->wpos) )
+    s->head = s->rpos = s->wpos = 0;
+
+  total = FrameLen( s );
+  if( total < 0 )
+    return( NULL );
+  want = total ? total : nbt_ssHEADER_LEN;
+  top  = s->wrapped ? s->head : s->size;
+
+  /* If the message will not fit where it is, move its start (at most one
+   * header) to the beginning of the ring.
+   */
+  if( (s->rpos + want) > top )
+    {
+    if( s->wrapped || ((s->head < s->rpos) && (want > s->head)) )
+      return( NULL );
+    n = s->wpos - s->rpos;
+    (void)memmove( s->bufr, &s->bufr[s->rpos], n );
+    if( s->head < s->rpos )
+      {
+      s->mark    = s->rpos;
+      s->wrapped = true;
+      top        = s->head;
+      }
+    else
+      s->head = 0;
+    s->rpos = 0;
+    s->wpos = n;
+    }
+
+  /* Past <zone>, a message might not fit before the end of the ring, so
+   * reads stop at the end of the current message, or of its header.
+   */
+  zone = s->size - (nbt_ssHEADER_LEN + s->maxlen);
+  want += s->rpos;
+  if( want < zone )
+    want = zone;
+  n = ((want < top) ? want : top) - s->wpos;
+  if( n < 1 )
+    return( NULL );
+
+  *len = n;
+  return( &s->bufr[s->wpos] );
+  } /* nbt_ssStreamRecvBufr */
+
+
+long nbt_ssStreamCommit( nbt_ssStream *s, const long len )
+  /* ------------------------------------------------------------------------ **
+   * Account for bytes read into the space given by nbt_ssStreamRecvBufr().
+   *
+   *  Input:  s   - The reassembler.
+   *          len - The number of bytes that were read.
+   *
+   *  Output: The number of bytes received but not yet handed out.
+   *
+   *  Notes:  <len> must not exceed the length returned by the last call
+   *          to <nbt_ssStreamRecvBufr()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( len > 0 )
+    s->wpos += len;
+  return( s->wpos - s->rpos );
+  } /* nbt_ssStreamCommit */
+
+
+int nbt_ssStreamNext( nbt_ssStream *s, cifs_Block *frame, uint8_t *type )
+  /* ------------------------------------------------------------------------ **
+   * Collect the next complete message.
+   *
+   *  Input:  s     - The reassembler.
+   *          frame - A block header that will be set to cover the message
+   *                  payload.  Both <size> and <used> are set to the
+   *                  payload length.
+   *          type  - Receives the session packet type.  With naked TCP
+   *                  framing, this is always nbt_ssSESSION_MESSAGE.  May
+   *                  be NULL.
+   *
+   *  Output: One if a message was returned, zero if more data is needed,
+   *          or a negative value if the stream is out of sync.
+   *
+   *  Errors: cifs_errIllegalSSType - The next header has an unknown type.
+   *          cifs_errInvalidSSLen  - The next header has an invalid length,
+   *                                  or the message is larger than the
+   *                                  <maxlen> given to nbt_ssStreamInit().
+   *
+   *  Notes:  Keep alive messages are returned like any other.  They have
+   *          a zero-length payload and must also be released.
+   *
+   *          Once an error has been returned, the stream cannot recover.
+   *          There is no way to find the next message boundary.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long total = FrameLen( s );
+
+  if( total < 1 )
+    return( (int)total );
+  if( (s->wpos - s->rpos) < total )
+    return( 0 );
+
+  if( NULL != type )
+    *type = s->bufr[s->rpos];
+  (void)cifs_BlockInit( frame, total - nbt_ssHEADER_LEN,
+                        &s->bufr[s->rpos + nbt_ssHEADER_LEN] );
+  frame->used = frame->size;
+  s->rpos += total;
+  return( 1 );
+  } /* nbt_ssStreamNext */
+
+
+void nbt_ssStreamRelease( nbt_ssStream *s, const cifs_Block *frame )
+  /* ------------------------------------------------------------------------ **
+   * Release a frame returned by nbt_ssStreamNext().
+   *
+   *  Input:  s     - The reassembler.
+   *          frame - The frame to be released.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  Frames must be released in the order in which they were
+   *          handed out.  Releasing a frame also releases any frames that
+   *          were handed out before it.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long start = (long)(frame->bufr - s->bufr) - nbt_ssHEADER_LEN;
+
+  if( s->wrapped && (start < s->head) )
+    s->wrapped = false;
+  s->head = start + nbt_ssHEADER_LEN + frame->size;
+  if( s->wrapped && (s->head == s->mark) )
+    {
+    s->head    = 0;
+    s->wrapped = false;
+    }
+  } /* nbt_ssStreamRelease */
+
+/* ========================================================================== */
@@ -0,0 +1,217 @@
+/* ========================================================================== **
+ *
+ *                                 Announce.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Parse Browser Protocol frames carried in \MAILSLOT\BROWSE datagrams.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Browser frames travel as the data of an SMB_COM_TRANSACTION request
+ *  that writes to the \MAILSLOT\BROWSE mailslot.  That request is the
+ *  user data of an NBT datagram (see NBT/DS/Packet.h).  There is no
+ *  session, so the SMB header carries nothing of interest.
+ *
+ *  <smb_brwParse()> checks the SMB header, the transaction words and the
+ *  mailslot name, and returns the browser frame's opcode.  For the three
+ *  announcement frames (HostAnnouncement, DomainAnnouncement and
+ *  LocalMasterAnnouncement), which all share one layout, the fields are
+ *  filled in as well.  Like <nbt_dsParse()>, nothing is copied.  The
+ *  name and comment point into the datagram.
+ *
+ *  All multi-byte fields in these frames are in SMB (little-endian) byte
+ *  order.
+ *
+ * ========================================================================== **
+ */
+
+#include <ctype.h>            /* For toupper(3).                    */
+#include <string.h>           /* For memset(3).                     */
+
+#include "Announce.h"         /* Module header.                     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  Offsets within an SMB_COM_TRANSACTION request, from the start of the
+ *  SMB header.  See section 3.15 of "Implementing CIFS".
+ *
+ *  BRW_TRANS_DATACNT   - DataCount.
+ *  BRW_TRANS_DATAOFF   - DataOffset, which is relative to the SMB header.
+ *  BRW_TRANS_SETUPCNT  - SetupCount.
+ *  BRW_TRANS_SETUP     - The first setup word.
+ *  BRW_TRANS_WORDS     - The end of the fixed words, where the setup
+ *                        words begin.
+ *
+ *  BRW_MAILSLOT_WRITE  - The first setup word of a mailslot write.
+ *  BRW_MAILSLOT_LEN    - Length of smb_brwMAILSLOT, including the nul.
+ */
+
+#define BRW_TRANS_DATACNT   55
+#define BRW_TRANS_DATAOFF   57
+#define BRW_TRANS_SETUPCNT  59
+#define BRW_TRANS_SETUP     61
+#define BRW_TRANS_WORDS     61
+
+#define BRW_MAILSLOT_WRITE  1
+#define BRW_MAILSLOT_LEN    ((int)sizeof( smb_brwMAILSLOT ))
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int smb_brwParse( smb_brwAnnounce *ann, const cifs_Block *data )
+  /* ------------------------------------------------------------------------ **
+   * Parse a browser frame from the user data of a datagram.
+   *
+   *  Input:  ann   - The structure to be filled in.
+   *          data  - The datagram's user data (eg., the <data> field of an
+   *                  nbt_dsMsg).  The used portion of the block is read.
+   *
+   *  Output: On success, the browser frame opcode.  On error, a negative
+   *          value.
+   *
+   *  Errors: cifs_errNullInput       - <ann>, <data> or its buffer is NULL.
+   *          cifs_errBufrTooSmall    - Too short to hold an SMB header.
+   *          cifs_errTruncatedBufr   - The transaction or the frame runs
+   *                                    past the end of the data.
+   *          cifs_errInvalidPacket   - Not an SMB, not a mailslot write
+   *                                    transaction, or not addressed to
+   *                                    \MAILSLOT\BROWSE.
+   *
+   *  Notes:  <ann->opcode> and <ann->frame> are set for any browser
+   *          frame.  The remaining fields are only filled in for the
+   *          announcement opcodes, and are zeroed otherwise.
+   *
+   *          <ann->name> points at the 16 byte, nul padded name field.
+   *          <ann->comment> is not nul terminated; use <ann->comment_len>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  const uchar *bufr;
+  const uchar *frame;
+  long         len;
+  long         pos;
+  long         doff;
+  long         dlen;
+  int          wc;
+  int          sc;
+  int          i;
+
+  if( (NULL == ann) || (NULL == data) || (NULL == data->bufr) )
+    return( cifs_errNullInput );
+  bufr = data->bufr;
+  len  = data->used;
+  (void)memset( ann, 0, sizeof( smb_brwAnnounce ) );
+
+  /* SMB header, then the Transaction request's words.
+   */
+  i = smb_hdrCheck( (uchar *)bufr, (int)len );
+  if( i < 0 )
+    return( i );
+  if( SMB_COM_TRANSACTION != smb_hdrGetCmd( bufr ) )
+    return( cifs_errInvalidPacket );
+  if( len < (BRW_TRANS_WORDS + 1) )
+    return( cifs_errTruncatedBufr );
+  wc = bufr[smb_HEADER_LEN];
+  sc = bufr[BRW_TRANS_SETUPCNT];
+  if( (wc != (BRW_TRANS_WORDS - smb_HEADER_LEN - 1) / 2 + sc) || (sc < 1) )
+    return( cifs_errInvalidPacket );
+  pos = smb_HEADER_LEN + 1 + (2 * wc);
+  if( len < (pos + 2) )
+    return( cifs_errTruncatedBufr );
+  if( BRW_MAILSLOT_WRITE != smb_GetShort( bufr, BRW_TRANS_SETUP ) )
+    return( cifs_errInvalidPacket );
+
+  /* The mailslot name follows the byte count.
+   */
+  pos += 2;
+  if( len < (pos + BRW_MAILSLOT_LEN) )
+    return( cifs_errTruncatedBufr );
+  for( i = 0; i < BRW_MAILSLOT_LEN; i++ )
+    {
+    if( toupper( bufr[pos + i] ) != (uchar)smb_brwMAILSLOT[i] )
+      return( cifs_errInvalidPacket );
+    }
+
+  /* The browser frame is the transaction data.
+   */
+  doff = smb_GetShort( bufr, BRW_TRANS_DATAOFF );
+  dlen = smb_GetShort( bufr, BRW_TRANS_DATACNT );
+  if( (dlen < 1) || (doff < (pos + BRW_MAILSLOT_LEN)) )
+    return( cifs_errInvalidPacket );
+  if( (doff + dlen) > len )
+    return( cifs_errTruncatedBufr );
+  frame = &bufr[doff];
+  (void)cifs_BlockInit( &ann->frame, dlen, (uchar *)frame );
+  ann->frame.used = dlen;
+  ann->opcode     = frame[0];
+
+  switch( ann->opcode )
+    {
+    case smb_brwHOST_ANNOUNCEMENT:
+    case smb_brwDOMAIN_ANNOUNCEMENT:
+    case smb_brwLOCAL_MASTER_ANNOUNCEMENT:
+      break;
+    default:
+      return( ann->opcode );
+    }
+
+  if( dlen < smb_brwANNOUNCE_LEN )
+    return( cifs_errTruncatedBufr );
+  ann->update     = frame[1];
+  ann->period     = smb_GetLong( frame, 2 );
+  ann->name       = &frame[6];
+  ann->os_major   = frame[22];
+  ann->os_minor   = frame[23];
+  ann->type       = smb_GetLong( frame, 24 );
+  ann->brw_major  = frame[28];
+  ann->brw_minor  = frame[29];
+  ann->signature  = smb_GetShort( frame, 30 );
+  ann->comment    = &frame[smb_brwANNOUNCE_LEN];
+
+  /* The comment should be nul terminated, but a missing nul is forgiven.
+   */
+  dlen -= smb_brwANNOUNCE_LEN;
+  if( dlen > smb_brwCOMMENT_MAX )
+    dlen = smb_brwCOMMENT_MAX;
+  for( i = 0; (i < dlen) && ('\0' != ann->comment[i]); i++ )
+    ;
+  ann->comment_len = (uint8_t)i;
+
+  return( ann->opcode );
+  } /* smb_brwParse */
+
+/* ========================================================================== */
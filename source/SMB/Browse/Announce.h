@@ -0,0 +1,202 @@
+#ifndef SMB_BROWSE_ANNOUNCE_H
+#define SMB_BROWSE_ANNOUNCE_H
+/* ========================================================================== **
+ *
+ *                                 Announce.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Parse Browser Protocol frames carried in \MAILSLOT\BROWSE datagrams.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Browser frames travel as the data of an SMB_COM_TRANSACTION request
+ *  that writes to the \MAILSLOT\BROWSE mailslot.  That request is the
+ *  user data of an NBT datagram (see NBT/DS/Packet.h).  There is no
+ *  session, so the SMB header carries nothing of interest.
+ *
+ *  <smb_brwParse()> checks the SMB header, the transaction words and the
+ *  mailslot name, and returns the browser frame's opcode.  For the three
+ *  announcement frames (HostAnnouncement, DomainAnnouncement and
+ *  LocalMasterAnnouncement), which all share one layout, the fields are
+ *  filled in as well.  Like <nbt_dsParse()>, nothing is copied.  The
+ *  name and comment point into the datagram.
+ *
+ *  All multi-byte fields in these frames are in SMB (little-endian) byte
+ *  order.
+ *
+ * ========================================================================== **
+ */
+
+#include "SMB/smb_common.h"   /* SMB subsystem common include file. */
+#include "SMB/Header.h"       /* SMB header fields.                 */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  smb_brwMAILSLOT       - The name of the browser mailslot, upper case.
+ *
+ *  Browser frame opcodes (the first byte of the mailslot data).
+ *
+ *  smb_brwHOST_ANNOUNCEMENT          - A server announces itself to the
+ *                                      workgroup (sent to WORKGROUP<1D>).
+ *  smb_brwANNOUNCEMENT_REQUEST       - Ask servers to announce themselves.
+ *  smb_brwREQUEST_ELECTION           - Master browser election.
+ *  smb_brwGET_BACKUP_LIST_REQUEST    - Ask a master for its backups.
+ *  smb_brwGET_BACKUP_LIST_RESPONSE   - The answer.
+ *  smb_brwBECOME_BACKUP              - Tell a potential browser to start.
+ *  smb_brwDOMAIN_ANNOUNCEMENT        - A local master announces its
+ *                                      workgroup (sent to __MSBROWSE__).
+ *  smb_brwMASTER_ANNOUNCEMENT        - A local master announces itself to
+ *                                      the domain master.
+ *  smb_brwRESET_STATE                - Tell a browser to stop or reset.
+ *  smb_brwLOCAL_MASTER_ANNOUNCEMENT  - A local master announces itself
+ *                                      (sent to WORKGROUP<1E>).
+ *
+ *  smb_brwANNOUNCE_LEN   - The fixed part of an announcement frame, from
+ *                          the opcode up to the comment.
+ *  smb_brwCOMMENT_MAX    - The longest comment that will be returned.
+ *
+ *  Server type bits (the <type> field of an announcement).  Only the ones
+ *  that the collector cares about are listed here.
+ *
+ *  smb_brwSV_TYPE_WORKSTATION      - The host is a workstation.
+ *  smb_brwSV_TYPE_SERVER           - The host offers file service.
+ *  smb_brwSV_TYPE_DOMAIN_CTRL      - Primary domain controller.
+ *  smb_brwSV_TYPE_BACKUP_BROWSER   - Backup browser.
+ *  smb_brwSV_TYPE_MASTER_BROWSER   - Local master browser.
+ *  smb_brwSV_TYPE_DOMAIN_MASTER    - Domain master browser.
+ *  smb_brwSV_TYPE_DOMAIN_ENUM      - Set in DomainAnnouncements.
+ */
+
+#define smb_brwMAILSLOT "\\MAILSLOT\\BROWSE"
+
+#define smb_brwHOST_ANNOUNCEMENT          0x01
+#define smb_brwANNOUNCEMENT_REQUEST       0x02
+#define smb_brwREQUEST_ELECTION           0x08
+#define smb_brwGET_BACKUP_LIST_REQUEST    0x09
+#define smb_brwGET_BACKUP_LIST_RESPONSE   0x0A
+#define smb_brwBECOME_BACKUP              0x0B
+#define smb_brwDOMAIN_ANNOUNCEMENT        0x0C
+#define smb_brwMASTER_ANNOUNCEMENT        0x0D
+#define smb_brwRESET_STATE                0x0E
+#define smb_brwLOCAL_MASTER_ANNOUNCEMENT  0x0F
+
+#define smb_brwANNOUNCE_LEN   32
+#define smb_brwCOMMENT_MAX    43
+
+#define smb_brwSV_TYPE_WORKSTATION      0x00000001
+#define smb_brwSV_TYPE_SERVER           0x00000002
+#define smb_brwSV_TYPE_DOMAIN_CTRL      0x00000008
+#define smb_brwSV_TYPE_BACKUP_BROWSER   0x00020000
+#define smb_brwSV_TYPE_MASTER_BROWSER   0x00040000
+#define smb_brwSV_TYPE_DOMAIN_MASTER    0x00080000
+#define smb_brwSV_TYPE_DOMAIN_ENUM      0x80000000
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  smb_brwAnnounce - A parsed browser frame.
+ *                    opcode      - The browser frame opcode.
+ *                    frame       - A view of the whole browser frame.
+ *                    update      - The update count.
+ *                    period      - Announcement interval, in ms.
+ *                    name        - Server name (or, in a domain
+ *                                  announcement, the workgroup name).
+ *                                  Sixteen bytes, nul padded.
+ *                    os_major    - Operating system major version.
+ *                    os_minor    - Operating system minor version.
+ *                    type        - Server type bits.
+ *                    brw_major   - Browser protocol major version.
+ *                    brw_minor   - Browser protocol minor version.
+ *                    signature   - Should be 0xAA55.
+ *                    comment     - The server comment (or, in a domain
+ *                                  announcement, the name of the local
+ *                                  master browser).
+ *                    comment_len - Length of <comment>.
+ */
+
+typedef struct
+  {
+  uint8_t      opcode;
+  cifs_Block   frame;
+  uint8_t      update;
+  uint32_t     period;
+  const uchar *name;
+  uint8_t      os_major;
+  uint8_t      os_minor;
+  uint32_t     type;
+  uint8_t      brw_major;
+  uint8_t      brw_minor;
+  uint16_t     signature;
+  const uchar *comment;
+  uint8_t      comment_len;
+  } smb_brwAnnounce;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+int smb_brwParse( smb_brwAnnounce *ann, const cifs_Block *data );
+  /* ------------------------------------------------------------------------ **
+   * Parse a browser frame from the user data of a datagram.
+   *
+   *  Input:  ann   - The structure to be filled in.
+   *          data  - The datagram's user data (eg., the <data> field of an
+   *                  nbt_dsMsg).  The used portion of the block is read.
+   *
+   *  Output: On success, the browser frame opcode.  On error, a negative
+   *          value.
+   *
+   *  Errors: cifs_errNullInput       - <ann>, <data> or its buffer is NULL.
+   *          cifs_errBufrTooSmall    - Too short to hold an SMB header.
+   *          cifs_errTruncatedBufr   - The transaction or the frame runs
+   *                                    past the end of the data.
+   *          cifs_errInvalidPacket   - Not an SMB, not a mailslot write
+   *                                    transaction, or not addressed to
+   *                                    \MAILSLOT\BROWSE.
+   *
+   *  Notes:  <ann->opcode> and <ann->frame> are set for any browser
+   *          frame.  The remaining fields are only filled in for the
+   *          announcement opcodes, and are zeroed otherwise.
+   *
+   *          <ann->name> points at the 16 byte, nul padded name field.
+   *          <ann->comment> is not nul terminated; use <ann->comment_len>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* SMB_BROWSE_ANNOUNCE_H */
@@ -0,0 +1,812 @@
+/* ========================================================================== **
+ *
+ *                                Collector.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Passively collect browser announcements into a live host table.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Every server on a LAN broadcasts a HostAnnouncement to its workgroup
+ *  every few minutes, and every local master browser broadcasts a
+ *  DomainAnnouncement for its workgroup.  Simply listening on UDP port
+ *  138 is enough to learn the hosts and workgroups on the wire, without
+ *  sending a single query.  This module keeps that table.
+ *
+ *  The table is written by one thread (the receive loop) and read by any
+ *  number of others:
+ *
+ *  - <smb_brwCollect()> takes a parsed (and, if need be, reassembled)
+ *    datagram and adds, refreshes or removes one record.  Records live
+ *    in a dense array, are found through a hash table, and their expiry
+ *    times are kept in a hashed timer wheel, so every update is O(1).
+ *    A record expires when nothing has been heard from it for
+ *    smb_brwLIFETIME announcement periods, as the announcements
+ *    themselves specify.
+ *
+ *  - <smb_brwPublish()> copies the records into a read-only snapshot,
+ *    but only if something has changed since the last one.  The copy is
+ *    a single memcpy(3) of the dense array.
+ *
+ *  - <smb_brwSnapGet()> hands a reader the current snapshot, with a
+ *    reference held.  The reader may take as long as it likes with it;
+ *    publishing a new snapshot does not wait for readers, and the old
+ *    one is freed when its last reader lets go.  The only lock is a spin
+ *    lock held while the snapshot pointer is read or swapped.
+ *
+ *  Reader thread-safety depends upon cifs_ATOMICS.  Without it, all of
+ *  the calls must be made from the same thread.
+ *
+ * ========================================================================== **
+ */
+
+#include <stdlib.h>           /* For malloc(3), calloc(3) and free(3). */
+#include <string.h>           /* For memcpy(3), memcmp(3), memset(3).  */
+#include <time.h>             /* For clock_gettime(2).                 */
+
+#include "Collector.h"        /* Module header.                        */
+#include "NBT/Names.h"        /* For nbt_L1Decode().                   */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  BRW_TICKBITS  - Each bucket of the timer wheel covers 2^BRW_TICKBITS
+ *                  milliseconds (about 16 seconds).  The wheel turns once
+ *                  every four and a half hours or so, which is longer than
+ *                  the longest record lifetime, so no record is ever more
+ *                  than one turn ahead.  The shortest lifetime is three
+ *                  minutes, so the coarse ticks cost little; <Expire()>
+ *                  still checks each record's exact expiry time.
+ */
+
+#define BRW_TICKBITS 14
+
+#if ((smb_brwWHEEL << BRW_TICKBITS) <= (smb_brwPERIOD_MAX * smb_brwLIFETIME))
+#error "The timer wheel must span the longest record lifetime."
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Macros:
+ *
+ *  AtomicHold( P ) - Add one to the reference count <*P>.
+ *  AtomicDrop( P ) - Subtract one from <*P> and return the new count.
+ *  Lock( C )       - Take the snapshot pointer lock.
+ *  Unlock( C )     - Release the snapshot pointer lock.
+ *
+ *  Without cifs_ATOMICS these reduce to plain accesses and no-ops.
+ */
+
+#if defined( cifs_ATOMICS )
+#define AtomicHold( P ) (void)__atomic_add_fetch( (P), 1, __ATOMIC_RELAXED )
+#define AtomicDrop( P ) __atomic_sub_fetch( (P), 1, __ATOMIC_ACQ_REL )
+#define Lock( C ) \
+  while( __atomic_exchange_n( &(C)->lock, 1, __ATOMIC_ACQUIRE ) ) Pause()
+#define Unlock( C ) __atomic_store_n( &(C)->lock, 0, __ATOMIC_RELEASE )
+#if defined( __i386__ ) || defined( __x86_64__ )
+#define Pause() __builtin_ia32_pause()
+#else
+#define Pause() ((void)0)
+#endif
+#else
+#define AtomicHold( P ) (void)(++(*(P)))
+#define AtomicDrop( P ) (--(*(P)))
+#define Lock( C )       ((void)0)
+#define Unlock( C )     ((void)0)
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static uint32_t Now( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a millisecond clock.
+   *
+   *  Input:  none.
+   *  Output: Milliseconds since some arbitrary point, modulo 2^32.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000) );
+  } /* Now */
+
+
+static void CopyName( uchar *dst, const uchar *src )
+  /* ------------------------------------------------------------------------ **
+   * Copy a name from an announcement.
+   *
+   *  Input:  dst - Sixteen bytes to receive the name.
+   *          src - The sixteen byte name field of the announcement.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  The name is cut at the first nul or after fifteen bytes, and
+   *          trailing spaces are removed.  The rest of <dst> is zeroed,
+   *          so that names can be compared with memcmp(3).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  for( i = 0; (i < 15) && ('\0' != src[i]); i++ )
+    dst[i] = src[i];
+  while( (i > 0) && (' ' == dst[i - 1]) )
+    i--;
+  (void)memset( &dst[i], 0, 16 - i );
+  } /* CopyName */
+
+
+static uint32_t Hash( const smb_brwRecord *key )
+  /* ------------------------------------------------------------------------ **
+   * Hash a record key.
+   *
+   *  Input:  key - A record with <kind>, <name> and <group> filled in.
+   *
+   *  Output: A 32-bit FNV-1a hash of the key.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t h = 2166136261u;
+  int      i;
+
+  h = (h ^ key->kind) * 16777619u;
+  for( i = 0; i < 16; i++ )
+    h = (h ^ key->name[i]) * 16777619u;
+  for( i = 0; i < 16; i++ )
+    h = (h ^ key->group[i]) * 16777619u;
+  return( h );
+  } /* Hash */
+
+
+static int32_t Lookup( smb_brwCollector    *c,
+                       const smb_brwRecord *key,
+                       const uint32_t       hash )
+  /* ------------------------------------------------------------------------ **
+   * Find a record.
+   *
+   *  Input:  c     - The collector.
+   *          key   - The key, as given to <Hash()>.
+   *          hash  - The hash of <key>.
+   *
+   *  Output: The index of the record, or -1 if there is none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int32_t        i;
+  smb_brwRecord *r;
+
+  for( i = c->bucket[hash & (c->nbuckets - 1)]; i >= 0; i = c->link[i].hnext )
+    {
+    r = &c->rec[i];
+    if( (c->link[i].hash == hash) && (r->kind == key->kind)
+     && (0 == memcmp( r->name, key->name, 16 ))
+     && (0 == memcmp( r->group, key->group, 16 )) )
+      return( i );
+    }
+  return( -1 );
+  } /* Lookup */
+
+
+static void TimerAdd( smb_brwCollector *c,
+                      const int32_t     idx,
+                      const uint32_t    expires )
+  /* ------------------------------------------------------------------------ **
+   * Put a record into the timer wheel.
+   *
+   *  Input:  c       - The collector.
+   *          idx     - The record.
+   *          expires - When the record expires, per <Now()>.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int32_t *head = &c->wheel[(expires >> BRW_TICKBITS) & (smb_brwWHEEL - 1)];
+
+  c->link[idx].expires = expires;
+  c->link[idx].prev    = -1;
+  c->link[idx].next    = *head;
+  if( *head >= 0 )
+    c->link[*head].prev = idx;
+  *head = idx;
+  } /* TimerAdd */
+
+
+static void TimerDel( smb_brwCollector *c, const int32_t idx )
+  /* ------------------------------------------------------------------------ **
+   * Take a record out of the timer wheel.
+   *
+   *  Input:  c   - The collector.
+   *          idx - The record.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  smb_brwLink *l = &c->link[idx];
+
+  if( l->prev >= 0 )
+    c->link[l->prev].next = l->next;
+  else
+    c->wheel[(l->expires >> BRW_TICKBITS) & (smb_brwWHEEL - 1)] = l->next;
+  if( l->next >= 0 )
+    c->link[l->next].prev = l->prev;
+  } /* TimerDel */
+
+
+static int32_t *HashRef( smb_brwCollector *c, const int32_t idx )
+  /* ------------------------------------------------------------------------ **
+   * Find the hash chain link that points to a record.
+   *
+   *  Input:  c   - The collector.
+   *          idx - The record.
+   *
+   *  Output: A pointer to the bucket head or <hnext> field that holds
+   *          <idx>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int32_t *ref = &c->bucket[c->link[idx].hash & (c->nbuckets - 1)];
+
+  while( *ref != idx )
+    ref = &c->link[*ref].hnext;
+  return( ref );
+  } /* HashRef */
+
+
+static void Remove( smb_brwCollector *c, const int32_t idx )
+  /* ------------------------------------------------------------------------ **
+   * Remove a record.
+   *
+   *  Input:  c   - The collector.
+   *          idx - The record.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  The last record in the array is moved into the hole, so the
+   *          array stays dense.  Its index changes to <idx>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int32_t      last = c->count - 1;
+  smb_brwLink *l;
+
+  TimerDel( c, idx );
+  *HashRef( c, idx ) = c->link[idx].hnext;
+
+  if( idx != last )
+    {
+    *HashRef( c, last ) = idx;
+    c->rec[idx]  = c->rec[last];
+    c->link[idx] = c->link[last];
+    l = &c->link[idx];
+    if( l->prev >= 0 )
+      c->link[l->prev].next = idx;
+    else
+      c->wheel[(l->expires >> BRW_TICKBITS) & (smb_brwWHEEL - 1)] = idx;
+    if( l->next >= 0 )
+      c->link[l->next].prev = idx;
+    }
+  c->count = last;
+  } /* Remove */
+
+
+static int32_t Soonest( smb_brwCollector *c )
+  /* ------------------------------------------------------------------------ **
+   * Find the record that will expire soonest.
+   *
+   *  Input:  c - The collector.  It must not be empty.
+   *
+   *  Output: The index of the record.
+   *
+   *  Notes:  The wheel spans the longest record lifetime, so every
+   *          record is less than one turn ahead and the first non-empty
+   *          bucket at or after the current tick holds the earliest
+   *          timers.  The earliest record in that bucket is the earliest
+   *          in the table.  <Expire()> must have been called first so
+   *          that the current tick is up to date.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int32_t  best = -1;
+  int32_t  i;
+  uint32_t t;
+
+  for( t = 0; (best < 0) && (t < smb_brwWHEEL); t++ )
+    {
+    i = c->wheel[(c->tick + t) & (smb_brwWHEEL - 1)];
+    for( ; i >= 0; i = c->link[i].next )
+      if( (best < 0)
+       || ((int32_t)(c->link[i].expires - c->link[best].expires) < 0) )
+        best = i;
+    }
+  return( best );
+  } /* Soonest */
+
+
+static int Expire( smb_brwCollector *c, const uint32_t now )
+  /* ------------------------------------------------------------------------ **
+   * Remove records whose time is up.
+   *
+   *  Input:  c   - The collector.
+   *          now - The current time, per <Now()>.
+   *
+   *  Output: The number of records removed.
+   *
+   *  Notes:  Each wheel bucket between the last tick processed and now
+   *          is examined.  If more than a full turn has passed, every
+   *          bucket is examined once.
+   *
+   *          <Remove()> moves the last record into the hole it leaves.
+   *          If that record is the next one on the list being walked,
+   *          the walk continues from its new index.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uint32_t tick  = now >> BRW_TICKBITS;
+  uint32_t steps = tick - c->tick + 1;
+  uint32_t t;
+  int      count = 0;
+  int32_t  i;
+  int32_t  next;
+
+  if( (int32_t)(tick - c->tick) < 0 )
+    return( 0 );
+  if( steps > smb_brwWHEEL )
+    steps = smb_brwWHEEL;
+
+  for( t = 0; t < steps; t++ )
+    {
+    i = c->wheel[(c->tick + t) & (smb_brwWHEEL - 1)];
+    for( ; i >= 0; i = next )
+      {
+      next = c->link[i].next;
+      if( (int32_t)(c->link[i].expires - now) > 0 )
+        continue;
+      if( next == (c->count - 1) )
+        next = i;
+      Remove( c, i );
+      count++;
+      }
+    }
+  c->tick     = tick;
+  c->expired += count;
+  if( count > 0 )
+    c->gen++;
+  return( count );
+  } /* Expire */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+smb_brwCollector *smb_brwNew( const int maxrec )
+  /* ------------------------------------------------------------------------ **
+   * Create an announcement collector.
+   *
+   *  Input:  maxrec  - The largest number of records (hosts plus
+   *                    workgroups) that will be kept.
+   *
+   *  Output: A pointer to the new collector, or NULL if <maxrec> is less
+   *          than one or memory could not be allocated.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  smb_brwCollector *c;
+  uint32_t          nbuckets = 1;
+  int               i;
+
+  if( maxrec < 1 )
+    return( NULL );
+  while( nbuckets < (uint32_t)maxrec * 2 )
+    nbuckets <<= 1;
+
+  c = (smb_brwCollector *)calloc( 1, sizeof( smb_brwCollector ) );
+  if( NULL == c )
+    return( NULL );
+  c->rec    = (smb_brwRecord *)calloc( maxrec, sizeof( smb_brwRecord ) );
+  c->link   = (smb_brwLink *)calloc( maxrec, sizeof( smb_brwLink ) );
+  c->bucket = (int32_t *)malloc( nbuckets * sizeof( int32_t ) );
+  if( (NULL == c->rec) || (NULL == c->link) || (NULL == c->bucket) )
+    {
+    smb_brwFree( c );
+    return( NULL );
+    }
+
+  c->maxrec   = maxrec;
+  c->nbuckets = nbuckets;
+  for( i = 0; i < (int)nbuckets; i++ )
+    c->bucket[i] = -1;
+  for( i = 0; i < smb_brwWHEEL; i++ )
+    c->wheel[i] = -1;
+  c->tick = Now() >> BRW_TICKBITS;
+  c->gen  = 1;
+  return( c );
+  } /* smb_brwNew */
+
+
+void smb_brwFree( smb_brwCollector *c )
+  /* ------------------------------------------------------------------------ **
+   * Destroy an announcement collector.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  Snapshots still held by readers are not freed until the
+   *          readers release them.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( NULL == c )
+    return;
+  if( NULL != c->snap )
+    smb_brwSnapPut( c->snap );
+  free( c->spare );
+  free( c->bucket );
+  free( c->link );
+  free( c->rec );
+  free( c );
+  } /* smb_brwFree */
+
+
+int smb_brwCollect( smb_brwCollector *c, const nbt_dsMsg *msg )
+  /* ------------------------------------------------------------------------ **
+   * Update the table from a received datagram.
+   *
+   *  Input:  c   - The collector.
+   *          msg - A parsed, complete datagram.  See <nbt_dsParse()> and
+   *                <nbt_dsReasmAdd()>.
+   *
+   *  Output: One if the table was changed, zero if the datagram was not
+   *          an announcement that the collector keeps, or a negative
+   *          value if the browser frame was malformed.
+   *
+   *  Errors: cifs_errNullInput     - <c> or <msg> is NULL.
+   *          Any error returned by <smb_brwParse()>.
+   *
+   *  Notes:  A HostAnnouncement or LocalMasterAnnouncement updates the
+   *          host's record.  The workgroup is taken from the datagram's
+   *          destination name, which must be a <1D> or <1E> name.  A
+   *          DomainAnnouncement updates the workgroup's record.
+   *
+   *          An announcement with a server type of zero means that the
+   *          host is shutting down, so its record is removed.
+   *
+   *          If the table is full, the record that would expire soonest
+   *          is evicted to make room.
+   *
+   *          Partial datagram fragments are ignored.  Reassemble them
+   *          first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  smb_brwAnnounce  ann;
+  smb_brwRecord    key;
+  smb_brwRecord   *rec;
+  uint32_t         now;
+  uint32_t         period;
+  uint32_t         hash;
+  int32_t          idx;
+  uchar            sfx;
+  int              i;
+
+  if( (NULL == c) || (NULL == msg) )
+    return( cifs_errNullInput );
+  c->frames++;
+  if( (msg->flags & nbt_dsFLAG_MORE) || !(msg->flags & nbt_dsFLAG_FIRST) )
+    return( 0 );
+
+  i = smb_brwParse( &ann, &msg->data );
+  if( i < 0 )
+    {
+    c->bad++;
+    return( i );
+    }
+
+  /* Build the key.
+   */
+  (void)memset( &key, 0, sizeof( smb_brwRecord ) );
+  switch( ann.opcode )
+    {
+    case smb_brwHOST_ANNOUNCEMENT:
+    case smb_brwLOCAL_MASTER_ANNOUNCEMENT:
+      if( (NULL == msg->dst_name) || (msg->dst_name_len < 34)
+       || (0x20 != msg->dst_name[0]) )
+        return( 0 );
+      if( nbt_L1Decode( key.group, msg->dst_name, 1, ' ', &sfx ) < 0 )
+        return( 0 );
+      if( (0x1D != sfx) && (0x1E != sfx) )
+        return( 0 );
+      key.kind = smb_brwHOST;
+      break;
+    case smb_brwDOMAIN_ANNOUNCEMENT:
+      key.kind = smb_brwDOMAIN;
+      break;
+    default:
+      return( 0 );
+    }
+  CopyName( key.name, ann.name );
+  if( '\0' == key.name[0] )
+    {
+    c->bad++;
+    return( cifs_errInvalidPacket );
+    }
+  c->announce++;
+
+  now  = Now();
+  hash = Hash( &key );
+  idx  = Lookup( c, &key, hash );
+
+  /* A server type of zero is a goodbye.
+   */
+  if( 0 == ann.type )
+    {
+    if( idx < 0 )
+      return( 0 );
+    Remove( c, idx );
+    c->removed++;
+    c->gen++;
+    return( 1 );
+    }
+
+  if( idx < 0 )
+    {
+    (void)Expire( c, now );
+    if( c->count >= c->maxrec )
+      {
+      Remove( c, Soonest( c ) );
+      c->evicted++;
+      }
+    idx = c->count++;
+    c->rec[idx] = key;
+    c->rec[idx].first = now;
+    c->link[idx].hash = hash;
+    c->link[idx].hnext = c->bucket[hash & (c->nbuckets - 1)];
+    c->bucket[hash & (c->nbuckets - 1)] = idx;
+    c->added++;
+    }
+  else
+    {
+    TimerDel( c, idx );
+    c->updated++;
+    }
+
+  rec = &c->rec[idx];
+  period = ann.period;
+  if( period < smb_brwPERIOD_MIN )
+    period = smb_brwPERIOD_MIN;
+  else if( period > smb_brwPERIOD_MAX )
+    period = smb_brwPERIOD_MAX;
+  rec->ip        = msg->src_ip;
+  rec->type      = ann.type;
+  rec->period    = period;
+  rec->seen      = now;
+  rec->os_major  = ann.os_major;
+  rec->os_minor  = ann.os_minor;
+  rec->update    = ann.update;
+  (void)memset( rec->comment, 0, sizeof( rec->comment ) );
+  (void)memcpy( rec->comment, ann.comment, ann.comment_len );
+  TimerAdd( c, idx, now + (period * smb_brwLIFETIME) );
+  c->gen++;
+  return( 1 );
+  } /* smb_brwCollect */
+
+
+int smb_brwTick( smb_brwCollector *c )
+  /* ------------------------------------------------------------------------ **
+   * Remove records that have expired.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: The number of records removed.
+   *
+   *  Notes:  Call this once a second or so.  Records are also expired
+   *          whenever a new one is added.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  return( Expire( c, Now() ) );
+  } /* smb_brwTick */
+
+
+int smb_brwPublish( smb_brwCollector *c )
+  /* ------------------------------------------------------------------------ **
+   * Publish a snapshot of the table for readers.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: One if a new snapshot was published, zero if nothing has
+   *          changed since the last one (which remains current), or a
+   *          negative value on error.
+   *
+   *  Errors: cifs_errGeneric - Out of memory.  The previous snapshot
+   *                            remains current.
+   *
+   *  Notes:  Must be called from the thread that calls <smb_brwCollect()>.
+   *          The cost is one copy of the record array, so publishing
+   *          once a second or so is sensible even for very large tables.
+   *          Readers are never waited for.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  smb_brwSnap *s;
+  smb_brwSnap *old;
+  int          max;
+
+  if( (NULL != c->snap) && (c->gen == c->pubgen) )
+    return( 0 );
+
+  /* Reuse the spare if it is big enough.
+   */
+  s = c->spare;
+  if( (NULL != s) && (s->max >= c->count) )
+    c->spare = NULL;
+  else
+    {
+    max = c->count + (c->count / 4) + 64;
+    if( max > c->maxrec )
+      max = c->maxrec;
+    s = (smb_brwSnap *)malloc( sizeof( smb_brwSnap )
+                             + (max * sizeof( smb_brwRecord )) );
+    if( NULL == s )
+      return( cifs_errGeneric );
+    s->max = max;
+    }
+  s->refs  = 1;
+  s->gen   = c->gen;
+  s->now   = Now();
+  s->count = c->count;
+  (void)memcpy( s->rec, c->rec, c->count * sizeof( smb_brwRecord ) );
+
+  Lock( c );
+  old = c->snap;
+  c->snap = s;
+  Unlock( c );
+  c->pubgen = c->gen;
+  c->published++;
+
+  /* If no reader holds the old snapshot, keep it as the next spare.
+   */
+  if( (NULL != old) && (0 == AtomicDrop( &old->refs )) )
+    {
+    if( (NULL == c->spare) || (c->spare->max < old->max) )
+      {
+      free( c->spare );
+      c->spare = old;
+      }
+    else
+      free( old );
+    }
+  return( 1 );
+  } /* smb_brwPublish */
+
+
+smb_brwSnap *smb_brwSnapGet( smb_brwCollector *c )
+  /* ------------------------------------------------------------------------ **
+   * Get the current snapshot.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: A pointer to the current snapshot, or NULL if none has been
+   *          published yet.
+   *
+   *  Notes:  May be called from any thread.  The caller must give the
+   *          snapshot back with <smb_brwSnapPut()> when done.  The
+   *          snapshot does not change while it is held.
+   *
+   *          The age of a record, in milliseconds, at the time the
+   *          snapshot was taken is (<snap->now> - <rec->seen>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  smb_brwSnap *s;
+
+  Lock( c );
+  s = c->snap;
+  if( NULL != s )
+    AtomicHold( &s->refs );
+  Unlock( c );
+  return( s );
+  } /* smb_brwSnapGet */
+
+
+void smb_brwSnapPut( smb_brwSnap *s )
+  /* ------------------------------------------------------------------------ **
+   * Release a snapshot.
+   *
+   *  Input:  s - A snapshot returned by <smb_brwSnapGet()>.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  The snapshot is freed once its last holder releases it.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( (NULL != s) && (0 == AtomicDrop( &s->refs )) )
+    free( s );
+  } /* smb_brwSnapPut */
+
+
+smb_brwStats *smb_brwGetStats( smb_brwCollector *c,
+                               smb_brwStats     *stats )
+  /* ------------------------------------------------------------------------ **
+   * Get the collector counters.
+   *
+   *  Input:  c     - The collector.
+   *          stats - A pointer to the structure to be filled in.
+   *
+   *  Output: A pointer to the filled-in structure (same as <stats>).
+   *
+   *  Notes:  Must be called from the thread that calls <smb_brwCollect()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  stats->records    = c->count;
+  stats->frames     = c->frames;
+  stats->announce   = c->announce;
+  stats->added      = c->added;
+  stats->updated    = c->updated;
+  stats->removed    = c->removed;
+  stats->expired    = c->expired;
+  stats->evicted    = c->evicted;
+  stats->bad        = c->bad;
+  stats->published  = c->published;
+  return( stats );
+  } /* smb_brwGetStats */
+
+/* ========================================================================== */
@@ -0,0 +1,373 @@
+#ifndef SMB_BROWSE_COLLECTOR_H
+#define SMB_BROWSE_COLLECTOR_H
+/* ========================================================================== **
+ *
+ *                                Collector.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Passively collect browser announcements into a live host table.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  Every server on a LAN broadcasts a HostAnnouncement to its workgroup
+ *  every few minutes, and every local master browser broadcasts a
+ *  DomainAnnouncement for its workgroup.  Simply listening on UDP port
+ *  138 is enough to learn the hosts and workgroups on the wire, without
+ *  sending a single query.  This module keeps that table.
+ *
+ *  The table is written by one thread (the receive loop) and read by any
+ *  number of others:
+ *
+ *  - <smb_brwCollect()> takes a parsed (and, if need be, reassembled)
+ *    datagram and adds, refreshes or removes one record.  Records live
+ *    in a dense array, are found through a hash table, and their expiry
+ *    times are kept in a hashed timer wheel, so every update is O(1).
+ *    A record expires when nothing has been heard from it for
+ *    smb_brwLIFETIME announcement periods, as the announcements
+ *    themselves specify.
+ *
+ *  - <smb_brwPublish()> copies the records into a read-only snapshot,
+ *    but only if something has changed since the last one.  The copy is
+ *    a single memcpy(3) of the dense array.
+ *
+ *  - <smb_brwSnapGet()> hands a reader the current snapshot, with a
+ *    reference held.  The reader may take as long as it likes with it;
+ *    publishing a new snapshot does not wait for readers, and the old
+ *    one is freed when its last reader lets go.  The only lock is a spin
+ *    lock held while the snapshot pointer is read or swapped.
+ *
+ *  Reader thread-safety depends upon cifs_ATOMICS.  Without it, all of
+ *  the calls must be made from the same thread.
+ *
+ * ========================================================================== **
+ */
+
+#include "SMB/smb_common.h"       /* SMB subsystem common include file. */
+#include "SMB/Browse/Announce.h"  /* Browser frame parsing.             */
+#include "NBT/DS/Packet.h"        /* nbt_dsMsg.                         */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *
+ *  smb_brwHOST       - Record kind: a host, from a Host or LocalMaster
+ *                      Announcement.
+ *  smb_brwDOMAIN     - Record kind: a workgroup, from a DomainAnnouncement.
+ *
+ *  smb_brwLIFETIME   - A record expires after this many announcement
+ *                      periods without a refresh.
+ *  smb_brwPERIOD_MIN - Announced periods are raised to at least this
+ *                      many ms...
+ *  smb_brwPERIOD_MAX - ...and cut to at most this many.  Together they
+ *                      keep broken or hostile senders from making records
+ *                      that vanish at once or live forever.
+ *  smb_brwWHEEL      - The number of buckets in the expiry timer wheel.
+ *                      The wheel must span smb_brwPERIOD_MAX *
+ *                      smb_brwLIFETIME; Collector.c checks this.
+ */
+
+#define smb_brwHOST         0
+#define smb_brwDOMAIN       1
+
+#define smb_brwLIFETIME     3
+#define smb_brwPERIOD_MIN   60000
+#define smb_brwPERIOD_MAX   3600000
+#define smb_brwWHEEL        1024
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  smb_brwRecord     - One host or workgroup.
+ *                      name      - Host or workgroup name, nul padded,
+ *                                  trailing spaces removed.
+ *                      group     - The host's workgroup (empty for a
+ *                                  workgroup record).
+ *                      comment   - The server comment, or for a workgroup
+ *                                  the name of its local master browser.
+ *                      ip        - Source IP address of the datagram, as
+ *                                  given in its header (host byte order).
+ *                      type      - Server type bits.
+ *                      period    - Announcement period, in ms, clamped.
+ *                      first     - When the record was created (ms).
+ *                      seen      - When the record was last refreshed.
+ *                      kind      - smb_brwHOST or smb_brwDOMAIN.
+ *                      os_major  - Operating system version.
+ *                      os_minor
+ *                      update    - The announcement's update count.
+ *
+ *  smb_brwLink       - Private bookkeeping for one record.  The table,
+ *                      hash chains and timer lists all work on indices
+ *                      into the record array.
+ *
+ *  smb_brwSnap       - A published snapshot.  <now> is the time it was
+ *                      taken, on the same clock as <first> and <seen>.
+ *                      <gen> changes whenever the table changes.  The
+ *                      records are in <rec[0]> through <rec[count-1]>, in
+ *                      no particular order.
+ *
+ *  smb_brwCollector  - The collector.  Treat as opaque.
+ *
+ *  smb_brwStats      - Counters, as returned by <smb_brwGetStats()>.
+ */
+
+typedef struct
+  {
+  uchar     name[16];
+  uchar     group[16];
+  uchar     comment[smb_brwCOMMENT_MAX + 1];
+  uint32_t  ip;
+  uint32_t  type;
+  uint32_t  period;
+  uint32_t  first;
+  uint32_t  seen;
+  uint8_t   kind;
+  uint8_t   os_major;
+  uint8_t   os_minor;
+  uint8_t   update;
+  } smb_brwRecord;
+
+typedef struct
+  {
+  int32_t   hnext;        /* Hash chain.                  */
+  int32_t   next;         /* Timer bucket.                */
+  int32_t   prev;         /* Timer bucket.                */
+  uint32_t  expires;
+  uint32_t  hash;
+  } smb_brwLink;
+
+typedef struct
+  {
+  int           refs;
+  int           max;
+  int           count;
+  uint32_t      gen;
+  uint32_t      now;
+  smb_brwRecord rec[];
+  } smb_brwSnap;
+
+typedef struct
+  {
+  smb_brwRecord *rec;
+  smb_brwLink   *link;
+  int32_t       *bucket;
+  int32_t        wheel[smb_brwWHEEL];
+  int            maxrec;
+  int            count;
+  uint32_t       nbuckets;
+  uint32_t       tick;
+  uint32_t       gen;
+  uint32_t       pubgen;
+  smb_brwSnap   *snap;
+  smb_brwSnap   *spare;
+  int            lock;
+  uint32_t       frames;
+  uint32_t       announce;
+  uint32_t       added;
+  uint32_t       updated;
+  uint32_t       removed;
+  uint32_t       expired;
+  uint32_t       evicted;
+  uint32_t       bad;
+  uint32_t       published;
+  } smb_brwCollector;
+
+typedef struct
+  {
+  uint32_t records;       /* Records currently held.                    */
+  uint32_t frames;        /* Datagrams offered.                         */
+  uint32_t announce;      /* Announcements accepted.                    */
+  uint32_t added;         /* New records.                               */
+  uint32_t updated;       /* Records refreshed.                         */
+  uint32_t removed;       /* Records removed on shutdown announcements. */
+  uint32_t expired;       /* Records that timed out.                    */
+  uint32_t evicted;       /* Records pushed out to make room.           */
+  uint32_t bad;           /* Malformed browser frames.                  */
+  uint32_t published;     /* Snapshots published.                       */
+  } smb_brwStats;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+smb_brwCollector *smb_brwNew( const int maxrec );
+  /* ------------------------------------------------------------------------ **
+   * Create an announcement collector.
+   *
+   *  Input:  maxrec  - The largest number of records (hosts plus
+   *                    workgroups) that will be kept.
+   *
+   *  Output: A pointer to the new collector, or NULL if <maxrec> is less
+   *          than one or memory could not be allocated.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void smb_brwFree( smb_brwCollector *c );
+  /* ------------------------------------------------------------------------ **
+   * Destroy an announcement collector.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  Snapshots still held by readers are not freed until the
+   *          readers release them.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int smb_brwCollect( smb_brwCollector *c, const nbt_dsMsg *msg );
+  /* ------------------------------------------------------------------------ **
+   * Update the table from a received datagram.
+   *
+   *  Input:  c   - The collector.
+   *          msg - A parsed, complete datagram.  See <nbt_dsParse()> and
+   *                <nbt_dsReasmAdd()>.
+   *
+   *  Output: One if the table was changed, zero if the datagram was not
+   *          an announcement that the collector keeps, or a negative
+   *          value if the browser frame was malformed.
+   *
+   *  Errors: cifs_errNullInput     - <c> or <msg> is NULL.
+   *          Any error returned by <smb_brwParse()>.
+   *
+   *  Notes:  A HostAnnouncement or LocalMasterAnnouncement updates the
+   *          host's record.  The workgroup is taken from the datagram's
+   *          destination name, which must be a <1D> or <1E> name.  A
+   *          DomainAnnouncement updates the workgroup's record.
+   *
+   *          An announcement with a server type of zero means that the
+   *          host is shutting down, so its record is removed.
+   *
+   *          If the table is full, the record that would expire soonest
+   *          is evicted to make room.
+   *
+   *          Partial datagram fragments are ignored.  Reassemble them
+   *          first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int smb_brwTick( smb_brwCollector *c );
+  /* ------------------------------------------------------------------------ **
+   * Remove records that have expired.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: The number of records removed.
+   *
+   *  Notes:  Call this once a second or so.  Records are also expired
+   *          whenever a new one is added.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+int smb_brwPublish( smb_brwCollector *c );
+  /* ------------------------------------------------------------------------ **
+   * Publish a snapshot of the table for readers.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: One if a new snapshot was published, zero if nothing has
+   *          changed since the last one (which remains current), or a
+   *          negative value on error.
+   *
+   *  Errors: cifs_errGeneric - Out of memory.  The previous snapshot
+   *                            remains current.
+   *
+   *  Notes:  Must be called from the thread that calls <smb_brwCollect()>.
+   *          The cost is one copy of the record array, so publishing
+   *          once a second or so is sensible even for very large tables.
+   *          Readers are never waited for.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+smb_brwSnap *smb_brwSnapGet( smb_brwCollector *c );
+  /* ------------------------------------------------------------------------ **
+   * Get the current snapshot.
+   *
+   *  Input:  c - The collector.
+   *
+   *  Output: A pointer to the current snapshot, or NULL if none has been
+   *          published yet.
+   *
+   *  Notes:  May be called from any thread.  The caller must give the
+   *          snapshot back with <smb_brwSnapPut()> when done.  The
+   *          snapshot does not change while it is held.
+   *
+   *          The age of a record, in milliseconds, at the time the
+   *          snapshot was taken is (<snap->now> - <rec->seen>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void smb_brwSnapPut( smb_brwSnap *s );
+  /* ------------------------------------------------------------------------ **
+   * Release a snapshot.
+   *
+   *  Input:  s - A snapshot returned by <smb_brwSnapGet()>.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  The snapshot is freed once its last holder releases it.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+smb_brwStats *smb_brwGetStats( smb_brwCollector *c,
+                               smb_brwStats     *stats );
+  /* ------------------------------------------------------------------------ **
+   * Get the collector counters.
+   *
+   *  Input:  c     - The collector.
+   *          stats - A pointer to the structure to be filled in.
+   *
+   *  Output: A pointer to the filled-in structure (same as <stats>).
+   *
+   *  Notes:  Must be called from the thread that calls <smb_brwCollect()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* SMB_BROWSE_COLLECTOR_H */
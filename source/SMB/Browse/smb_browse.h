@@ -0,0 +1,56 @@
+#ifndef SMB_BROWSE_H
+#define SMB_BROWSE_H
+/* ========================================================================== **
+ *
+ *                                smb_browse.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email:
+ *  crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  This is the global header file for the SMB Browse subsystem.
+ *  Including this header will include all of the following:
+ *    libcifs/SMB/Browse/?*.h
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public   
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *  
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of   
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU Lesser General Public   
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *  The purpose of this file is to offer one-stop shopping.  Simply include
+ *  this file and all of the headers for the SMB Browse subsystem will be
+ *  included for you.  There is no run-time penalty for including
+ *  everything.
+ *
+ * ========================================================================== **
+ */
+
+#include "SMB/Browse/Announce.h"   /* Browser frame parsing.       */
+#include "SMB/Browse/Collector.h"  /* Announcement collector.      */
+
+
+/* ========================================================================== */
+#endif /* SMB_BROWSE_H */
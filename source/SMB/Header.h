@@ -57,6 +57,7 @@
  *  These should really be someplace else (like in per-command modules).
  */
 
+#define SMB_COM_TRANSACTION         0x25
 #define SMB_COM_ECHO                0x2B
 #define SMB_COM_NEGOTIATE           0x72
 #define SMB_COM_SESSION_SETUP_ANDX  0x73
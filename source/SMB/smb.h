@@ -19,6 +19,7 @@
  *  header will include all of the following:
  *    libcifs/SMB/?*.h
  *    libcifs/SMB/URL/?*.h
+ *    libcifs/SMB/Browse/?*.h
  *
  * -------------------------------------------------------------------------- **
  *
@@ -50,6 +51,7 @@
 
 #include "SMB/Header.h"         /* SMB Header [de]composition.                */
 #include "SMB/URL/smb_url.h"    /* SMB URL global header.                     */
+#include "SMB/Browse/smb_browse.h" /* Browser announcement collection.       */
 
 
 /* ========================================================================== */
@@ -61,6 +61,10 @@
  */
 
 #include "cifs_typedefs.h"  /* Common definitions, typedefs, etc.       */
+#include "cifs_pool.h"      /* Pooled cifs_Block allocator.             */
+#include "cifs_chain.h"     /* Scatter/gather block chains.             */
+#include "cifs_slice.h"     /* Reference-counted block slices.          */
+#include "cifs_arena.h"     /* Per-request arena allocation.            */
 #include "NBT/nbt.h"        /* Global include for the NBT subsystem.    */
 #include "SMB/smb.h"        /* Global include for the SMB subsystem.    */
 #include "Auth/auth.h"      /* Global include for the Auth subsystem.   */
@@ -0,0 +1,292 @@
+/* ========================================================================== **
+ *
+ *                                cifs_arena.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Per-request arena allocation, carved from cifs_Block buffers.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A request handler typically needs a small pile of temporary structures:
+ *  the parsed message, a decoded name or two, a few records, a response
+ *  under construction.  All of them die together when the request has
+ *  been answered.  An arena hands these out from a single memory block,
+ *  and takes them all back with one call to cifs_ArenaReset().
+ *
+ *  cifs_BlockReAlloc() already carves byte ranges out of a block, but makes
+ *  no attempt at alignment.  That's right for marshalling network
+ *  messages, but not for C structures.  cifs_ArenaAlloc() pads each
+ *  allocation to the requested alignment, based on the actual address.
+ *
+ *  cifs_ArenaMark() records the current position and cifs_ArenaRewind()
+ *  returns to it, releasing everything allocated in the meantime.  Marks
+ *  nest in the obvious, stack-like, way.
+ *
+ *  If the first block fills up, further blocks are taken from the block
+ *  pool (see cifs_pool.h) and chained together.  The pointer to the
+ *  previous block is kept in the first few bytes of each overflow block,
+ *  so the arena itself needs no extra storage.  Overflow blocks are given
+ *  back to the pool on rewind or reset.  The first block belongs to the
+ *  caller and may come from anywhere.
+ *
+ *  An arena is not thread-safe.  It is meant to be used by whichever
+ *  thread is handling the request.
+ *
+ * ========================================================================== **
+ */
+
+#include "cifs_arena.h"   /* Header for this module. */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  ARENA_LINK  - Space reserved at the start of each overflow block for
+ *                the pointer to the previous block.
+ */
+
+#define ARENA_LINK ((long)sizeof( cifs_Block * ))
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static uchar *Carve( cifs_Block *b, const long size, const long align )
+  /* ------------------------------------------------------------------------ **
+   * Allocate an aligned range of bytes from a block.
+   *
+   *  Input:  b     - The block.
+   *          size  - The number of bytes required.
+   *          align - The alignment (a power of two).
+   *
+   *  Output: A pointer to the aligned range, or NULL if the block does not
+   *          have enough room.
+   *
+   *  Notes:  Alignment is based upon the address, not the offset, since
+   *          the block buffer itself may not be aligned.  The padding is
+   *          simply marked as used.
+   *
+   *          This is what cifs_BlockAlloc() does, done inline because it
+   *          happens on every allocation.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  uchar *p;
+  long   pad;
+
+  pad = (long)((0 - (size_t)(b->bufr + b->used)) & (size_t)(align - 1));
+  if( (pad + size) > (b->size - b->used) )
+    return( NULL );
+
+  p        = b->bufr + b->used + pad;
+  b->used += pad + size;
+  return( p );
+  } /* Carve */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+cifs_Arena *cifs_ArenaInit( cifs_Arena *arena, cifs_Block *block )
+  /* ------------------------------------------------------------------------ **
+   * Initialize an arena.
+   *
+   *  Input:  arena - A pointer to the arena structure to be initialized.
+   *          block - The first block from which to allocate.  Any bytes
+   *                  already marked as used in the block are left alone.
+   *
+   *  Output: A pointer to the initialized arena (same as <arena>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  arena->base      = block;
+  arena->cur       = block;
+  arena->base_used = block->used;
+  arena->overflow  = 0;
+  return( arena );
+  } /* cifs_ArenaInit */
+
+
+void *cifs_ArenaAlloc( cifs_Arena *arena, const long size, long align )
+  /* ------------------------------------------------------------------------ **
+   * Allocate memory from an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          size  - The number of bytes required.
+   *          align - The required alignment, which must be a power of two.
+   *                  Zero selects cifs_arenaALIGN, which is suitable for
+   *                  any of the library's structures.
+   *
+   *  Output: A pointer to the allocated memory, or NULL if the request
+   *          could not be satisfied (no overflow block could be found),
+   *          or if <size> is negative or <align> is not a power of two.
+   *
+   *  Notes:  The memory is not cleared.
+   *
+   *          If the current block is full, an overflow block is taken
+   *          from the block pool.  It is taken from the smallest size
+   *          class that can hold the request, but never smaller than
+   *          cifs_poolNS_SIZE.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_Block *b;
+  uchar      *p;
+  long        need;
+
+  /* Reject requests that would produce a bogus alignment mask.
+   */
+  if( 0 == align )
+    align = cifs_arenaALIGN;
+  if( (size < 0) || (align < 0) || (0 != (align & (align - 1))) )
+    return( NULL );
+
+  p = Carve( arena->cur, size, align );
+  if( NULL != p )
+    return( p );
+
+  /* Out of room.  Chain on an overflow block.  The first bytes of the new
+   * buffer hold a pointer to the previous block.
+   */
+  need = ARENA_LINK + size + align;
+  b    = cifs_BlockPoolGet( (need < cifs_poolNS_SIZE) ? cifs_poolNS_SIZE : need );
+  if( NULL == b )
+    return( NULL );
+  (void)memcpy( b->bufr, &arena->cur, sizeof( cifs_Block * ) );
+  b->used = ARENA_LINK;
+  arena->cur = b;
+  arena->overflow++;
+  return( Carve( b, size, align ) );
+  } /* cifs_ArenaAlloc */
+
+
+void *cifs_ArenaDup( cifs_Arena *arena, const void *src, const long len )
+  /* ------------------------------------------------------------------------ **
+   * Copy a string of bytes into an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          src   - The bytes to copy.
+   *          len   - The number of bytes to copy.
+   *
+   *  Output: A pointer to the copy, or NULL if no memory was available.
+   *
+   *  Notes:  The copy is not aligned, and is not nul-terminated unless
+   *          <src> includes the terminating nul.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  void *dst = cifs_ArenaAlloc( arena, len, 1 );
+
+  if( NULL != dst )
+    (void)memcpy( dst, src, (size_t)len );
+  return( dst );
+  } /* cifs_ArenaDup */
+
+
+cifs_ArenaMark *cifs_ArenaGetMark( const cifs_Arena *arena,
+                                  cifs_ArenaMark   *mark )
+  /* ------------------------------------------------------------------------ **
+   * Record the current position of an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          mark  - A pointer to the mark structure to be filled in.
+   *
+   *  Output: A pointer to the mark (same as <mark>).
+   *
+   *  See Also: <cifs_ArenaRewind()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  mark->block = arena->cur;
+  mark->used  = arena->cur->used;
+  return( mark );
+  } /* cifs_ArenaGetMark */
+
+
+void cifs_ArenaRewind( cifs_Arena *arena, const cifs_ArenaMark *mark )
+  /* ------------------------------------------------------------------------ **
+   * Release everything allocated since a mark was taken.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          mark  - A mark returned by <cifs_ArenaGetMark()>.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Overflow blocks allocated after the mark are returned to the
+   *          pool.  Marks taken after <mark> are no longer valid.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_Block *prev;
+
+  while( arena->cur != mark->block )
+    {
+    (void)memcpy( &prev, arena->cur->bufr, sizeof( cifs_Block * ) );
+    cifs_BlockPoolPut( arena->cur );
+    arena->cur = prev;
+    arena->overflow--;
+    }
+  arena->cur->used = mark->used;
+  } /* cifs_ArenaRewind */
+
+
+void cifs_ArenaReset( cifs_Arena *arena )
+  /* ------------------------------------------------------------------------ **
+   * Release everything allocated from an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The arena is returned to the state it was in just after
+   *          <cifs_ArenaInit()>, and may be used again.  All overflow
+   *          blocks go back to the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_ArenaMark mark;
+
+  mark.block = arena->base;
+  mark.used  = arena->base_used;
+  cifs_ArenaRewind( arena, &mark );
+  } /* cifs_ArenaReset */
+
+/* ========================================================================== */
@@ -0,0 +1,219 @@
+#ifndef CIFS_ARENA_H
+#define CIFS_ARENA_H
+/* ========================================================================== **
+ *
+ *                                cifs_arena.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Per-request arena allocation, carved from cifs_Block buffers.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  A request handler typically needs a small pile of temporary structures:
+ *  the parsed message, a decoded name or two, a few records, a response
+ *  under construction.  All of them die together when the request has
+ *  been answered.  An arena hands these out from a single memory block,
+ *  and takes them all back with one call to cifs_ArenaReset().
+ *
+ *  cifs_BlockReAlloc() already carves byte ranges out of a block, but makes
+ *  no attempt at alignment.  That's right for marshalling network
+ *  messages, but not for C structures.  cifs_ArenaAlloc() pads each
+ *  allocation to the requested alignment, based on the actual address.
+ *
+ *  cifs_ArenaMark() records the current position and cifs_ArenaRewind()
+ *  returns to it, releasing everything allocated in the meantime.  Marks
+ *  nest in the obvious, stack-like, way.
+ *
+ *  If the first block fills up, further blocks are taken from the block
+ *  pool (see cifs_pool.h) and chained together.  The pointer to the
+ *  previous block is kept in the first few bytes of each overflow block,
+ *  so the arena itself needs no extra storage.  Overflow blocks are given
+ *  back to the pool on rewind or reset.  The first block belongs to the
+ *  caller and may come from anywhere.
+ *
+ *  An arena is not thread-safe.  It is meant to be used by whichever
+ *  thread is handling the request.
+ *
+ * ========================================================================== **
+ */
+
+#include "cifs_common.h"    /* CIFS library common include file. */
+#include "cifs_pool.h"      /* Overflow blocks come from the pool. */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defined Constants:
+ *
+ *  cifs_arenaALIGN - The default alignment.  Enough for any of the basic
+ *                    C types on the platforms we know about.
+ */
+
+#define cifs_arenaALIGN 16
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  cifs_Arena      - The arena header.
+ *                    base      - The first (caller-supplied) block.
+ *                    cur       - The block currently being carved.
+ *                    base_used - The <used> value of <base> at init time.
+ *                    overflow  - The number of overflow blocks in use.
+ *
+ *  cifs_ArenaMark  - A saved arena position.
+ */
+
+typedef struct
+  {
+  cifs_Block *base;
+  cifs_Block *cur;
+  long        base_used;
+  int         overflow;
+  } cifs_Arena;
+
+typedef struct
+  {
+  cifs_Block *block;
+  long        used;
+  } cifs_ArenaMark;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+cifs_Arena *cifs_ArenaInit( cifs_Arena *arena, cifs_Block *block );
+  /* ------------------------------------------------------------------------ **
+   * Initialize an arena.
+   *
+   *  Input:  arena - A pointer to the arena structure to be initialized.
+   *          block - The first block from which to allocate.  Any bytes
+   *                  already marked as used in the block are left alone.
+   *
+   *  Output: A pointer to the initialized arena (same as <arena>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void *cifs_ArenaAlloc( cifs_Arena *arena, const long size, long align );
+  /* ------------------------------------------------------------------------ **
+   * Allocate memory from an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          size  - The number of bytes required.
+   *          align - The required alignment, which must be a power of two.
+   *                  Zero selects cifs_arenaALIGN, which is suitable for
+   *                  any of the library's structures.
+   *
+   *  Output: A pointer to the allocated memory, or NULL if the request
+   *          could not be satisfied (no overflow block could be found),
+   *          or if <size> is negative or <align> is not a power of two.
+   *
+   *  Notes:  The memory is not cleared.
+   *
+   *          If the current block is full, an overflow block is taken
+   *          from the block pool.  It is taken from the smallest size
+   *          class that can hold the request, but never smaller than
+   *          cifs_poolNS_SIZE.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void *cifs_ArenaDup( cifs_Arena *arena, const void *src, const long len );
+  /* ------------------------------------------------------------------------ **
+   * Copy a string of bytes into an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          src   - The bytes to copy.
+   *          len   - The number of bytes to copy.
+   *
+   *  Output: A pointer to the copy, or NULL if no memory was available.
+   *
+   *  Notes:  The copy is not aligned, and is not nul-terminated unless
+   *          <src> includes the terminating nul.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+cifs_ArenaMark *cifs_ArenaGetMark( const cifs_Arena *arena,
+                                  cifs_ArenaMark   *mark );
+  /* ------------------------------------------------------------------------ **
+   * Record the current position of an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          mark  - A pointer to the mark structure to be filled in.
+   *
+   *  Output: A pointer to the mark (same as <mark>).
+   *
+   *  See Also: <cifs_ArenaRewind()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void cifs_ArenaRewind( cifs_Arena *arena, const cifs_ArenaMark *mark );
+  /* ------------------------------------------------------------------------ **
+   * Release everything allocated since a mark was taken.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *          mark  - A mark returned by <cifs_ArenaGetMark()>.
+   *
+   *  Output: none.
+   *
+   *  Notes:  Overflow blocks allocated after the mark are returned to the
+   *          pool.  Marks taken after <mark> are no longer valid.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void cifs_ArenaReset( cifs_Arena *arena );
+  /* ------------------------------------------------------------------------ **
+   * Release everything allocated from an arena.
+   *
+   *  Input:  arena - A pointer to the arena.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The arena is returned to the state it was in just after
+   *          <cifs_ArenaInit()>, and may be used again.  All overflow
+   *          blocks go back to the pool.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* CIFS_ARENA_H */
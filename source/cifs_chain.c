@@ -0,0 +1,327 @@
+/* ========================================================================== **
+ *
+ *                                cifs_chain.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Chains of memory blocks, for scatter/gather I/O.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  The notes in cifs_block.h point out that very large messages (eg., RAP
+ *  or MS-RPC payloads carried in SMB transactions) have to be handled in
+ *  more than one block, "possibly held together using an array or linked
+ *  list".  This module provides the linked list.
+ *
+ *  A chain is a list of cifs_Block headers.  Any block will do: ordinary
+ *  blocks, pooled blocks (see cifs_pool.h), or sub-blocks created with
+ *  cifs_BlockSubInit().  The chain does not own the blocks, nor does it
+ *  allocate anything.  Each block is attached using a cifs_BlockLink
+ *  provided by the caller, in the same way that cifs_BlockInit() uses a
+ *  header provided by the caller.
+ *
+ *  The point of all this is to avoid copying.  A message is typically
+ *  built as a header, a parameter block, and a data block.  With a chain,
+ *  each piece can be built in its own block and the whole thing handed to
+ *  writev(2) or sendmsg(2) using cifs_BlockChainIovec().  Going the other
+ *  way, cifs_BlockChainRecvIovec() describes the free space in each block
+ *  so that readv(2) or recvmsg(2) can fill the chain directly, and
+ *  cifs_BlockChainCommit() then marks the received bytes as used.
+ *
+ *  Platforms that do not have <sys/uio.h> should define NO_SYS_UIO_H in
+ *  their platform.h, in which case a compatible struct iovec is declared
+ *  here.
+ *
+ * ========================================================================== **
+ */
+
+#include "cifs_chain.h"   /* Header for this module. */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+cifs_BlockChain *cifs_BlockChainInit( cifs_BlockChain *chain )
+  /* ------------------------------------------------------------------------ **
+   * Initialize an empty chain.
+   *
+   *  Input:  chain - A pointer to the chain header to be initialized.
+   *
+   *  Output: A pointer to the initialized chain (same as <chain>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  chain->head  = NULL;
+  chain->tail  = NULL;
+  chain->count = 0;
+  return( chain );
+  } /* cifs_BlockChainInit */
+
+
+cifs_BlockChain *cifs_BlockChainAppend( cifs_BlockChain *chain,
+                                        cifs_BlockLink  *link,
+                                        cifs_Block      *block )
+  /* ------------------------------------------------------------------------ **
+   * Add a block to the end of a chain.
+   *
+   *  Input:  chain - A pointer to the chain.
+   *          link  - A pointer to an unused link structure, which will be
+   *                  used to attach <block> to the chain.  It must remain
+   *                  valid for as long as the block is in the chain.
+   *          block - The block to be added.
+   *
+   *  Output: A pointer to the chain (same as <chain>).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  link->next  = NULL;
+  link->block = block;
+  if( NULL == chain->tail )
+    chain->head = link;
+  else
+    chain->tail->next = link;
+  chain->tail = link;
+  chain->count++;
+  return( chain );
+  } /* cifs_BlockChainAppend */
+
+
+cifs_BlockChain *cifs_BlockChainPrepend( cifs_BlockChain *chain,
+                                         cifs_BlockLink  *link,
+                                         cifs_Block      *block )
+  /* ------------------------------------------------------------------------ **
+   * Add a block to the front of a chain.
+   *
+   *  Input:  chain - A pointer to the chain.
+   *          link  - A pointer to an unused link structure.
+   *          block - The block to be added.
+   *
+   *  Output: A pointer to the chain (same as <chain>).
+   *
+   *  Notes:  This is handy for headers, such as the NBT Session Service
+   *          header, that can only be written once the length of the
+   *          rest of the message is known.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  link->next  = chain->head;
+  link->block = block;
+  chain->head = link;
+  if( NULL == chain->tail )
+    chain->tail = link;
+  chain->count++;
+  return( chain );
+  } /* cifs_BlockChainPrepend */
+
+
+long cifs_BlockChainUsed( const cifs_BlockChain *chain )
+  /* ------------------------------------------------------------------------ **
+   * Return the total number of used bytes in a chain.
+   *
+   *  Input:  chain - A pointer to the chain.
+   *
+   *  Output: The sum of the <used> fields of all blocks in the chain.
+   *
+   *  Notes:  The blocks may still be changing after they have been added
+   *          to the chain, so the total is calculated on each call.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_BlockLink *link;
+  long            total = 0;
+
+  for( link = chain->head; NULL != link; link = link->next )
+    total += link->block->used;
+  return( total );
+  } /* cifs_BlockChainUsed */
+
+
+int cifs_BlockChainIovec( const cifs_BlockChain *chain,
+                          struct iovec          *iov,
+                          const int              max )
+  /* ------------------------------------------------------------------------ **
+   * Describe the used portions of a chain, for writev(2) or sendmsg(2).
+   *
+   *  Input:  chain - A pointer to the chain.
+   *          iov   - An array of at least <max> iovec structures.
+   *          max   - The number of entries available in <iov>.
+   *
+   *  Output: The number of <iov> entries filled in, or -1 if <max> was
+   *          not large enough.
+   *
+   *  Notes:  Blocks with nothing in them are skipped.  Each entry points
+   *          directly into a block buffer, so the blocks must not be
+   *          released until the I/O has completed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_BlockLink *link;
+  int             n = 0;
+
+  for( link = chain->head; NULL != link; link = link->next )
+    {
+    if( link->block->used > 0 )
+      {
+      if( n >= max )
+        return( -1 );
+      iov[n].iov_base = link->block->bufr;
+      iov[n].iov_len  = (size_t)link->block->used;
+      n++;
+      }
+    }
+  return( n );
+  } /* cifs_BlockChainIovec */
+
+
+int cifs_BlockChainRecvIovec( const cifs_BlockChain *chain,
+                              struct iovec          *iov,
+                              const int              max )
+  /* ------------------------------------------------------------------------ **
+   * Describe the free space in a chain, for readv(2) or recvmsg(2).
+   *
+   *  Input:  chain - A pointer to the chain.
+   *          iov   - An array of at least <max> iovec structures.
+   *          max   - The number of entries available in <iov>.
+   *
+   *  Output: The number of <iov> entries filled in.
+   *
+   *  Notes:  Each entry covers the unused space at the end of a block.
+   *          Full blocks are skipped.  If there are more than <max>
+   *          blocks with free space, only the first <max> are described,
+   *          which simply means that less data will be read.
+   *
+   *          Once the read has completed, call <cifs_BlockChainCommit()>
+   *          with the number of bytes received.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_BlockLink *link;
+  int             n = 0;
+
+  for( link = chain->head; (NULL != link) && (n < max); link = link->next )
+    {
+    if( link->block->size > link->block->used )
+      {
+      iov[n].iov_base = link->block->bufr + link->block->used;
+      iov[n].iov_len  = (size_t)(link->block->size - link->block->used);
+      n++;
+      }
+    }
+  return( n );
+  } /* cifs_BlockChainRecvIovec */
+
+
+long cifs_BlockChainCommit( cifs_BlockChain *chain, long len )
+  /* ------------------------------------------------------------------------ **
+   * Mark received bytes as used, following a read into the chain.
+   *
+   *  Input:  chain - A pointer to the chain.
+   *          len   - The number of bytes that were read (eg., the return
+   *                  value of readv(2)).
+   *
+   *  Output: The number of bytes that did not fit.  This will be zero
+   *          unless <len> was larger than the free space in the chain.
+   *
+   *  Notes:  The free space in each block is filled in chain order, which
+   *          is the same order used by <cifs_BlockChainRecvIovec()>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_BlockLink *link;
+  long            avail;
+
+  for( link = chain->head; (NULL != link) && (len > 0); link = link->next )
+    {
+    avail = link->block->size - link->block->used;
+    if( avail > len )
+      avail = len;
+    link->block->used += avail;
+    len -= avail;
+    }
+  return( len );
+  } /* cifs_BlockChainCommit */
+
+
+long cifs_BlockChainCopyOut( const cifs_BlockChain *chain,
+                             uchar                 *dst,
+                             long                   offset,
+                             long                   len )
+  /* ------------------------------------------------------------------------ **
+   * Copy a range of used bytes out of a chain.
+   *
+   *  Input:  chain   - A pointer to the chain.
+   *          dst     - The destination buffer.  Must have room for <len>
+   *                    bytes.
+   *          offset  - The starting position within the used bytes of the
+   *                    chain, as if all of the blocks were one buffer.
+   *          len     - The number of bytes to copy.
+   *
+   *  Output: The number of bytes copied.  This will be less than <len> if
+   *          the chain does not contain enough data.
+   *
+   *  Notes:  This is for the (hopefully rare) fields that straddle a
+   *          block boundary.  Anything that lies entirely within one
+   *          block should be parsed in place.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_BlockLink *link;
+  long            copied = 0;
+  long            n;
+
+  for( link = chain->head; (NULL != link) && (len > 0); link = link->next )
+    {
+    if( offset >= link->block->used )
+      {
+      offset -= link->block->used;
+      continue;
+      }
+    n = link->block->used - offset;
+    if( n > len )
+      n = len;
+    (void)memcpy( dst + copied, link->block->bufr + offset, (size_t)n );
+    copied += n;
+    len    -= n;
+    offset  = 0;
+    }
+  return( copied );
+  } /* cifs_BlockChainCopyOut */
+
+/* ========================================================================== */
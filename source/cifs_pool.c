@@ -0,0 +1,609 @@
+/* ========================================================================== **
+ *
+ *                                cifs_pool.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  A pooled allocator for cifs_Block buffers.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  The cifs_Block functions in cifs_block.c only keep track of memory that
+ *  the caller provides.  This module provides that memory.  Blocks are
+ *  handed out in a few fixed size classes that match the protocol limits:
+ *
+ *    576     - The maximum size of an NBT datagram (RFC 1001/1002).
+ *    1024    - Enough for any NBT Name Service message.
+ *    65536   - A full-sized SMB over NBT Session Service message.
+ *    131072  - The largest possible NBT Session Service message (2^17).
+ *
+ *  Requests larger than the largest class are passed straight through to
+ *  malloc() and free().
+ *
+ *  A pooled block is an ordinary cifs_Block, initialized with
+ *  cifs_BlockInit(), whose buffer immediately follows a hidden header.  All
+ *  of the cifs_Block functions and macros, and all of the existing parsing
+ *  code, work on pooled blocks as-is.  A pooled block may even be
+ *  re-initialized with cifs_BlockInit(), as long as it is eventually given
+ *  back to cifs_BlockPoolPut() using the same header pointer.
+ *
+ *  Free blocks are kept in two tiers.  Each thread has a small cache for
+ *  each size class, which is used without any locking at all.  When a
+ *  thread cache runs dry, it takes the entire global freelist for that
+ *  class in one atomic exchange.  When a thread cache gets too full, half
+ *  of it is pushed back onto the global freelist with a single
+ *  compare-and-swap.  Since blocks are only ever removed from the global
+ *  list all at once, the list is immune to the ABA problem that plagues
+ *  simple lock-free stacks.
+ *
+ *  Pooled blocks are reference counted, so that one receive buffer can be
+ *  shared by several owners (see cifs_slice.h).  The buffer goes back to
+ *  the pool when the last reference is released.
+ *
+ *  Blocks cached by a thread are stranded if the thread exits.  Threads
+ *  that use the pool should call cifs_BlockPoolFlush() before exiting.
+ *
+ *  Thread-safety depends upon cifs_THREAD_LOCAL and cifs_ATOMICS (see
+ *  platform.h).  Without them, there are no thread caches and the global
+ *  freelists are manipulated directly, which is fine for single-threaded
+ *  programs.
+ *
+ * ========================================================================== **
+ */
+
+#include <stdlib.h>       /* For malloc(3) and free(3). */
+
+#include "cifs_pool.h"    /* Header for this module.    */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Constants:
+ *
+ *  POOL_THREADS  - Defined if thread caches and atomic operations are
+ *                  available.
+ *  POOL_NSIZES   - The number of real size classes.  Index POOL_NSIZES in
+ *                  the statistics array is used for oversized blocks.
+ *  ClassSize     - Buffer size of each class.
+ *  CacheMax      - The most blocks of each class that a thread will hold
+ *                  before spilling half of them to the global freelist.
+ */
+
+#if defined( cifs_THREAD_LOCAL ) && defined( cifs_ATOMICS )
+#define POOL_THREADS 1
+#endif
+
+#define POOL_NSIZES (cifs_poolCLASSES - 1)
+
+static const long ClassSize[POOL_NSIZES] =
+  {
+  cifs_poolDGRAM_SIZE, cifs_poolNS_SIZE, cifs_poolSS_SIZE, cifs_poolSSMAX_SIZE
+  };
+
+static const int CacheMax[POOL_NSIZES] = { 64, 64, 8, 4 };
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  PoolHdr   - The hidden header in front of each pooled buffer.  The
+ *              cifs_Block must come first, so that a cifs_Block pointer
+ *              can be cast back to a PoolHdr pointer.
+ *  PoolCache - A thread's cache of free blocks for one size class.
+ *  PoolCount - Statistics for one size class.
+ */
+
+typedef struct PoolHdr
+  {
+  cifs_Block      block;
+  struct PoolHdr *next;
+  long            bufsize;
+  long            refs;
+  int             class;
+  } PoolHdr;
+
+typedef struct
+  {
+  PoolHdr *head;
+  int      count;
+  } PoolCache;
+
+typedef struct
+  {
+  long inuse;
+  long highwater;
+  long misses;
+  } PoolCount;
+
+
+/* -------------------------------------------------------------------------- **
+ * Macros:
+ *
+ *  POOL_HDRSIZE    - The header size, rounded up so that buffers are
+ *                    16-byte aligned.
+ *  POOL_BUFR( H )  - The buffer that follows header <H>.
+ *
+ *  AtomicLoad( P )     - Read <*P>.
+ *  AtomicAdd( P, V )   - Add <V> to <*P>, returning the new value.
+ *
+ *  AtomicHold( P )     - Increment reference count <*P>.
+ *  AtomicDrop( P )     - Decrement reference count <*P>, returning the new
+ *                        value.
+ *
+ *  AtomicLoad() and AtomicAdd() are relaxed.  They are used for the
+ *  statistics, which need not be ordered with respect to anything else.
+ *  AtomicDrop() orders the block's memory, so that whichever thread drops
+ *  the last reference sees everything the other holders wrote.
+ */
+
+#define POOL_HDRSIZE ((sizeof( PoolHdr ) + 15) & ~((size_t)15))
+#define POOL_BUFR( H ) ((uchar *)(H) + POOL_HDRSIZE)
+
+#if defined( cifs_ATOMICS )
+#define AtomicLoad( P )   __atomic_load_n( (P), __ATOMIC_RELAXED )
+#define AtomicAdd( P, V ) __atomic_add_fetch( (P), (V), __ATOMIC_RELAXED )
+#define AtomicHold( P )   (void)__atomic_add_fetch( (P), 1, __ATOMIC_RELAXED )
+#define AtomicDrop( P )   __atomic_sub_fetch( (P), 1, __ATOMIC_ACQ_REL )
+#else
+#define AtomicLoad( P )   (*(P))
+#define AtomicAdd( P, V ) (*(P) += (V))
+#define AtomicHold( P )   (void)(++(*(P)))
+#define AtomicDrop( P )   (--(*(P)))
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *
+ *  FreeList  - The global freelists, one per size class.
+ *  Stats     - Counters, one set per size class plus one for oversized
+ *              blocks.
+ *  Local     - The per-thread caches.
+ */
+
+static PoolHdr  *FreeList[POOL_NSIZES];
+static PoolCount Stats[cifs_poolCLASSES];
+
+#if defined( POOL_THREADS )
+static cifs_THREAD_LOCAL PoolCache Local[POOL_NSIZES];
+#endif
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions:
+ */
+
+static PoolHdr *TakeAll( const int c )
+  /* ------------------------------------------------------------------------ **
+   * Remove the entire global freelist for a size class.
+   *
+   *  Input:  c - The size class.
+   *
+   *  Output: The list of free blocks, or NULL if there were none.
+   *
+   *  Notes:  This is the only way that blocks leave the global list.
+   *          An atomic exchange can't be fooled by a block that was
+   *          removed and pushed back in the meantime, which is what makes
+   *          the list safe without locks or tagged pointers.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+#if defined( POOL_THREADS )
+  if( NULL == __atomic_load_n( &FreeList[c], __ATOMIC_RELAXED ) )
+    return( NULL );
+  return( __atomic_exchange_n( &FreeList[c], NULL, __ATOMIC_ACQUIRE ) );
+#else
+  PoolHdr *list = FreeList[c];
+
+  FreeList[c] = NULL;
+  return( list );
+#endif
+  } /* TakeAll */
+
+
+static void PushChain( const int c, PoolHdr *first, PoolHdr *last )
+  /* ------------------------------------------------------------------------ **
+   * Push a chain of blocks onto the global freelist for a size class.
+   *
+   *  Input:  c     - The size class.
+   *          first - The first block in the chain.
+   *          last  - The last block in the chain.
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+#if defined( POOL_THREADS )
+  PoolHdr *head = __atomic_load_n( &FreeList[c], __ATOMIC_RELAXED );
+
+  do
+    {
+    last->next = head;
+    } while( !__atomic_compare_exchange_n( &FreeList[c], &head, first, true,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED ) );
+#else
+  last->next  = FreeList[c];
+  FreeList[c] = first;
+#endif
+  } /* PushChain */
+
+
+#if defined( POOL_THREADS )
+
+static void Spill( const int c, const int n )
+  /* ------------------------------------------------------------------------ **
+   * Move blocks from the thread cache to the global freelist.
+   *
+   *  Input:  c - The size class.
+   *          n - The number of blocks to move (at least one, and no more
+   *              than are in the cache).
+   *
+   *  Output: none.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  PoolHdr *first = Local[c].head;
+  PoolHdr *last  = first;
+  int      i;
+
+  for( i = 1; i < n; i++ )
+    last = last->next;
+  Local[c].head   = last->next;
+  Local[c].count -= n;
+  PushChain( c, first, last );
+  } /* Spill */
+
+
+static void Refill( const int c )
+  /* ------------------------------------------------------------------------ **
+   * Refill an empty thread cache from the global freelist.
+   *
+   *  Input:  c - The size class.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The whole global list is taken.  If that is more than the
+   *          thread should keep, the excess is pushed straight back.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  PoolHdr *list = TakeAll( c );
+  PoolHdr *hdr;
+  int      n;
+
+  if( NULL == list )
+    return;
+
+  for( n = 1, hdr = list; (n < CacheMax[c]) && (NULL != hdr->next); n++ )
+    hdr = hdr->next;
+  if( NULL != hdr->next )
+    {
+    PoolHdr *rest = hdr->next;
+    PoolHdr *last = rest;
+
+    while( NULL != last->next )
+      last = last->next;
+    PushChain( c, rest, last );
+    hdr->next = NULL;
+    }
+  Local[c].head  = list;
+  Local[c].count = n;
+  } /* Refill */
+
+#endif /* POOL_THREADS */
+
+
+static PoolHdr *NewHdr( const int c, const long size )
+  /* ------------------------------------------------------------------------ **
+   * Allocate a new block from the system.
+   *
+   *  Input:  c     - The size class.
+   *          size  - The buffer size.
+   *
+   *  Output: A pointer to the new block header, or NULL if malloc() failed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  PoolHdr *hdr = (PoolHdr *)malloc( POOL_HDRSIZE + (size_t)size );
+
+  if( NULL != hdr )
+    {
+    hdr->next    = NULL;
+    hdr->bufsize = size;
+    hdr->class   = c;
+    (void)AtomicAdd( &Stats[c].misses, 1 );
+    }
+  return( hdr );
+  } /* NewHdr */
+
+
+static void CountGet( const int c )
+  /* ------------------------------------------------------------------------ **
+   * Update the statistics for a successful get.
+   *
+   *  Input:  c - The size class.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The high-water mark is raised with a compare-and-swap loop,
+   *          which only loops if another thread raised it first.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  long inuse;
+  long high;
+
+  inuse = AtomicAdd( &Stats[c].inuse, 1 );
+  high  = AtomicLoad( &Stats[c].highwater );
+#if defined( cifs_ATOMICS )
+  while( (inuse > high)
+      && !__atomic_compare_exchange_n( &Stats[c].highwater, &high, inuse,
+                                       true,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+    ;
+#else
+  if( inuse > high )
+    Stats[c].highwater = inuse;
+#endif
+  } /* CountGet */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+cifs_Block *cifs_BlockPoolGet( const long size )
+  /* ------------------------------------------------------------------------ **
+   * Get a block from the pool.
+   *
+   *  Input:  size  - The minimum buffer size required, in bytes.
+   *
+   *  Output: A pointer to an initialized cifs_Block, or NULL if memory
+   *          could not be allocated.
+   *
+   *  Notes:  The block comes from the smallest size class that can hold
+   *          <size> bytes, and its <size> field is the size of the class,
+   *          so there may be more room than was asked for.  The block is
+   *          returned empty (nothing marked as used).  The buffer
+   *          contents are not cleared.
+   *
+   *          Requests larger than cifs_poolSSMAX_SIZE are allocated
+   *          directly, at exactly the requested size.
+   *
+   *  See Also: <cifs_BlockPoolPut()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  PoolHdr *hdr;
+  int      c;
+
+  /* Find the size class.
+   */
+  for( c = 0; (c < POOL_NSIZES) && (size > ClassSize[c]); c++ )
+    ;
+
+  if( c < POOL_NSIZES )
+    {
+#if defined( POOL_THREADS )
+    if( NULL == Local[c].head )
+      Refill( c );
+    hdr = Local[c].head;
+    if( NULL != hdr )
+      {
+      Local[c].head = hdr->next;
+      Local[c].count--;
+      }
+#else
+    hdr = FreeList[c];
+    if( NULL != hdr )
+      FreeList[c] = hdr->next;
+#endif
+    if( NULL == hdr )
+      hdr = NewHdr( c, ClassSize[c] );
+    }
+  else
+    hdr = NewHdr( c, size );
+
+  if( NULL == hdr )
+    return( NULL );
+
+  hdr->refs = 1;
+  CountGet( c );
+  return( cifs_BlockInit( &hdr->block, hdr->bufsize, POOL_BUFR( hdr ) ) );
+  } /* cifs_BlockPoolGet */
+
+
+cifs_Block *cifs_BlockPoolHold( cifs_Block *b )
+  /* ------------------------------------------------------------------------ **
+   * Add a reference to a pooled block.
+   *
+   *  Input:  b - A pointer to a block header, as returned by
+   *              <cifs_BlockPoolGet()>.
+   *
+   *  Output: A pointer to the block (same as <b>).
+   *
+   *  Notes:  Each call must be matched by a call to <cifs_BlockPoolPut()>.
+   *          This is what allows several owners (eg., the slices in
+   *          cifs_slice.h) to share one buffer.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  AtomicHold( &((PoolHdr *)b)->refs );
+  return( b );
+  } /* cifs_BlockPoolHold */
+
+
+void cifs_BlockPoolPut( cifs_Block *b )
+  /* ------------------------------------------------------------------------ **
+   * Release a reference to a pooled block.
+   *
+   *  Input:  b - A pointer to a block header, as returned by
+   *              <cifs_BlockPoolGet()>.  May be NULL.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The block goes back to the pool when its last reference is
+   *          released.  A block starts out with one reference, so a
+   *          block that has never been passed to <cifs_BlockPoolHold()>
+   *          is returned to the pool immediately.
+   *
+   *          The block may be released by any thread, not just the one
+   *          that got it.  Blocks that did not come from the pool must
+   *          not be passed to this function.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  PoolHdr *hdr = (PoolHdr *)b;
+  int      c;
+
+  if( NULL == hdr )
+    return;
+
+  if( AtomicDrop( &hdr->refs ) > 0 )
+    return;
+
+  c = hdr->class;
+  (void)AtomicAdd( &Stats[c].inuse, -1 );
+  if( c >= POOL_NSIZES )
+    {
+    free( hdr );
+    return;
+    }
+
+#if defined( POOL_THREADS )
+  hdr->next     = Local[c].head;
+  Local[c].head = hdr;
+  if( ++(Local[c].count) > CacheMax[c] )
+    Spill( c, Local[c].count / 2 );
+#else
+  hdr->next   = FreeList[c];
+  FreeList[c] = hdr;
+#endif
+  } /* cifs_BlockPoolPut */
+
+
+void cifs_BlockPoolFlush( void )
+  /* ------------------------------------------------------------------------ **
+   * Move the calling thread's cached blocks back to the global freelists.
+   *
+   *  Input:  none.
+   *  Output: none.
+   *
+   *  Notes:  Call this before a thread exits, or its cached blocks will
+   *          be lost.  It does nothing if thread caches are not in use.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+#if defined( POOL_THREADS )
+  int c;
+
+  for( c = 0; c < POOL_NSIZES; c++ )
+    {
+    if( Local[c].count > 0 )
+      Spill( c, Local[c].count );
+    }
+#endif
+  } /* cifs_BlockPoolFlush */
+
+
+long cifs_BlockPoolTrim( void )
+  /* ------------------------------------------------------------------------ **
+   * Release all free blocks back to the system.
+   *
+   *  Input:  none.
+   *
+   *  Output: The number of bytes freed (including block headers).
+   *
+   *  Notes:  The calling thread's cache is flushed first.  Blocks cached
+   *          by other threads are not touched.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  PoolHdr *hdr;
+  PoolHdr *next;
+  long     freed = 0;
+  int      c;
+
+  cifs_BlockPoolFlush();
+  for( c = 0; c < POOL_NSIZES; c++ )
+    {
+    for( hdr = TakeAll( c ); NULL != hdr; hdr = next )
+      {
+      next   = hdr->next;
+      freed += (long)POOL_HDRSIZE + hdr->bufsize;
+      free( hdr );
+      }
+    }
+  return( freed );
+  } /* cifs_BlockPoolTrim */
+
+
+cifs_BlockPoolStats *cifs_BlockPoolGetStats( cifs_BlockPoolStats *stats )
+  /* ------------------------------------------------------------------------ **
+   * Retrieve the pool statistics.
+   *
+   *  Input:  stats - A pointer to an array of cifs_poolCLASSES structures,
+   *                  which will receive the counters for each size class.
+   *                  The last entry covers the oversized (pass-through)
+   *                  allocations, and has a <size> of zero.
+   *
+   *  Output: A pointer to the filled-in array (same as <stats>).
+   *
+   *  Notes:  The counters are read without stopping other threads, so
+   *          they are a snapshot, not a consistent set.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int c;
+
+  for( c = 0; c < cifs_poolCLASSES; c++ )
+    {
+    stats[c].size      = (c < POOL_NSIZES) ? ClassSize[c] : 0;
+    stats[c].inuse     = (uint32_t)AtomicLoad( &Stats[c].inuse );
+    stats[c].highwater = (uint32_t)AtomicLoad( &Stats[c].highwater );
+    stats[c].misses    = (uint32_t)AtomicLoad( &Stats[c].misses );
+    }
+  return( stats );
+  } /* cifs_BlockPoolGetStats */
+
+/* ========================================================================== */
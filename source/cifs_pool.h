@@ -0,0 +1,242 @@
+#ifndef CIFS_POOL_H
+#define CIFS_POOL_H
+/* ========================================================================== **
+ *
+ *                                cifs_pool.h
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  A pooled allocator for cifs_Block buffers.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  The cifs_Block functions in cifs_block.c only keep track of memory that
+ *  the caller provides.  This module provides that memory.  Blocks are
+ *  handed out in a few fixed size classes that match the protocol limits:
+ *
+ *    576     - The maximum size of an NBT datagram (RFC 1001/1002).
+ *    1024    - Enough for any NBT Name Service message.
+ *    65536   - A full-sized SMB over NBT Session Service message.
+ *    131072  - The largest possible NBT Session Service message (2^17).
+ *
+ *  Requests larger than the largest class are passed straight through to
+ *  malloc() and free().
+ *
+ *  A pooled block is an ordinary cifs_Block, initialized with
+ *  cifs_BlockInit(), whose buffer immediately follows a hidden header.  All
+ *  of the cifs_Block functions and macros, and all of the existing parsing
+ *  code, work on pooled blocks as-is.  A pooled block may even be
+ *  re-initialized with cifs_BlockInit(), as long as it is eventually given
+ *  back to cifs_BlockPoolPut() using the same header pointer.
+ *
+ *  Free blocks are kept in two tiers.  Each thread has a small cache for
+ *  each size class, which is used without any locking at all.  When a
+ *  thread cache runs dry, it takes the entire global freelist for that
+ *  class in one atomic exchange.  When a thread cache gets too full, half
+ *  of it is pushed back onto the global freelist with a single
+ *  compare-and-swap.  Since blocks are only ever removed from the global
+ *  list all at once, the list is immune to the ABA problem that plagues
+ *  simple lock-free stacks.
+ *
+ *  Pooled blocks are reference counted, so that one receive buffer can be
+ *  shared by several owners (see cifs_slice.h).  The buffer goes back to
+ *  the pool when the last reference is released.
+ *
+ *  Blocks cached by a thread are stranded if the thread exits.  Threads
+ *  that use the pool should call cifs_BlockPoolFlush() before exiting.
+ *
+ *  Thread-safety depends upon cifs_THREAD_LOCAL and cifs_ATOMICS (see
+ *  platform.h).  Without them, there are no thread caches and the global
+ *  freelists are manipulated directly, which is fine for single-threaded
+ *  programs.
+ *
+ * ========================================================================== **
+ */
+
+#include "cifs_common.h"    /* CIFS library common include file. */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defined Constants:
+ *
+ *  cifs_poolDGRAM_SIZE - Size class for NBT datagrams.
+ *  cifs_poolNS_SIZE    - Size class for NBT Name Service messages.
+ *  cifs_poolSS_SIZE    - Size class for 64K session messages.
+ *  cifs_poolSSMAX_SIZE - Size class for maximum-sized NBT session messages.
+ *
+ *  cifs_poolCLASSES    - The number of entries in the statistics array.
+ *                        That's one per size class, plus one more for
+ *                        oversized allocations.
+ */
+
+#define cifs_poolDGRAM_SIZE    576
+#define cifs_poolNS_SIZE      1024
+#define cifs_poolSS_SIZE     65536
+#define cifs_poolSSMAX_SIZE 131072
+
+#define cifs_poolCLASSES 5
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  cifs_BlockPoolStats - Counters for one size class.
+ *                        size      - The buffer size of the class.
+ *                        inuse     - Blocks currently handed out.
+ *                        highwater - The largest value <inuse> has had.
+ *                        misses    - Gets that had to call malloc().
+ */
+
+typedef struct
+  {
+  long     size;
+  uint32_t inuse;
+  uint32_t highwater;
+  uint32_t misses;
+  } cifs_BlockPoolStats;
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+cifs_Block *cifs_BlockPoolGet( const long size );
+  /* ------------------------------------------------------------------------ **
+   * Get a block from the pool.
+   *
+   *  Input:  size  - The minimum buffer size required, in bytes.
+   *
+   *  Output: A pointer to an initialized cifs_Block, or NULL if memory
+   *          could not be allocated.
+   *
+   *  Notes:  The block comes from the smallest size class that can hold
+   *          <size> bytes, and its <size> field is the size of the class,
+   *          so there may be more room than was asked for.  The block is
+   *          returned empty (nothing marked as used).  The buffer
+   *          contents are not cleared.
+   *
+   *          Requests larger than cifs_poolSSMAX_SIZE are allocated
+   *          directly, at exactly the requested size.
+   *
+   *  See Also: <cifs_BlockPoolPut()>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+cifs_Block *cifs_BlockPoolHold( cifs_Block *b );
+  /* ------------------------------------------------------------------------ **
+   * Add a reference to a pooled block.
+   *
+   *  Input:  b - A pointer to a block header, as returned by
+   *              <cifs_BlockPoolGet()>.
+   *
+   *  Output: A pointer to the block (same as <b>).
+   *
+   *  Notes:  Each call must be matched by a call to <cifs_BlockPoolPut()>.
+   *          This is what allows several owners (eg., the slices in
+   *          cifs_slice.h) to share one buffer.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void cifs_BlockPoolPut( cifs_Block *b );
+  /* ------------------------------------------------------------------------ **
+   * Release a reference to a pooled block.
+   *
+   *  Input:  b - A pointer to a block header, as returned by
+   *              <cifs_BlockPoolGet()>.  May be NULL.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The block goes back to the pool when its last reference is
+   *          released.  A block starts out with one reference, so a
+   *          block that has never been passed to <cifs_BlockPoolHold()>
+   *          is returned to the pool immediately.
+   *
+   *          The block may be released by any thread, not just the one
+   *          that got it.  Blocks that did not come from the pool must
+   *          not be passed to this function.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+void cifs_BlockPoolFlush( void );
+  /* ------------------------------------------------------------------------ **
+   * Move the calling thread's cached blocks back to the global freelists.
+   *
+   *  Input:  none.
+   *  Output: none.
+   *
+   *  Notes:  Call this before a thread exits, or its cached blocks will
+   *          be lost.  It does nothing if thread caches are not in use.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+long cifs_BlockPoolTrim( void );
+  /* ------------------------------------------------------------------------ **
+   * Release all free blocks back to the system.
+   *
+   *  Input:  none.
+   *
+   *  Output: The number of bytes freed (including block headers).
+   *
+   *  Notes:  The calling thread's cache is flushed first.  Blocks cached
+   *          by other threads are not touched.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+cifs_BlockPoolStats *cifs_BlockPoolGetStats( cifs_BlockPoolStats *stats );
+  /* ------------------------------------------------------------------------ **
+   * Retrieve the pool statistics.
+   *
+   *  Input:  stats - A pointer to an array of cifs_poolCLASSES structures,
+   *                  which will receive the counters for each size class.
+   *                  The last entry covers the oversized (pass-through)
+   *                  allocations, and has a <size> of zero.
+   *
+   *  Output: A pointer to the filled-in array (same as <stats>).
+   *
+   *  Notes:  The counters are read without stopping other threads, so
+   *          they are a snapshot, not a consistent set.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+
+
+/* ========================================================================== */
+#endif /* CIFS_POOL_H */
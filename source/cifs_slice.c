@@ -0,0 +1,183 @@
+/* ========================================================================== **
+ *
+ *                                cifs_slice.c
+ *
+ * Copyright:
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ * Email: crh@ubiqx.mn.org
+ *
+ * $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *  Reference-counted slices of pooled memory blocks.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Notes:
+ *
+ *  When a message is parsed, the results usually point back into the
+ *  receive buffer.  For example, nbt_nsParseMsg() leaves the QR_name and
+ *  rdata fields of an nbt_nsMsgBlock pointing at the original packet.
+ *  That's fine until the receive loop wants its buffer back, at which
+ *  point anything that needs to be kept has to be copied.
+ *
+ *  A slice is a pointer and a length within a pooled block (see
+ *  cifs_pool.h), plus a reference to that block.  While any slice exists
+ *  the block stays out of the pool, so a slice can be handed to another
+ *  thread, or stored in a cache, without copying the data.  The block
+ *  goes back to the pool when the receive loop and all of the slices
+ *  have let go of it.
+ *
+ *  Slices are small structures, and are passed around by value or
+ *  embedded in other structures.  Each one holds exactly one reference,
+ *  so each one must be released exactly once.
+ *
+ *  Slices are read-only by convention.  Several threads may be reading
+ *  the same bytes.
+ *
+ *  Slices only work with pooled blocks.  Sub-blocks created with
+ *  cifs_BlockSubInit() share their parent's buffer but not its header, so
+ *  make the slice from the parent.
+ *
+ * ========================================================================== **
+ */
+
+#include "cifs_slice.h"   /* Header for this module. */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions:
+ */
+
+cifs_BlockSlice *cifs_BlockSliceInit( cifs_BlockSlice *slice,
+                                      cifs_Block      *owner,
+                                      uchar           *data,
+                                      const long       len )
+  /* ------------------------------------------------------------------------ **
+   * Create a slice of a pooled block.
+   *
+   *  Input:  slice - A pointer to the slice structure to be initialized.
+   *          owner - The pooled block (from <cifs_BlockPoolGet()>) that
+   *                  contains the data.
+   *          data  - A pointer to the start of the slice, within the
+   *                  buffer of <owner>.
+   *          len   - The length of the slice, in bytes.
+   *
+   *  Output: A pointer to the slice (same as <slice>), or NULL if the
+   *          given range does not lie within the buffer of <owner>.
+   *
+   *  Notes:  On success, the slice holds a reference to <owner>.  The
+   *          caller's own reference is not affected.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( (len < 0) || (data < owner->bufr)
+   || (len > (owner->size - (data - owner->bufr))) )
+    return( NULL );
+
+  slice->owner = cifs_BlockPoolHold( owner );
+  slice->data  = data;
+  slice->len   = len;
+  return( slice );
+  } /* cifs_BlockSliceInit */
+
+
+cifs_BlockSlice *cifs_BlockSliceSub( cifs_BlockSlice       *dst,
+                                     const cifs_BlockSlice *src,
+                                     const long             offset,
+                                     const long             len )
+  /* ------------------------------------------------------------------------ **
+   * Create a slice of a slice.
+   *
+   *  Input:  dst     - A pointer to the slice structure to be initialized.
+   *          src     - An existing slice.
+   *          offset  - The start of the new slice, relative to the start
+   *                    of <src>.
+   *          len     - The length of the new slice.
+   *
+   *  Output: A pointer to the new slice (same as <dst>), or NULL if the
+   *          range does not lie within <src>.
+   *
+   *  Notes:  The new slice holds its own reference to the block, so
+   *          <src> may be released first.  Passing zero and src->len
+   *          makes a plain copy of <src>.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( (offset < 0) || (len < 0) || (len > (src->len - offset)) )
+    return( NULL );
+
+  dst->owner = cifs_BlockPoolHold( src->owner );
+  dst->data  = src->data + offset;
+  dst->len   = len;
+  return( dst );
+  } /* cifs_BlockSliceSub */
+
+
+void cifs_BlockSliceRelease( cifs_BlockSlice *slice )
+  /* ------------------------------------------------------------------------ **
+   * Release a slice.
+   *
+   *  Input:  slice - The slice to be released.
+   *
+   *  Output: none.
+   *
+   *  Notes:  The slice's reference to the block is dropped, and the
+   *          slice is cleared.  Releasing a cleared slice does nothing.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  cifs_BlockPoolPut( slice->owner );
+  slice->owner = NULL;
+  slice->data  = NULL;
+  slice->len   = 0;
+  } /* cifs_BlockSliceRelease */
+
+
+cifs_Block *cifs_BlockSliceView( cifs_Block            *view,
+                                 const cifs_BlockSlice *slice )
+  /* ------------------------------------------------------------------------ **
+   * Make a block header that covers a slice.
+   *
+   *  Input:  view  - A pointer to the block header to be initialized.
+   *          slice - The slice.
+   *
+   *  Output: A pointer to the block header (same as <view>).
+   *
+   *  Notes:  The block is full (used == size == slice->len), which is
+   *          the state that parsing code expects.  The view holds no
+   *          reference of its own, so it must not outlive the slice.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)cifs_BlockInit( view, slice->len, slice->data );
+  view->used = slice->len;
+  return( view );
+  } /* cifs_BlockSliceView */
+
+/* ========================================================================== */
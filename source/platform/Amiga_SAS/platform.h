@@ -61,6 +61,13 @@ typedef unsigned long int       uint32_t;     /* Unsigned long.    */
 typedef enum { false = 0, true  = 1 } bool;   /* C99 Boolean type. */
 
 
+/* There is no <sys/uio.h> either, so cifs_chain.h will declare its own
+ * struct iovec.
+ */
+
+#define NO_SYS_UIO_H
+
+
 /* SAS C has strnicmp() instead of strncasecmp().
  */
 
@@ -63,5 +63,37 @@
 #define dbg_FUNCNAME (__FUNCTION__)
 
 
+/* Byte order.
+ *
+ * cifs_LITTLE_ENDIAN is defined if the host is known to be little-endian.
+ * It is only used to enable fast paths (eg., loading message words in the
+ * MD4 and MD5 modules directly from memory).  The portable code is always
+ * correct, so if the byte order cannot be determined, leave this undefined.
+ */
+
+#if defined( __BYTE_ORDER__ ) && defined( __ORDER_LITTLE_ENDIAN__ )
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define cifs_LITTLE_ENDIAN 1
+#endif
+#elif defined( _M_IX86 ) || defined( _M_X64 ) || defined( _M_AMD64 )
+#define cifs_LITTLE_ENDIAN 1
+#endif
+
+
+/* Threads.
+ *
+ * cifs_THREAD_LOCAL is the storage class keyword for thread-local data, and
+ * cifs_ATOMICS is defined if the GCC-style __atomic builtins are available.
+ * Modules that keep per-thread caches or lock-free lists (eg., the block
+ * pool in cifs_pool.c) use these.  If either is left undefined, those
+ * modules fall back to plain global data, and are not thread-safe.
+ */
+
+#if defined( __GNUC__ )
+#define cifs_THREAD_LOCAL __thread
+#define cifs_ATOMICS 1
+#endif
+
+
 /* ========================================================================== */
 #endif /* PLATFORM_H */
@@ -0,0 +1,330 @@
+/* ========================================================================== **
+ *                                arenabench.c
+ *
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ *  Email: crh@ubiqx.mn.org
+ *
+ *  $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *
+ *  This program compares the per-request arena allocator (cifs_arena.c)
+ *  against malloc(3) and free(3) for the temporary allocations made while
+ *  handling a typical NBT name query.
+ *
+ *  Each cycle allocates, and touches:
+ *    - the parsed query message (an nbt_nsMsgBlock),
+ *    - the decoded NetBIOS name and a copy of the scope,
+ *    - the reply message and a 576-byte reply packet buffer,
+ *    - the reply RDATA (four address entries), and
+ *    - a small cache record.
+ *  The malloc version then frees the seven allocations one at a time.
+ *  The arena version makes one call to cifs_ArenaReset().
+ *
+ * Compile:
+ *
+ * $ cc -O2 -I ../ -o arenabench arenabench.c ../util/MsgOut.c \
+ *   ../cifs_block.c ../cifs_pool.c ../cifs_arena.c -lpthread
+ *
+ * ========================================================================== **
+ */
+
+#include <stdio.h>      /* Standard I/O.              */
+#include <stdlib.h>     /* Standard C stuff.          */
+#include <unistd.h>     /* For getopt(3).             */
+#include <time.h>       /* For clock_gettime(2).      */
+
+#include "cifs.h"       /* CIFS toolkit header.       */
+
+
+/* -------------------------------------------------------------------------- **
+ * Constants:
+ *
+ *  aSIZE     - Size of the arena's first block.  Large enough that a
+ *              cycle never overflows into a pooled block.
+ *  PKT_SIZE  - Size of the reply packet buffer.
+ *  RDATA_LEN - Length of the reply RDATA (four NB address entries).
+ */
+
+#define aSIZE     2048
+#define PKT_SIZE  576
+#define RDATA_LEN (4 * 6)
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  CacheRec  - Stand-in for a resolved name cache record.
+ */
+
+typedef struct
+  {
+  uchar    name[nbt_NB_NAME_MAX];
+  uint32_t addr;
+  uint32_t expires;
+  uint16_t flags;
+  } CacheRec;
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *  helpmsg   - An array of strings, terminated by a NULL pointer value.
+ *
+ *  Copyright - Copyright string.
+ *  License   - License under which the software is released.
+ *  ID        - Long-hand string providing revision information.
+ *
+ *  Scope     - A sample scope string.
+ *  Sink      - Every allocation is stored here, so that the compiler
+ *              cannot remove a malloc()/free() pair.
+ */
+
+static const char *helpmsg[] =
+  {
+  "",
+  "Usage: %s [-h|-V] [-n <cycles>]",
+  "  Time <cycles> (default 5000000) name query request/response",
+  "  allocation cycles using malloc(3), and then using an arena.",
+  "  ",
+  "  -h : Causes this message to be displayed then exits the program.",
+  "  -V : Displays version and license information, then exits.",
+  "",
+  NULL
+  };
+
+static const char *Copyright = "Copyright (c) 2026 by the libcifs contributors";
+static const char *License   = "GNU General Public License Version 2 or Later";
+static const char *ID        = "$Id$";
+
+static const uchar Scope[] = "\x04CORP\x07EXAMPLE\x03COM";
+
+static void * volatile Sink;
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions...
+ */
+
+static void usage( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Prints the usage message, then exits with the given <status>.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)util_Usage( stderr, helpmsg, prognam );
+  exit( status );
+  } /* usage */
+
+
+static void version( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Print version and license information, the bail out.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Err( "%s: %s\n", prognam, ID );
+  Err( " License: %s\n", License );
+  Err( "%s\n\n", Copyright );
+  exit( status );
+  } /* version */
+
+
+static double Seconds( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a monotonic time in seconds.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + (ts.tv_nsec / 1e9) );
+  } /* Seconds */
+
+
+static void Touch( nbt_nsMsgBlock *query,
+                   uchar          *name,
+                   uchar          *scope,
+                   nbt_nsMsgBlock *reply,
+                   uchar          *pkt,
+                   uchar          *rdata,
+                   CacheRec       *rec )
+  /* ------------------------------------------------------------------------ **
+   * Fill in the allocations made by one cycle.
+   *
+   *  Notes:  The same work is done in both versions of the cycle, so that
+   *          the difference in time is the difference in allocation cost.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  query->QR_name     = scope;
+  query->QR_name_len = sizeof( Scope );
+  (void)memcpy( name, "FILESERVER     ", nbt_NB_NAME_MAX );
+  (void)memcpy( scope, Scope, sizeof( Scope ) );
+  (void)memcpy( rec->name, name, nbt_NB_NAME_MAX );
+  rec->addr  = 0x0A000001;
+  rec->flags = 0;
+  (void)memset( rdata, 0, RDATA_LEN );
+  (void)memcpy( &rdata[2], &rec->addr, 4 );
+  reply->rdata       = rdata;
+  reply->rdata_len   = RDATA_LEN;
+  pkt[0]             = name[0];
+  Sink = query;
+  Sink = name;
+  Sink = scope;
+  Sink = reply;
+  Sink = pkt;
+  Sink = rdata;
+  Sink = rec;
+  } /* Touch */
+
+
+static void CycleMalloc( void )
+  /* ------------------------------------------------------------------------ **
+   * One request/response cycle, using malloc() and free().
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *query = (nbt_nsMsgBlock *)malloc( sizeof( nbt_nsMsgBlock ) );
+  uchar          *name  = (uchar *)malloc( nbt_NB_NAME_MAX );
+  uchar          *scope = (uchar *)malloc( sizeof( Scope ) );
+  nbt_nsMsgBlock *reply = (nbt_nsMsgBlock *)malloc( sizeof( nbt_nsMsgBlock ) );
+  uchar          *pkt   = (uchar *)malloc( PKT_SIZE );
+  uchar          *rdata = (uchar *)malloc( RDATA_LEN );
+  CacheRec       *rec   = (CacheRec *)malloc( sizeof( CacheRec ) );
+
+  if( !query || !name || !scope || !reply || !pkt || !rdata || !rec )
+    Fail( "Out of memory.\n" );
+  Touch( query, name, scope, reply, pkt, rdata, rec );
+  free( rec );
+  free( rdata );
+  free( pkt );
+  free( reply );
+  free( scope );
+  free( name );
+  free( query );
+  } /* CycleMalloc */
+
+
+static void CycleArena( cifs_Arena *arena )
+  /* ------------------------------------------------------------------------ **
+   * One request/response cycle, using an arena.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsMsgBlock *query;
+  uchar          *name;
+  uchar          *scope;
+  nbt_nsMsgBlock *reply;
+  uchar          *pkt;
+  uchar          *rdata;
+  CacheRec       *rec;
+
+  query = (nbt_nsMsgBlock *)cifs_ArenaAlloc( arena,
+                                             sizeof( nbt_nsMsgBlock ), 0 );
+  name  = (uchar *)cifs_ArenaAlloc( arena, nbt_NB_NAME_MAX, 1 );
+  scope = (uchar *)cifs_ArenaAlloc( arena, sizeof( Scope ), 1 );
+  reply = (nbt_nsMsgBlock *)cifs_ArenaAlloc( arena,
+                                             sizeof( nbt_nsMsgBlock ), 0 );
+  pkt   = (uchar *)cifs_ArenaAlloc( arena, PKT_SIZE, 0 );
+  rdata = (uchar *)cifs_ArenaAlloc( arena, RDATA_LEN, 2 );
+  rec   = (CacheRec *)cifs_ArenaAlloc( arena, sizeof( CacheRec ), 0 );
+
+  if( !query || !name || !scope || !reply || !pkt || !rdata || !rec )
+    Fail( "Out of memory.\n" );
+  Touch( query, name, scope, reply, pkt, rdata, rec );
+  cifs_ArenaReset( arena );
+  } /* CycleArena */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions...
+ */
+
+int main( int argc, char *argv[] )
+  /* ------------------------------------------------------------------------ **
+   * Mainline
+   *
+   *  Input:  argc  - You know what this is.
+   *          argv  - You know what to do.
+   *
+   *  Output: EXIT_SUCCESS, or EXIT_FAILURE if the user needs some help.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static uchar bufr[aSIZE];
+  cifs_Block   block[1];
+  cifs_Arena   arena[1];
+  long         cycles = 5000000;
+  long         i;
+  int          c;
+  double       t0;
+  double       t1;
+  double       t2;
+
+  while( (c = getopt( argc, argv, "hVn:" )) > 0 )
+    {
+    switch( c )
+      {
+      case 'n': cycles = atol( optarg ); break;
+      case 'V': version( argv[0], EXIT_SUCCESS ); break;
+      case 'h': usage( argv[0], EXIT_SUCCESS );   break;
+      default:  usage( argv[0], EXIT_FAILURE );   break;
+      }
+    }
+  if( cycles < 1 )
+    usage( argv[0], EXIT_FAILURE );
+
+  (void)cifs_BlockInit( block, aSIZE, bufr );
+  (void)cifs_ArenaInit( arena, block );
+
+  t0 = Seconds();
+  for( i = 0; i < cycles; i++ )
+    CycleMalloc();
+  t1 = Seconds();
+  for( i = 0; i < cycles; i++ )
+    CycleArena( arena );
+  t2 = Seconds();
+
+  Say( "%ld name query cycles, 7 allocations each\n", cycles );
+  Say( "  malloc/free: %6.1f ns per cycle\n", ((t1 - t0) * 1e9) / cycles );
+  Say( "  arena:       %6.1f ns per cycle\n", ((t2 - t1) * 1e9) / cycles );
+  return( EXIT_SUCCESS );
+  } /* main */
+
+/* ========================================================================== */
@@ -0,0 +1,398 @@
+/* ========================================================================== **
+ *                                  deskat.c
+ *
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ *  Email: crh@ubiqx.mn.org
+ *
+ *  $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *
+ *  Known-answer test for the DES and LM hash code in the Auth/ directory.
+ *
+ *  The scalar functions, <auth_DEShash()> and <auth_LMhash()>, are checked
+ *  against published DES test vectors and well-known LM hashes.  The key
+ *  schedule API and the batch functions, <auth_DEShashN()> and
+ *  <auth_LMhashN()>, are then checked against the scalar functions using
+ *  pseudo-random keys, data, and passwords.
+ *
+ *  The program prints a summary and exits with EXIT_FAILURE if any result
+ *  does not match.
+ *
+ * Compile:
+ *
+ * $ cc -I ../ -o deskat deskat.c ../util/MsgOut.c ../Auth/LMhash.c \
+ *   ../Auth/DES.c
+ *
+ * ========================================================================== **
+ */
+
+#include <stdio.h>      /* Standard I/O.     */
+#include <stdlib.h>     /* Standard C stuff. */
+#include <unistd.h>     /* For getopt(3).    */
+
+#include "cifs.h"       /* CIFS toolkit header.     */
+
+
+/* -------------------------------------------------------------------------- **
+ * Constants:
+ *
+ *  kMAX  - The largest batch passed to the batch functions.
+ */
+
+#define kMAX 1024
+
+
+/* -------------------------------------------------------------------------- **
+ * Typedefs:
+ *
+ *  DESvector - A DES known answer: 8-byte key (with parity bits),
+ *              plaintext, and ciphertext.
+ *  LMvector  - An LM hash known answer: upper-case password and hash.
+ */
+
+typedef struct
+  {
+  const char *key;
+  const char *plain;
+  const char *cipher;
+  } DESvector;
+
+typedef struct
+  {
+  const char *pwd;
+  const char *hash;
+  } LMvector;
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *  helpmsg   - An array of strings, terminated by a NULL pointer value.
+ *
+ *  Copyright - Copyright string.
+ *  License   - License under which the software is released.
+ *  ID        - Long-hand string providing revision information.
+ *
+ *  DESkat    - Published DES test vectors, in hex.
+ *  LMkat     - Known LM hashes, in hex.
+ *  Counts    - Batch sizes passed to the batch functions.  Some of these
+ *              are not a multiple of any lane count (32, 64, 128, 256),
+ *              so that partly filled slices are tested.
+ *
+ *  Seed      - State for the pseudo-random generator.
+ *  Failures  - Number of mismatches found.
+ */
+
+static const char *helpmsg[] =
+  {
+  "",
+  "Usage: %s [-h|-V] [-r <rounds>]",
+  "  Check the DES and LM hash functions against known answers, then",
+  "  check the key schedule and batch functions against the scalar",
+  "  functions for <rounds> (default 20) sets of random input.",
+  "  ",
+  "  -h : Causes this message to be displayed then exits the program.",
+  "  -V : Displays version and license information, then exits.",
+  "",
+  NULL
+  };
+
+static const char *Copyright = "Copyright (c) 2026 by the libcifs contributors";
+static const char *License   = "GNU General Public License Version 2 or Later";
+static const char *ID        = "$Id$";
+
+static const DESvector DESkat[] =
+  {
+  { "133457799BBCDFF1", "0123456789ABCDEF", "85E813540F0AB405" },
+  { "0E329232EA6D0D73", "8787878787878787", "0000000000000000" },
+  { "0123456789ABCDEF", "4E6F772069732074", "3FA40E8A984D4815" },
+  { "0101010101010101", "95F8A5E5DD31D900", "8000000000000000" },
+  { "8001010101010101", "0000000000000000", "95A8D72813DAA94D" },
+  { NULL, NULL, NULL }
+  };
+
+static const LMvector LMkat[] =
+  {
+  { "",         "AAD3B435B51404EEAAD3B435B51404EE" },
+  { "PASSWORD", "E52CAC67419A9A224A3B108F3FA6CB6D" },
+  { NULL, NULL }
+  };
+
+static const int Counts[] = { 1, 3, 100, 256, 257, 1000, kMAX, 0 };
+
+static unsigned long Seed     = 1;
+static int           Failures = 0;
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions...
+ */
+
+static void usage( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Prints the usage message, then exits with the given <status>.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)util_Usage( stderr, helpmsg, prognam );
+  exit( status );
+  } /* usage */
+
+
+static void version( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Print version and license information, the bail out.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Err( "%s: %s\n", prognam, ID );
+  Err( " License: %s\n", License );
+  Err( "%s\n\n", Copyright );
+  exit( status );
+  } /* version */
+
+
+static uchar Random( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a pseudo-random byte.
+   *
+   *  Notes:  A simple LCG is used so that the results do not depend upon
+   *          the C library.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Seed = (Seed * 1103515245UL) + 12345UL;
+  return( (uchar)(Seed >> 16) );
+  } /* Random */
+
+
+static void Unhex( uchar *dst, const char *src, int len )
+  /* ------------------------------------------------------------------------ **
+   * Convert <len> bytes' worth of hex string into binary.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  unsigned int x;
+  int          i;
+
+  for( i = 0; i < len; i++ )
+    {
+    (void)sscanf( &src[2 * i], "%2x", &x );
+    dst[i] = (uchar)x;
+    }
+  } /* Unhex */
+
+
+static void Check( const char *what, int index,
+                   const uchar *got, const uchar *want, int len )
+  /* ------------------------------------------------------------------------ **
+   * Compare a result against the expected value, and report mismatches.
+   *
+   *  Input:  what  - Name of the test, for the report.
+   *          index - Test case number, for the report.
+   *          got   - The computed result.
+   *          want  - The expected result.
+   *          len   - Number of bytes to compare.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int i;
+
+  if( 0 == memcmp( got, want, len ) )
+    return;
+  Failures++;
+  Say( "FAIL %s [%d]: got ", what, index );
+  for( i = 0; i < len; i++ )
+    Say( "%.2x", got[i] );
+  Say( ", want " );
+  for( i = 0; i < len; i++ )
+    Say( "%.2x", want[i] );
+  Say( "\n" );
+  } /* Check */
+
+
+static void KnownAnswers( void )
+  /* ------------------------------------------------------------------------ **
+   * Check the scalar functions against the known answer tables.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  auth_DESschedule ks;
+  uchar            key[8];
+  uchar            plain[8];
+  uchar            want[16];
+  uchar            got[16];
+  int              i;
+
+  for( i = 0; NULL != DESkat[i].key; i++ )
+    {
+    Unhex( key,   DESkat[i].key,    8 );
+    Unhex( plain, DESkat[i].plain,  8 );
+    Unhex( want,  DESkat[i].cipher, 8 );
+    (void)auth_DESkey8to7( key, key );
+    Check( "auth_DEShash", i, auth_DEShash( got, key, plain ), want, 8 );
+    (void)auth_DESexpandKey( &ks, key );
+    Check( "auth_DESencrypt", i,
+           auth_DESencrypt( got, &ks, plain ), want, 8 );
+    }
+
+  for( i = 0; NULL != LMkat[i].pwd; i++ )
+    {
+    Unhex( want, LMkat[i].hash, 16 );
+    (void)auth_LMhash( got, (const uchar *)LMkat[i].pwd,
+                       strlen( LMkat[i].pwd ) );
+    Check( "auth_LMhash", i, got, want, 16 );
+    }
+  } /* KnownAnswers */
+
+
+static void Batch( int count )
+  /* ------------------------------------------------------------------------ **
+   * Compare the batch functions against the scalar ones.
+   *
+   *  Input:  count - Number of entries to pass to the batch functions.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  The key, data, and password arrays are allocated with exactly
+   *          <count> entries so that a memory checker will catch any read
+   *          beyond the end of them.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static uchar  keys[kMAX][7];
+  static uchar  data[kMAX][8];
+  static uchar  pwds[kMAX][14];
+  static uchar  outN[kMAX][16];
+  uchar         want[16];
+  const uchar **key;
+  const uchar **src;
+  const uchar **pwd;
+  uchar       **dst;
+  int          *pwdlen;
+  int           i;
+  int           j;
+
+  key    = (const uchar **)calloc( count, sizeof( uchar * ) );
+  src    = (const uchar **)calloc( count, sizeof( uchar * ) );
+  pwd    = (const uchar **)calloc( count, sizeof( uchar * ) );
+  dst    = (uchar **)calloc( count, sizeof( uchar * ) );
+  pwdlen = (int *)calloc( count, sizeof( int ) );
+  if( !key || !src || !pwd || !dst || !pwdlen )
+    Fail( "Out of memory.\n" );
+
+  for( i = 0; i < count; i++ )
+    {
+    for( j = 0; j < 7; j++ )
+      keys[i][j] = Random();
+    for( j = 0; j < 8; j++ )
+      data[i][j] = Random();
+    pwdlen[i] = Random() % 15;
+    for( j = 0; j < pwdlen[i]; j++ )
+      pwds[i][j] = 0x20 + (Random() % 0x5F);
+    key[i] = keys[i];
+    src[i] = data[i];
+    pwd[i] = pwds[i];
+    dst[i] = outN[i];
+    }
+
+  (void)auth_DEShashN( dst, key, src, count );
+  for( i = 0; i < count; i++ )
+    Check( "auth_DEShashN", i,
+           outN[i], auth_DEShash( want, keys[i], data[i] ), 8 );
+
+  (void)auth_LMhashN( dst, pwd, pwdlen, count );
+  for( i = 0; i < count; i++ )
+    Check( "auth_LMhashN", i,
+           outN[i], auth_LMhash( want, pwds[i], pwdlen[i] ), 16 );
+
+  free( key );
+  free( src );
+  free( pwd );
+  free( dst );
+  free( pwdlen );
+  } /* Batch */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions...
+ */
+
+int main( int argc, char *argv[] )
+  /* ------------------------------------------------------------------------ **
+   * Mainline
+   *
+   *  Input:  argc  - You know what this is.
+   *          argv  - You know what to do.
+   *
+   *  Output: EXIT_SUCCESS if all results match, else EXIT_FAILURE.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  int rounds = 20;
+  int c;
+  int r;
+  int i;
+
+  while( (c = getopt( argc, argv, "hVr:" )) > 0 )
+    {
+    switch( c )
+      {
+      case 'r': rounds = atoi( optarg ); break;
+      case 'V': version( argv[0], EXIT_SUCCESS ); break;
+      case 'h': usage( argv[0], EXIT_SUCCESS );   break;
+      default:  usage( argv[0], EXIT_FAILURE );   break;
+      }
+    }
+  if( rounds < 0 )
+    usage( argv[0], EXIT_FAILURE );
+
+  KnownAnswers();
+  for( r = 0; r < rounds; r++ )
+    for( i = 0; Counts[i] > 0; i++ )
+      Batch( Counts[i] );
+
+  Say( "%s\n", Failures ? "FAILED" : "All results match." );
+  return( Failures ? EXIT_FAILURE : EXIT_SUCCESS );
+  } /* main */
+
+/* ========================================================================== */
@@ -0,0 +1,250 @@
+/* ========================================================================== **
+ *                                 md5bench.c
+ *
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ *  Email: crh@ubiqx.mn.org
+ *
+ *  $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *
+ *  This program measures the throughput of the MD5 module (Auth/MD5.c) in
+ *  megabytes per second, for a range of message sizes.
+ *
+ *  Each size is hashed two ways:
+ *    whole   - Init/Sum/Close with the message passed in a single call.
+ *              Full 64-byte blocks are compressed straight from the
+ *              caller's buffer.
+ *    pieces  - The message is passed to auth_md5SumCtx() in 13-byte
+ *              chunks, so that every block is assembled in the context.
+ *
+ *  To compare against another version of the MD5 module, build this
+ *  program a second time using that version of MD5.c.
+ *
+ * Compile:
+ *
+ * $ cc -O2 -I ../ -o md5bench md5bench.c ../util/MsgOut.c ../Auth/MD5.c
+ *
+ * ========================================================================== **
+ */
+
+#include <stdio.h>      /* Standard I/O.              */
+#include <stdlib.h>     /* Standard C stuff.          */
+#include <unistd.h>     /* For getopt(3).             */
+#include <time.h>       /* For clock_gettime(2).      */
+
+#include "cifs.h"       /* CIFS toolkit header.       */
+
+
+/* -------------------------------------------------------------------------- **
+ * Constants:
+ *
+ *  bSIZE - Size of the largest message to be hashed.
+ *  CHUNK - Size of the pieces in which the message is fed in "pieces" mode.
+ */
+
+#define bSIZE (64 * 1024)
+#define CHUNK 13
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *  helpmsg   - An array of strings, terminated by a NULL pointer value.
+ *
+ *  Copyright - Copyright string.
+ *  License   - License under which the software is released.
+ *  ID        - Long-hand string providing revision information.
+ *
+ *  Sizes     - Message sizes to be measured, terminated by zero.
+ */
+
+static const char *helpmsg[] =
+  {
+  "",
+  "Usage: %s [-h|-V] [-t <seconds>]",
+  "  Measure MD5 throughput for a range of message sizes, spending about",
+  "  <seconds> (default 0.5) on each measurement.",
+  "  ",
+  "  -h : Causes this message to be displayed then exits the program.",
+  "  -V : Displays version and license information, then exits.",
+  "",
+  NULL
+  };
+
+static const char *Copyright = "Copyright (c) 2026 by the libcifs contributors";
+static const char *License   = "GNU General Public License Version 2 or Later";
+static const char *ID        = "$Id$";
+
+static const int Sizes[] = { 64, 576, 1500, 4096, bSIZE, 0 };
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions...
+ */
+
+static void usage( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Prints the usage message, then exits with the given <status>.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)util_Usage( stderr, helpmsg, prognam );
+  exit( status );
+  } /* usage */
+
+
+static void version( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Print version and license information, the bail out.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Err( "%s: %s\n", prognam, ID );
+  Err( " License: %s\n", License );
+  Err( "%s\n\n", Copyright );
+  exit( status );
+  } /* version */
+
+
+static double Seconds( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a monotonic time in seconds.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + (ts.tv_nsec / 1e9) );
+  } /* Seconds */
+
+
+static double Measure( const uchar *msg, int size, int chunk, double limit )
+  /* ------------------------------------------------------------------------ **
+   * Hash <msg> repeatedly for about <limit> seconds.
+   *
+   *  Input:  msg   - The message to hash.
+   *          size  - Length of <msg>, in bytes.
+   *          chunk - Number of bytes per call to auth_md5SumCtx().
+   *          limit - Approximate run time, in seconds.
+   *
+   *  Output: Throughput, in megabytes (10^6 bytes) per second.
+   *
+   *  Notes:  Each digest is folded into the next message's first bytes
+   *          so that the compiler cannot skip any of the work.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static uchar copy[bSIZE];
+  auth_md5Ctx  ctx[1];
+  uchar        digest[16];
+  long         count = 0;
+  double       t0;
+  double       t1;
+  int          i;
+  int          n;
+
+  (void)memcpy( copy, msg, size );
+  t0 = Seconds();
+  do
+    {
+    for( n = 0; n < 64; n++ )
+      {
+      (void)auth_md5InitCtx( ctx );
+      for( i = 0; i < size; i += chunk )
+        (void)auth_md5SumCtx( ctx, &copy[i],
+                              ((size - i) < chunk) ? (size - i) : chunk );
+      (void)auth_md5CloseCtx( ctx, digest );
+      copy[0] ^= digest[0];
+      }
+    count += n;
+    t1 = Seconds();
+    } while( (t1 - t0) < limit );
+
+  return( ((double)count * size) / (t1 - t0) / 1e6 );
+  } /* Measure */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions...
+ */
+
+int main( int argc, char *argv[] )
+  /* ------------------------------------------------------------------------ **
+   * Mainline
+   *
+   *  Input:  argc  - You know what this is.
+   *          argv  - You know what to do.
+   *
+   *  Output: EXIT_SUCCESS, or EXIT_FAILURE if the user needs some help.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static uchar msg[bSIZE];
+  double       limit = 0.5;
+  int          c;
+  int          i;
+
+  while( (c = getopt( argc, argv, "hVt:" )) > 0 )
+    {
+    switch( c )
+      {
+      case 't': limit = atof( optarg ); break;
+      case 'V': version( argv[0], EXIT_SUCCESS ); break;
+      case 'h': usage( argv[0], EXIT_SUCCESS );   break;
+      default:  usage( argv[0], EXIT_FAILURE );   break;
+      }
+    }
+  if( limit <= 0.0 )
+    usage( argv[0], EXIT_FAILURE );
+
+  for( i = 0; i < bSIZE; i++ )
+    msg[i] = (uchar)(i * 131);
+
+  Say( "%8s  %12s  %12s\n", "size", "whole MB/s", "pieces MB/s" );
+  for( i = 0; Sizes[i] > 0; i++ )
+    {
+    Say( "%8d  %12.1f  %12.1f\n", Sizes[i],
+         Measure( msg, Sizes[i], Sizes[i], limit ),
+         Measure( msg, Sizes[i], CHUNK, limit ) );
+    }
+
+  return( EXIT_SUCCESS );
+  } /* main */
+
+/* ========================================================================== */
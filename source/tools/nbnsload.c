@@ -0,0 +1,474 @@
+/* ========================================================================== **
+ *                                 nbnsload.c
+ *
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ *  Email: crh@ubiqx.mn.org
+ *
+ *  $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *
+ *  This program is a load generator for the NBNS name server engine
+ *  (NBT/NS/Server.c).  By default, it forks a server that listens on
+ *  the loopback interface, then runs three phases against it:
+ *
+ *    - Register <names> distinct unique names.
+ *    - Send <queries> name queries for those names, using the
+ *      asynchronous resolver with a fixed number of queries in flight.
+ *    - Release all of the names.
+ *
+ *  The rate of each phase is reported.  With -a, the local server is not
+ *  started, and the load is sent to the given address instead.
+ *
+ * Compile:
+ *
+ * $ cc -I ../ -o nbnsload nbnsload.c ../util/MsgOut.c ../NBT/Names.c \
+ *   ../NBT/NS/Packet.c ../NBT/NS/Message.c ../NBT/NS/Builder.c \
+ *   ../NBT/NS/Transport.c ../NBT/NS/Resolver.c ../NBT/NS/Server.c \
+ *   ../cifs_block.c ../cifs_pool.c -lpthread
+ *
+ * ========================================================================== **
+ */
+
+#include <stdio.h>        /* Standard I/O.             */
+#include <stdlib.h>       /* Standard C stuff.         */
+#include <unistd.h>       /* For fork(2), getopt(3).   */
+#include <errno.h>        /* For errno.                */
+#include <signal.h>       /* For kill(2).              */
+#include <time.h>         /* For clock_gettime(2).     */
+#include <sys/wait.h>     /* For waitpid(2).           */
+#include <arpa/inet.h>    /* For inet_addr(3).         */
+
+#include "cifs.h"         /* CIFS toolkit header.      */
+
+
+/* -------------------------------------------------------------------------- **
+ * Defines:
+ *  BATCH - Number of registration or release requests sent at once.
+ *  TRIES - Number of times a registration or release request is sent
+ *          before giving up on it.
+ */
+
+#define BATCH 256
+#define TRIES 3
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *  helpmsg   - An array of strings, terminated by a NULL pointer value.
+ *
+ *  Copyright - Copyright string.
+ *  License   - License under which the software is released.
+ *  ID        - Long-hand string providing revision information.
+ *
+ *  Answered  - Number of queries that received a positive reply.
+ *  Failed    - Number of queries that timed out or were refused.
+ *  InFlight  - Number of queries currently pending.
+ */
+
+static const char *helpmsg[] =
+  {
+  "",
+  "Usage: %s [-h|-V] [-n <names>] [-q <queries>] [-c <inflight>]",
+  "          [-t <threads>] [-p <port>] [-a <IP>]",
+  "  Register <names> names (default 10000), send <queries> name queries",
+  "  (default 200000) with <inflight> outstanding (default 1000, maximum",
+  "  4096), then release the names.  Unless -a is given, a name server",
+  "  with <threads> worker threads (default 2) is started on",
+  "  127.0.0.1:<port> (default 1137).",
+  "  ",
+  "  -a : Send the load to the server at <IP> instead of starting one.",
+  "  -h : Causes this message to be displayed then exits the program.",
+  "  -V : Displays version and license information, then exits.",
+  "",
+  NULL
+  };
+
+static const char *Copyright = "Copyright (c) 2026 by the libcifs contributors";
+static const char *License   = "GNU General Public License Version 2 or Later";
+static const char *ID        = "$Id$";
+
+static long Answered = 0;
+static long Failed   = 0;
+static int  InFlight = 0;
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions...
+ */
+
+static void usage( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Prints the usage message, then exits with the given <status>.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)util_Usage( stderr, helpmsg, prognam );
+  exit( status );
+  } /* usage */
+
+
+static void version( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Print version and license information, the bail out.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Err( "%s: %s\n", prognam, ID );
+  Err( " License: %s\n", License );
+  Err( "%s\n\n", Copyright );
+  exit( status );
+  } /* version */
+
+
+static double Seconds( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a monotonic time in seconds.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + (ts.tv_nsec / 1e9) );
+  } /* Seconds */
+
+
+static void SetName( nbt_NameRec *namerec, const long idx )
+  /* ------------------------------------------------------------------------ **
+   * Fill in the name field of a name record with the <idx>'th test name.
+   *
+   *  Notes:  <namerec>->name must point to nbt_NB_NAME_MAX bytes.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  namerec->namelen = snprintf( (char *)namerec->name, nbt_NB_NAME_MAX,
+                               "HOST%09ld", idx );
+  } /* SetName */
+
+
+static void Server( nbt_nsServer *srv, struct sockaddr_in *addr, int threads )
+  /* ------------------------------------------------------------------------ **
+   * Run the local name server.  Never returns.
+   *
+   *  Input:  srv     - The server engine.
+   *          addr    - The address to listen on.
+   *          threads - Number of worker threads.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  if( nbt_nsServerRun( srv, addr, threads ) < 0 )
+    Fail( "Server failed: %s.\n", strerror( errno ) );
+  exit( EXIT_SUCCESS );
+  } /* Server */
+
+
+static long Update( nbt_nsTransport    *xport,
+                    struct sockaddr_in *dest,
+                    const uint16_t      opcode,
+                    const long          names )
+  /* ------------------------------------------------------------------------ **
+   * Register or release the test names.
+   *
+   *  Input:  xport   - Transport to use.
+   *          dest    - The name server.
+   *          opcode  - nbt_nsOPCODE_REGISTER or nbt_nsOPCODE_RELEASE.
+   *          names   - Number of names.
+   *
+   *  Output: The number of names for which a positive response was
+   *          received.
+   *
+   *  Notes:  Requests are sent in batches of BATCH.  The TID of each
+   *          request is its index within the batch, and a batch is
+   *          finished when every request has been answered or has been
+   *          sent TRIES times.  Each name <i> is given the address
+   *          10.<i>, so that every name has a different owner.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static cifs_Block  *msg[BATCH];
+  static struct sockaddr_in addr[BATCH];
+  static bool         done[BATCH];
+  nbt_NameRec         namerec[1];
+  uchar               name[nbt_NB_NAME_MAX];
+  nbt_nsDatagram     *dg;
+  long                good = 0;
+  long                base;
+  int                 count;
+  int                 left;
+  int                 tries;
+  int                 n;
+  int                 i;
+
+  namerec->name     = name;
+  namerec->pad      = ' ';
+  namerec->sfx      = 0x20;
+  namerec->scope_id = NULL;
+
+  for( base = 0; base < names; base += count )
+    {
+    count = ((names - base) < BATCH) ? (int)(names - base) : BATCH;
+    for( i = 0; i < count; i++ )
+      done[i] = false;
+    left = count;
+
+    for( tries = 0; (left > 0) && (tries < TRIES); tries++ )
+      {
+      /* (Re)send whatever has not been answered. */
+      for( n = i = 0; i < count; i++ )
+        {
+        nbt_nsBuilder bld[1];
+        cifs_Block   *b;
+        uchar         rdata[6];
+        long          idx = base + i;
+
+        if( done[i] )
+          continue;
+        b = cifs_BlockPoolGet( cifs_poolNS_SIZE );
+        if( NULL == b )
+          Fail( "Out of memory.\n" );
+        SetName( namerec, idx );
+        nbt_SetShort( rdata, 0, 0x2000 );         /* P node, unique. */
+        rdata[2] = 10;
+        rdata[3] = (uchar)(idx >> 16);
+        rdata[4] = (uchar)(idx >> 8);
+        rdata[5] = (uchar)idx;
+        (void)nbt_nsBuildInit( bld, b, i, opcode | nbt_nsRD_BIT );
+        (void)nbt_nsBuildQuestionName( bld, namerec, nbt_nsQTYPE_NB );
+        (void)nbt_nsBuildRR( bld, nbt_nsADDREC, NULL, 0,
+                             nbt_nsRRTYPE_NB, 3600, rdata, 6 );
+        (void)nbt_nsBuildEnd( bld );
+        msg[n]  = b;
+        addr[n] = *dest;
+        n++;
+        }
+      (void)nbt_nsTransportSend( xport, msg, addr, n );
+      for( i = 0; i < n; i++ )
+        cifs_BlockPoolPut( msg[i] );
+
+      /* Collect responses until all are in or the wait runs out. */
+      while( (left > 0) && (nbt_nsTransportRecv( xport, 1000 ) > 0) )
+        {
+        while( NULL != (dg = nbt_nsTransportNext( xport )) )
+          {
+          int type = nbt_nsParseMsg( &dg->msg );
+
+          i = dg->msg.tid;
+          if( (i < count) && !done[i] && (type > 0)
+           && (nbt_nsWACK_REPLY != type) )
+            {
+            done[i] = true;
+            left--;
+            if( (nbt_nsNAME_REG_REPLY_POS == type)
+             || (nbt_nsNAME_RELEASE_REPLY_POS == type) )
+              good++;
+            }
+          nbt_nsTransportRelease( xport );
+          }
+        }
+      }
+    }
+  return( good );
+  } /* Update */
+
+
+static void Done( nbt_nsQuery *q, nbt_nsMsgBlock *reply )
+  /* ------------------------------------------------------------------------ **
+   * Resolver completion callback.
+   *
+   *  Input:  q     - The finished query.
+   *          reply - The reply, or NULL on timeout.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  InFlight--;
+  if( (NULL != reply) && (nbt_nsRES_POSITIVE == q->status) )
+    Answered++;
+  else
+    Failed++;
+  } /* Done */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions...
+ */
+
+int main( int argc, char *argv[] )
+  /* ------------------------------------------------------------------------ **
+   * Mainline
+   *
+   *  Input:  argc  - You know what this is.
+   *          argv  - You know what to do.
+   *
+   *  Output: EXIT_SUCCESS, or EXIT_FAILURE if any request failed.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static nbt_nsTransport xport[1];
+  nbt_nsServer          *srv;
+  nbt_nsResolver        *r;
+  nbt_NameRec            namerec[1];
+  uchar                  name[nbt_NB_NAME_MAX];
+  struct sockaddr_in     dest;
+  struct sockaddr_in     local;
+  char                  *server   = NULL;
+  long                   names    = 10000;
+  long                   queries  = 200000;
+  long                   started  = 0;
+  long                   registered;
+  long                   released;
+  int                    inflight = 1000;
+  int                    threads  = 2;
+  int                    port     = 1137;
+  int                    sock;
+  int                    c;
+  pid_t                  pid = 0;
+  double                 t0;
+  double                 t1;
+  double                 t2;
+  double                 t3;
+
+  while( (c = getopt( argc, argv, "hVn:q:c:t:p:a:" )) > 0 )
+    {
+    switch( c )
+      {
+      case 'n': names    = atol( optarg ); break;
+      case 'q': queries  = atol( optarg ); break;
+      case 'c': inflight = atoi( optarg ); break;
+      case 't': threads  = atoi( optarg ); break;
+      case 'p': port     = atoi( optarg ); break;
+      case 'a': server   = optarg;         break;
+      case 'V': version( argv[0], EXIT_SUCCESS ); break;
+      case 'h': usage( argv[0], EXIT_SUCCESS );   break;
+      default:  usage( argv[0], EXIT_FAILURE );   break;
+      }
+    }
+  if( (names < 1) || (names > 0xFFFFFF) || (queries < 0)
+   || (inflight < 1) || (inflight > nbt_nsRES_MAXQ) || (threads < 1) )
+    usage( argv[0], EXIT_FAILURE );
+
+  (void)memset( &dest, 0, sizeof( dest ) );
+  dest.sin_family      = AF_INET;
+  dest.sin_port        = htons( port );
+  dest.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  if( NULL != server )
+    dest.sin_addr.s_addr = inet_addr( server );
+  else
+    {
+    srv = nbt_nsServerNew( 0 );
+    if( NULL == srv )
+      Fail( "Could not create the server.\n" );
+    pid = fork();
+    if( 0 == pid )
+      Server( srv, &dest, threads );
+    if( pid < 0 )
+      Fail( "Could not start the server.\n" );
+    nbt_nsServerFree( srv );
+    (void)usleep( 100000 );
+    }
+
+  /* Registration and release use their own socket. */
+  sock = socket( AF_INET, SOCK_DGRAM, 0 );
+  (void)memset( &local, 0, sizeof( local ) );
+  local.sin_family = AF_INET;
+  if( (sock < 0)
+   || (bind( sock, (struct sockaddr *)&local, sizeof( local ) ) < 0) )
+    Fail( "Could not open a socket.\n" );
+  c = 4 * 1024 * 1024;
+  (void)setsockopt( sock, SOL_SOCKET, SO_RCVBUF, &c, sizeof( c ) );
+  (void)nbt_nsTransportInit( xport, sock );
+
+  t0 = Seconds();
+  registered = Update( xport, &dest, nbt_nsOPCODE_REGISTER, names );
+  t1 = Seconds();
+
+  r = nbt_nsResolverOpen( 0 );
+  if( NULL == r )
+    Fail( "Could not open the resolver.\n" );
+  nbt_nsResolverSetRetry( r, 1000, 1000, 3 );
+
+  namerec->name     = name;
+  namerec->pad      = ' ';
+  namerec->sfx      = 0x20;
+  namerec->scope_id = NULL;
+
+  while( (Answered + Failed) < queries )
+    {
+    while( (InFlight < inflight) && (started < queries) )
+      {
+      SetName( namerec, started % names );
+      if( NULL == nbt_nsResolverQuery( r, namerec, nbt_nsQTYPE_NB,
+                                       nbt_nsRD_BIT, &dest, Done, NULL ) )
+        break;
+      InFlight++;
+      started++;
+      }
+    if( nbt_nsResolverRun( r, 10 ) < 0 )
+      Fail( "Resolver error.\n" );
+    }
+  t2 = Seconds();
+  nbt_nsResolverClose( r );
+
+  released = Update( xport, &dest, nbt_nsOPCODE_RELEASE, names );
+  t3 = Seconds();
+  nbt_nsTransportFree( xport );
+  (void)close( sock );
+
+  if( pid > 0 )
+    {
+    (void)kill( pid, SIGTERM );
+    (void)waitpid( pid, NULL, 0 );
+    }
+
+  Say( "register: %ld of %ld in %.3f seconds, %.0f/second\n",
+       registered, names, t1 - t0, registered / (t1 - t0) );
+  Say( "query:    %ld of %ld in %.3f seconds, %.0f/second (%d in flight)\n",
+       Answered, queries, t2 - t1, Answered / (t2 - t1), inflight );
+  Say( "release:  %ld of %ld in %.3f seconds, %.0f/second\n",
+       released, names, t3 - t2, released / (t3 - t2) );
+  return( ((registered < names) || (released < names) || (Failed > 0))
+          ? EXIT_FAILURE : EXIT_SUCCESS );
+  } /* main */
+
+/* ========================================================================== */
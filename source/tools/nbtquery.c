@@ -47,6 +47,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
+#include <time.h>
 
 #include <sys/ioctl.h>
 
@@ -64,6 +65,7 @@
  * Constants:
  *
  *  bSIZE     - Buffer size.
+ *  SWEEP_QPS - Default sweep rate, in queries per second (-q).
  *
  *  Copyright - Copyright string.  It's a difficult world...
  *  Revision  - Short-hand string providing revision information (-V).
@@ -76,7 +78,8 @@
  *  verbosemsg- A more detailed help message.
  */
 
-#define bSIZE 1024
+#define bSIZE     1024
+#define SWEEP_QPS 1000
 
 static const char *Copyright
                 = "Copyright (c) 2001-2008, 2010 by Christopher R. Hertel";
@@ -91,6 +94,7 @@ static const char *helpmsg[] =
   "  nbtquery [-crRv][-w <w>][(-B|-U) <IP>][-p <pad>][-s <sfx>][-S <scp>] <Name>",
   "Adapter Status Queries:",
   "  nbtquery -A [-rv][-w <w>][-S <scp>] <IP>",
+  "  nbtquery -A [-rv][-w <w>][-q <qps>][-S <scp>] <IP|CIDR|@file> ...",
   "  nbtquery -a [-crv][-w <w>][(-B|-U) <IP>][-p <pad>][-s <sfx>][-S <scp>] <Name>",
   "Locate Browser nodes:",
   "  nbtquery -b [-crRv][-w <w>][(-B|-U) <IP>][-S <scp>][[-D|-L] <Name>]",
@@ -105,6 +109,7 @@ static const char *helpmsg[] =
   "  -S <scp>   Append Scope ID <scp> to the NetBIOS name",
   "  -D, -L     Look for Domain Master Browser; Look for Local Master Browser",
   "  -w <w:i,r> Wait <w> ms for replies, add <i> ms per retry, max retries <r>",
+  "  -q <qps>   Sweep: send at most <qps> queries per second (default 1000)",
   "  -v[v], -V  -v[v] = Be [very] verbose;  -V = Display Version and exit.",
   "<Name> is either an asterisk ('*') or NetBIOS name.  If '*', then the",
   "default <pad> is nul (0x00).  <IP> may be an IP address or a DNS name.",
@@ -137,6 +142,25 @@ static const char *verbosemsg[] =
   "",
   "      nbtquery -a [-rv][-w <w>][-S <scp>] -U <IP> \"*\"",
   "",
+  "  nbtquery -A [-rv][-w <w>][-q <qps>][-S <scp>] <IP|CIDR|@file> ...",
+  "",
+  "    Given more than one target, a CIDR range (eg. 10.1.0.0/16), or a",
+  "    file of targets (@file, or @- for standard input), -A sweeps all of",
+  "    the addresses.  Queries are sent from a single socket at up to <qps>",
+  "    per second, with many outstanding at once, and each target is",
+  "    retried as given by -w.  The network and broadcast addresses of a",
+  "    range are skipped.  Target files list one target per line, and '#'",
+  "    starts a comment.  A <qps> of zero removes the rate limit.",
+  "",
+  "    Each node that answers produces one line of tab-separated output:",
+  "",
+  "      <IP> <MAC> <NAME><<sfx>>/<flags> ...",
+  "",
+  "    The flags are as shown for a single query (eg. U,H,ACT).  Non-printing",
+  "    characters in names are escaped, and trailing spaces are removed.",
+  "    With -v, targets that do not answer are listed with a MAC of '-',",
+  "    negative replies with '!<rcode>', and a summary is printed to stderr.",
+  "",
   "  nbtquery -a [-crv][-w <w>][(-B|-U) <IP>][-p <pad>][-s <sfx>][-S <scp>] <Name>",
   "",
   "    The -a option causes nbtquery to send a Node Status Request using the",
@@ -193,6 +217,7 @@ static const char *verbosemsg[] =
   "  -S <scp>   Append Scope ID <scp> to the NetBIOS name",
   "  -D, -L     Look for Domain Master Browser; Look for Local Master Browser",
   "  -w <w:i,r> Wait <w> ms for replies, add <i> ms per retry, max retries <r>",
+  "  -q <qps>   Sweep: send at most <qps> queries per second (default 1000)",
   "  -v[v], -V  -v[v] = Be [very] verbose;  -V = Display Version and exit.",
   "<Name> is either an asterisk ('*') or NetBIOS name.  If '*', then default",
   "<pad> is nul (0x00).  <IP> may be an IP address or a DNS name.",
@@ -342,6 +367,10 @@ static const char *verbosemsg[] =
  * Typedefs:
  *
  *  ValName - Value to name mapping structure.
+ *
+ *  Range   - A range of IPv4 addresses to sweep, in host byte order.
+ *            <next> is the next address to query, and <done> is set once
+ *            <last> has been queried.
  */
 
 typedef struct
@@ -350,6 +379,13 @@ typedef struct
   char *name;
   } ValName;
 
+typedef struct
+  {
+  uint32_t next;
+  uint32_t last;
+  bool     done;
+  } Range;
+
 
 /* -------------------------------------------------------------------------- **
  * Enumerated types:
@@ -359,6 +395,8 @@ typedef struct
  *              NodeStatusIP    - Adapter Status using wildcard name, sent
  *                                to the given IP.
  *              NodeStatusName  - Adapter Status using a NetBIOS name.
+ *              NodeStatusSweep - Adapter Status using wildcard name, sent
+ *                                to many IPs.
  *              BrowserFind     - Locate browser nodes.
  *              Version         - Just print version and exit.
  *
@@ -370,6 +408,7 @@ typedef enum
   NameQuery = 0,
   NodeStatusIP,
   NodeStatusName,
+  NodeStatusSweep,
   BrowserFind,
   Version
   } querytype;
@@ -399,6 +438,9 @@ typedef enum
  *
  *  ForceSfx  - Default false.  True if sfx set on command line via -s.
  *
+ *  ForceRate - Default false.  True if the sweep rate was set on the
+ *              command line via -q.
+ *
  *  DMBQuery  - Default false.  Used with -b.  If true use suffix 0x1B.
  *
  *  LMBQuery  - Default false.  Used with -b.  If true use suffix 0x1D.
@@ -438,7 +480,27 @@ typedef enum
  *
  *  SendBufr  - Outgoing packet buffer.
  *
- *  RecvBufr  - Incoming packet buffer.
+ *  SendBlock - Block header for <SendBufr>.
+ *
+ *  Xport     - Receive ring.  Replies are read in batches.
+ *
+ *  SweepRate - Sweep mode.  Maximum number of queries sent per second.
+ *              Zero means no limit.
+ *
+ *  Targets   - Sweep mode.  Target arguments from the command line.
+ *  NTargets  - Number of entries in <Targets>.
+ *
+ *  Ranges    - Sweep mode.  Address ranges built from <Targets>.
+ *  NRanges   - Number of entries in <Ranges>.
+ *  CurRange  - Index of the range currently being swept.
+ *
+ *  SweepAddr - Sweep mode.  The target address of each outstanding query.
+ *              The resolver hands the query's entry back to us as its
+ *              context pointer.
+ *  SweepFree - Stack of free <SweepAddr> entries.
+ *  NFree     - Number of entries on the <SweepFree> stack.
+ *
+ *  Replies   - Sweep mode.  Number of node status replies received.
  */
 
 static bool    Bcast      = true;
@@ -446,6 +508,7 @@ static bool    UpCase     = true;
 static bool    Port137    = false;
 static bool    ForcePad   = false;
 static bool    ForceSfx   = false;
+static bool    ForceRate  = false;
 static bool    DMBQuery   = false;
 static bool    LMBQuery   = false;
 
@@ -465,10 +528,25 @@ static int      RetryCnt  = 3;
 static int      OurSocket = -1;
 
 static uchar    SendBufr[bSIZE];
-static uchar    RecvBufr[bSIZE];
+
+static cifs_Block SendBlock[1];
+
+static nbt_nsTransport Xport[1];
 
 static uint16_t TID = 0xF00D;
 
+static long     SweepRate = SWEEP_QPS;
+static char   **Targets   = NULL;
+static int      NTargets  = 0;
+static Range   *Ranges    = NULL;
+static int      NRanges   = 0;
+static int      CurRange  = 0;
+
+static struct in_addr SweepAddr[nbt_nsRES_MAXQ];
+static int            SweepFree[nbt_nsRES_MAXQ];
+static int            NFree   = 0;
+static long           Replies = 0;
+
 
 /* -------------------------------------------------------------------------- **
  * Functions:
@@ -519,6 +597,7 @@ static char *qtoptchar( querytype qt )
     case NameQuery:       return( "" );
     case NodeStatusIP:    return( "-A" );
     case NodeStatusName:  return( "-a" );
+    case NodeStatusSweep: return( "-A" );
     case BrowserFind:     return( "-b" );
     case Version:         return( "-V" );
     }
@@ -801,7 +880,7 @@ static querytype ReadOpts( int argc, char * const argv[] )
   if( argc <= 1 )
     usage( argv[0] );
 
-  while( (c = getopt( argc, argv, "AaB:bcDhLp:R:rS:s:U:Vvw:" )) >= 0 )
+  while( (c = getopt( argc, argv, "AaB:bcDhLp:q:R:rS:s:U:Vvw:" )) >= 0 )
     {
     switch( c )     /* Read the options. */
       {
@@ -900,6 +979,12 @@ static querytype ReadOpts( int argc, char * const argv[] )
       case 'r':
         Port137 = true;
         break;
+      case 'q':
+        SweepRate = atol( optarg );
+        if( SweepRate < 0 )
+          Fail( "Invalid query rate: -q %s.\n", optarg );
+        ForceRate = true;
+        break;
       case 'v':
         Verbose++;
         break;
@@ -987,6 +1072,21 @@ static querytype ReadOpts( int argc, char * const argv[] )
       if( t_true == RecDes )
         Warn( "-R 1 used with -A; RD bit will be set.\n" );
 
+      /* More than one target, a range, or a file means a sweep. */
+      if( ((argc - optind) > 1)
+       || (NULL != strchr( QueryName, '/' ))
+       || ('@' == *QueryName) )
+        {
+        Targets   = (char **)&argv[optind];
+        NTargets  = argc - optind;
+        QueryName = "*";
+        ForcePad  = false;
+        ForceSfx  = false;
+        Bcast     = false;
+        qt        = NodeStatusSweep;
+        break;
+        }
+
       /* Shuffle some stuff around. */
       DestIP    = QueryName;      /* It's an IP (or DNS name). */
       QueryName = "*";            /* Wildcard query.           */
@@ -1042,6 +1142,8 @@ static querytype ReadOpts( int argc, char * const argv[] )
     }
 
   /* Validate the RetryWait, Increment, and Count values. */
+  if( ForceRate && (NodeStatusSweep != qt) )
+    Warn( "-q <qps> is only used when sweeping (-A with many targets).\n" );
   if( (RetryWait + ((RetryCnt - 1) * RetryInc)) > 0xFFFF )
     {
     Fail( "Total timeout may exceed maximum: -w %d:%d,%d.\n",
@@ -1121,7 +1223,7 @@ static struct in_addr ResolveDestAddr( char *Dest )
   } /* ResolveDestAddr */
 
 
-static uchar *Hexify( uchar *str, int len )
+static uchar *Hexify( const uchar *str, int len )
   /* ------------------------------------------------------------------------ **
    * Rewrite a string, converting any non-printing characters to hex escape
    * sequences.
@@ -1361,6 +1463,32 @@ static int CheckReply( nbt_nsMsgBlock *msg )
   } /* CheckReply */
 
 
+static char *NameFlags( uint16_t flags )
+  /* ------------------------------------------------------------------------ **
+   * Format a node status NAME_FLAGS field.
+   *
+   *  Input:  flags - The NAME_FLAGS value.
+   *
+   *  Output: A pointer to a string such as "U,H,ACT".  You don't own this
+   *          buffer.  It is overwritten on the next call.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static char str[24];
+  static char ont[] = "BPMH";
+
+  (void)snprintf( str, sizeof( str ), "%c,%c%s%s%s%s",
+                  (nbt_nsGROUP_BIT & flags) ? 'G' : 'U',
+                  ont[(nbt_nsONT_MASK & flags) >> 13],
+                  (nbt_nsDRG & flags) ? ",DRG" : "",
+                  (nbt_nsCNF & flags) ? ",CNF" : "",
+                  (nbt_nsACT & flags) ? ",ACT" : "",
+                  (nbt_nsPRM & flags) ? ",PRM" : "" );
+  return( str );
+  } /* NameFlags */
+
+
 static void DumpReply( uchar *reply, int replylen )
   /* ------------------------------------------------------------------------ **
    * Decomposes and prints the reply in simple format.
@@ -1445,42 +1573,26 @@ static void DumpReply( uchar *reply, int replylen )
 
     case nbt_nsNODE_STATUS_REPLY:
       {
-      uint16_t name_flags;
-      uchar   *rdata     = msg->rdata;
-      int      num_names = *rdata;
-
-      offset = 1;   /* We have read one byte into num_names. */
+      nbt_nsNodeStatus ns[1];
+      nbt_nsNodeName   ent[1];
 
       Say( "Response to Node Status Request for: %s\n",
            FormatName( msg->RR_name ) );
 
-      for( i = 0; i < num_names; i++ )
+      if( nbt_nsNodeStatusParseMsg( ns, msg ) < 0 )
         {
-        Say( "%s<%.2x> ", Hexify( &rdata[offset], 15 ), rdata[offset+15] );
-        offset += 16;
-        name_flags = nbt_GetShort( rdata, offset );
-        offset += 2;
-        Say( "[%c", (nbt_nsGROUP_BIT & name_flags)?'G':'U' );
-        switch( nbt_nsONT_MASK & name_flags )
-          {
-          case nbt_nsONT_B:  Say( ",B" ); break;
-          case nbt_nsONT_P:  Say( ",P" ); break;
-          case nbt_nsONT_M:  Say( ",M" ); break;
-          case nbt_nsONT_H:  Say( ",H" ); break;
-          }
-        if( nbt_nsDRG & name_flags )
-          Say( ",DRG" );
-        if( nbt_nsCNF & name_flags )
-          Say( ",CNF" );
-        if( nbt_nsACT & name_flags )
-          Say( ",ACT" );
-        if( nbt_nsPRM & name_flags )
-          Say( ",PRM" );
-        Say( "]\n" );
+        Warn( "Malformed Node Status RDATA.\n" );
+        break;
+        }
+      while( nbt_nsNodeStatusNext( ns, ent ) )
+        {
+        Say( "%s<%.2x> ", Hexify( ent->name, 15 ), ent->sfx );
+        Say( "[%s]\n", NameFlags( ent->flags ) );
         }
-      Say( "MAC Addr: %.2x:%.2x:%.2x:%.2x:%.2x:%.2x\n",
-           rdata[offset],   rdata[offset+1], rdata[offset+2],
-           rdata[offset+3], rdata[offset+4], rdata[offset+5] );
+      if( NULL != ns->unit_id )
+        Say( "MAC Addr: %.2x:%.2x:%.2x:%.2x:%.2x:%.2x\n",
+             ns->unit_id[0], ns->unit_id[1], ns->unit_id[2],
+             ns->unit_id[3], ns->unit_id[4], ns->unit_id[5] );
       }
       break;
 
@@ -1622,26 +1734,27 @@ static void VDumpReply( uchar *reply, int replylen )
     }
   else  /* Node Status Reply */
     {
-    uchar   *rdata = msg->rdata;
-    int      num_names = *rdata;
-    uint16_t name_flags;
+    nbt_nsNodeStatus ns[1];
+    nbt_nsNodeName   ent[1];
 
-    offset = 1;   /* We have already eaten one byte for num_names. */
-    Say( "      NUM_NAMES = %d\n", num_names );
-    for( i = 0; i < num_names; i++ )
+    if( nbt_nsNodeStatusParseMsg( ns, msg ) < 0 )
+      {
+      Say( "      <Malformed Node Status RDATA>\n" );
+      Say( "      }\n    }\n  }\n" );
+      return;
+      }
+    Say( "      NUM_NAMES = %d\n", ns->num_names );
+    for( i = 0; nbt_nsNodeStatusNext( ns, ent ); i++ )
       {
       Say( "      NODE_NAME[%d]\n", i );
       Say( "        {\n" );
-      Say( "        NETBIOS_NAME = %s", Hexify( &rdata[offset], 15 ) );
-      Say( "<%.2x>\n", rdata[offset+15] );
-      offset += 16;
-      name_flags = nbt_GetShort( rdata, offset );
-      offset += 2;
+      Say( "        NETBIOS_NAME = %s", Hexify( ent->name, 15 ) );
+      Say( "<%.2x>\n", ent->sfx );
       Say( "        NAME_FLAGS\n" );
       Say( "          {\n" );
-      Say( "          G   = %d\n", (nbt_nsGROUP_BIT & name_flags)?1:0 );
+      Say( "          G   = %d\n", (nbt_nsGROUP_BIT & ent->flags)?1:0 );
       Say( "          ONT = " );
-      switch( nbt_nsONT_MASK & name_flags )
+      switch( nbt_nsONT_MASK & ent->flags )
         {
         case nbt_nsONT_B:  Say( "B (0x00)\n" ); break;
         case nbt_nsONT_P:  Say( "P (0x01)\n" ); break;
@@ -1649,27 +1762,28 @@ static void VDumpReply( uchar *reply, int replylen )
         case nbt_nsONT_H:  Say( "H (0x11)\n" ); break;
         default:  Say( "??\n" ); break;
         }
-      Say( "          DRG = %d\n", (nbt_nsDRG & name_flags)?1:0 );
-      Say( "          CNF = %d\n", (nbt_nsCNF & name_flags)?1:0 );
-      Say( "          ACT = %d\n", (nbt_nsACT & name_flags)?1:0 );
-      Say( "          PRM = %d\n", (nbt_nsPRM & name_flags)?1:0 );
+      Say( "          DRG = %d\n", (nbt_nsDRG & ent->flags)?1:0 );
+      Say( "          CNF = %d\n", (nbt_nsCNF & ent->flags)?1:0 );
+      Say( "          ACT = %d\n", (nbt_nsACT & ent->flags)?1:0 );
+      Say( "          PRM = %d\n", (nbt_nsPRM & ent->flags)?1:0 );
       Say( "          }\n" );
       Say( "        }\n" );
       }
     Say( "      STATISTICS\n" );
     Say( "        {\n" );
-    Say( "        MAC = %.2x:%.2x:%.2x:%.2x:%.2x:%.2x\n",
-          rdata[offset],   rdata[offset+1], rdata[offset+2],
-          rdata[offset+3], rdata[offset+4], rdata[offset+5] );
+    if( NULL != ns->unit_id )
+      Say( "        MAC = %.2x:%.2x:%.2x:%.2x:%.2x:%.2x\n",
+            ns->unit_id[0], ns->unit_id[1], ns->unit_id[2],
+            ns->unit_id[3], ns->unit_id[4], ns->unit_id[5] );
     /* Verbose level > 2 returns a dump of the stats portion. */
-    if( 3 <= Verbose )
+    if( (3 <= Verbose) && (ns->stats_len > 6) )
       {
       uchar tmpbfr[80];
 
-      offset += 6;
-      for( i = 0; offset < replylen; i += 16 )
+      for( i = 0, offset = 6; offset < ns->stats_len; i += 16 )
         {
-        offset += util_HexDumpLn( tmpbfr, &rdata[offset], (replylen - offset) );
+        offset += util_HexDumpLn( tmpbfr, &ns->stats[offset],
+                                  (ns->stats_len - offset) );
         Say( "        %.2x: %s\n", i, tmpbfr );
         }
       }
@@ -1762,6 +1876,7 @@ static void doQuery( uchar Qtype )
   int           i;
   int           result;
   int           msglen;
+  nbt_nsBuilder bld[1];
   struct pollfd pfd[1];
   uint16_t      flags = nbt_nsOPCODE_QUERY | (Bcast  ? nbt_nsB_BIT  : 0);
 
@@ -1778,27 +1893,15 @@ static void doQuery( uchar Qtype )
       break;
     }
 
-  /* Create the header. */
-  result = nbt_nsSetHdr( SendBufr, bSIZE, flags, nbt_nsQUERYREC );
-  switch( result )
-    {
-    case cifs_errBufrTooSmall:
-      Fail( 
-        "[Internal wierdness] nbt_nsSetHdr() buffer too small in doNameQuery()"
-          );
-      break;
-    default:
-      if( result < 0 )
-        Fail( "Unknown error %d from nbt_nsSetHdr()" );
-      break;
-    }
-
-  nbt_nsSetTID( SendBufr, TID );
-
-  /* Fill in the Query Name. */
-  result = nbt_L2Encode( &(SendBufr[nbt_nsHEADER_LEN]), NameRec );
+  /* Build the query message. */
+  (void)cifs_BlockInit( SendBlock, bSIZE, SendBufr );
+  result = nbt_nsBuildInit( bld, SendBlock, TID, flags );
+  if( result < 0 )
+    Fail( "[Internal wierdness] Error %d from nbt_nsBuildInit().\n", result );
+  result = nbt_nsBuildQuestionName( bld, NameRec, Qtype );
   if( result < 0 )
-    Fail( "Unknown error %d returned from L2Encode().\n", result );
+    Fail( "Error %d returned from nbt_nsBuildQuestionName().\n", result );
+  msglen = (int)nbt_nsBuildEnd( bld );
 
   if( Verbose )
     {
@@ -1811,17 +1914,10 @@ static void doQuery( uchar Qtype )
     Say( "]\n" );
 
     Say( "  NBT Name: [%s]\n",
-         Hexify( &(SendBufr[nbt_nsHEADER_LEN]), result ) );
+         Hexify( &(SendBufr[nbt_nsHEADER_LEN]), bld->qlen ) );
     Say( "     Flags: [%s]\n", ListFlags( flags ) );
     }
 
-  /* Fill in Qtype and Qclass. */
-  msglen = result + nbt_nsHEADER_LEN;
-  nbt_SetShort( SendBufr, msglen, Qtype );
-  msglen += 2;
-  nbt_SetShort( SendBufr, msglen, nbt_nsQCLASS_IN );
-  msglen += 2;
-
   /* Sending once, sending twice, sending chicken soup with rice. */
   OpenSocket();
   pfd->fd     = OurSocket;
@@ -1843,41 +1939,316 @@ static void doQuery( uchar Qtype )
   else
     {
     /* Something received.
-     * Grab it, dump it,
+     * Drain everything that has arrived, dump it,
      * and then wait at most a fraction of a second for more.
-     * Note: we are finished using SendBufr so we can recycle it.
+     * A batch in which every datagram was dropped (eg., as truncated)
+     * yields nothing, but that is no reason to stop waiting.
      */
+    (void)nbt_nsTransportInit( Xport, OurSocket );
     do
       {
-      struct sockaddr_in *sox = (struct sockaddr_in *)SendBufr;
+      nbt_nsDatagram *dg;
 
-      result = bSIZE;
-      msglen = recvfrom( OurSocket, RecvBufr, bSIZE, 0,
-                         (struct sockaddr *)sox, (socklen_t *)&result );
-      if( msglen < 0 )
-        Fail( "Error reading reply: %s.\n", strerror( errno ) );
+      result = nbt_nsTransportRecv( Xport, 0 );
+      if( result < 0 )
+        break;
 
-      if( 0 == Verbose )
+      while( NULL != (dg = nbt_nsTransportNext( Xport )) )
         {
-        DumpReply( RecvBufr, msglen );
-        }
-      else
-        {
-        Say( "\nReply from %s:%d\n",
-             inet_ntoa( sox->sin_addr ),
-             ntohs( sox->sin_port ) );
-        if( 1 == Verbose )
-          DumpReply( RecvBufr, msglen );
+        uchar *reply  = dg->msg.block.bufr;
+
+        msglen = (int)dg->msg.block.used;
+        if( 0 == Verbose )
+          {
+          DumpReply( reply, msglen );
+          }
         else
-          VDumpReply( RecvBufr, msglen );
+          {
+          Say( "\nReply from %s:%d\n",
+               inet_ntoa( dg->addr.sin_addr ),
+               ntohs( dg->addr.sin_port ) );
+          if( 1 == Verbose )
+            DumpReply( reply, msglen );
+          else
+            VDumpReply( reply, msglen );
+          }
+        nbt_nsTransportRelease( Xport );
         }
       } while( poll( pfd, 1, 250 ) > 0 );
+    if( result < 0 )
+      Fail( "Error reading reply: %s.\n", strerror( errno ) );
+    nbt_nsTransportFree( Xport );
     }
 
   close( OurSocket );
   } /* doQuery */
 
 
+static void AddTargetFile( char *path );
+
+static void AddTarget( char *spec )
+  /* ------------------------------------------------------------------------ **
+   * Add a sweep target.
+   *
+   *  Input:  spec  - An IP address or DNS name, an address range in CIDR
+   *                  notation (<IP>/<bits>), or @<file>.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  The network and broadcast addresses of a range are skipped,
+   *          except in /31 and /32 ranges, which have neither.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct in_addr addr;
+  char          *slash;
+  char          *end;
+  long           bits = 32;
+  uint32_t       mask;
+  Range         *r;
+
+  if( '@' == *spec )
+    {
+    AddTargetFile( spec + 1 );
+    return;
+    }
+
+  slash = strchr( spec, '/' );
+  if( NULL != slash )
+    {
+    *slash = '\0';
+    bits = strtol( slash + 1, &end, 10 );
+    if( (end == slash + 1) || ('\0' != *end) || (bits < 0) || (bits > 32) )
+      Fail( "Invalid prefix length in %s/%s.\n", spec, slash + 1 );
+    if( 0 == inet_aton( spec, &addr ) )
+      Fail( "Invalid address in range %s/%s.\n", spec, slash + 1 );
+    }
+  else
+    addr = ResolveDestAddr( spec );
+
+  Ranges = (Range *)realloc( Ranges, (NRanges + 1) * sizeof( Range ) );
+  if( NULL == Ranges )
+    Fail( "Out of memory.\n" );
+  r = &Ranges[NRanges++];
+
+  mask    = (bits > 0) ? (0xFFFFFFFF << (32 - bits)) : 0;
+  r->next = ntohl( addr.s_addr ) & mask;
+  r->last = r->next | ~mask;
+  r->done = false;
+  if( bits < 31 )
+    {
+    r->next++;
+    r->last--;
+    }
+  } /* AddTarget */
+
+
+static void AddTargetFile( char *path )
+  /* ------------------------------------------------------------------------ **
+   * Add the sweep targets listed in a file.
+   *
+   *  Input:  path  - The file name, or "-" for standard input.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  Targets are separated by white space.  A '#' starts a comment,
+   *          which runs to the end of the line.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  FILE *f;
+  char  line[256];
+  char *tok;
+
+  f = strcmp( "-", path ) ? fopen( path, "r" ) : stdin;
+  if( NULL == f )
+    Fail( "Cannot open target file %s: %s.\n", path, strerror( errno ) );
+  while( NULL != fgets( line, sizeof( line ), f ) )
+    {
+    line[strcspn( line, "#" )] = '\0';
+    for( tok = strtok( line, " \t\r\n" );
+         NULL != tok;
+         tok = strtok( NULL, " \t\r\n" ) )
+      AddTarget( tok );
+    }
+  if( stdin != f )
+    (void)fclose( f );
+  } /* AddTargetFile */
+
+
+static bool NextTarget( struct in_addr *addr )
+  /* ------------------------------------------------------------------------ **
+   * Return the next address to sweep.
+   *
+   *  Input:  addr  - Receives the next address.
+   *
+   *  Output: True if an address was returned, false if there are no more.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Range *r;
+
+  for( ; CurRange < NRanges; CurRange++ )
+    {
+    r = &Ranges[CurRange];
+    if( !r->done )
+      {
+      addr->s_addr = htonl( r->next );
+      if( r->next == r->last )
+        r->done = true;
+      else
+        r->next++;
+      return( true );
+      }
+    }
+  return( false );
+  } /* NextTarget */
+
+
+static double Seconds( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a monotonic time in seconds.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + (ts.tv_nsec / 1e9) );
+  } /* Seconds */
+
+
+static void SweepDone( nbt_nsQuery *q, nbt_nsMsgBlock *reply )
+  /* ------------------------------------------------------------------------ **
+   * Resolver callback for sweep queries.  Print one line per target.
+   *
+   *  Input:  q     - The finished query.  The context pointer points to
+   *                  the target's entry in <SweepAddr>.
+   *          reply - The reply, or NULL if the query timed out.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct in_addr  *addr = (struct in_addr *)q->ctx;
+  nbt_nsNodeStatus ns[1];
+  nbt_nsNodeName   ent[1];
+  int              len;
+
+  if( (NULL != reply)
+   && (nbt_nsRES_POSITIVE == q->status)
+   && (nbt_nsNodeStatusParseMsg( ns, reply ) >= 0) )
+    {
+    Replies++;
+    Say( "%s\t", inet_ntoa( *addr ) );
+    if( NULL != ns->unit_id )
+      Say( "%.2x:%.2x:%.2x:%.2x:%.2x:%.2x",
+           ns->unit_id[0], ns->unit_id[1], ns->unit_id[2],
+           ns->unit_id[3], ns->unit_id[4], ns->unit_id[5] );
+    else
+      Say( "-" );
+    while( nbt_nsNodeStatusNext( ns, ent ) )
+      {
+      for( len = 15; (len > 0) && (' ' == ent->name[len - 1]); len-- )
+        ;
+      Say( "\t%s<%.2x>", Hexify( ent->name, len ), ent->sfx );
+      Say( "/%s", NameFlags( ent->flags ) );
+      }
+    Say( "\n" );
+    }
+  else if( Verbose )
+    {
+    if( NULL == reply )
+      Say( "%s\t-\n", inet_ntoa( *addr ) );
+    else
+      Say( "%s\t!%d\n", inet_ntoa( *addr ), q->rcode );
+    }
+
+  SweepFree[NFree++] = (int)(addr - SweepAddr);
+  } /* SweepDone */
+
+
+static void doSweep( void )
+  /* ------------------------------------------------------------------------ **
+   * Send node status queries to every sweep target.
+   *
+   *  Input:  <none>
+   *
+   *  Output: <none>
+   *
+   *  Notes:  Queries go out through the asynchronous resolver, which
+   *          handles retries and matches the replies.  New queries are
+   *          started as long as a slot is free and the rate limit allows.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsResolver     *r;
+  struct sockaddr_in  dest;
+  struct in_addr      next;
+  bool                more;
+  long                sent = 0;
+  double              t0;
+  double              t1;
+  int                 slot;
+  int                 i;
+  uint16_t            flags = (t_true == RecDes) ? nbt_nsRD_BIT : 0;
+
+  for( i = 0; i < NTargets; i++ )
+    AddTarget( Targets[i] );
+
+  for( i = 0; i < nbt_nsRES_MAXQ; i++ )
+    SweepFree[i] = i;
+  NFree = nbt_nsRES_MAXQ;
+
+  r = nbt_nsResolverOpen( Port137 ? 137 : 0 );
+  if( NULL == r )
+    Fail( "Unable to open the query socket: %s.\n", strerror( errno ) );
+  nbt_nsResolverSetRetry( r, RetryWait, RetryInc, RetryCnt );
+
+  (void)memset( &dest, 0, sizeof( dest ) );
+  dest.sin_family = AF_INET;
+
+  t0   = Seconds();
+  more = NextTarget( &next );
+  while( more || (NFree < nbt_nsRES_MAXQ) )
+    {
+    /* Start as many queries as the rate limit allows. */
+    long allowed = SweepRate
+                 ? (long)((Seconds() - t0) * SweepRate) + 1
+                 : sent + nbt_nsRES_MAXQ;
+
+    while( more && (NFree > 0) && (sent < allowed) )
+      {
+      slot = SweepFree[--NFree];
+      SweepAddr[slot] = next;
+      dest.sin_addr   = next;
+      if( NULL == nbt_nsResolverQuery( r, NameRec, nbt_nsQTYPE_NBSTAT,
+                                       flags, &dest, SweepDone,
+                                       &SweepAddr[slot] ) )
+        Fail( "Unable to start a query: %s.\n", strerror( errno ) );
+      sent++;
+      more = NextTarget( &next );
+      }
+
+    if( nbt_nsResolverRun( r, (more && (NFree > 0)) ? 1 : 10 ) < 0 )
+      Fail( "Error while waiting for replies: %s.\n", strerror( errno ) );
+    }
+  t1 = Seconds();
+  nbt_nsResolverClose( r );
+
+  if( Verbose )
+    {
+    (void)fflush( stdout );
+    Err( "%ld targets, %ld replies, %.3f seconds.\n", sent, Replies, t1 - t0 );
+    }
+  } /* doSweep */
+
+
 int main( int argc, char *argv[] )
   /* ------------------------------------------------------------------------ **
    * Main.
@@ -1917,6 +2288,9 @@ int main( int argc, char *argv[] )
     case NodeStatusName:
       doQuery( nbt_nsQTYPE_NBSTAT );
       break;
+    case NodeStatusSweep:
+      doSweep();
+      break;
     default:
       if( Verbose > 1 )
         Say( "%s\n", Copyright );
@@ -0,0 +1,339 @@
+/* ========================================================================== **
+ *                                nbtresbench.c
+ *
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ *  Email: crh@ubiqx.mn.org
+ *
+ *  $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *
+ *  This program measures the throughput of the asynchronous NBT name
+ *  resolver (NBT/NS/Resolver.c).  It forks a stand-in name server that
+ *  listens on the loopback interface and answers every name query with
+ *  a positive reply, then resolves a stream of distinct names against it
+ *  while keeping a fixed number of queries in flight.
+ *
+ *  The stand-in does no name lookup at all, so the result is a measure of
+ *  the client side: query construction, batched I/O, TID matching, and
+ *  timer handling.
+ *
+ * Compile:
+ *
+ * $ cc -I ../ -o nbtresbench nbtresbench.c ../util/MsgOut.c \
+ *   ../NBT/Names.c ../NBT/NS/Packet.c ../NBT/NS/Message.c \
+ *   ../NBT/NS/Builder.c ../NBT/NS/Transport.c ../NBT/NS/Resolver.c \
+ *   ../cifs_block.c ../cifs_pool.c -lpthread
+ *
+ * ========================================================================== **
+ */
+
+#include <stdio.h>        /* Standard I/O.             */
+#include <stdlib.h>       /* Standard C stuff.         */
+#include <unistd.h>       /* For fork(2), getopt(3).   */
+#include <signal.h>       /* For kill(2).              */
+#include <time.h>         /* For clock_gettime(2).     */
+#include <sys/wait.h>     /* For waitpid(2).           */
+#include <arpa/inet.h>    /* For inet_addr(3).         */
+
+#include "cifs.h"         /* CIFS toolkit header.      */
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *  helpmsg   - An array of strings, terminated by a NULL pointer value.
+ *
+ *  Copyright - Copyright string.
+ *  License   - License under which the software is released.
+ *  ID        - Long-hand string providing revision information.
+ *
+ *  Answered  - Number of queries that received a positive reply.
+ *  Failed    - Number of queries that timed out or were refused.
+ *  InFlight  - Number of queries currently pending.
+ */
+
+static const char *helpmsg[] =
+  {
+  "",
+  "Usage: %s [-h|-V] [-n <count>] [-c <inflight>] [-p <port>]",
+  "  Resolve <count> names (default 100000) against a stand-in name",
+  "  server on 127.0.0.1:<port> (default 1137), keeping <inflight>",
+  "  queries (default 1000, maximum 4096) outstanding at once.",
+  "  ",
+  "  -h : Causes this message to be displayed then exits the program.",
+  "  -V : Displays version and license information, then exits.",
+  "",
+  NULL
+  };
+
+static const char *Copyright = "Copyright (c) 2026 by the libcifs contributors";
+static const char *License   = "GNU General Public License Version 2 or Later";
+static const char *ID        = "$Id$";
+
+static long Answered = 0;
+static long Failed   = 0;
+static int  InFlight = 0;
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions...
+ */
+
+static void usage( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Prints the usage message, then exits with the given <status>.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)util_Usage( stderr, helpmsg, prognam );
+  exit( status );
+  } /* usage */
+
+
+static void version( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Print version and license information, the bail out.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Err( "%s: %s\n", prognam, ID );
+  Err( " License: %s\n", License );
+  Err( "%s\n\n", Copyright );
+  exit( status );
+  } /* version */
+
+
+static double Seconds( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a monotonic time in seconds.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + (ts.tv_nsec / 1e9) );
+  } /* Seconds */
+
+
+static void Responder( int port )
+  /* ------------------------------------------------------------------------ **
+   * Stand-in name server.  Never returns.
+   *
+   *  Input:  port  - UDP port on which to listen.
+   *
+   *  Output: <none>
+   *
+   *  Notes:  Each query is turned into a positive name query response in
+   *          place, using <nbt_nsBuildReply()>.  The replies are then sent
+   *          back as a batch.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static nbt_nsTransport xport[1];
+  cifs_Block            *msg[nbt_nsRING_SIZE];
+  struct sockaddr_in     addr[nbt_nsRING_SIZE];
+  struct sockaddr_in     sox;
+  nbt_nsDatagram        *dg;
+  int                    sock;
+  int                    n;
+
+  sock = socket( AF_INET, SOCK_DGRAM, 0 );
+  (void)memset( &sox, 0, sizeof( sox ) );
+  sox.sin_family      = AF_INET;
+  sox.sin_port        = htons( port );
+  sox.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  if( bind( sock, (struct sockaddr *)&sox, sizeof( sox ) ) < 0 )
+    Fail( "Responder could not bind port %d.\n", port );
+  n = 4 * 1024 * 1024;
+  (void)setsockopt( sock, SOL_SOCKET, SO_RCVBUF, &n, sizeof( n ) );
+  (void)nbt_nsTransportInit( xport, sock );
+
+  for(;;)
+    {
+    if( nbt_nsTransportRecv( xport, -1 ) < 0 )
+      Fail( "Responder receive error.\n" );
+    /* Walk the ring without releasing anything, so that the replies
+     * can be built in place and sent as one batch.
+     */
+    for( n = 0; n < xport->count; n++ )
+      {
+      nbt_nsBuilder bld[1];
+      int           pos;
+
+      dg = &xport->ring[(xport->head + n) % nbt_nsRING_SIZE];
+
+      /* Response, AA, RD, RA; NB_FLAGS and 127.0.0.1. */
+      (void)nbt_nsBuildReply( bld, &dg->msg.block,
+                              nbt_nsR_BIT | nbt_nsAA_BIT
+                                | nbt_nsRD_BIT | nbt_nsRA_BIT,
+                              nbt_nsANSREC );
+      pos = nbt_nsBuildRData( bld, 300, NULL, 6 );
+      if( pos > 0 )
+        {
+        nbt_SetShort( dg->msg.block.bufr, pos, 0 );
+        (void)memcpy( &dg->msg.block.bufr[pos + 2], "\x7f\0\0\1", 4 );
+        }
+      (void)nbt_nsBuildEnd( bld );
+
+      msg[n]  = &dg->msg.block;
+      addr[n] = dg->addr;
+      }
+    (void)nbt_nsTransportSend( xport, msg, addr, n );
+    while( NULL != nbt_nsTransportNext( xport ) )
+      nbt_nsTransportRelease( xport );
+    }
+  } /* Responder */
+
+
+static void Done( nbt_nsQuery *q, nbt_nsMsgBlock *reply )
+  /* ------------------------------------------------------------------------ **
+   * Resolver completion callback.
+   *
+   *  Input:  q     - The finished query.
+   *          reply - The reply, or NULL on timeout.
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  InFlight--;
+  if( (NULL != reply) && (nbt_nsRES_POSITIVE == q->status) )
+    Answered++;
+  else
+    Failed++;
+  } /* Done */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions...
+ */
+
+int main( int argc, char *argv[] )
+  /* ------------------------------------------------------------------------ **
+   * Mainline
+   *
+   *  Input:  argc  - You know what this is.
+   *          argv  - You know what to do.
+   *
+   *  Output: EXIT_SUCCESS, or EXIT_FAILURE if some queries were not
+   *          answered.
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  nbt_nsResolver     *r;
+  nbt_NameRec         namerec[1];
+  uchar               name[nbt_NB_NAME_MAX];
+  struct sockaddr_in  dest;
+  long                count    = 100000;
+  long                started  = 0;
+  int                 inflight = 1000;
+  int                 port     = 1137;
+  int                 c;
+  pid_t               pid;
+  double              t0;
+  double              t1;
+
+  while( (c = getopt( argc, argv, "hVn:c:p:" )) > 0 )
+    {
+    switch( c )
+      {
+      case 'n': count    = atol( optarg ); break;
+      case 'c': inflight = atoi( optarg ); break;
+      case 'p': port     = atoi( optarg ); break;
+      case 'V': version( argv[0], EXIT_SUCCESS ); break;
+      case 'h': usage( argv[0], EXIT_SUCCESS );   break;
+      default:  usage( argv[0], EXIT_FAILURE );   break;
+      }
+    }
+  if( (count < 1) || (inflight < 1) || (inflight > nbt_nsRES_MAXQ) )
+    usage( argv[0], EXIT_FAILURE );
+
+  pid = fork();
+  if( 0 == pid )
+    Responder( port );
+  if( pid < 0 )
+    Fail( "Could not start the responder.\n" );
+  (void)usleep( 100000 );
+
+  r = nbt_nsResolverOpen( 0 );
+  if( NULL == r )
+    Fail( "Could not open the resolver.\n" );
+  nbt_nsResolverSetRetry( r, 1000, 1000, 3 );
+
+  (void)memset( &dest, 0, sizeof( dest ) );
+  dest.sin_family      = AF_INET;
+  dest.sin_port        = htons( port );
+  dest.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+  namerec->name     = name;
+  namerec->pad      = ' ';
+  namerec->sfx      = 0x20;
+  namerec->scope_id = NULL;
+
+  t0 = Seconds();
+  while( (Answered + Failed) < count )
+    {
+    while( (InFlight < inflight) && (started < count) )
+      {
+      namerec->namelen = snprintf( (char *)name, sizeof( name ),
+                                   "HOST%09ld", started );
+      if( NULL == nbt_nsResolverQuery( r, namerec, nbt_nsQTYPE_NB,
+                                       nbt_nsRD_BIT, &dest, Done, NULL ) )
+        break;
+      InFlight++;
+      started++;
+      }
+    if( nbt_nsResolverRun( r, 10 ) < 0 )
+      Fail( "Resolver error.\n" );
+    }
+  t1 = Seconds();
+
+  (void)kill( pid, SIGTERM );
+  (void)waitpid( pid, NULL, 0 );
+  nbt_nsResolverClose( r );
+
+  Say( "%ld queries, %d in flight: %ld answered, %ld failed\n",
+       count, inflight, Answered, Failed );
+  Say( "%.3f seconds, %.0f resolutions/second\n",
+       t1 - t0, Answered / (t1 - t0) );
+  return( (Failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS );
+  } /* main */
+
+/* ========================================================================== */
@@ -34,9 +34,9 @@
  *
  * Bugs:
  *
- *  The program should accept Unicode input and handle it in UCS-2LE format.
- *  Instead, it takes ASCII input and pads the string with nul bytes to
- *  approximate UCS-2LE.  Fudge.
+ *  The input is taken to be UTF-8 (which includes plain ASCII).  Bytes that
+ *  are not valid UTF-8 are treated as ISO Latin-1.  Other character sets
+ *  are not supported.
  *
  * Compile:
  *
@@ -44,7 +44,7 @@
  * well as the LMhash, DES, and MD4 modules in the Auth/ directory. 
  *
  * $ cc -I ../ -o ntlmhash ntlmhash.c ../util/MsgOut.c ../Auth/LMhash.c \
- *   ../Auth/DES.c ../Auth/MD4.c
+ *   ../Auth/DES.c ../Auth/MD4.c ../Auth/auth_common.c
  *
  * ========================================================================== **
  */
@@ -228,19 +228,10 @@ int main( int argc, char *argv[] )
   Say( "]\n" );
 
   /* Generate the NTLM Hash
-   * - First step is to convert the input <iBufr> to Unicode.
-   *   *Cheat!* This program simply places nul bytes following
-   *   each byte of the input password.  Ick!  *Not* real UCS-2LE conversion.
-   * - Next, we perform an MD4 on the newly expanded password.
+   * - auth_NThash() converts the UTF-8 input to UTF-16LE and performs the
+   *   MD4 in one step.
    */
-  max = (len > (bSIZE/2) ? (bSIZE/2) : len);
-  iBufr[(2*max)-1] = '\0';
-  for( i = max-1; i > 0; i-- )
-    {
-    iBufr[(i*2)]   = iBufr[i];
-    iBufr[(i*2)-1] = '\0';
-    }
-  (void)auth_md4Sum( oBufr, iBufr, 2*max );
+  (void)auth_NThash( oBufr, iBufr, len );
 
   Say( "NTLM Hash [" );
   for( i = 0; i < 16; i++ )
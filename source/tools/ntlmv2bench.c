@@ -0,0 +1,278 @@
+/* ========================================================================== **
+ *                                ntlmv2bench.c
+ *
+ *  Copyright (C) 2026 by the libcifs contributors
+ *
+ *  Email: crh@ubiqx.mn.org
+ *
+ *  $Id$
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * License:
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * -------------------------------------------------------------------------- **
+ *
+ * Description:
+ *
+ *  This program measures NTLMv2 and LMv2 response verification rates on a
+ *  single CPU core, using the functions in Auth/NTLMv2.c.
+ *
+ *  Three cases are measured:
+ *    NTLMv2 cached - auth_NTLMv2verify() with an HMAC key state that was
+ *                    prepared ahead of time, as a server would keep it
+ *                    with the user's account.
+ *    NTLMv2 full   - The NTLMv2 hash and HMAC key state are rebuilt from
+ *                    the NT hash for every verification.
+ *    LMv2 cached   - auth_LMv2verify() with a prepared key state.
+ *
+ *  Every response checked is valid, so the work done is the same as for
+ *  a successful logon.
+ *
+ * Compile:
+ *
+ * $ cc -O2 -I ../ -o ntlmv2bench ntlmv2bench.c ../util/MsgOut.c \
+ *   ../Auth/MD5.c ../Auth/HMAC.c ../Auth/NTLMv2.c ../Auth/auth_common.c
+ *
+ * ========================================================================== **
+ */
+
+#include <stdio.h>      /* Standard I/O.              */
+#include <stdlib.h>     /* Standard C stuff.          */
+#include <unistd.h>     /* For getopt(3).             */
+#include <time.h>       /* For clock_gettime(2).      */
+
+#include "cifs.h"       /* CIFS toolkit header.       */
+
+
+/* -------------------------------------------------------------------------- **
+ * Constants:
+ *
+ *  bSIZE - Maximum blob length.
+ */
+
+#define bSIZE 1024
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Variables:
+ *  helpmsg   - An array of strings, terminated by a NULL pointer value.
+ *
+ *  Copyright - Copyright string.
+ *  License   - License under which the software is released.
+ *  ID        - Long-hand string providing revision information.
+ *
+ *  User      - User name, as UTF-16LE.
+ *  Domain    - Domain name, as UTF-16LE.
+ */
+
+static const char *helpmsg[] =
+  {
+  "",
+  "Usage: %s [-h|-V] [-b <bloblen>] [-t <seconds>]",
+  "  Measure NTLMv2 and LMv2 verifications per second on one core, using",
+  "  a client blob of <bloblen> bytes (default 128, maximum 1024) and",
+  "  spending about <seconds> (default 1) on each measurement.",
+  "  ",
+  "  -h : Causes this message to be displayed then exits the program.",
+  "  -V : Displays version and license information, then exits.",
+  "",
+  NULL
+  };
+
+static const char *Copyright = "Copyright (c) 2026 by the libcifs contributors";
+static const char *License   = "GNU General Public License Version 2 or Later";
+static const char *ID        = "$Id$";
+
+static const uchar User[]   = "U\0S\0E\0R\0";
+static const uchar Domain[] = "D\0O\0M\0A\0I\0N\0";
+
+
+/* -------------------------------------------------------------------------- **
+ * Static Functions...
+ */
+
+static void usage( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Prints the usage message, then exits with the given <status>.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  (void)util_Usage( stderr, helpmsg, prognam );
+  exit( status );
+  } /* usage */
+
+
+static void version( char *prognam, int status )
+  /* ------------------------------------------------------------------------ **
+   * Print version and license information, the bail out.
+   *
+   *  Input:  prognam - The name of the program (via argv[0]).
+   *          status  - Exit status (typically EXIT_SUCCESS or EXIT_FAILURE).
+   *
+   *  Output: <none>
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Err( "%s: %s\n", prognam, ID );
+  Err( " License: %s\n", License );
+  Err( "%s\n\n", Copyright );
+  exit( status );
+  } /* version */
+
+
+static double Seconds( void )
+  /* ------------------------------------------------------------------------ **
+   * Return a monotonic time in seconds.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + (ts.tv_nsec / 1e9) );
+  } /* Seconds */
+
+
+static void Report( const char *what, long count, double elapsed )
+  /* ------------------------------------------------------------------------ **
+   * Print the rate for one test case.
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  Say( "%-14s %10.0f verifications/second  (%.2f us each)\n",
+       what, count / elapsed, (elapsed * 1e6) / count );
+  } /* Report */
+
+
+/* -------------------------------------------------------------------------- **
+ * Functions...
+ */
+
+int main( int argc, char *argv[] )
+  /* ------------------------------------------------------------------------ **
+   * Mainline
+   *
+   *  Input:  argc  - You know what this is.
+   *          argv  - You know what to do.
+   *
+   *  Output: EXIT_SUCCESS, or EXIT_FAILURE if a valid response was
+   *          rejected (which would be a bug).
+   *
+   * ------------------------------------------------------------------------ **
+   */
+  {
+  static uchar     resp[16 + bSIZE];
+  auth_hmacMD5Key  key[1];
+  uchar            nthash[16];
+  uchar            v2hash[16];
+  uchar            challenge[8];
+  uchar            lmresp[24];
+  double           limit   = 1.0;
+  int              bloblen = 128;
+  long             count;
+  long             bad = 0;
+  double           t0;
+  double           t1;
+  int              c;
+  int              i;
+
+  while( (c = getopt( argc, argv, "hVb:t:" )) > 0 )
+    {
+    switch( c )
+      {
+      case 'b': bloblen = atoi( optarg ); break;
+      case 't': limit   = atof( optarg ); break;
+      case 'V': version( argv[0], EXIT_SUCCESS ); break;
+      case 'h': usage( argv[0], EXIT_SUCCESS );   break;
+      default:  usage( argv[0], EXIT_FAILURE );   break;
+      }
+    }
+  if( (bloblen < 1) || (bloblen > bSIZE) || (limit <= 0.0) )
+    usage( argv[0], EXIT_FAILURE );
+
+  /* Build a valid NTLMv2 response and LMv2 response to check.
+   * The blob contents don't matter, since the blob is not parsed.
+   */
+  for( i = 0; i < 16; i++ )
+    nthash[i] = (uchar)(i * 17);
+  for( i = 0; i < 8; i++ )
+    challenge[i] = (uchar)(0xA0 + i);
+  for( i = 0; i < bloblen; i++ )
+    resp[16 + i] = (uchar)i;
+  (void)auth_NTLMv2hash( v2hash, nthash, User, sizeof( User ) - 1,
+                         Domain, sizeof( Domain ) - 1 );
+  (void)auth_hmacMD5SetKey( key, v2hash, 16 );
+  (void)auth_NTLMv2response( resp, key, challenge, &resp[16], bloblen );
+  (void)auth_LMv2response( lmresp, key, challenge, &resp[16] );
+
+  Say( "Blob length: %d bytes\n", bloblen );
+
+  count = 0;
+  t0    = Seconds();
+  do
+    {
+    for( i = 0; i < 1000; i++ )
+      if( !auth_NTLMv2verify( key, challenge, resp, 16 + bloblen ) )
+        bad++;
+    count += i;
+    t1 = Seconds();
+    } while( (t1 - t0) < limit );
+  Report( "NTLMv2 cached", count, t1 - t0 );
+
+  count = 0;
+  t0    = Seconds();
+  do
+    {
+    for( i = 0; i < 1000; i++ )
+      {
+      (void)auth_NTLMv2hash( v2hash, nthash, User, sizeof( User ) - 1,
+                             Domain, sizeof( Domain ) - 1 );
+      (void)auth_hmacMD5SetKey( key, v2hash, 16 );
+      if( !auth_NTLMv2verify( key, challenge, resp, 16 + bloblen ) )
+        bad++;
+      }
+    count += i;
+    t1 = Seconds();
+    } while( (t1 - t0) < limit );
+  Report( "NTLMv2 full", count, t1 - t0 );
+
+  count = 0;
+  t0    = Seconds();
+  do
+    {
+    for( i = 0; i < 1000; i++ )
+      if( !auth_LMv2verify( key, challenge, lmresp ) )
+        bad++;
+    count += i;
+    t1 = Seconds();
+    } while( (t1 - t0) < limit );
+  Report( "LMv2 cached", count, t1 - t0 );
+
+  if( bad )
+    Say( "%ld valid responses were rejected.\n", bad );
+  return( bad ? EXIT_FAILURE : EXIT_SUCCESS );
+  } /* main */
+
+/* ========================================================================== */